@@ -242,6 +242,11 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_AXES_FLAGS_HIDE_MINOR = 0x0400
         DVZ_AXES_FLAGS_HIDE_GRID = 0x0800
 
+    ctypedef enum DvzPathFlags:
+        DVZ_PATH_FLAGS_DEFAULT = 0x0000
+        DVZ_PATH_FLAGS_GPU_BAKE = 0x1000
+        DVZ_PATH_FLAGS_CPU_BAKE = 0x2000
+
     # from file: canvas.h
 
     ctypedef enum DvzCanvasFlags:
@@ -305,6 +310,35 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_SCREENCAST_AWAIT_COPY = 2
         DVZ_SCREENCAST_AWAIT_TRANSFER = 3
 
+    ctypedef enum DvzPickType:
+        DVZ_PICK_NONE = 0
+        DVZ_PICK_POINTS = 1
+        DVZ_PICK_RECT = 2
+
+    ctypedef enum DvzPickStatus:
+        DVZ_PICK_STATUS_NONE = 0
+        DVZ_PICK_STATUS_IDLE = 1
+        DVZ_PICK_STATUS_AWAIT_SUBMIT = 2
+        DVZ_PICK_STATUS_AWAIT_READBACK = 3
+
+    ctypedef enum DvzBatchSlotStatus:
+        DVZ_BATCH_SLOT_IDLE = 0
+        DVZ_BATCH_SLOT_AWAIT_SUBMIT = 1
+        DVZ_BATCH_SLOT_AWAIT_READBACK = 2
+
+    ctypedef enum DvzFramePhase:
+        DVZ_FRAME_PHASE_POLL = 0
+        DVZ_FRAME_PHASE_FENCE_WAIT = 1
+        DVZ_FRAME_PHASE_ACQUIRE = 2
+        DVZ_FRAME_PHASE_CALLBACKS = 3
+        DVZ_FRAME_PHASE_SCENE = 4
+        DVZ_FRAME_PHASE_TRANSFERS = 5
+        DVZ_FRAME_PHASE_REFILL = 6
+        DVZ_FRAME_PHASE_SUBMIT = 7
+        DVZ_FRAME_PHASE_PRESENT = 8
+        DVZ_FRAME_PHASE_TOTAL = 9
+        DVZ_FRAME_PHASE_COUNT = 10
+
     ctypedef enum DvzEventType:
         DVZ_EVENT_NONE = 0
         DVZ_EVENT_INIT = 1
@@ -328,7 +362,8 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_EVENT_RESIZE = 19
         DVZ_EVENT_PRE_SEND = 20
         DVZ_EVENT_POST_SEND = 21
-        DVZ_EVENT_DESTROY = 22
+        DVZ_EVENT_PICK = 22
+        DVZ_EVENT_DESTROY = 23
 
     ctypedef enum DvzEventMode:
         DVZ_EVENT_MODE_SYNC = 0
@@ -745,6 +780,9 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_VISUAL_FLAGS_TRANSFORM_AUTO = 0x0000
         DVZ_VISUAL_FLAGS_TRANSFORM_NONE = 0x0010
         DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT = 0x0020
+        DVZ_VISUAL_FLAGS_TRANSFORM_CPU = 0x0040
+        DVZ_VISUAL_FLAGS_LOD = 0x0080
+        DVZ_VISUAL_FLAGS_SPATIAL_INDEX = 0x4000
 
     ctypedef enum DvzSceneUpdateType:
         DVZ_SCENE_UPDATE_NONE = 0
@@ -767,6 +805,7 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_TRANSFER_TEXTURE_UPLOAD = 4
         DVZ_TRANSFER_TEXTURE_DOWNLOAD = 5
         DVZ_TRANSFER_TEXTURE_COPY = 6
+        DVZ_TRANSFER_COMPUTE = 7
 
     # from file: transforms.h
 
@@ -862,8 +901,9 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_SOURCE_TYPE_TRANSFER = 8
         DVZ_SOURCE_TYPE_COLOR_TEXTURE = 9
         DVZ_SOURCE_TYPE_FONT_ATLAS = 10
-        DVZ_SOURCE_TYPE_OTHER = 11
-        DVZ_SOURCE_TYPE_COUNT = 12
+        DVZ_SOURCE_TYPE_STORAGE = 11
+        DVZ_SOURCE_TYPE_OTHER = 12
+        DVZ_SOURCE_TYPE_COUNT = 13
 
     ctypedef enum DvzSourceOrigin:
         DVZ_SOURCE_ORIGIN_NONE = 0
@@ -873,6 +913,7 @@ cdef extern from "<datoviz/datoviz.h>":
 
     ctypedef enum DvzSourceFlags:
         DVZ_SOURCE_FLAG_MAPPABLE = 0x0001
+        DVZ_SOURCE_FLAG_GPU_BAKE = 0x0002
 
     ctypedef enum DvzVisualRequest:
         DVZ_VISUAL_REQUEST_NOT_SET = 0x0000
@@ -908,6 +949,7 @@ cdef extern from "<datoviz/datoviz.h>":
     ctypedef enum DvzGraphicsFlags:
         DVZ_GRAPHICS_FLAGS_DEPTH_TEST = 0x0100
         DVZ_GRAPHICS_FLAGS_PICK = 0x0200
+        DVZ_GRAPHICS_FLAGS_INSTANCED = 0x8000
 
     ctypedef enum DvzGraphicsType:
         DVZ_GRAPHICS_NONE = 0
@@ -961,10 +1003,14 @@ cdef extern from "<datoviz/datoviz.h>":
         vec4 margins
         uvec2 offset_screen
         uvec2 size_screen
-        uvec2 offset_framebuffer
+        ivec2 offset_framebuffer
         uvec2 size_framebuffer
         DvzViewportClip clip
         int32_t interact_axis
+        vec4 data_scale
+        vec4 data_shift
+        uvec4 ring
+        vec4 tile
 
     ctypedef struct DvzMouseButtonEvent:
         DvzMouseButton button
@@ -1012,6 +1058,15 @@ cdef extern from "<datoviz/datoviz.h>":
         uint32_t height
         uint8_t* rgba
 
+    ctypedef struct DvzPickEvent:
+        uint64_t idx
+        DvzPickType type
+        uint32_t count
+        uvec2 offset
+        uvec2 shape
+        ivec4* values
+        void* user_data
+
     ctypedef struct DvzRefillEvent:
         uint32_t img_idx
         uint32_t cmd_count
@@ -1042,6 +1097,7 @@ cdef extern from "<datoviz/datoviz.h>":
         DvzRefillEvent rf
         DvzResizeEvent r
         DvzScreencastEvent sc
+        DvzPickEvent p
         DvzSubmitEvent s
         DvzGuiEvent g
 
@@ -1050,6 +1106,14 @@ cdef extern from "<datoviz/datoviz.h>":
         void* user_data
         DvzEventUnion u
 
+    ctypedef struct DvzFrameStats:
+        uint32_t count
+        double mean
+        double max
+        double p50
+        double p95
+        double p99
+
     # from file: controls.h
 
     ctypedef struct DvzGuiControlSliderFloat:
@@ -1096,6 +1160,7 @@ cdef extern from "<datoviz/datoviz.h>":
 
 
     ctypedef void (*DvzEventCallback)(DvzCanvas*, DvzEvent)
+    ctypedef void (*DvzVisualReleaseCallback)(DvzVisual*, void*, void*)
     void dvz_colormap_array(DvzColormap cmap, uint32_t count, double* values, double vmin, double vmax, cvec4* out);
     void dvz_colormap_packuv(cvec3 color, vec2 uv)
     void dvz_colormap_custom(uint8_t cmap, uint32_t color_count, cvec4* colors)
@@ -1146,8 +1211,10 @@ cdef extern from "<datoviz/datoviz.h>":
     # from file: scene.h
     DvzScene* dvz_scene(DvzCanvas* canvas, uint32_t n_rows, uint32_t n_cols)
     void dvz_scene_destroy(DvzScene* scene)
+    int dvz_scene_save(DvzScene* scene, const char* path)
     DvzPanel* dvz_scene_panel(DvzScene* scene, uint32_t row, uint32_t col, DvzControllerType type, int flags)
     DvzVisual* dvz_scene_visual(DvzPanel* panel, DvzVisualType type, int flags)
+    bint dvz_visual_nearest(DvzPanel* panel, DvzVisual* visual, DvzCDS source, dvec3 pos, double radius, uint32_t* item)
 
     # from file: transfers.h
     void dvz_upload_buffers(DvzCanvas* canvas, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
@@ -1161,9 +1228,14 @@ cdef extern from "<datoviz/datoviz.h>":
     void dvz_transform(DvzPanel* panel, DvzCDS source, dvec3 pos_in, DvzCDS target, dvec3 pos_out)
 
     # from file: visuals.h
+    void dvz_visual_prop_origin(DvzProp* prop, dvec3 origin)
     void dvz_visual_data(DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data)
+    void dvz_visual_data_append(DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data)
+    void dvz_visual_data_borrow(DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, void* data, DvzVisualReleaseCallback release, void* user_data)
+    void dvz_visual_ring(DvzVisual* visual, uint32_t capacity)
     void dvz_visual_data_source(DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx, uint32_t first_item, uint32_t item_count, uint32_t data_item_count, const void* data)
     void dvz_visual_texture(DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx, DvzTexture* texture)
+    void dvz_visual_visible(DvzVisual* visual, bint visible)
     DvzProp* dvz_prop_get(DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx)
 
     # from file: vklite.h
@@ -95,6 +95,7 @@ _EVENTS ={
 _VISUALS = {
     'point': cv.DVZ_VISUAL_POINT,
     'marker': cv.DVZ_VISUAL_MARKER,
+    'segment': cv.DVZ_VISUAL_SEGMENT,
     'mesh': cv.DVZ_VISUAL_MESH,
     'path': cv.DVZ_VISUAL_PATH,
     'polygon': cv.DVZ_VISUAL_POLYGON,
@@ -422,7 +423,7 @@ def _get_prop(name):
 # -------------------------------------------------------------------------------------------------
 
 def _validate_data(dt, nc, data):
-    data = data.astype(dt)
+    data = data.astype(dt, copy=False)
     if not data.flags['C_CONTIGUOUS']:
         data = np.ascontiguousarray(data)
     if not hasattr(nc, '__len__'):
@@ -667,6 +668,11 @@ cdef class Canvas:
         cdef char* _c_path = path
         cv.dvz_screenshot_file(self._c_canvas, _c_path);
 
+    def save(self, unicode path):
+        cdef char* _c_path = path
+        if cv.dvz_scene_save(self._c_scene, _c_path) != 0:
+            raise IOError(f"unable to save the scene to {path}")
+
     def video(self, unicode path):
         cdef char* _c_path = path
         cv.dvz_canvas_video(self._c_canvas, 30, 10000000, _c_path, False)
@@ -971,8 +977,52 @@ cdef class Visual:
         dtype, nc = _DTYPES[c_prop.dtype]
         value = _validate_data(dtype, nc, value)
         N = value.shape[0]
+        # NOTE: the data is copied by the visual. The NumPy array may be freed or modified by the
+        # caller as soon as this method returns, whereas the visual sources and the pending
+        # uploads could still reference borrowed memory after the prop has released it.
         cv.dvz_visual_data(self._c_visual, prop_type, idx, N, &value.data[0])
 
+    def append(self, name, np.ndarray value, idx=0):
+        # Append items to the prop, the data is copied.
+        prop_type = _get_prop(name)
+        c_prop = cv.dvz_prop_get(self._c_visual, prop_type, idx)
+        dtype, nc = _DTYPES[c_prop.dtype]
+        value = _validate_data(dtype, nc, value)
+        N = value.shape[0]
+        cv.dvz_visual_data_append(self._c_visual, prop_type, idx, N, &value.data[0])
+
+    def ring(self, int capacity):
+        # Use a fixed-capacity circular vertex buffer: Visual.append() then overwrites the
+        # oldest items instead of growing the visual (streaming mode).
+        cv.dvz_visual_ring(self._c_visual, capacity)
+
+    def visible(self, bint visible):
+        # Show or hide the visual.
+        cv.dvz_visual_visible(self._c_visual, visible)
+
+    def nearest(self, pos, radius=0, coords='window'):
+        # Index of the item nearest to a position (the mouse position by default), within an
+        # optional radius, or None. Uses a spatial index of the positions, on the CPU.
+        cdef cv.dvec3 c_pos
+        cdef cv.uint32_t c_item = 0
+        c_pos[0] = pos[0]
+        c_pos[1] = pos[1]
+        c_pos[2] = pos[2] if len(pos) > 2 else 0
+        source = _COORDINATE_SYSTEMS[coords]
+        if cv.dvz_visual_nearest(self._c_panel, self._c_visual, source, c_pos, radius, &c_item):
+            return c_item
+        return None
+
+    def origin(self, origin, idx=0):
+        # Store the POS prop in single precision, relative to a double-precision origin: the
+        # data passed to Visual.data('pos') is then float32 offsets relative to that origin.
+        cdef cv.dvec3 c_origin
+        c_origin[0] = origin[0]
+        c_origin[1] = origin[1]
+        c_origin[2] = origin[2]
+        c_prop = cv.dvz_prop_get(self._c_visual, cv.DVZ_PROP_POS, idx)
+        cv.dvz_visual_prop_origin(c_prop, c_origin)
+
     def texture(self, Texture tex, idx=0):
         # Bind the texture with the visual for the specified source.
         cv.dvz_visual_texture(
@@ -34,6 +34,8 @@ STRUCTS = (
     'DvzRefillEvent',
     'DvzGuiEvent',
     'DvzResizeEvent',
+    'DvzPickEvent',
+    'DvzFrameStats',
     'DvzScreencastEvent',
     'DvzSubmitEvent',
     'DvzTimerEvent',
@@ -231,6 +233,8 @@ def _camel_to_snake(name):
 
 def _gen_cython_func(name, func):
     out, args = func
+    if out == 'bool':
+        out = 'bint'
     args_s = []
     for const, dtype, argname in args:
         if not argname:
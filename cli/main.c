@@ -50,9 +50,13 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_fifo_2), //
     CASE_FIXTURE_NONE(test_fifo_3), //
 
+    // Task pool
+    CASE_FIXTURE_NONE(test_task_pool), //
+
     // context
-    CASE_FIXTURE_NONE(test_default_app),      //
-    CASE_FIXTURE_NONE(test_context_colormap), //
+    CASE_FIXTURE_NONE(test_default_app),        //
+    CASE_FIXTURE_NONE(test_context_colormap),   //
+    CASE_FIXTURE_NONE(test_context_font_atlas), //
 
     // canvas
     CASE_FIXTURE_NONE(test_canvas_transfer_buffer),  //
@@ -69,7 +73,12 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_canvas_append),           //
     CASE_FIXTURE_NONE(test_canvas_particles),        //
     CASE_FIXTURE_NONE(test_canvas_pick),             //
+    CASE_FIXTURE_NONE(test_canvas_pick_async),       //
     CASE_FIXTURE_NONE(test_canvas_offscreen),        //
+    CASE_FIXTURE_NONE(test_canvas_batch),            //
+    CASE_FIXTURE_NONE(test_canvas_threaded),         //
+    CASE_FIXTURE_NONE(test_canvas_timing),           //
+    CASE_FIXTURE_NONE(test_canvas_tiled),            //
     CASE_FIXTURE_NONE(test_canvas_gui_1),            //
     CASE_FIXTURE_NONE(test_canvas_screencast),       //
 
@@ -93,11 +102,13 @@ static TestCase TEST_CASES[] = {
     // generate marker screenshots:
     CASE_FIXTURE_NONE(test_graphics_marker_screenshots), //
 
-    CASE_FIXTURE_NONE(test_graphics_segment),    //
-    CASE_FIXTURE_NONE(test_graphics_path),       //
-    CASE_FIXTURE_NONE(test_graphics_text),       //
-    CASE_FIXTURE_NONE(test_graphics_image_1),    //
-    CASE_FIXTURE_NONE(test_graphics_image_cmap), //
+    CASE_FIXTURE_NONE(test_graphics_segment),           //
+    CASE_FIXTURE_NONE(test_graphics_segment_instanced), //
+    CASE_FIXTURE_NONE(test_graphics_path),              //
+    CASE_FIXTURE_NONE(test_graphics_text),              //
+    CASE_FIXTURE_NONE(test_graphics_text_instanced),    //
+    CASE_FIXTURE_NONE(test_graphics_image_1),           //
+    CASE_FIXTURE_NONE(test_graphics_image_cmap),        //
 
     CASE_FIXTURE_NONE(test_graphics_volume_1),     //
     CASE_FIXTURE_NONE(test_graphics_volume_slice), //
@@ -105,30 +116,39 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_graphics_mesh_2),       //
 
     // transforms
-    CASE_FIXTURE_NONE(test_transforms_1), //
-    CASE_FIXTURE_NONE(test_transforms_2), //
-    CASE_FIXTURE_NONE(test_transforms_3), //
-    CASE_FIXTURE_NONE(test_transforms_4), //
-    CASE_FIXTURE_NONE(test_transforms_5), //
+    CASE_FIXTURE_NONE(test_transforms_1),      //
+    CASE_FIXTURE_NONE(test_transforms_2),      //
+    CASE_FIXTURE_NONE(test_transforms_3),      //
+    CASE_FIXTURE_NONE(test_transforms_4),      //
+    CASE_FIXTURE_NONE(test_transforms_5),      //
+    CASE_FIXTURE_NONE(test_transforms_origin), //
 
     // array
-    CASE_FIXTURE_NONE(test_array_1),    //
-    CASE_FIXTURE_NONE(test_array_2),    //
-    CASE_FIXTURE_NONE(test_array_3),    //
-    CASE_FIXTURE_NONE(test_array_4),    //
-    CASE_FIXTURE_NONE(test_array_5),    //
-    CASE_FIXTURE_NONE(test_array_6),    //
-    CASE_FIXTURE_NONE(test_array_7),    //
-    CASE_FIXTURE_NONE(test_array_cast), //
-    CASE_FIXTURE_NONE(test_array_mvp),  //
-    CASE_FIXTURE_NONE(test_array_3D),   //
+    CASE_FIXTURE_NONE(test_array_1),      //
+    CASE_FIXTURE_NONE(test_array_2),      //
+    CASE_FIXTURE_NONE(test_array_3),      //
+    CASE_FIXTURE_NONE(test_array_4),      //
+    CASE_FIXTURE_NONE(test_array_5),      //
+    CASE_FIXTURE_NONE(test_array_6),      //
+    CASE_FIXTURE_NONE(test_array_7),      //
+    CASE_FIXTURE_NONE(test_array_cast),   //
+    CASE_FIXTURE_NONE(test_array_mvp),    //
+    CASE_FIXTURE_NONE(test_array_3D),     //
+    CASE_FIXTURE_NONE(test_array_column), //
+    CASE_FIXTURE_NONE(test_array_bounds), //
 
     // visuals
-    CASE_FIXTURE_NONE(test_visuals_1), //
-    CASE_FIXTURE_NONE(test_visuals_2), //
-    CASE_FIXTURE_NONE(test_visuals_3), //
-    CASE_FIXTURE_NONE(test_visuals_4), //
-    CASE_FIXTURE_NONE(test_visuals_5), //
+    CASE_FIXTURE_NONE(test_visuals_1),       //
+    CASE_FIXTURE_NONE(test_visuals_2),       //
+    CASE_FIXTURE_NONE(test_visuals_3),       //
+    CASE_FIXTURE_NONE(test_visuals_4),       //
+    CASE_FIXTURE_NONE(test_visuals_5),       //
+    CASE_FIXTURE_NONE(test_visuals_partial), //
+    CASE_FIXTURE_NONE(test_visuals_borrow),  //
+    CASE_FIXTURE_NONE(test_visuals_ring),    //
+    CASE_FIXTURE_NONE(test_visuals_lod),     //
+    CASE_FIXTURE_NONE(test_visuals_bounds),  //
+    CASE_FIXTURE_NONE(test_visuals_spatial), //
 
     // interact
     CASE_FIXTURE_NONE(test_interact_1),       //
@@ -150,8 +170,12 @@ static TestCase TEST_CASES[] = {
 #endif
 
     CASE_FIXTURE_NONE(test_visuals_marker),         //
+    CASE_FIXTURE_NONE(test_visuals_segment),        //
+    CASE_FIXTURE_NONE(test_visuals_text),           //
     CASE_FIXTURE_NONE(test_visuals_polygon),        //
     CASE_FIXTURE_NONE(test_visuals_path),           //
+    CASE_FIXTURE_NONE(test_visuals_path_gpu),       //
+    CASE_FIXTURE_NONE(test_visuals_path_lod),       //
     CASE_FIXTURE_NONE(test_visuals_image_1),        //
     CASE_FIXTURE_NONE(test_visuals_image_cmap),     //
     CASE_FIXTURE_NONE(test_visuals_axes_2D_1),      //
@@ -162,44 +186,60 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_visuals_volume_slice), //
 
     // axes
-    CASE_FIXTURE_NONE(test_axes_1), //
-    CASE_FIXTURE_NONE(test_axes_2), //
-    CASE_FIXTURE_NONE(test_axes_3), //
+    CASE_FIXTURE_NONE(test_axes_1),     //
+    CASE_FIXTURE_NONE(test_axes_2),     //
+    CASE_FIXTURE_NONE(test_axes_3),     //
+    CASE_FIXTURE_NONE(test_axes_bench), //
 
     // scene
-    CASE_FIXTURE_NONE(test_scene_0),        //
-    CASE_FIXTURE_NONE(test_scene_1),        //
-    CASE_FIXTURE_NONE(test_scene_mesh),     //
-    CASE_FIXTURE_NONE(test_scene_axes),     //
-    CASE_FIXTURE_NONE(test_scene_logistic), //
+    CASE_FIXTURE_NONE(test_scene_0),             //
+    CASE_FIXTURE_NONE(test_scene_1),             //
+    CASE_FIXTURE_NONE(test_scene_mesh),          //
+    CASE_FIXTURE_NONE(test_scene_axes),          //
+    CASE_FIXTURE_NONE(test_scene_axes_async),    //
+    CASE_FIXTURE_NONE(test_scene_logistic),      //
+    CASE_FIXTURE_NONE(test_scene_transform_gpu), //
+    CASE_FIXTURE_NONE(test_scene_updates),       //
+    CASE_FIXTURE_NONE(test_scene_culling),       //
+    CASE_FIXTURE_NONE(test_scene_batch),         //
+    CASE_FIXTURE_NONE(test_scene_snapshot),      //
+    CASE_FIXTURE_NONE(test_scene_panels),        //
 
 };
 static uint32_t N_TESTS = sizeof(TEST_CASES) / sizeof(TestCase);
 
 
 
+// Benchmarks, only run with the bench command as they are too slow for the test suite.
+static TestCase BENCH_CASES[] = {
+    CASE_FIXTURE_NONE(test_graphics_segment_bench), //
+};
+static uint32_t N_BENCHS = sizeof(BENCH_CASES) / sizeof(TestCase);
+
+
+
 /*************************************************************************************************/
 /*  Tests utils                                                                                  */
 /*************************************************************************************************/
 
-static TestCase get_test_case(const char* name)
+static TestCase get_test_case(TestCase* cases, uint32_t n_cases, const char* name)
 {
-    for (uint32_t i = 0; i < N_TESTS; i++)
+    for (uint32_t i = 0; i < n_cases; i++)
     {
-        if (strcmp(TEST_CASES[i].name, name) == 0)
+        if (strcmp(cases[i].name, name) == 0)
         {
-            return TEST_CASES[i];
+            return cases[i];
         }
     }
     log_error("test case %s not found!", name);
     return (TestCase){0};
 }
 
-static int launcher(TestContext* context, const char* name)
+static int launcher(TestContext* context, TestCase* cases, uint32_t n_cases, const char* name)
 {
     srand(0);
 
-    TestCase test_case = get_test_case(name);
+    TestCase test_case = get_test_case(cases, n_cases, name);
     if (test_case.function == NULL)
         return 1;
 
@@ -263,7 +303,7 @@ static int launcher(TestContext* context, const char* name)
 /*  Main functions                                                                               */
 /*************************************************************************************************/
 
-static int test(int argc, char** argv)
+static int run_cases(TestCase* cases, uint32_t n_cases, int argc, char** argv)
 {
     // argv: test, <name>, --live
     // bool is_live = argc >= 3 && strcmp(argv[2], "--live") == 0;
@@ -277,15 +317,15 @@ static int test(int argc, char** argv)
     int res = 0;
     int index = 0;
     // Loop over all possible tests.
-    for (uint32_t i = 0; i < N_TESTS; i++)
+    for (uint32_t i = 0; i < n_cases; i++)
     {
         // Run a test only if all tests are requested, or if the requested test matches
         // the current test.
-        if (argc == 1 || strstr(TEST_CASES[i].name, argv[1]) != NULL)
+        if (argc == 1 || strstr(cases[i].name, argv[1]) != NULL)
         {
-            print_case(index, TEST_CASES[i].name);
-            cur_res = launcher(NULL, TEST_CASES[i].name);
-            print_res(index, TEST_CASES[i].name, cur_res);
+            print_case(index, cases[i].name);
+            cur_res = launcher(NULL, cases, n_cases, cases[i].name);
+            print_res(index, cases[i].name, cur_res);
             res += cur_res == 0 ? 0 : 1;
             index++;
         }
@@ -298,6 +338,16 @@ static int test(int argc, char** argv)
     return res;
 }
 
+static int test(int argc, char** argv)
+{
+    return run_cases(TEST_CASES, N_TESTS, argc, argv);
+}
+
+static int bench(int argc, char** argv)
+{
+    return run_cases(BENCH_CASES, N_BENCHS, argc, argv);
+}
+
 static int info(int argc, char** argv)
 {
     DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
@@ -334,13 +384,14 @@ int main(int argc, char** argv)
     log_set_level_env();
     if (argc <= 1)
     {
-        log_error("specify a command: info, demo, test");
+        log_error("specify a command: info, demo, test, bench");
         return 1;
     }
     ASSERT(argc >= 2);
     int res = 0;
     SWITCH_CLI_ARG(info)
     SWITCH_CLI_ARG(test)
+    SWITCH_CLI_ARG(bench)
     SWITCH_CLI_ARG(demo)
     return res;
 }
@@ -332,3 +332,179 @@ int test_array_3D(TestContext* context)
     dvz_array_destroy(&arr);
     return 0;
 }
+
+
+
+// Reference per-item implementation of dvz_array_column(), used to check the optimized kernels.
+static void _column_ref(
+    DvzArray* array, VkDeviceSize offset, VkDeviceSize col_size, uint32_t data_item_count,
+    const void* data, bool cast, DvzArrayCopyType copy_type, uint32_t reps)
+{
+    const uint8_t* src = data;
+    uint8_t* dst = (uint8_t*)array->data + offset;
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < array->item_count; i++)
+    {
+        j = MIN(i / MAX(1, reps), data_item_count - 1);
+        if (copy_type == DVZ_ARRAY_COPY_SINGLE && reps > 1 && i % reps > 0)
+            continue;
+        if (!cast)
+            memcpy(dst + i * array->item_size, src + j * col_size, col_size);
+        else
+            for (uint32_t k = 0; k < col_size / sizeof(double); k++)
+                ((float*)(dst + i * array->item_size))[k] =
+                    (float)((const double*)(src + j * col_size))[k];
+    }
+}
+
+
+
+static int _column_bench(
+    const char* name, uint32_t item_count, VkDeviceSize item_size, VkDeviceSize offset,
+    DvzDataType source_dtype, DvzDataType target_dtype, DvzArrayCopyType copy_type, uint32_t reps)
+{
+    const uint32_t n_iter = 10;
+    bool cast = target_dtype != DVZ_DTYPE_NONE;
+    VkDeviceSize col_size = _get_dtype_size(source_dtype);
+    uint32_t data_item_count = item_count / MAX(1, reps);
+
+    // Random source data.
+    uint8_t* data = calloc(data_item_count, col_size);
+    for (uint32_t i = 0; i < data_item_count * col_size / sizeof(double); i++)
+        ((double*)data)[i] = dvz_rand_normal();
+
+    DvzArray arr = dvz_array_struct(item_count, item_size);
+    DvzArray arr_ref = dvz_array_struct(item_count, item_size);
+
+    // Optimized kernels.
+    double t0 = _clock_now();
+    for (uint32_t i = 0; i < n_iter; i++)
+        dvz_array_column(
+            &arr, offset, col_size, 0, item_count, data_item_count, data, source_dtype,
+            target_dtype, copy_type, reps);
+    double t1 = _clock_now();
+
+    // Reference implementation.
+    for (uint32_t i = 0; i < n_iter; i++)
+        _column_ref(&arr_ref, offset, col_size, data_item_count, data, cast, copy_type, reps);
+    double t2 = _clock_now();
+
+    AT(memcmp(arr.data, arr_ref.data, item_count * item_size) == 0);
+
+    double size = n_iter * (double)(data_item_count * col_size) / (1024. * 1024. * 1024.);
+    log_info(
+        "%-24s %6.2f GB/s (reference %6.2f GB/s, x%.1f)", name, size / (t1 - t0),
+        size / (t2 - t1), (t2 - t1) / (t1 - t0));
+
+    dvz_array_destroy(&arr);
+    dvz_array_destroy(&arr_ref);
+    FREE(data);
+    return 0;
+}
+
+
+
+int test_array_column(TestContext* context)
+{
+    const uint32_t n = 1000000;
+    log_info("array copy kernels: %s", dvz_array_simd());
+
+    // Contiguous copy.
+    AT(_column_bench(
+           "copy contiguous", n, sizeof(dvec3), 0, DVZ_DTYPE_DVEC3, DVZ_DTYPE_NONE,
+           DVZ_ARRAY_COPY_SINGLE, 1) == 0);
+
+    // Strided copy into a vertex struct.
+    AT(_column_bench(
+           "copy strided", n, 32, 8, DVZ_DTYPE_DOUBLE, DVZ_DTYPE_NONE, //
+           DVZ_ARRAY_COPY_SINGLE, 1) == 0);
+
+    // double to float.
+    AT(_column_bench(
+           "double->float", n, sizeof(float), 0, DVZ_DTYPE_DOUBLE, DVZ_DTYPE_FLOAT,
+           DVZ_ARRAY_COPY_SINGLE, 1) == 0);
+
+    // dvec3 to vec3, contiguous and into a vertex struct (vec3 pos, cvec4 color).
+    AT(_column_bench(
+           "dvec3->vec3 contiguous", n, sizeof(vec3), 0, DVZ_DTYPE_DVEC3, DVZ_DTYPE_VEC3,
+           DVZ_ARRAY_COPY_SINGLE, 1) == 0);
+    AT(_column_bench(
+           "dvec3->vec3 strided", n, sizeof(DvzVertex), 0, DVZ_DTYPE_DVEC3, DVZ_DTYPE_VEC3,
+           DVZ_ARRAY_COPY_SINGLE, 1) == 0);
+    AT(_column_bench(
+           "dvec2->vec2 strided", n, 16, 0, DVZ_DTYPE_DVEC2, DVZ_DTYPE_VEC2,
+           DVZ_ARRAY_COPY_SINGLE, 1) == 0);
+
+    // Repeats.
+    AT(_column_bench(
+           "dvec3->vec3 repeat x4", n, sizeof(DvzVertex), 0, DVZ_DTYPE_DVEC3, DVZ_DTYPE_VEC3,
+           DVZ_ARRAY_COPY_REPEAT, 4) == 0);
+    AT(_column_bench(
+           "dvec3->vec3 single x4", n, sizeof(DvzVertex), 0, DVZ_DTYPE_DVEC3, DVZ_DTYPE_VEC3,
+           DVZ_ARRAY_COPY_SINGLE, 4) == 0);
+
+    return 0;
+}
+
+
+
+int test_array_bounds(TestContext* context)
+{
+    // NOTE: odd size to exercise the scalar tail of the SIMD kernels.
+    const uint32_t n = 1000003;
+    const uint32_t n_iter = 10;
+    log_info("array bounds kernels: %s", dvz_array_simd());
+
+    DvzArray arr_d = dvz_array(n, DVZ_DTYPE_DVEC3);
+    DvzArray arr_f = dvz_array(n, DVZ_DTYPE_VEC3);
+    double* d = (double*)arr_d.data;
+    float* f = (float*)arr_f.data;
+    for (uint32_t i = 0; i < 3 * n; i++)
+    {
+        d[i] = dvz_rand_normal();
+        f[i] = (float)d[i];
+    }
+    // NaN values are ignored.
+    d[3 * 1234 + 1] = NAN;
+    f[3 * 1234 + 1] = NAN;
+
+    // Reference implementation, on a subset of the items.
+    uint32_t first = 17, count = n - 100;
+    DvzBox ref = DVZ_BOX_INF;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            if (i == 1234 && j == 1)
+                continue;
+            ref.p0[j] = MIN(ref.p0[j], d[3 * i + j]);
+            ref.p1[j] = MAX(ref.p1[j], d[3 * i + j]);
+        }
+    }
+
+    DvzBox box = DVZ_BOX_INF;
+    double t0 = _clock_now();
+    for (uint32_t i = 0; i < n_iter; i++)
+        dvz_array_bounds(&arr_d, first, count, box.p0, box.p1);
+    double t1 = _clock_now();
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        AT(box.p0[j] == ref.p0[j]);
+        AT(box.p1[j] == ref.p1[j]);
+    }
+
+    DvzBox box_f = DVZ_BOX_INF;
+    dvz_array_bounds(&arr_f, first, count, box_f.p0, box_f.p1);
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        AT(box_f.p0[j] == (float)ref.p0[j]);
+        AT(box_f.p1[j] == (float)ref.p1[j]);
+    }
+
+    double size = n_iter * (double)(count * sizeof(dvec3)) / (1024. * 1024. * 1024.);
+    log_info("dvec3 bounds %6.2f GB/s", size / (t1 - t0));
+
+    dvz_array_destroy(&arr_d);
+    dvz_array_destroy(&arr_f);
+    return 0;
+}
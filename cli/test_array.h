@@ -20,6 +20,8 @@ int test_array_7(TestContext* context);
 int test_array_cast(TestContext* context);
 int test_array_mvp(TestContext* context);
 int test_array_3D(TestContext* context);
+int test_array_column(TestContext* context);
+int test_array_bounds(TestContext* context);
 
 
 
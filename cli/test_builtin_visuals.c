@@ -175,6 +175,84 @@ int test_visuals_marker(TestContext* context)
 
 
 
+int test_visuals_segment(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_SEGMENT, 0);
+    AT(visual.graphics[0]->instance_vertex_count > 0);
+
+    const uint32_t N = 50;
+    dvec3* pos0 = calloc(N, sizeof(dvec3));
+    dvec3* pos1 = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    float t = 0;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        t = -.9 + 1.8 * i / (float)(N - 1);
+        pos0[i][0] = pos1[i][0] = t;
+        pos0[i][1] = -.5;
+        pos1[i][1] = +.5 * sin(M_2PI * t);
+        dvz_colormap_scale(DVZ_CMAP_HSV, i, 0, N, color[i]);
+    }
+
+    // Set visual data.
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos0);
+    dvz_visual_data(&visual, DVZ_PROP_POS, 1, N, pos1);
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, N, color);
+
+    RUN;
+
+    // One vertex per segment.
+    DvzSource* src = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(src->arr.item_count == N);
+    DvzGraphicsSegmentVertex* vertices = (DvzGraphicsSegmentVertex*)src->arr.data;
+    AT(vertices[N - 1].P0[0] == (float)pos0[N - 1][0]);
+    AT(vertices[N - 1].cap1 == DVZ_CAP_ROUND);
+
+    SCREENSHOT("segment")
+    FREE(pos0);
+    FREE(pos1);
+    FREE(color);
+    END;
+}
+
+
+
+int test_visuals_text(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_TEXT, 0);
+    AT(visual.graphics[0]->instance_vertex_count > 0);
+
+    const uint32_t N = 3;
+    dvec3 pos[] = {{0, .5, 0}, {0, 0, 0}, {0, -.5, 0}};
+    char* strings[] = {"Hello world!", "", "datoviz"};
+    float size[] = {24, 24, 36};
+
+    // Set visual data.
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(&visual, DVZ_PROP_TEXT, 0, N, strings);
+    dvz_visual_data(&visual, DVZ_PROP_TEXT_SIZE, 0, N, size);
+
+    RUN;
+
+    // One vertex per glyph, the empty string is skipped.
+    DvzSource* src = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(src->arr.item_count == strlen(strings[0]) + strlen(strings[2]));
+    DvzGraphicsTextVertex* vertices = (DvzGraphicsTextVertex*)src->arr.data;
+    AT(vertices[0].glyph[2] == strlen(strings[0]));
+    AT(vertices[src->arr.item_count - 1].pos[1] == -.5f);
+
+    SCREENSHOT("text")
+    END;
+}
+
+
+
 int test_visuals_line(TestContext* context)
 {
     INIT;
@@ -601,6 +679,160 @@ int test_visuals_path(TestContext* context)
 
 
 
+static void _path_data(DvzVisual* visual, uint32_t n_paths, uint32_t n_points)
+{
+    ASSERT(visual != NULL);
+    const uint32_t N = n_paths * n_points;
+    dvec3* points = calloc(N, sizeof(dvec3));
+    cvec4* colors = calloc(N, sizeof(cvec4));
+    uint32_t* path_lengths = calloc(n_paths, sizeof(uint32_t));
+    int32_t* topology = calloc(n_paths, sizeof(int32_t));
+
+    uint32_t k = 0;
+    double t = 0;
+    for (uint32_t i = 0; i < n_paths; i++)
+    {
+        for (uint32_t j = 0; j < n_points; j++)
+        {
+            t = M_2PI * j / (float)n_points;
+            points[k][0] = .25 * (i + 1) * cos(t);
+            points[k][1] = .25 * (i + 1) * sin(t);
+            dvz_colormap_scale(DVZ_CMAP_HSV, j, 0, n_points - 1, colors[k]);
+            k++;
+        }
+        path_lengths[i] = n_points;
+        topology[i] = i % 2 == 0 ? DVZ_PATH_CLOSED : DVZ_PATH_OPEN;
+    }
+
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, points);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, N, colors);
+    dvz_visual_data(visual, DVZ_PROP_LENGTH, 0, n_paths, path_lengths);
+    dvz_visual_data(visual, DVZ_PROP_TOPOLOGY, 0, n_paths, topology);
+    dvz_visual_data(visual, DVZ_PROP_LINE_WIDTH, 0, 1, (float[]){10});
+
+    FREE(points);
+    FREE(colors);
+    FREE(path_lengths);
+    FREE(topology);
+}
+
+int test_visuals_path_gpu(TestContext* context)
+{
+    INIT;
+
+    const uint32_t n_paths = 3;
+    const uint32_t n_points = 1000;
+    const uint32_t N = n_paths * n_points;
+
+    // Reference path visual, baked on the CPU.
+    DvzVisual visual_cpu = dvz_visual(canvas);
+    dvz_visual_builtin(&visual_cpu, DVZ_VISUAL_PATH, DVZ_PATH_FLAGS_CPU_BAKE);
+    _path_data(&visual_cpu, n_paths, n_points);
+    dvz_visual_data(&visual_cpu, DVZ_PROP_MODEL, 0, 1, MAT4_ID);
+    dvz_visual_data(&visual_cpu, DVZ_PROP_VIEW, 0, 1, MAT4_ID);
+    dvz_visual_data(&visual_cpu, DVZ_PROP_PROJ, 0, 1, MAT4_ID);
+    dvz_visual_data(&visual_cpu, DVZ_PROP_TIME, 0, 1, &zero);
+    dvz_visual_bake(&visual_cpu, canvas->viewport, (DvzDataCoords){0}, NULL);
+
+    // Same path visual, baked on the GPU.
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_PATH, DVZ_PATH_FLAGS_GPU_BAKE);
+    _path_data(&visual, n_paths, n_points);
+    _common_data(&visual);
+
+    DvzSource* src_cpu = dvz_source_get(&visual_cpu, DVZ_SOURCE_TYPE_VERTEX, 0);
+    DvzSource* src = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT((src_cpu->flags & DVZ_SOURCE_FLAG_GPU_BAKE) == 0);
+    AT((src->flags & DVZ_SOURCE_FLAG_GPU_BAKE) != 0);
+    AT(src_cpu->arr.item_count == 4 * N);
+    AT(src->arr.item_count == 4 * N);
+    AT(visual.compute_count == 1);
+
+    // Compare the vertex buffer filled by the compute shader with the CPU bake.
+    VkDeviceSize size = 4 * N * sizeof(DvzGraphicsPathVertex);
+    DvzGraphicsPathVertex* vertices = calloc(4 * N, sizeof(DvzGraphicsPathVertex));
+    dvz_download_buffers(canvas, src->u.br, 0, size, vertices);
+    AT(memcmp(vertices, src_cpu->arr.data, size) == 0);
+    FREE(vertices);
+
+    dvz_event_callback(canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _resize, NULL);
+    dvz_app_run(app, N_FRAMES);
+    dvz_visual_destroy(&visual_cpu);
+    END;
+}
+
+
+
+int test_visuals_path_lod(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_PATH, DVZ_PATH_FLAGS_CPU_BAKE);
+
+    // Single path, the color of each point encodes its index.
+    const uint32_t N = 20000;
+    dvec3* points = calloc(N, sizeof(dvec3));
+    cvec4* colors = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        points[i][0] = -1 + 2 * i / (double)(N - 1);
+        points[i][1] = .5 * sin(M_2PI * 10 * points[i][0]);
+        colors[i][0] = i % 256;
+        colors[i][1] = i / 256;
+        colors[i][3] = 255;
+    }
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, points);
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, N, colors);
+    dvz_visual_data(&visual, DVZ_PROP_LENGTH, 0, 1, &N);
+    dvz_visual_data(&visual, DVZ_PROP_LINE_WIDTH, 0, 1, (float[]){5});
+    _common_data(&visual);
+
+    // Whole path on 100 pixel columns.
+    visual.lod = (DvzLod*)calloc(1, sizeof(DvzLod));
+    visual.lod->range[0] = -1;
+    visual.lod->range[1] = +1;
+    visual.lod->width = 100;
+    dvz_visual_bake(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+
+    DvzProp* prop_pos = dvz_prop_get(&visual, DVZ_PROP_POS, 0);
+    DvzProp* prop_color = dvz_prop_get(&visual, DVZ_PROP_COLOR, 0);
+    DvzSource* src = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    uint32_t n = prop_pos->arr_staging.item_count;
+    AT(0 < n && n < N / 10);
+    AT(prop_color->arr_staging.item_count == n);
+    AT(src->arr.item_count == 4 * n);
+
+    // Each vertex has the color of the decimated sample it belongs to.
+    DvzGraphicsPathVertex* vertices = (DvzGraphicsPathVertex*)src->arr.data;
+    uint32_t k = 0;
+    for (uint32_t j = 0; j < 4 * n; j++)
+    {
+        k = vertices[j].color[0] + 256 * vertices[j].color[1];
+        AT(k < N);
+        AT(vertices[j].p1[0] == (float)points[k][0]);
+    }
+    k = vertices[0].color[0] + 256 * vertices[0].color[1];
+    AT(k == 0);
+    k = vertices[4 * n - 1].color[0] + 256 * vertices[4 * n - 1].color[1];
+    AT(k == N - 1);
+
+    // A single color is not decimated.
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, 1, (cvec4){255, 0, 0, 255});
+    dvz_visual_bake(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(prop_color->arr_staging.item_count == 0);
+    AT(src->arr.item_count == 4 * n);
+    AT(vertices[4 * n - 1].color[0] == 255);
+    AT(vertices[4 * n - 1].color[1] == 0);
+
+    FREE(points);
+    FREE(colors);
+    RUN;
+    END;
+}
+
+
+
 /*************************************************************************************************/
 /* Polygon visual tests                                                                          */
 /*************************************************************************************************/
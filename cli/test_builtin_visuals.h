@@ -26,9 +26,13 @@ int test_visuals_triangle_fan(TestContext* context);
 
 // 2D visuals.
 int test_visuals_marker(TestContext* context);
+int test_visuals_segment(TestContext* context);
+int test_visuals_text(TestContext* context);
 int test_visuals_axes_2D_1(TestContext* context);
 int test_visuals_axes_2D_update(TestContext* context);
 int test_visuals_path(TestContext* context);
+int test_visuals_path_gpu(TestContext* context);
+int test_visuals_path_lod(TestContext* context);
 int test_visuals_polygon(TestContext* context);
 int test_visuals_image_1(TestContext* context);
 int test_visuals_image_cmap(TestContext* context);
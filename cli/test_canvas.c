@@ -2,6 +2,7 @@
 #include "../include/datoviz/canvas.h"
 #include "../include/datoviz/context.h"
 #include "../include/datoviz/controls.h"
+#include "../include/datoviz/scene.h"
 #include "../src/vklite_utils.h"
 #include "utils.h"
 
@@ -870,6 +871,74 @@ int test_canvas_pick(TestContext* context)
 
 
 
+static void _pick_async_frame(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    if (ev.u.f.idx != 1)
+        return;
+
+    // Batched async picking: two points, and a 10x5 rectangle.
+    uvec2 points[2] = {{TEST_WIDTH / 2, TEST_HEIGHT / 2}, {0, 0}};
+    dvz_canvas_pick_points(canvas, 2, (const uvec2*)points, NULL);
+    dvz_canvas_pick_rect(canvas, (uvec2){10, 10}, (uvec2){19, 14}, NULL);
+}
+
+static void _pick_async_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    uint32_t* counts = (uint32_t*)ev.user_data;
+    ASSERT(counts != NULL);
+    ASSERT(ev.u.p.values != NULL);
+
+    ivec4* v = ev.u.p.values;
+    log_info(
+        "async pick #%d: %d value(s), first is %d %d %d %d", ev.u.p.idx, ev.u.p.count, v[0][0],
+        v[0][1], v[0][2], v[0][3]);
+    counts[ev.u.p.type] = ev.u.p.count;
+}
+
+int test_canvas_pick_async(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, DVZ_CANVAS_FLAGS_PICK);
+    AT(canvas != NULL);
+
+    TestVisual visual = {0};
+    visual.gpu = canvas->gpu;
+    visual.n_vertices = 3;
+    visual.renderpass = &canvas->renderpass;
+    visual.framebuffers = &canvas->framebuffers;
+
+    _triangle_graphics(&visual, "_pick");
+    visual.bindings = dvz_bindings(&visual.graphics.slots, 1);
+    dvz_bindings_update(&visual.bindings);
+    dvz_graphics_pick(&visual.graphics, true);
+    dvz_graphics_create(&visual.graphics);
+    _triangle_buffer(&visual);
+
+    // Number of picked values, for each pick type.
+    uint32_t counts[3] = {0};
+
+    dvz_event_callback(
+        canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _triangle_refill, &visual);
+    dvz_event_callback(
+        canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _pick_async_frame, &visual);
+    dvz_event_callback(
+        canvas, DVZ_EVENT_PICK, 0, DVZ_EVENT_MODE_SYNC, _pick_async_callback, counts);
+
+    dvz_app_run(app, 10);
+
+    AT(counts[DVZ_PICK_POINTS] == 2);
+    AT(counts[DVZ_PICK_RECT] == 10 * 5);
+
+    dvz_graphics_destroy(&visual.graphics);
+    destroy_visual(&visual);
+    TEST_END
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas triangle with vertex buffer update                                                    */
 /*************************************************************************************************/
@@ -1230,6 +1299,222 @@ int test_canvas_offscreen(TestContext* context)
 
 
 
+/*************************************************************************************************/
+/*  Canvas batch rendering                                                                       */
+/*************************************************************************************************/
+
+#define BATCH_IMAGE_COUNT 64
+
+int test_canvas_batch(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    AT(canvas != NULL);
+
+    TestVisual visual = {0};
+    visual.gpu = canvas->gpu;
+    visual.n_vertices = 3;
+    visual.renderpass = &canvas->renderpass;
+    visual.framebuffers = &canvas->framebuffers;
+
+    _triangle_graphics(&visual, "");
+    visual.bindings = dvz_bindings(&visual.graphics.slots, 1);
+    dvz_bindings_update(&visual.bindings);
+    dvz_graphics_create(&visual.graphics);
+    _triangle_buffer(&visual);
+
+    dvz_event_callback(
+        canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _triangle_refill, &visual);
+
+    char path[1024];
+    DvzClock clock = {0};
+    const uint32_t n_sync = BATCH_IMAGE_COUNT / 8;
+
+    // Baseline: one frame and one synchronous screenshot per image.
+    _clock_init(&clock);
+    for (uint32_t i = 0; i < n_sync; i++)
+    {
+        dvz_app_run(app, 1);
+        snprintf(path, sizeof(path), "%s/batch_sync_%03d.png", ARTIFACTS_DIR, i);
+        dvz_screenshot_file(canvas, path);
+    }
+    double dur_sync = _clock_get(&clock);
+
+    // Batch rendering.
+    dvz_batch(canvas, 0);
+    AT(canvas->batch != NULL);
+    _clock_init(&clock);
+    for (uint32_t i = 0; i < BATCH_IMAGE_COUNT; i++)
+    {
+        snprintf(path, sizeof(path), "%s/batch_%03d.png", ARTIFACTS_DIR, i);
+        AT(dvz_batch_render(canvas, path) == i);
+    }
+    dvz_batch_flush(canvas);
+    double dur_batch = _clock_get(&clock);
+    AT(atomic_load(&canvas->batch->written) == BATCH_IMAGE_COUNT);
+
+    log_info(
+        "%dx%d offscreen rendering: %.1f images/s with screenshots, %.1f images/s in batch mode "
+        "with %d PNG worker(s)",
+        TEST_WIDTH, TEST_HEIGHT, n_sync / dur_sync, BATCH_IMAGE_COUNT / dur_batch,
+        canvas->batch->worker_count);
+
+    dvz_batch_destroy(canvas);
+    AT(canvas->batch == NULL);
+
+    dvz_graphics_destroy(&visual.graphics);
+    destroy_visual(&visual);
+    TEST_END
+}
+
+
+
+/*************************************************************************************************/
+/*  Canvas threaded rendering                                                                    */
+/*************************************************************************************************/
+
+#define THREADED_CANVAS_COUNT 3
+#define THREADED_FRAME_COUNT  10
+
+int test_canvas_threaded(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu_best(app);
+
+    DvzCanvas* canvases[THREADED_CANVAS_COUNT] = {0};
+    for (uint32_t i = 0; i < THREADED_CANVAS_COUNT; i++)
+    {
+        canvases[i] = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+        AT(canvases[i] != NULL);
+        dvz_canvas_clear_color(canvases[i], i / (float)THREADED_CANVAS_COUNT, 0, 1);
+    }
+
+    dvz_app_run_threaded(app, THREADED_FRAME_COUNT);
+
+    for (uint32_t i = 0; i < THREADED_CANVAS_COUNT; i++)
+    {
+        AT(canvases[i]->frame_idx == THREADED_FRAME_COUNT);
+        AT(!canvases[i]->threaded);
+    }
+
+    // The canvases can still be used with the serial event loop afterwards.
+    dvz_app_run(app, 2);
+    AT(canvases[0]->frame_idx == THREADED_FRAME_COUNT + 2);
+
+    TEST_END
+}
+
+
+
+/*************************************************************************************************/
+/*  Canvas frame timing                                                                          */
+/*************************************************************************************************/
+
+#define TIMING_FRAME_COUNT 20
+
+int test_canvas_timing(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    AT(canvas != NULL);
+
+    dvz_app_run(app, TIMING_FRAME_COUNT);
+    AT(canvas->timing.frame_count == TIMING_FRAME_COUNT);
+
+    DvzFrameStats stats = {0};
+    uint64_t hist_count = 0;
+    for (uint32_t phase = 0; phase < DVZ_FRAME_PHASE_COUNT; phase++)
+    {
+        stats = dvz_canvas_timing_stats(canvas, (DvzFramePhase)phase);
+        AT(stats.count == TIMING_FRAME_COUNT);
+        AT(stats.p50 <= stats.p95);
+        AT(stats.p95 <= stats.p99);
+        AT(stats.p99 <= stats.max);
+
+        hist_count = 0;
+        for (uint32_t i = 0; i < DVZ_TIMING_HIST_BINS; i++)
+            hist_count += canvas->timing.hist[phase][i];
+        AT(hist_count == TIMING_FRAME_COUNT);
+    }
+    stats = dvz_canvas_timing_stats(canvas, DVZ_FRAME_PHASE_TOTAL);
+    AT(stats.p50 > 0);
+    log_info(
+        "frame time: p50 %.3f ms, p95 %.3f ms, p99 %.3f ms", //
+        1000 * stats.p50, 1000 * stats.p95, 1000 * stats.p99);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/frame_timing.csv", ARTIFACTS_DIR);
+    AT(dvz_canvas_timing_csv(canvas, path) == 0);
+
+    dvz_canvas_timing_reset(canvas);
+    AT(dvz_canvas_timing_stats(canvas, DVZ_FRAME_PHASE_TOTAL).count == 0);
+
+    TEST_END
+}
+
+
+
+/*************************************************************************************************/
+/*  Canvas tiled export                                                                          */
+/*************************************************************************************************/
+
+int test_canvas_tiled(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    AT(canvas != NULL);
+    dvz_canvas_clear_color(canvas, 0, 0, 0);
+
+    // A point at the center of a panel covering the full image.
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_NONE, 0);
+    DvzVisual* visual =
+        dvz_scene_visual(panel, DVZ_VISUAL_POINT, DVZ_VISUAL_FLAGS_TRANSFORM_NONE);
+    dvec3 pos = {0, 0, 0};
+    cvec4 color = {255, 0, 0, 255};
+    float size = 20;
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, 1, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, 1, color);
+    dvz_visual_data(visual, DVZ_PROP_MARKER_SIZE, 0, 1, &size);
+    dvz_app_run(app, 3);
+
+    // Image with 3x2 tiles, the last column and row of tiles are cropped. The panel viewport
+    // starts before every tile but the first one, and is larger than the framebuffer.
+    uint32_t width = 5 * TEST_WIDTH / 2;
+    uint32_t height = 3 * TEST_HEIGHT / 2;
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/tiled.ppm", ARTIFACTS_DIR);
+    AT(dvz_screenshot_tiled(canvas, path, width, height) == 0);
+    AT(canvas->tiling == NULL);
+
+    int w = 0, h = 0;
+    uint8_t* rgb = dvz_read_ppm(path, &w, &h);
+    AT(rgb != NULL);
+    AT(w == (int)width);
+    AT(h == (int)height);
+
+    // The point is at the center of the full image, in the second tile, and its size in pixels
+    // does not depend on the tiling.
+    uint8_t* center = &rgb[3 * ((height / 2) * width + width / 2)];
+    AT(center[0] > 128);
+    AT(center[1] < 64);
+    uint8_t* beside = &rgb[3 * ((height / 2) * width + width / 2 + 2 * (uint32_t)size)];
+    AT(beside[0] == 0);
+
+    // Nothing at the center of the first tile.
+    uint8_t* tile = &rgb[3 * ((TEST_HEIGHT / 2) * width + TEST_WIDTH / 2)];
+    AT(tile[0] == 0);
+    FREE(rgb);
+
+    dvz_scene_destroy(scene);
+    TEST_END
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas GUI                                                                                   */
 /*************************************************************************************************/
@@ -24,7 +24,12 @@ int test_canvas_depth(TestContext* context);
 int test_canvas_append(TestContext* context);
 int test_canvas_particles(TestContext* context);
 int test_canvas_pick(TestContext* context);
+int test_canvas_pick_async(TestContext* context);
 int test_canvas_offscreen(TestContext* context);
+int test_canvas_batch(TestContext* context);
+int test_canvas_threaded(TestContext* context);
+int test_canvas_timing(TestContext* context);
+int test_canvas_tiled(TestContext* context);
 int test_canvas_gui_1(TestContext* context);
 int test_canvas_screencast(TestContext* context);
 
@@ -232,3 +232,66 @@ int test_fifo_3(TestContext* context)
     dvz_fifo_destroy(&fifo);
     return 0;
 }
+
+
+
+/*************************************************************************************************/
+/*  Task pool                                                                                    */
+/*************************************************************************************************/
+
+static DvzTaskPool* _test_pool;
+static atomic(uint64_t, _test_sum);
+
+static void _task_add(void* user_data)
+{
+    atomic_fetch_add(&_test_sum, (uint64_t)(*(uint32_t*)user_data));
+}
+
+static void _task_range_add(void* user_data, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < first + count; i++)
+        atomic_fetch_add(&_test_sum, (uint64_t)i);
+}
+
+static void _task_nested(void* user_data)
+{
+    // Tasks can wait for other tasks.
+    dvz_task_range(_test_pool, 1000, 10, _task_range_add, NULL);
+}
+
+int test_task_pool(TestContext* context)
+{
+    uint32_t numbers[1024] = {0};
+    for (uint32_t i = 0; i < 1024; i++)
+        numbers[i] = i;
+
+    // Without a pool, the chunks run on the calling thread.
+    atomic_store(&_test_sum, 0);
+    dvz_task_range(NULL, 1000, 10, _task_range_add, NULL);
+    AT(atomic_load(&_test_sum) == 999 * 1000 / 2);
+
+    for (uint32_t worker_count = 1; worker_count <= 4; worker_count += 3)
+    {
+        _test_pool = dvz_task_pool(worker_count);
+        AT(dvz_task_pool_threads(_test_pool) == worker_count + 1);
+
+        // More tasks than the initial queue capacity.
+        DvzTaskGroup group = {0};
+        atomic_store(&_test_sum, 0);
+        for (uint32_t i = 0; i < 1024; i++)
+            dvz_task_enqueue(_test_pool, &group, _task_add, &numbers[i]);
+        dvz_task_wait(_test_pool, &group);
+        AT(group.pending == 0);
+        AT(atomic_load(&_test_sum) == 1023 * 1024 / 2);
+
+        // Nested waits.
+        atomic_store(&_test_sum, 0);
+        for (uint32_t i = 0; i < 16; i++)
+            dvz_task_enqueue(_test_pool, &group, _task_nested, NULL);
+        dvz_task_wait(_test_pool, &group);
+        AT(atomic_load(&_test_sum) == 16 * 999 * 1000 / 2);
+
+        dvz_task_pool_destroy(_test_pool);
+    }
+    return 0;
+}
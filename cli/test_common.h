@@ -24,4 +24,12 @@ int test_fifo_3(TestContext* context);
 
 
 
+/*************************************************************************************************/
+/*  Task pool                                                                                    */
+/*************************************************************************************************/
+
+int test_task_pool(TestContext* context);
+
+
+
 #endif
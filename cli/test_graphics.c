@@ -77,7 +77,11 @@ static void _graphics_refill(DvzCanvas* canvas, DvzEvent ev)
         else
         {
             log_debug("draw non-indexed %d", tg->vertices.item_count);
-            dvz_cmd_draw(cmds, idx, 0, tg->vertices.item_count);
+            if (graphics->instance_vertex_count > 0)
+                dvz_cmd_draw_instanced(
+                    cmds, idx, 0, graphics->instance_vertex_count, 0, tg->vertices.item_count);
+            else
+                dvz_cmd_draw(cmds, idx, 0, tg->vertices.item_count);
         }
     }
     dvz_cmd_end_renderpass(cmds, idx);
@@ -647,16 +651,12 @@ static void _resize(DvzCanvas* canvas, DvzEvent ev)
     dvz_upload_buffers(canvas, tg->br_viewport, 0, sizeof(DvzViewport), &canvas->viewport);
 }
 
-int test_graphics_segment(TestContext* context)
+static void _segment_data(DvzGraphicsData* data, uint32_t n)
 {
-    INIT_GRAPHICS(DVZ_GRAPHICS_SEGMENT, 0)
-    const uint32_t N = 16;
-    BEGIN_DATA(DvzGraphicsSegmentVertex, 4 * N, NULL)
-
     DvzGraphicsSegmentVertex vertex = {0};
-    for (uint32_t i = 0; i < N; i++)
+    for (uint32_t i = 0; i < n; i++)
     {
-        float t = (float)i / (float)N;
+        float t = (float)i / (float)n;
         float x = .75 * (-1 + 2 * t);
         float y = .75;
         vertex.P0[0] = vertex.P1[0] = x;
@@ -665,8 +665,16 @@ int test_graphics_segment(TestContext* context)
         vertex.linewidth = 5 + 30 * t;
         dvz_colormap_scale(DVZ_CMAP_RAINBOW, t, 0, 1, vertex.color);
         vertex.cap0 = vertex.cap1 = i % DVZ_CAP_COUNT;
-        dvz_graphics_append(&data, &vertex);
+        dvz_graphics_append(data, &vertex);
     }
+}
+
+int test_graphics_segment(TestContext* context)
+{
+    INIT_GRAPHICS(DVZ_GRAPHICS_SEGMENT, 0)
+    const uint32_t N = 16;
+    BEGIN_DATA(DvzGraphicsSegmentVertex, 4 * N, NULL)
+    _segment_data(&data, N);
     END_DATA
     BINDINGS_NO_PARAMS
     dvz_event_callback(canvas, DVZ_EVENT_RESIZE, 0, DVZ_EVENT_MODE_SYNC, _resize, &tg);
@@ -675,6 +683,73 @@ int test_graphics_segment(TestContext* context)
     TEST_END
 }
 
+int test_graphics_segment_instanced(TestContext* context)
+{
+    INIT_GRAPHICS(DVZ_GRAPHICS_SEGMENT, DVZ_GRAPHICS_FLAGS_INSTANCED)
+    const uint32_t N = 16;
+    BEGIN_DATA(DvzGraphicsSegmentVertex, N, NULL)
+    // One vertex per segment, and no index buffer.
+    AT(graphics->instance_vertex_count == 4);
+    AT(vertex_count == N);
+    AT(index_count == 0);
+    _segment_data(&data, N);
+    END_DATA
+    BINDINGS_NO_PARAMS
+    dvz_event_callback(canvas, DVZ_EVENT_RESIZE, 0, DVZ_EVENT_MODE_SYNC, _resize, &tg);
+    RUN;
+    SCREENSHOT("segment_instanced")
+    TEST_END
+}
+
+// Compare the upload size and the frame time of n small random segments, with the default
+// layout (4 vertices and 6 indices per segment) and with the instanced layout.
+static int _segment_bench(int flags, uint32_t n, uint32_t n_frames)
+{
+    INIT_GRAPHICS(DVZ_GRAPHICS_SEGMENT, flags)
+    double t0 = _clock_now();
+    BEGIN_DATA(DvzGraphicsSegmentVertex, n, NULL)
+    DvzGraphicsSegmentVertex vertex = {0};
+    vertex.linewidth = 2;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        vertex.P0[0] = -1 + 2 * dvz_rand_float();
+        vertex.P0[1] = -1 + 2 * dvz_rand_float();
+        vertex.P1[0] = vertex.P0[0] + .01;
+        vertex.P1[1] = vertex.P0[1] + .01;
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, i, 0, n, vertex.color);
+        dvz_graphics_append(&data, &vertex);
+    }
+    double t1 = _clock_now();
+    END_DATA
+    BINDINGS_NO_PARAMS
+    dvz_event_callback(canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _graphics_refill, &tg);
+
+    // The first frames upload the data and record the command buffers.
+    dvz_app_run(app, 3);
+    double t2 = _clock_now();
+    dvz_app_run(app, n_frames);
+    double t3 = _clock_now();
+
+    VkDeviceSize size = vertex_count * tg.vertices.item_size + index_count * tg.indices.item_size;
+    log_info(
+        "%d segments, %-9s %8.1f MB, bake %7.1f ms, frame %6.2f ms", n,
+        flags != 0 ? "instanced" : "default", size / (1024. * 1024.), (t1 - t0) * 1000,
+        (t3 - t2) * 1000 / n_frames);
+
+    dvz_array_destroy(&tg.vertices);
+    dvz_array_destroy(&tg.indices);
+    return dvz_app_destroy(app);
+}
+
+int test_graphics_segment_bench(TestContext* context)
+{
+    const uint32_t n = 1000000;
+    const uint32_t n_frames = 100;
+    AT(_segment_bench(0, n, n_frames) == 0);
+    AT(_segment_bench(DVZ_GRAPHICS_FLAGS_INSTANCED, n, n_frames) == 0);
+    return 0;
+}
+
 
 
 /*************************************************************************************************/
@@ -747,9 +822,9 @@ int test_graphics_path(TestContext* context)
 /*  Text tests                                                                                   */
 /*************************************************************************************************/
 
-int test_graphics_text(TestContext* context)
+static int _graphics_text(int flags, const char* name)
 {
-    INIT_GRAPHICS(DVZ_GRAPHICS_TEXT, 0)
+    INIT_GRAPHICS(DVZ_GRAPHICS_TEXT, flags)
     const uint32_t N = 26;
     const char str[] = "Hello world!";
     const uint32_t offset = strlen(str);
@@ -814,10 +889,17 @@ int test_graphics_text(TestContext* context)
     dvz_event_callback(canvas, DVZ_EVENT_RESIZE, 0, DVZ_EVENT_MODE_SYNC, _resize, &tg);
 
     RUN;
-    SCREENSHOT("text")
+    SCREENSHOT(name)
     TEST_END
 }
 
+int test_graphics_text(TestContext* context) { return _graphics_text(0, "text"); }
+
+int test_graphics_text_instanced(TestContext* context)
+{
+    return _graphics_text(DVZ_GRAPHICS_FLAGS_INSTANCED, "text_instanced");
+}
+
 
 
 /*************************************************************************************************/
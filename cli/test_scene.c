@@ -2,6 +2,7 @@
 #include "../external/video.h"
 #include "../include/datoviz/builtin_visuals.h"
 #include "../include/datoviz/scene.h"
+#include "../src/snapshot_utils.h"
 #include "../src/ticks.h"
 #include "utils.h"
 
@@ -108,6 +109,96 @@ int test_axes_3(TestContext* context)
 
 
 
+int test_axes_bench(TestContext* context)
+{
+    DvzAxesContext ctx = {0};
+    ctx.coord = DVZ_AXES_COORD_X;
+    ctx.size_viewport = 1000;
+    ctx.size_glyph = 10;
+    ctx.extensions = 1;
+
+    // Random ranges at various scales.
+    const uint32_t n = 200;
+    const uint32_t n_iter = 100;
+    dvec2* ranges = calloc(n, sizeof(dvec2));
+    double scale = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        scale = pow(10, -3 + 6 * dvz_rand_float());
+        ranges[i][0] = scale * dvz_rand_normal();
+        ranges[i][1] = ranges[i][0] + scale * (.1 + dvz_rand_float());
+    }
+
+    // Full extended Wilkinson search.
+    DvzAxesTicks ticks = {0};
+    double t0 = _clock_now();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ticks = dvz_ticks(ranges[i][0], ranges[i][1], ctx);
+        dvz_ticks_destroy(&ticks);
+    }
+    double t1 = _clock_now();
+
+    // Cache hits on the last ranges.
+    DvzAxesTicksCache cache = {0};
+    DvzAxesTicksKey key = {0};
+    DvzAxesTicks ref[DVZ_TICKS_CACHE_SIZE] = {0};
+    for (uint32_t i = 0; i < DVZ_TICKS_CACHE_SIZE; i++)
+    {
+        ref[i] = dvz_ticks(ranges[i][0], ranges[i][1], ctx);
+        AT(_ticks_key(ranges[i][0], ranges[i][1], &ctx, &key));
+        _ticks_cache_put(&cache, &key, &ref[i]);
+    }
+    AT(cache.count == DVZ_TICKS_CACHE_SIZE);
+    double t2 = _clock_now();
+    for (uint32_t k = 0; k < n_iter; k++)
+    {
+        for (uint32_t i = 0; i < DVZ_TICKS_CACHE_SIZE; i++)
+        {
+            AT(_ticks_key(ranges[i][0], ranges[i][1], &ctx, &key));
+            AT(_ticks_cache_get(&cache, &key, &ticks));
+            AT(ticks.value_count == ref[i].value_count);
+            AT(ticks.lstep == ref[i].lstep);
+            dvz_ticks_destroy(&ticks);
+        }
+    }
+    double t3 = _clock_now();
+
+    // A zoomed range does not hit the cache.
+    double d = ranges[0][1] - ranges[0][0];
+    AT(_ticks_key(ranges[0][0], ranges[0][1] + d, &ctx, &key));
+    AT(!_ticks_cache_get(&cache, &key, &ticks));
+
+    // Pure pans shift the ticks.
+    ticks = dvz_ticks(-1, 1, ctx);
+    double lstep = ticks.lstep;
+    double x = 0;
+    double t4 = _clock_now();
+    for (uint32_t i = 0; i < n * n_iter; i++)
+    {
+        x = -1 + .1 * i;
+        AT(_ticks_shift(&ticks, x, x + 2, &ctx));
+    }
+    double t5 = _clock_now();
+    AT(ticks.lstep == lstep);
+    AT(ticks.lmin_in < x && x + 2 < ticks.lmax_in);
+    AT(!duplicate_labels(&ticks, &ctx));
+    dvz_ticks_destroy(&ticks);
+
+    log_info(
+        "ticks: search %.1f us, cache hit %.2f us, pan shift %.2f us", //
+        1e6 * (t1 - t0) / n, 1e6 * (t3 - t2) / (n_iter * DVZ_TICKS_CACHE_SIZE),
+        1e6 * (t5 - t4) / (n * n_iter));
+
+    for (uint32_t i = 0; i < DVZ_TICKS_CACHE_SIZE; i++)
+        dvz_ticks_destroy(&ref[i]);
+    _ticks_cache_destroy(&cache);
+    FREE(ranges);
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Scene tests                                                                                  */
 /*************************************************************************************************/
@@ -390,6 +481,52 @@ int test_scene_axes(TestContext* context)
 
 
 
+int test_scene_axes_async(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_AXES_2D, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    for (uint32_t i = 0; i < N; i++)
+        RANDN_POS(pos[i])
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_app_run(app, 3);
+
+    DvzAxes2D* axes = &panel->controller->u.axes_2D;
+    DvzVisual* xaxis = panel->controller->visuals[DVZ_AXES_COORD_X];
+    double lstep = axes->ticks[DVZ_AXES_COORD_X].lstep;
+
+    // Zoom with the mouse wheel: the new ticks are computed and baked in the background, and
+    // swapped in at a later frame.
+    vec2 center = {TEST_WIDTH / 2, TEST_HEIGHT / 2};
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        dvz_event_mouse_wheel(canvas, center, (vec2){0, 2}, 0);
+        dvz_app_run(app, 1);
+    }
+    for (uint32_t i = 0; i < 100 && axes->ticks[DVZ_AXES_COORD_X].lstep == lstep; i++)
+        dvz_app_run(app, 1);
+    AT(axes->ticks[DVZ_AXES_COORD_X].lstep != lstep);
+
+    // The ticks, the props and the vertices of the axes visual are always consistent.
+    uint32_t n = axes->ticks[DVZ_AXES_COORD_X].value_count;
+    AT(dvz_prop_get(xaxis, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR)->arr_orig.item_count == n);
+    AT(dvz_prop_get(xaxis, DVZ_PROP_TEXT, 0)->arr_orig.item_count == n);
+    AT(dvz_source_get(xaxis, DVZ_SOURCE_TYPE_VERTEX, 0)->arr.item_count ==
+       2 * n + 4 * (n - 1) + 1);
+
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    TEST_END
+}
+
+
+
 static void _logistic(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
@@ -460,3 +597,443 @@ int test_scene_logistic(TestContext* context)
     dvz_scene_destroy(scene);
     TEST_END
 }
+
+
+
+int test_scene_transform_gpu(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+
+    // Visual data around zero.
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        RANDN_POS(pos[i])
+        pos[i][0] *= 10;
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_app_run(app, 3);
+
+    // The data is normalized by the GPU.
+    AT(visual->transform_gpu);
+    AT(prop->arr_trans.item_count == 0);
+    AT(visual->viewport.data_scale[3] == 1);
+    DvzBox box = panel->data_coords.box;
+    AC(visual->viewport.data_scale[0], (2 / (box.p1[0] - box.p0[0])), 1e-6);
+
+    // Data far from zero is normalized by the CPU, in double precision.
+    for (uint32_t i = 0; i < N; i++)
+        pos[i][0] += 1e9;
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_app_run(app, 3);
+    AT(!visual->transform_gpu);
+    AT(prop->arr_trans.item_count == N);
+    AT(visual->viewport.data_scale[3] == 0);
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    TEST_END
+}
+
+
+
+static DvzVisualDataCallback _bake_orig;
+static uint32_t _bake_count;
+
+static void _count_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+    _bake_count++;
+    _bake_orig(visual, ev);
+}
+
+int test_scene_updates(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_COLOR, 0);
+    _bake_orig = visual->callback_bake;
+    dvz_visual_callback_bake(visual, _count_bake);
+
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        RANDN_POS(pos[i])
+        RAND_COLOR(color[i])
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_app_run(app, 3);
+    AT(_bake_count >= 1);
+
+    // Several updates of the same visual in a frame are merged, and the visual is baked once,
+    // with the last data.
+    _bake_count = 0;
+    for (uint32_t k = 0; k < 3; k++)
+    {
+        for (uint32_t i = 0; i < N; i++)
+            color[i][3] = 100 + k;
+        dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+        dvz_visual_data(visual, DVZ_PROP_COLOR, 0, N, color);
+    }
+    dvz_app_run(app, 3);
+    AT(_bake_count == 1);
+    AT(((cvec4*)prop->arr_orig.data)[N - 1][3] == 102);
+
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
+int test_scene_culling(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    DvzVisual* right = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    DvzVisual* hidden = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    DvzVisual* strip = dvz_scene_visual(panel, DVZ_VISUAL_LINE_STRIP, 0);
+
+    // Two clusters of points, on the left and on the right of the panel.
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(2 * N, sizeof(dvec3));
+    for (uint32_t i = 0; i < 2 * N; i++)
+    {
+        pos[i][0] = (i < N ? 0 : 9) + dvz_rand_float();
+        pos[i][1] = dvz_rand_float();
+    }
+    // One group per cluster.
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, 2 * N, pos);
+    dvz_visual_group(visual, 0, N);
+    dvz_visual_group(visual, 1, N);
+    // The groups of a line strip share vertices and cannot be culled individually.
+    dvz_visual_data(strip, DVZ_PROP_POS, 0, 2 * N, pos);
+    dvz_visual_group(strip, 0, N);
+    dvz_visual_group(strip, 1, N);
+    // Right cluster only.
+    dvz_visual_data(right, DVZ_PROP_POS, 0, N, &pos[N]);
+    dvz_visual_data(hidden, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_visible(hidden, false);
+    dvz_app_run(app, 3);
+
+    // All data is in view.
+    AT(!visual->culled);
+    AT(visual->group_culled_count == 0);
+    AT(!right->culled);
+    AT(hidden->hidden);
+
+    // Zoom on the left cluster.
+    DvzMVP* mvp = &panel->controller->interacts[0].mvp;
+    glm_translate_make(mvp->view, (vec3){.9, 0, 0});
+    glm_ortho(-.2, .2, -1, 1, -10, 10, mvp->proj);
+    dvz_app_run(app, 3);
+
+    AT(!visual->culled);
+    AT(visual->group_culled_count == 1);
+    AT(!visual->group_culled[0]);
+    AT(visual->group_culled[1]);
+    AT(right->culled);
+    AT(!strip->culled);
+    AT(strip->group_culled_count == 0);
+
+    // Back to the initial view.
+    glm_mat4_identity(mvp->view);
+    glm_mat4_identity(mvp->proj);
+    dvz_visual_visible(hidden, true);
+    dvz_app_run(app, 3);
+
+    AT(!visual->culled);
+    AT(visual->group_culled_count == 0);
+    AT(!right->culled);
+    AT(!hidden->hidden);
+
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    TEST_END
+}
+
+
+
+int test_scene_batch(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+
+    // Several small point visuals, followed by a marker visual.
+    const uint32_t V = 4;
+    const uint32_t N = 100;
+    DvzVisual* visuals[4] = {0};
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t k = 0; k < V; k++)
+    {
+        visuals[k] = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+        for (uint32_t i = 0; i < N; i++)
+        {
+            pos[i][0] = -1 + .5 * k + .5 * dvz_rand_float();
+            pos[i][1] = -1 + 2 * dvz_rand_float();
+            dvz_colormap(DVZ_CMAP_HSV, k * 64, color[i]);
+            color[i][3] = 255;
+        }
+        dvz_visual_data(visuals[k], DVZ_PROP_POS, 0, N, pos);
+        dvz_visual_data(visuals[k], DVZ_PROP_COLOR, 0, N, color);
+    }
+    DvzVisual* marker = dvz_scene_visual(panel, DVZ_VISUAL_MARKER, 0);
+    dvz_visual_data(marker, DVZ_PROP_POS, 0, N, pos);
+    dvz_app_run(app, 3);
+
+    // The point visuals are drawn together.
+    AT(scene->batch_count == 1);
+    DvzDrawBatch* batch = visuals[0]->batch;
+    AT(batch != NULL);
+    AT(batch->visual_count == V);
+    AT(batch->vertex_count == V * N);
+    for (uint32_t k = 0; k < V; k++)
+    {
+        AT(visuals[k]->batch == batch);
+        AT(batch->first[k] == k * N);
+    }
+    AT(marker->batch == NULL);
+
+    // Changing the data of a visual updates the shared vertex buffer.
+    dvz_visual_data(visuals[1], DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_visible(visuals[2], false);
+    dvz_app_run(app, 3);
+    AT(visuals[1]->batch == batch);
+    AT(!visuals[1]->batch_changed);
+
+    // Changing the number of items rebuilds the batch.
+    dvz_visual_data(visuals[1], DVZ_PROP_POS, 0, N / 2, pos);
+    dvz_app_run(app, 3);
+    batch = visuals[0]->batch;
+    AT(batch != NULL);
+    AT(batch->visual_count == V);
+    AT(batch->vertex_count == V * N - N / 2);
+    AT(batch->first[2] == N + N / 2);
+    // The vertices of a batched visual are only uploaded to the shared vertex buffer.
+    AT(visuals[1]->batch_outdated);
+
+    // A visual leaving the batch is drawn from its own, updated, vertex buffer.
+    float param = 20.0f;
+    dvz_visual_data(visuals[1], DVZ_PROP_MARKER_SIZE, 0, 1, &param);
+    dvz_app_run(app, 3);
+    AT(visuals[1]->batch == NULL);
+    AT(!visuals[1]->batch_outdated);
+    DvzSource* source = dvz_source_get(visuals[1], DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(source->u.br.size >= source->arr.item_count * source->arr.item_size);
+    AT(source->dirty.count == 0);
+
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
+// Load a copy of a snapshot file with a 32-bit field overwritten.
+static DvzScene*
+_load_corrupted(DvzCanvas* canvas, const char* path, uint64_t offset, uint32_t value)
+{
+    size_t size = 0;
+    uint32_t* data = dvz_read_file(path, &size);
+    ASSERT(data != NULL);
+    ASSERT(offset + sizeof(uint32_t) <= size);
+    memcpy((char*)data + offset, &value, sizeof(uint32_t));
+
+    char corrupted[1024];
+    snprintf(corrupted, sizeof(corrupted), "%s/scene_corrupted.dvz", ARTIFACTS_DIR);
+    FILE* fp = fopen(corrupted, "wb");
+    ASSERT(fp != NULL);
+    fwrite(data, 1, size, fp);
+    fclose(fp);
+    FREE(data);
+    return dvz_scene_load(canvas, corrupted);
+}
+
+int test_scene_snapshot(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 2);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_AXES_2D, 0);
+    DvzPanel* panel_unbaked = dvz_scene_panel(scene, 0, 1, DVZ_CONTROLLER_PANZOOM, 0);
+
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        RANDN_POS(pos[i])
+        RAND_COLOR(color[i])
+    }
+    DvzVisual* marker = dvz_scene_visual(panel, DVZ_VISUAL_MARKER, 0);
+    dvz_visual_data(marker, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(marker, DVZ_PROP_COLOR, 0, N, color);
+    DvzVisual* point = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    dvz_visual_data(point, DVZ_PROP_POS, 0, N / 2, pos);
+    dvz_app_run(app, 3);
+
+    // A visual that has not been baked yet when the snapshot is saved.
+    DvzVisual* unbaked = dvz_scene_visual(panel_unbaked, DVZ_VISUAL_POINT, 0);
+    dvz_visual_data(unbaked, DVZ_PROP_POS, 0, N, pos);
+
+    uint32_t vertex_count = dvz_source_get(marker, DVZ_SOURCE_TYPE_VERTEX, 0)->arr.item_count;
+    DvzBox box = panel->data_coords.box;
+    AT(vertex_count > 0);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/scene.dvz", ARTIFACTS_DIR);
+    AT(dvz_scene_save(scene, path) == 0);
+    dvz_scene_destroy(scene);
+    dvz_app_destroy(app);
+
+    // Reload the snapshot in a new canvas.
+    app = dvz_app(DVZ_BACKEND_GLFW);
+    gpu = dvz_gpu_best(app);
+    canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    // Corrupted records are rejected.
+    uint64_t panels = sizeof(DvzSnapshotHeader);
+    uint64_t visuals = panels + 2 * sizeof(DvzSnapshotPanel);
+    AT(_load_corrupted(canvas, path, panels + offsetof(DvzSnapshotPanel, row), 1) == NULL);
+    AT(_load_corrupted(canvas, path, panels + offsetof(DvzSnapshotPanel, controller), 99) ==
+       NULL);
+    AT(_load_corrupted(
+           canvas, path, panels + sizeof(DvzSnapshotPanel) + offsetof(DvzSnapshotPanel, hspan),
+           2) == NULL);
+    AT(_load_corrupted(
+           canvas, path, visuals + offsetof(DvzSnapshotVisual, group_count),
+           DVZ_MAX_VISUAL_GROUPS + 1) == NULL);
+    AT(canvas->scene == NULL);
+
+    scene = dvz_scene_load(canvas, path);
+    AT(scene != NULL);
+    AT(scene->snapshot != NULL);
+    AT(dvz_scene_load(canvas, path) == NULL);
+
+    panel = dvz_container_get(&scene->grid.panels, 0);
+    panel_unbaked = dvz_container_get(&scene->grid.panels, 1);
+    AT(panel->controller->type == DVZ_CONTROLLER_AXES_2D);
+    AT(memcmp(&panel->data_coords.box, &box, sizeof(DvzBox)) == 0);
+
+    // The axes visuals are recreated with the panel, followed by the saved visuals.
+    AT(panel->visual_count == panel->controller->visual_count + 2);
+    marker = panel->visuals[panel->visual_count - 2];
+    point = panel->visuals[panel->visual_count - 1];
+    AT(marker->type == DVZ_VISUAL_MARKER);
+    AT(point->type == DVZ_VISUAL_POINT);
+    AT(dvz_prop_get(point, DVZ_PROP_POS, 0)->arr_orig.item_count == N / 2);
+
+    // The baked data references the mapping and has been uploaded without baking.
+    DvzArray* arr = &dvz_prop_get(marker, DVZ_PROP_POS, 0)->arr_orig;
+    AT(arr->item_count == N);
+    AT(arr->is_borrowed);
+    AT(memcmp(arr->data, pos, N * sizeof(dvec3)) == 0);
+    DvzSource* source = dvz_source_get(marker, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(source->arr.is_borrowed);
+    AT(source->arr.item_count == vertex_count);
+    AT(marker->obj.request == DVZ_VISUAL_REQUEST_SET);
+
+    // The visual that was not baked is baked after loading.
+    AT(panel_unbaked->visual_count == 1);
+    unbaked = panel_unbaked->visuals[0];
+    AT(unbaked->obj.request == DVZ_VISUAL_REQUEST_UPLOAD);
+
+    dvz_app_run(app, 3);
+    AT(memcmp(&panel->data_coords.box, &box, sizeof(DvzBox)) == 0);
+    AT(dvz_source_get(marker, DVZ_SOURCE_TYPE_VERTEX, 0)->arr.is_borrowed);
+    AT(unbaked->obj.request == DVZ_VISUAL_REQUEST_SET);
+    AT(dvz_source_get(unbaked, DVZ_SOURCE_TYPE_VERTEX, 0)->arr.item_count == N);
+
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
+int test_scene_panels(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    // A large grid of panels with a few points each.
+    const uint32_t R = 16;
+    const uint32_t C = 16;
+    const uint32_t N = 10;
+    DvzScene* scene = dvz_scene(canvas, R, C);
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = -1 + 2 * dvz_rand_float();
+        pos[i][1] = -1 + 2 * dvz_rand_float();
+    }
+    DvzPanel* panel = NULL;
+    DvzVisual* visual = NULL;
+    for (uint32_t i = 0; i < R; i++)
+    {
+        for (uint32_t j = 0; j < C; j++)
+        {
+            panel = dvz_scene_panel(scene, i, j, DVZ_CONTROLLER_PANZOOM, 0);
+            visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+            dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+        }
+    }
+    dvz_app_run(app, 3);
+
+    // All panel MVPs are packed in a single uniform buffer, at consecutive slots.
+    AT(scene->grid.mvp_block_count == 1);
+    DvzMVPBlock* block = &scene->grid.mvp_blocks[0];
+    AT(block->count == R * C);
+    for (uint32_t k = 0; k < R * C; k++)
+    {
+        panel = dvz_container_get(&scene->grid.panels, k);
+        AT(panel->mvp_block == 0);
+        AT(panel->mvp_slot == k);
+        AT(panel->br_mvp.buffer == block->br.buffer);
+        AT(panel->br_mvp.offsets[0] == block->br.offsets[0] + k * block->stride);
+    }
+
+    // The MVP of a panel is copied to its slot at the next frame.
+    panel = dvz_container_get(&scene->grid.panels, R * C - 1);
+    DvzMVP* mvp = &panel->controller->interacts[0].mvp;
+    glm_translate_make(mvp->view, (vec3){.5, 0, 0});
+    dvz_app_run(app, 3);
+    DvzMVP* packed = (DvzMVP*)((char*)block->data + panel->mvp_slot * block->stride);
+    AT(memcmp(packed, mvp, sizeof(DvzMVP)) == 0);
+
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    TEST_END
+}
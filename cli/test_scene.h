@@ -12,12 +12,20 @@
 int test_axes_1(TestContext* context);
 int test_axes_2(TestContext* context);
 int test_axes_3(TestContext* context);
+int test_axes_bench(TestContext* context);
 
 int test_scene_0(TestContext* context);
 int test_scene_1(TestContext* context);
 int test_scene_mesh(TestContext* context);
 int test_scene_axes(TestContext* context);
+int test_scene_axes_async(TestContext* context);
 int test_scene_logistic(TestContext* context);
+int test_scene_transform_gpu(TestContext* context);
+int test_scene_updates(TestContext* context);
+int test_scene_culling(TestContext* context);
+int test_scene_batch(TestContext* context);
+int test_scene_snapshot(TestContext* context);
+int test_scene_panels(TestContext* context);
 
 
 
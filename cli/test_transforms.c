@@ -1,5 +1,6 @@
 #include "test_transforms.h"
 #include "../include/datoviz/panel.h"
+#include "../include/datoviz/scene.h"
 #include "../include/datoviz/transforms.h"
 #include "../src/transforms_utils.h"
 
@@ -215,3 +216,66 @@ int test_transforms_5(TestContext* context)
 
     TEST_END
 }
+
+
+
+int test_transforms_origin(TestContext* context)
+{
+    const uint32_t n = 1000;
+
+    // Timestamps around 1.6e9 with a millisecond resolution, stored as float offsets relative to a
+    // double-precision origin.
+    dvec3 origin = {1.6e9, 0, 0};
+    DvzArray pos_in = dvz_array(n, DVZ_DTYPE_VEC3);
+    vec3* offsets = (vec3*)pos_in.data;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        offsets[i][0] = i * .001f;
+        offsets[i][1] = i;
+    }
+
+    // Bounding box.
+    DvzBox box = _box_bounding(&pos_in);
+    _box_translate(&box, origin);
+    AC(box.p0[0], 1.6e9, EPS);
+    AC(box.p1[0], (1.6e9 + (n - 1) * .001f), EPS);
+    AC(box.p1[1], (n - 1), EPS);
+
+    // Normalization in single precision, relative to the origin.
+    DvzDataCoords coords = {0};
+    coords.transform = DVZ_TRANSFORM_CARTESIAN;
+    coords.box = box;
+    DvzArray pos_out = dvz_array(n, DVZ_DTYPE_VEC3);
+    dvz_transform_pos_origin(coords, origin, &pos_in, &pos_out, false);
+    vec3* normalized = (vec3*)pos_out.data;
+    AC(normalized[0][0], (-1), 1e-5);
+    AC(normalized[n - 1][0], +1, 1e-5);
+    // Consecutive timestamps remain distinct after the normalization.
+    for (uint32_t i = 1; i < n; i++)
+        AT(normalized[i][0] > normalized[i - 1][0]);
+    AC(normalized[n / 2][1], normalized[n / 2][0], 1e-5);
+
+    // Visual storing its POS prop in single precision, relative to the origin.
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    dvz_visual_prop_origin(prop, origin);
+    AT(prop->dtype == DVZ_DTYPE_VEC3);
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, n, offsets);
+    dvz_app_run(app, 3);
+
+    // The panel box is in absolute data coordinates.
+    DvzBox* panel_box = &panel->data_coords.box;
+    AT(panel_box->p0[0] <= box.p0[0]);
+    AT(panel_box->p1[0] >= box.p1[0]);
+    AT(panel_box->p1[0] - panel_box->p0[0] < 10);
+
+    dvz_array_destroy(&pos_in);
+    dvz_array_destroy(&pos_out);
+    dvz_scene_destroy(scene);
+    TEST_END
+}
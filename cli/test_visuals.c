@@ -1,5 +1,8 @@
 #include "test_visuals.h"
 #include "../include/datoviz/visuals.h"
+#include "../src/lod_utils.h"
+#include "../src/spatial_utils.h"
+#include "../src/transforms_utils.h"
 #include "../src/visuals_utils.h"
 #include "utils.h"
 
@@ -366,3 +369,535 @@ int test_visuals_5(TestContext* context)
     dvz_visual_destroy(&visual);
     TEST_END
 }
+
+
+
+int test_visuals_partial(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzVisual visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+
+    // Vertex data.
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        RANDN_POS(pos[i])
+        color[i][3] = 255;
+    }
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, N, color);
+
+    // MVP.
+    mat4 id = GLM_MAT4_IDENTITY_INIT;
+    dvz_visual_data(&visual, DVZ_PROP_MODEL, 0, 1, id);
+    dvz_visual_data(&visual, DVZ_PROP_VIEW, 0, 1, id);
+    dvz_visual_data(&visual, DVZ_PROP_PROJ, 0, 1, id);
+    float param = 5.0f;
+    dvz_visual_data(&visual, DVZ_PROP_MARKER_SIZE, 0, 1, &param);
+    dvz_visual_data_source(&visual, DVZ_SOURCE_TYPE_VIEWPORT, 0, 0, 1, 1, &canvas->viewport);
+
+    DvzProp* prop = dvz_prop_get(&visual, DVZ_PROP_COLOR, 0);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(prop->dirty.count == DVZ_ITEM_RANGE_ALL);
+
+    // Full upload.
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(prop->dirty.count == 0);
+    AT(source->dirty.count == 0);
+    AT(source->arr.item_count == N);
+    void* source_data = source->arr.data;
+
+    // Partial updates of two subranges of the color prop.
+    cvec4 red = {255, 0, 0, 255};
+    dvz_visual_data_partial(&visual, DVZ_PROP_COLOR, 0, 100, 10, 1, red);
+    dvz_visual_data_partial(&visual, DVZ_PROP_COLOR, 0, 200, 10, 1, red);
+    AT(prop->arr_orig.item_count == N);
+    AT(prop->dirty.first == 100);
+    AT(prop->dirty.count == 110);
+
+    // Only the changed range is baked.
+    DvzVertex* vertices = source->arr.data;
+    vertices[0].color[0] = 12;
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.data == source_data);
+    AT(source->arr.item_count == N);
+    AT(prop->dirty.count == 0);
+    AT(vertices[0].color[0] == 12);
+    AT(vertices[99].color[0] == 0);
+    AT(vertices[100].color[0] == 255);
+    AT(vertices[209].color[0] == 255);
+    AT(vertices[210].color[0] == 0);
+
+    // Check the uploaded GPU data.
+    DvzVertex* downloaded = calloc(N, sizeof(DvzVertex));
+    dvz_download_buffers(canvas, source->u.br, 0, N * sizeof(DvzVertex), downloaded);
+    AT(downloaded[100].color[0] == 255);
+    AT(downloaded[150].color[0] == 255);
+    AT(downloaded[99].color[0] == 0);
+    AT(downloaded[210].color[0] == 0);
+    AT(downloaded[500].pos[0] == (float)pos[500][0]);
+
+    // Changing the number of items triggers a full bake.
+    dvz_visual_data_append(&visual, DVZ_PROP_COLOR, 0, 1, red);
+    AT(prop->dirty.count == DVZ_ITEM_RANGE_ALL);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.item_count == N + 1);
+    AT(((DvzVertex*)source->arr.data)[0].color[0] == 0);
+
+    dvz_visual_destroy(&visual);
+    FREE(pos);
+    FREE(color);
+    FREE(downloaded);
+    TEST_END
+}
+
+
+
+static void _release_count(DvzVisual* visual, void* data, void* user_data)
+{
+    ASSERT(user_data != NULL);
+    (*(int*)user_data)++;
+}
+
+int test_visuals_borrow(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzVisual visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+
+    // Vertex data.
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        RANDN_POS(pos[i])
+        color[i][0] = i % 256;
+        color[i][3] = 255;
+    }
+    int released = 0;
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data_borrow(&visual, DVZ_PROP_COLOR, 0, N, color, _release_count, &released);
+
+    // MVP.
+    mat4 id = GLM_MAT4_IDENTITY_INIT;
+    dvz_visual_data(&visual, DVZ_PROP_MODEL, 0, 1, id);
+    dvz_visual_data(&visual, DVZ_PROP_VIEW, 0, 1, id);
+    dvz_visual_data(&visual, DVZ_PROP_PROJ, 0, 1, id);
+    float param = 5.0f;
+    dvz_visual_data(&visual, DVZ_PROP_MARKER_SIZE, 0, 1, &param);
+    dvz_visual_data_source(&visual, DVZ_SOURCE_TYPE_VIEWPORT, 0, 0, 1, 1, &canvas->viewport);
+
+    // The prop references the caller memory.
+    DvzProp* prop = dvz_prop_get(&visual, DVZ_PROP_COLOR, 0);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(prop->arr_orig.is_borrowed);
+    AT(prop->arr_orig.data == color);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(((DvzVertex*)source->arr.data)[10].color[0] == 10);
+    AT(released == 0);
+
+    // A partial update makes a private copy and releases the caller memory.
+    cvec4 red = {255, 0, 0, 255};
+    dvz_visual_data_partial(&visual, DVZ_PROP_COLOR, 0, 10, 1, 1, red);
+    AT(released == 1);
+    AT(!prop->arr_orig.is_borrowed);
+    AT(prop->arr_orig.data != color);
+    AT(color[10][0] == 10);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(((DvzVertex*)source->arr.data)[10].color[0] == 255);
+
+    // Setting the prop again releases the borrowed memory without copying it.
+    dvz_visual_data_borrow(&visual, DVZ_PROP_COLOR, 0, N, color, _release_count, &released);
+    AT(released == 1);
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, 1, red);
+    AT(released == 2);
+    AT(prop->arr_orig.item_count == 1);
+
+    // Destroying the visual releases the borrowed memory.
+    dvz_visual_data_borrow(&visual, DVZ_PROP_COLOR, 0, N, color, _release_count, &released);
+    dvz_visual_destroy(&visual);
+    AT(released == 3);
+
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
+int test_visuals_ring(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzVisual visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+
+    mat4 id = GLM_MAT4_IDENTITY_INIT;
+    dvz_visual_data(&visual, DVZ_PROP_MODEL, 0, 1, id);
+    dvz_visual_data(&visual, DVZ_PROP_VIEW, 0, 1, id);
+    dvz_visual_data(&visual, DVZ_PROP_PROJ, 0, 1, id);
+    float param = 5.0f;
+    dvz_visual_data(&visual, DVZ_PROP_MARKER_SIZE, 0, 1, &param);
+    dvz_visual_data_source(&visual, DVZ_SOURCE_TYPE_VIEWPORT, 0, 0, 1, 1, &canvas->viewport);
+    cvec4 white = {255, 255, 255, 255};
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, 1, white);
+
+    // Circular vertex buffer.
+    const uint32_t capacity = 100;
+    dvz_visual_ring(&visual, capacity);
+    DvzProp* prop = dvz_prop_get(&visual, DVZ_PROP_COLOR, 0);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    DvzSource* source_vp = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VIEWPORT, 0);
+    AT(prop->arr_orig.item_count == capacity + DVZ_RING_OVERLAP);
+    AT(((cvec4*)prop->arr_orig.data)[capacity - 1][0] == 255);
+    AT(((DvzViewport*)source_vp->arr.data)->ring[1] == capacity);
+    AT(((DvzViewport*)source_vp->arr.data)->ring[2] == 0);
+
+    // Samples.
+    const uint32_t N = 60;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    for (uint32_t i = 0; i < N; i++)
+        pos[i][0] = i;
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.item_count == capacity + DVZ_RING_OVERLAP);
+    AT(visual.ring_head == 0);
+    AT(visual.ring_count == N);
+    AT(((DvzViewport*)source_vp->arr.data)->ring[2] == N);
+    AT(visual.br_ring_draws.buffer != NULL);
+    AT(visual.ring_draws[0].firstVertex == 0);
+    AT(visual.ring_draws[0].vertexCount == N);
+    AT(visual.ring_draws[1].vertexCount == 0);
+
+    // Appending items overwrites the oldest ones, and only bakes these items.
+    for (uint32_t i = 0; i < N; i++)
+        pos[i][0] = N + i;
+    DvzProp* prop_pos = dvz_prop_get(&visual, DVZ_PROP_POS, 0);
+    void* source_data = source->arr.data;
+    DvzVertex* vertices = source->arr.data;
+    vertices[0].color[0] = 12;
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 10, pos);
+    AT(prop_pos->arr_orig.item_count == capacity + DVZ_RING_OVERLAP);
+    AT(prop_pos->dirty.first == N);
+    AT(prop_pos->dirty.count == 10);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.data == source_data);
+    AT(source->arr.item_count == capacity + DVZ_RING_OVERLAP);
+    AT(vertices[0].color[0] == 12);
+    AT(vertices[N].pos[0] == N);
+    AT(vertices[N + 9].pos[0] == N + 9);
+    AT(vertices[N + 10].pos[0] == 0);
+
+    // Wraparound.
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, N, pos);
+    AT(visual.ring_count == capacity);
+    AT(visual.ring_head == 30);
+    AT(((DvzViewport*)source_vp->arr.data)->ring[0] == 30);
+    AT(((DvzViewport*)source_vp->arr.data)->ring[2] == capacity);
+
+    // The vertices are drawn from the oldest to the newest one.
+    AT(visual.ring_draws[0].firstVertex == 30);
+    AT(visual.ring_draws[0].vertexCount == capacity - 30);
+    AT(visual.ring_draws[1].firstVertex == 0);
+    AT(visual.ring_draws[1].vertexCount == 30);
+
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.data == source_data);
+    AT(vertices[99].pos[0] == N + 29);
+    AT(vertices[0].pos[0] == N + 30);
+    AT(vertices[29].pos[0] == N + N - 1);
+    AT(vertices[30].pos[0] == 30);
+    // The first vertices are duplicated after the end of the buffer.
+    AT(vertices[capacity].pos[0] == N + 30);
+    AT(vertices[capacity + 1].pos[0] == N + 31);
+
+    dvz_visual_destroy(&visual);
+    FREE(pos);
+    TEST_END
+}
+
+
+
+int test_visuals_lod(TestContext* context)
+{
+    // Time series with a single spike.
+    const uint32_t N = 100000;
+    DvzArray arr_pos = dvz_array(N, DVZ_DTYPE_DVEC3);
+    dvec3* pos = (dvec3*)arr_pos.data;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = i;
+        pos[i][1] = sin(i / 100.0);
+    }
+    pos[12345][1] = 10;
+    pos[54321][1] = -10;
+
+    DvzLod lod = {0};
+    _lod_build(&lod, &arr_pos);
+    AT(lod.item_count == N);
+    AT(lod.sorted);
+    AT(lod.level_count > 10);
+
+    // Every level keeps the first and last samples and the extrema, in increasing order.
+    uint32_t* items = NULL;
+    uint32_t count = 0, found = 0;
+    for (uint32_t k = 1; k < lod.level_count; k++)
+    {
+        items = (uint32_t*)lod.levels[k].data;
+        count = lod.levels[k].item_count;
+        AT(count <= 4 * (N / lod.bucket_size[k] + 1));
+        AT(items[0] == 0);
+        AT(items[count - 1] == N - 1);
+        found = 0;
+        for (uint32_t j = 0; j < count; j++)
+        {
+            if (j > 0)
+                AT(items[j] > items[j - 1]);
+            found += items[j] == 12345 || items[j] == 54321;
+        }
+        AT(found == 2);
+    }
+
+    // Whole range on 1000 pixels: at most 100 samples per pixel column.
+    lod.range[0] = 0;
+    lod.range[1] = N;
+    lod.width = 1000;
+    AT(_lod_select(&lod, &arr_pos));
+    AT(lod.level > 0);
+    AT(lod.bucket_size[lod.level] <= 100);
+    AT(!_lod_is_full(&lod));
+    AT(!_lod_select(&lod, &arr_pos));
+
+    DvzArray staging = {0};
+    _lod_gather(&lod, &arr_pos, &staging);
+    AT(staging.item_count == lod.levels[lod.level].item_count);
+    AT(((dvec3*)staging.data)[0][0] == 0);
+
+    // Zooming in selects the original samples around the visible range.
+    lod.range[0] = 50000;
+    lod.range[1] = 50500;
+    AT(_lod_select(&lod, &arr_pos));
+    AT(lod.level == 0);
+    AT(lod.first <= 50000);
+    AT(lod.first + lod.count >= 50500);
+    AT(lod.count < 2000);
+    _lod_gather(&lod, &arr_pos, &staging);
+    AT(staging.item_count == lod.count);
+    AT(((dvec3*)staging.data)[0][0] == lod.first);
+
+    // Panning within the uploaded window keeps the selection.
+    lod.range[0] = 50100;
+    lod.range[1] = 50600;
+    AT(!_lod_select(&lod, &arr_pos));
+
+    // Single-precision positions relative to an origin.
+    DvzArray arr_pos_f = dvz_array(N, DVZ_DTYPE_VEC3);
+    vec3* pos_f = (vec3*)arr_pos_f.data;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos_f[i][0] = pos[i][0] - 1000;
+        pos_f[i][1] = pos[i][1];
+    }
+    DvzLod lod_f = {0};
+    lod_f.origin = 1000;
+    _lod_build(&lod_f, &arr_pos_f);
+    AT(lod_f.item_count == N);
+    AT(lod_f.sorted);
+    AT(lod_f.level_count == lod.level_count);
+    items = (uint32_t*)lod_f.levels[lod_f.level_count - 1].data;
+    count = lod_f.levels[lod_f.level_count - 1].item_count;
+    found = 0;
+    for (uint32_t j = 0; j < count; j++)
+        found += items[j] == 12345 || items[j] == 54321;
+    AT(found == 2);
+    lod_f.range[0] = 50000;
+    lod_f.range[1] = 50500;
+    lod_f.width = 1000;
+    AT(_lod_select(&lod_f, &arr_pos_f));
+    AT(lod_f.level == lod.level);
+    AT(lod_f.first == lod.first);
+    AT(lod_f.count == lod.count);
+
+    _lod_destroy(&lod_f);
+    dvz_array_destroy(&arr_pos_f);
+    dvz_array_destroy(&staging);
+    _lod_destroy(&lod);
+    dvz_array_destroy(&arr_pos);
+    return 0;
+}
+
+
+
+static bool _box_equal(DvzBox a, DvzBox b)
+{
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        if (a.p0[j] != b.p0[j] || a.p1[j] != b.p1[j])
+            return false;
+    }
+    return true;
+}
+
+
+
+int test_visuals_bounds(TestContext* context)
+{
+    const uint32_t N = 1000;
+    DvzProp prop = {0};
+    prop.prop_type = DVZ_PROP_POS;
+    prop.arr_orig = dvz_array(N, DVZ_DTYPE_DVEC3);
+    dvec3* pos = (dvec3*)prop.arr_orig.data;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = i;
+        pos[i][1] = -(double)i;
+        pos[i][2] = i % 10;
+    }
+    AT(_prop_has_bounds(&prop));
+
+    // Full scan.
+    DvzBox box = _prop_bounds(&prop);
+    AT(prop.bounds_valid);
+    AT(box.p0[0] == 0 && box.p1[0] == N - 1);
+    AT(box.p0[1] == -(double)(N - 1) && box.p1[1] == 0);
+    AT(box.p0[2] == 0 && box.p1[2] == 9);
+
+    // Append: only the new items are scanned.
+    dvec3 new_pos = {-5, 1, 3};
+    _prop_bounds_before(&prop, N, 1, N + 1);
+    AT(prop.bounds_valid);
+    dvz_array_resize(&prop.arr_orig, N + 1);
+    dvz_array_data(&prop.arr_orig, N, 1, 1, new_pos);
+    _prop_bounds_after(&prop, N, 1);
+    box = _prop_bounds(&prop);
+    AT(box.p0[0] == -5 && box.p1[1] == 1);
+
+    // Overwriting items that are not extremes keeps the bounds.
+    _prop_bounds_before(&prop, 505, 1, N + 1);
+    AT(prop.bounds_valid);
+    dvz_array_data(&prop.arr_orig, 505, 1, 1, (dvec3){1, -1, 1});
+    _prop_bounds_after(&prop, 505, 1);
+    AT(prop.bounds_valid);
+
+    // Overwriting an extreme invalidates the bounds.
+    _prop_bounds_before(&prop, N, 1, N + 1);
+    AT(!prop.bounds_valid);
+    dvz_array_data(&prop.arr_orig, N, 1, 1, (dvec3){1, -1, 1});
+    _prop_bounds_after(&prop, N, 1);
+    AT(!prop.bounds_valid);
+
+    // The incremental bounds match a full scan.
+    box = _prop_bounds(&prop);
+    AT(_box_equal(box, _box_bounding(&prop.arr_orig)));
+    AT(box.p0[0] == 0 && box.p1[1] == 0);
+
+    // Truncating removes the extremes.
+    _prop_bounds_before(&prop, 0, 0, 10);
+    AT(!prop.bounds_valid);
+
+    dvz_array_destroy(&prop.arr_orig);
+    return 0;
+}
+
+
+
+// Nearest item with a linear scan, with the same tie-breaking as the spatial index.
+static int64_t _nearest_linear(DvzSpatialIndex* index, dvec2 q, dvec2 scale)
+{
+    double best = INFINITY, d = 0;
+    int64_t best_item = -1;
+    for (uint32_t i = 0; i < index->item_count; i++)
+    {
+        d = _spatial_dist(index->pos[i], q, scale);
+        if (d < best)
+        {
+            best = d;
+            best_item = i;
+        }
+    }
+    return best_item;
+}
+
+int test_visuals_spatial(TestContext* context)
+{
+    const uint32_t N = 10000;
+    const uint32_t M = 10;
+    DvzProp prop = {0};
+    prop.prop_type = DVZ_PROP_POS;
+    prop.arr_orig = dvz_array(N + M, DVZ_DTYPE_DVEC3);
+    dvec3* pos = (dvec3*)prop.arr_orig.data;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = 10 * dvz_rand_float();
+        pos[i][1] = dvz_rand_float();
+    }
+
+    DvzVisual visual = {0};
+    _spatial_create(&visual);
+    DvzSpatialIndex* index = visual.spatial;
+    AT(index != NULL);
+    AT(index->stale);
+    _spatial_copy(index, &prop, 0, N);
+    _spatial_build(index);
+    AT(index->grid_count == N);
+    AT(index->cell_first[index->shape[0] * index->shape[1]] == N);
+
+    // Nearest items with an anisotropic scaling, compared to a linear scan.
+    dvec2 q = {0};
+    dvec2 scale = {1, 100};
+    for (uint32_t k = 0; k < 100; k++)
+    {
+        q[0] = -1 + 12 * dvz_rand_float();
+        q[1] = -.1 + 1.2 * dvz_rand_float();
+        AT(_spatial_nearest(index, q, scale, INFINITY) == _nearest_linear(index, q, scale));
+    }
+
+    // Radius.
+    AT(_spatial_nearest(index, (dvec2){100, 100}, scale, 1) == -1);
+
+    // The appended items are found before the grid is rebuilt.
+    for (uint32_t i = N; i < N + M; i++)
+    {
+        pos[i][0] = 20 + (i - N);
+        pos[i][1] = 2;
+    }
+    _spatial_copy(index, &prop, N, M);
+    AT(index->item_count == N + M);
+    AT(index->grid_count == N);
+    AT(!_spatial_needs_build(index));
+    AT(_spatial_nearest(index, (dvec2){25.1, 2}, scale, INFINITY) == N + 5);
+
+    // Lasso selection, compared to a linear scan.
+    dvec2 poly[3] = {{1, .1}, {8, .2}, {4, .9}};
+    DvzSpatialSelection sel = {0};
+    _spatial_polygon(index, 3, poly, &sel);
+    DvzArray selection = {0};
+    uint32_t count = _selection_output(&sel, &selection);
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < N + M; i++)
+        expected += _point_in_polygon(index->pos[i], 3, poly);
+    AT(count > 0);
+    AT(count == expected);
+    AT(selection.item_count == count);
+    uint32_t* items = (uint32_t*)selection.data;
+    for (uint32_t k = 0; k < count; k++)
+    {
+        AT(k == 0 || items[k - 1] < items[k]);
+        AT(_point_in_polygon(index->pos[items[k]], 3, poly));
+    }
+
+    dvz_array_destroy(&selection);
+    _spatial_destroy(&visual);
+    AT(visual.spatial == NULL);
+    dvz_array_destroy(&prop.arr_orig);
+    return 0;
+}
@@ -109,6 +109,12 @@ int test_visuals_2(TestContext* context);
 int test_visuals_3(TestContext* context);
 int test_visuals_4(TestContext* context);
 int test_visuals_5(TestContext* context);
+int test_visuals_partial(TestContext* context);
+int test_visuals_borrow(TestContext* context);
+int test_visuals_ring(TestContext* context);
+int test_visuals_lod(TestContext* context);
+int test_visuals_bounds(TestContext* context);
+int test_visuals_spatial(TestContext* context);
 
 
 
@@ -1,4 +1,5 @@
 #include "test_vklite.h"
+#include "../include/datoviz/atlas.h"
 #include "../include/datoviz/context.h"
 #include "../src/spirv.h"
 #include "../src/vklite_utils.h"
@@ -725,6 +726,80 @@ int test_context_colormap(TestContext* context)
 
 
 
+int test_context_font_atlas(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu_best(app);
+    DvzContext* ctx = dvz_context(gpu, NULL);
+    DvzFontAtlas* atlas = &ctx->font_atlas;
+
+    // UTF-8 decoding of "aé€".
+    const char* str = "a\xc3\xa9\xe2\x82\xac";
+    uint32_t c = 0;
+    AT(dvz_utf8_length(str) == 3);
+    AT(dvz_utf8_decode(str, &c) == 1);
+    AT(c == 'a');
+    AT(dvz_utf8_decode(str + 1, &c) == 2);
+    AT(c == 0xE9);
+    AT(dvz_utf8_decode(str + 3, &c) == 3);
+    AT(c == 0x20AC);
+    AT(dvz_utf8_decode("\xe2\x82", &c) == 2);
+    AT(c == DVZ_UTF8_REPLACEMENT);
+
+    // The printable ASCII characters are in the first cells of the atlas.
+    AT(dvz_font_atlas_glyph(atlas, ' ') == 0);
+    AT(dvz_font_atlas_glyph(atlas, 'a') == 'a' - 32);
+    uint32_t count = atlas->glyph_count;
+
+    // The font file is shipped in the data directory, the ASCII font atlas is only a fallback.
+    AT(atlas->font_info != NULL);
+    AT(strcmp(atlas->name, DVZ_FONT_ATLAS_FILE) == 0);
+
+    // A new glyph is rendered in the next free cell, and cached.
+    uint32_t g = dvz_font_atlas_glyph(atlas, 0xE9);
+    AT(g == count);
+    AT(atlas->glyph_count == count + 1);
+    AT(dvz_font_atlas_glyph(atlas, 0xE9) == g);
+    AT(atlas->glyph_count == count + 1);
+
+    // The new glyph is only rendered in the CPU texture.
+    uint32_t cw = (uint32_t)atlas->glyph_width;
+    uint32_t ch = (uint32_t)atlas->glyph_height;
+    uvec3 offset = {(g % atlas->cols) * cw, (g / atlas->cols) * ch, 0};
+    bool inside = false;
+    for (uint32_t i = 0; i < ch; i++)
+        for (uint32_t j = 0; j < cw; j++)
+            inside |=
+                atlas->font_texture[4 * ((offset[1] + i) * atlas->width + offset[0] + j)] > 128;
+    AT(inside);
+    AT(atlas->glyph_uploaded == count);
+
+    // Upload the new glyph, and check that the whole GPU texture, including the ASCII cells,
+    // matches the CPU texture.
+    dvz_font_atlas_upload(atlas);
+    AT(atlas->glyph_uploaded == count + 1);
+    VkDeviceSize size = atlas->width * atlas->height * 4;
+    uint8_t* tex = calloc(size, sizeof(uint8_t));
+    dvz_texture_download(
+        atlas->texture, DVZ_ZERO_OFFSET, (uvec3){atlas->width, atlas->height, 1}, size, tex);
+    AT(memcmp(tex, atlas->font_texture, size) == 0);
+
+    // Region download of the new cell.
+    uint8_t* cell = calloc(cw * ch, 4 * sizeof(uint8_t));
+    dvz_texture_download(atlas->texture, offset, (uvec3){cw, ch, 1}, cw * ch * 4, cell);
+    for (uint32_t i = 0; i < ch; i++)
+        AT(memcmp(
+               &cell[4 * i * cw],
+               &atlas->font_texture[4 * ((offset[1] + i) * atlas->width + offset[0])],
+               4 * cw) == 0);
+    FREE(cell);
+    FREE(tex);
+
+    TEST_END
+}
+
+
+
 int test_default_app(TestContext* context)
 {
     DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
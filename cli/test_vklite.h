@@ -46,6 +46,7 @@ int test_shader_compile(TestContext* context);
 // int test_context_download(TestContext* context);
 
 int test_context_colormap(TestContext* context);
+int test_context_font_atlas(TestContext* context);
 int test_default_app(TestContext* context);
 
 
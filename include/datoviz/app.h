@@ -18,6 +18,7 @@
 #include <vulkan/vulkan.h>
 
 #include "common.h"
+#include "fifo.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,23 +58,38 @@ struct DvzClock
     double elapsed;  // time in seconds elapsed since calling _start_time(clock)
     double interval; // interval since the last clock update
 
-    struct timeval start, current;
+    double start, current; // monotonic timestamps, in seconds
     // double checkpoint_time;
     // uint64_t checkpoint_value;
 };
 
 
 
-static inline void _clock_init(DvzClock* clock) { gettimeofday(&clock->start, NULL); }
+// Monotonic high-resolution time, in seconds, from an arbitrary origin.
+static inline double _clock_now(void)
+{
+#if OS_WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+
+
+static inline void _clock_init(DvzClock* clock) { clock->start = _clock_now(); }
 
 
 
 static inline double _clock_get(DvzClock* clock)
 {
-    gettimeofday(&clock->current, NULL);
-    double elapsed = (clock->current.tv_sec - clock->start.tv_sec) +
-                     (clock->current.tv_usec - clock->start.tv_usec) / 1000000.0;
-    return elapsed;
+    clock->current = _clock_now();
+    return clock->current - clock->start;
 }
 
 
@@ -115,6 +131,7 @@ struct DvzApp
 
     // Threads.
     DvzThread timer_thread;
+    DvzTaskPool* tasks; // worker pool used to bake the visuals in parallel
 };
 
 
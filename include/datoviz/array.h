@@ -8,6 +8,10 @@
 
 #include "vklite.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 
 
 /*************************************************************************************************/
@@ -94,6 +98,7 @@ struct DvzArray
     uint32_t item_count;
     VkDeviceSize buffer_size;
     void* data;
+    bool is_borrowed; // the data buffer is owned by the caller, it is never reallocated or freed
 
     // 3D arrays
     uint32_t ndims; // 1, 2, or 3
@@ -236,6 +241,29 @@ static uint32_t _get_components(DvzDataType dtype)
 
 
 
+// Make a borrowed array own a copy of its data, before the array is modified.
+static void _array_detach(DvzArray* array)
+{
+    ASSERT(array != NULL);
+    if (!array->is_borrowed)
+        return;
+    void* data = array->data;
+    array->is_borrowed = false;
+    array->data = NULL;
+    array->buffer_size = 0;
+    if (data == NULL || array->item_count == 0)
+    {
+        array->item_count = 0;
+        return;
+    }
+    log_trace("copy the borrowed data of an array before modifying it");
+    array->buffer_size = array->item_count * array->item_size;
+    array->data = malloc(array->buffer_size);
+    memcpy(array->data, data, array->buffer_size);
+}
+
+
+
 /*************************************************************************************************/
 /*  Functions                                                                                    */
 /*************************************************************************************************/
@@ -285,6 +313,7 @@ static DvzArray dvz_array(uint32_t item_count, DvzDataType dtype)
 static DvzArray dvz_array_copy(DvzArray* arr)
 {
     DvzArray arr_new = *arr; // struct copy
+    arr_new.is_borrowed = false;
     arr_new.data = malloc(arr->buffer_size);
     memcpy(arr_new.data, arr->data, arr->buffer_size);
     return arr_new;
@@ -331,6 +360,27 @@ static DvzArray dvz_array_wrap(uint32_t item_count, DvzDataType dtype, void* dat
 
 
 
+/**
+ * Create a 1D array referencing memory owned by the caller.
+ *
+ * The created array does not allocate memory, and it never frees nor modifies the passed buffer:
+ * the array makes a private copy of the data the first time it is modified (resized or
+ * overwritten). The buffer must remain valid as long as the array references it.
+ *
+ * @param item_count number of elements in the passed buffer
+ * @param dtype the data type of the array
+ * @param data the buffer owned by the caller
+ * @returns the array borrowing the buffer
+ */
+static DvzArray dvz_array_borrow(uint32_t item_count, DvzDataType dtype, void* data)
+{
+    DvzArray arr = dvz_array_wrap(item_count, dtype, data);
+    arr.is_borrowed = true;
+    return arr;
+}
+
+
+
 /**
  * Create a 1D record array with heterogeneous data type.
  *
@@ -420,6 +470,9 @@ static void dvz_array_resize(DvzArray* array, uint32_t item_count)
     if (item_count == old_item_count)
         return;
 
+    // Never reallocate memory owned by the caller.
+    _array_detach(array);
+
     // If the array was not allocated, allocate it with the specified size.
     if (array->data == NULL)
     {
@@ -470,6 +523,7 @@ static void dvz_array_resize(DvzArray* array, uint32_t item_count)
 static void dvz_array_clear(DvzArray* array)
 {
     ASSERT(array != NULL);
+    _array_detach(array);
     memset(array->data, 0, array->buffer_size);
 }
 
@@ -568,6 +622,7 @@ static void dvz_array_copy_region(
     ASSERT(dst_offset + item_count <= dst_arr->item_count);
     ASSERT(src_arr->dtype == dst_arr->dtype);
     ASSERT(src_arr->item_size == dst_arr->item_size);
+    _array_detach(dst_arr);
 
     void* src = (void*)((int64_t)src_arr->data + ((int64_t)(src_offset * src_arr->item_size)));
     void* dst = (void*)((int64_t)dst_arr->data + ((int64_t)(dst_offset * dst_arr->item_size)));
@@ -615,6 +670,7 @@ static void dvz_array_data(
         return;
     }
     ASSERT(item_count > 0);
+    _array_detach(array);
 
     // Resize if necessary.
     if (first_item + item_count > array->item_count)
@@ -669,6 +725,7 @@ static void dvz_array_scale(DvzArray* arr, float scaling)
     // TODO: support other dtypes.
     if (arr->dtype == DVZ_DTYPE_FLOAT)
     {
+        _array_detach(arr);
         for (uint32_t i = 0; i < arr->item_count; i++)
         {
             ((float*)arr->data)[i] *= scaling;
@@ -694,27 +751,55 @@ static inline void* dvz_array_item(DvzArray* array, uint32_t idx)
 
 
 
-// Cast a vector.
-static inline void _cast(DvzDataType target_dtype, void* dst, DvzDataType source_dtype, void* src)
-{
-    if (source_dtype == DVZ_DTYPE_DOUBLE && target_dtype == DVZ_DTYPE_FLOAT)
-    {
-        ((vec3*)dst)[0][0] = ((dvec3*)src)[0][0];
-    }
-    else if (source_dtype == DVZ_DTYPE_DVEC2 && target_dtype == DVZ_DTYPE_VEC2)
-    {
-        ((vec3*)dst)[0][0] = ((dvec3*)src)[0][0];
-        ((vec3*)dst)[0][1] = ((dvec3*)src)[0][1];
-    }
-    else if (source_dtype == DVZ_DTYPE_DVEC3 && target_dtype == DVZ_DTYPE_VEC3)
-    {
-        ((vec3*)dst)[0][0] = ((dvec3*)src)[0][0];
-        ((vec3*)dst)[0][1] = ((dvec3*)src)[0][1];
-        ((vec3*)dst)[0][2] = ((dvec3*)src)[0][2];
-    }
-    else
-        log_error("unknown casting dtypes %d %d", source_dtype, target_dtype);
-}
+/**
+ * Copy strided items, with optional repeats and casting.
+ *
+ * The destination item `i` receives the source item `min(i / reps, data_item_count - 1)`. The
+ * copy uses SIMD kernels (AVX2, SSE2, or NEON) when they are supported by the CPU, which is
+ * determined at runtime. Define the `DVZ_NO_SIMD` environment variable to force the scalar code.
+ *
+ * @param dst pointer to the first destination item
+ * @param dst_stride stride in the destination buffer, in bytes
+ * @param src pointer to the first source item
+ * @param src_stride stride in the source buffer, in bytes
+ * @param col_size size of each source item, in bytes
+ * @param item_count number of destination items to write
+ * @param data_item_count number of items in `src`
+ * @param source_dtype the source dtype (only used when casting)
+ * @param target_dtype the target dtype (only used when casting)
+ * @param copy_type the type of copy
+ * @param reps the number of repeats for each copied element
+ */
+DVZ_EXPORT void dvz_column_copy(
+    void* dst, VkDeviceSize dst_stride, const void* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t item_count, uint32_t data_item_count, //
+    DvzDataType source_dtype, DvzDataType target_dtype, DvzArrayCopyType copy_type, uint32_t reps);
+
+
+
+/**
+ * Return the name of the SIMD instruction set used by the array copy kernels.
+ *
+ * @returns "avx2", "sse2", "neon", or "scalar"
+ */
+DVZ_EXPORT const char* dvz_array_simd(void);
+
+
+
+/**
+ * Extend a bounding box with items of a vec3 or dvec3 array.
+ *
+ * The min/max reduction uses the same SIMD instruction set as the copy kernels. NaN values are
+ * ignored.
+ *
+ * @param array the array, with dtype DVZ_DTYPE_VEC3 or DVZ_DTYPE_DVEC3
+ * @param first_item the first item to scan
+ * @param item_count the number of items to scan
+ * @param p0 the lower corner of the box, updated in place
+ * @param p1 the upper corner of the box, updated in place
+ */
+DVZ_EXPORT void dvz_array_bounds(
+    DvzArray* array, uint32_t first_item, uint32_t item_count, dvec3 p0, dvec3 p1);
 
 
 
@@ -750,64 +835,17 @@ static void dvz_array_column(
     ASSERT(data != NULL);
     ASSERT(item_count > 0);
     ASSERT(first_item + item_count <= array->item_count);
-
-    VkDeviceSize src_offset = 0;
-    VkDeviceSize src_stride = col_size;
-
-    VkDeviceSize dst_offset = offset;
-    VkDeviceSize dst_stride = array->item_size;
-
-    void* dst = array->data;
-    const void* src = data;
-
-    ASSERT(src != NULL);
-    ASSERT(dst != NULL);
-    ASSERT(src_stride > 0);
-    ASSERT(dst_stride > 0);
-    ASSERT(item_count > 0);
+    _array_detach(array);
 
     log_trace(
-        "copy src offset %d stride %d, dst offset %d stride %d, item size %d count %d", //
-        src_offset, src_stride, dst_offset, dst_stride, col_size, item_count);
-
-    int64_t src_byte = (int64_t)src + (int64_t)src_offset;
-    int64_t dst_byte = (int64_t)dst + (int64_t)(first_item * dst_stride) + (int64_t)dst_offset;
-
-    uint32_t j = 0; // j: src index
-    uint32_t m = 0;
-    bool skip = false;
-    for (uint32_t i = 0; i < item_count; i++) // i: dst index
-    {
-        if (reps > 1)
-            m = i % reps;
-        // Determine whether the current item copy should be skipped.
-        skip = copy_type == DVZ_ARRAY_COPY_SINGLE && reps > 1 && m > 0;
-
-        // NOTE: this function is not optimized and might benefit from being refactored.
-
-        // Copy the current item, unless we are in SINGLE copy mode
-        if (!skip)
-        {
-            if (source_dtype == target_dtype ||   //
-                source_dtype == DVZ_DTYPE_NONE || //
-                target_dtype == DVZ_DTYPE_NONE)   //
-                memcpy((void*)dst_byte, (void*)src_byte, col_size);
-            else
-            {
-                _cast(target_dtype, (void*)dst_byte, source_dtype, (void*)src_byte);
-            }
-        }
-
-        // Advance the source pointer, unless we are in SINGLE copy mode
-        skip = reps > 1 && m < reps - 1;
-        if (j < data_item_count - 1 && !skip)
-        {
-            src_byte += (int64_t)src_stride;
-            j++;
-        }
-
-        dst_byte += (int64_t)dst_stride;
-    }
+        "copy stride %d, dst offset %d stride %d, count %d", //
+        col_size, offset, array->item_size, item_count);
+
+    void* dst = (void*)((int64_t)array->data + (int64_t)(first_item * array->item_size) +
+                        (int64_t)offset);
+    dvz_column_copy(
+        dst, array->item_size, data, col_size, col_size, item_count, data_item_count, //
+        source_dtype, target_dtype, copy_type, reps);
 }
 
 
@@ -841,9 +879,16 @@ static void dvz_array_destroy(DvzArray* array)
     if (!dvz_obj_is_created(&array->obj))
         return;
     dvz_obj_destroyed(&array->obj);
+    // NOTE: borrowed data is owned by the caller.
+    if (array->is_borrowed)
+        array->data = NULL;
     FREE(array->data) //
 }
 
 
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
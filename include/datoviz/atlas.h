@@ -1,5 +1,6 @@
 /*************************************************************************************************/
-/*  Simple monospace font atlas                                                                  */
+/*  Font atlas                                                                                   */
+/*  Signed distance field glyphs rendered at runtime from a font file, with a glyph cache        */
 /*************************************************************************************************/
 
 #ifndef DVZ_FONT_ATLAS_HEADER
@@ -8,109 +9,109 @@
 #include "common.h"
 #include "context.h"
 
-// #define STB_IMAGE_IMPLEMENTATION
-BEGIN_INCL_NO_WARN
-#include "../external/stb_image.h"
-END_INCL_NO_WARN
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 
 
 /*************************************************************************************************/
-/*  Font atlas                                                                                   */
+/*  Constants                                                                                    */
 /*************************************************************************************************/
 
-static const char DVZ_FONT_ATLAS_STRING[] =
-    " !\"#$%&'()*+,-./"
-    "0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\x7f";
-
-
-
-static size_t _font_atlas_glyph(DvzFontAtlas* atlas, const char* str, uint32_t idx)
-{
-    ASSERT(atlas != NULL);
-    ASSERT(atlas->rows > 0);
-    ASSERT(atlas->cols > 0);
-    ASSERT(str != NULL);
-    ASSERT(strlen(str) > 0);
-    ASSERT(idx < strlen(str));
-    ASSERT(atlas->font_str != NULL);
-    ASSERT(strlen(atlas->font_str) > 0);
-
-    char c[2] = {str[idx], 0};
-    return strcspn(atlas->font_str, c);
-}
-
-
-
-static void _font_atlas_glyph_size(DvzFontAtlas* atlas, float size, vec2 glyph_size)
-{
-    ASSERT(atlas != NULL);
-    glyph_size[0] = size * atlas->glyph_width / atlas->glyph_height;
-    glyph_size[1] = size;
-}
-
+#define DVZ_FONT_ATLAS_FILE         "Roboto-Medium.ttf" // in the fonts directory of DATA_DIR
+#define DVZ_FONT_ATLAS_COLS         16
+#define DVZ_FONT_ATLAS_ROWS         32 // the glyph cache holds up to 16 * 32 = 512 glyphs
+#define DVZ_FONT_ATLAS_GLYPH_HEIGHT 64 // height of a glyph cell, in pixels
+#define DVZ_FONT_ATLAS_PXRANGE      4  // distance range, in pixels, must match the text shader
 
+#define DVZ_UTF8_REPLACEMENT 0xFFFD // code point used for invalid UTF-8 sequences
 
-static DvzTexture* _font_texture(DvzContext* ctx, DvzFontAtlas* atlas)
-{
-    ASSERT(ctx != NULL);
-    ASSERT(atlas != NULL);
-    ASSERT(atlas->font_texture != NULL);
 
-    uvec3 shape = {(uint32_t)atlas->width, (uint32_t)atlas->height, 1};
-    DvzTexture* texture = dvz_ctx_texture(ctx, 2, shape, VK_FORMAT_R8G8B8A8_UNORM);
-    // NOTE: the font texture must have LINEAR filter! otherwise no antialiasing
-    dvz_texture_filter(texture, DVZ_FILTER_MAG, VK_FILTER_LINEAR);
-    dvz_texture_filter(texture, DVZ_FILTER_MIN, VK_FILTER_LINEAR);
 
-    dvz_texture_upload(
-        texture, DVZ_ZERO_OFFSET, DVZ_ZERO_OFFSET, (uint32_t)(atlas->width * atlas->height * 4),
-        atlas->font_texture);
-    return texture;
-}
-
-
-
-static DvzFontAtlas dvz_font_atlas(DvzContext* ctx)
-{
-    // Font texture
-    char path[1024];
-    snprintf(path, sizeof(path), "%s/textures/%s", DATA_DIR, "font_inconsolata.png");
-    ASSERT(path != NULL);
+/*************************************************************************************************/
+/*  Font atlas                                                                                   */
+/*************************************************************************************************/
 
-    int width, height, depth;
+/**
+ * Create the font atlas of a context.
+ *
+ * The printable ASCII characters are rendered in the first cells of the atlas grid, the other
+ * glyphs are rendered the first time they are used, and uploaded in the next frame. When the
+ * font file cannot be loaded, the atlas falls back to the fixed ASCII font texture.
+ *
+ * @param ctx the context
+ * @returns the font atlas
+ */
+DVZ_EXPORT DvzFontAtlas dvz_font_atlas(DvzContext* ctx);
+
+/**
+ * Return the glyph index of a Unicode code point, rendering it in the atlas if needed.
+ *
+ * This function is thread-safe. A new glyph is only rendered in the CPU copy of the atlas
+ * texture, it is uploaded to the GPU by the next call to `dvz_font_atlas_upload()`.
+ *
+ * @param atlas the font atlas
+ * @param codepoint the Unicode code point
+ * @returns the index of the glyph cell in the atlas grid
+ */
+DVZ_EXPORT uint32_t dvz_font_atlas_glyph(DvzFontAtlas* atlas, uint32_t codepoint);
+
+/**
+ * Upload the glyphs added since the last upload to the GPU texture of the atlas.
+ *
+ * This function is called by the canvas in every frame, before the command buffers are
+ * submitted. The new glyphs are uploaded with a single sub-region texture upload.
+ *
+ * @param atlas the font atlas
+ */
+DVZ_EXPORT void dvz_font_atlas_upload(DvzFontAtlas* atlas);
+
+/**
+ * Compute the size of a glyph for a given font size.
+ *
+ * @param atlas the font atlas
+ * @param size the font size
+ * @param[out] glyph_size the glyph width and height
+ */
+DVZ_EXPORT void dvz_font_atlas_glyph_size(DvzFontAtlas* atlas, float size, vec2 glyph_size);
+
+/**
+ * Destroy a font atlas.
+ *
+ * @param atlas the font atlas
+ */
+DVZ_EXPORT void dvz_font_atlas_destroy(DvzFontAtlas* atlas);
 
-    DvzFontAtlas atlas = {0};
-    atlas.font_texture = stbi_load(path, &width, &height, &depth, STBI_rgb_alpha);
-    ASSERT(width > 0);
-    ASSERT(height > 0);
-    ASSERT(depth > 0);
 
-    // TODO: parameters
-    atlas.font_str = DVZ_FONT_ATLAS_STRING;
-    ASSERT(strlen(atlas.font_str) > 0);
-    atlas.cols = 16;
-    atlas.rows = 6;
 
-    atlas.width = (uint32_t)width;
-    atlas.height = (uint32_t)height;
-    atlas.glyph_width = atlas.width / (float)atlas.cols;
-    atlas.glyph_height = atlas.height / (float)atlas.rows;
+/*************************************************************************************************/
+/*  UTF-8                                                                                        */
+/*************************************************************************************************/
 
-    atlas.texture = _font_texture(ctx, &atlas);
+/**
+ * Decode the first code point of a UTF-8 string.
+ *
+ * Invalid or truncated sequences are decoded as the replacement character U+FFFD.
+ *
+ * @param str a non-empty UTF-8 string
+ * @param[out] codepoint the decoded code point
+ * @returns the number of bytes consumed
+ */
+DVZ_EXPORT uint32_t dvz_utf8_decode(const char* str, uint32_t* codepoint);
 
-    return atlas;
-}
+/**
+ * Return the number of code points in a UTF-8 string.
+ *
+ * @param str a UTF-8 string
+ * @returns the number of code points, i.e. the number of glyphs
+ */
+DVZ_EXPORT uint32_t dvz_utf8_length(const char* str);
 
 
 
-static void dvz_font_atlas_destroy(DvzFontAtlas* atlas)
-{
-    ASSERT(atlas != NULL);
-    ASSERT(atlas->font_texture != NULL);
-    stbi_image_free(atlas->font_texture);
+#ifdef __cplusplus
 }
-
-
+#endif
 
 #endif
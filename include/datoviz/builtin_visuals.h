@@ -10,6 +10,15 @@
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+// Minimum number of points for a path to be baked on the GPU by default.
+#define DVZ_PATH_GPU_BAKE_MIN_POINTS (1 << 20)
+
+
+
 /*************************************************************************************************/
 /*  Macros                                                                                       */
 /*************************************************************************************************/
@@ -104,6 +113,33 @@ typedef enum
 
 
 
+// Path flags.
+typedef enum
+{
+    DVZ_PATH_FLAGS_DEFAULT = 0x0000,
+    DVZ_PATH_FLAGS_GPU_BAKE = 0x1000, // always bake the path vertex buffer on the GPU
+    DVZ_PATH_FLAGS_CPU_BAKE = 0x2000, // always bake the path vertex buffer on the CPU
+} DvzPathFlags;
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+typedef struct DvzAxesBake DvzAxesBake;
+
+// Axes data baked outside of the visual props and sources, passed as the user data of the bake
+// event of an axes visual. Used to bake the axes in a worker thread.
+struct DvzAxesBake
+{
+    DvzArray* pos[DVZ_AXES_LEVEL_COUNT]; // tick positions of each level (DOUBLE)
+    DvzArray* text;                      // tick labels (STR)
+    DvzArray* vertices[2];               // segment and text vertices
+};
+
+
+
 /*************************************************************************************************/
 /*  Functions                                                                                    */
 /*************************************************************************************************/
@@ -34,6 +34,16 @@ extern "C" {
 #define DVZ_DEFAULT_IMAGE_FORMAT      VK_FORMAT_B8G8R8A8_UNORM
 #define DVZ_PICK_IMAGE_FORMAT         VK_FORMAT_R32G32B32A32_SINT
 #define DVZ_PICK_STAGING_SIZE         8
+#define DVZ_PICK_BUFFER_SIZE          65536 // initial size of the async pick readback buffer
+#define DVZ_PICK_MAX_POINTS           4096
+#define DVZ_PICK_MAX_BATCH            64
+#define DVZ_BATCH_STAGING_COUNT       3  // number of staging images in the batch readback ring
+#define DVZ_BATCH_DEFAULT_WORKERS     4  // default number of PNG encoding threads
+#define DVZ_BATCH_MAX_WORKERS         16
+#define DVZ_BATCH_MAX_PENDING         32 // maximum number of images waiting to be encoded
+#define DVZ_TILING_ROW_BUFFERS        2  // number of tile rows being assembled or encoded
+#define DVZ_TIMING_SAMPLES            256 // number of frames in the rolling frame timing window
+#define DVZ_TIMING_HIST_BINS          24  // log2 histogram bins, from 1 us to 2^23 us
 #define DVZ_DEFAULT_DPI_SCALING       1.0f
 #define DVZ_MIN_SWAPCHAIN_IMAGE_COUNT 3
 #define DVZ_SEMAPHORE_IMG_AVAILABLE   0
@@ -158,6 +168,55 @@ typedef enum
 
 
 
+// Pick request type.
+typedef enum
+{
+    DVZ_PICK_NONE,
+    DVZ_PICK_POINTS, // a set of individual pixels
+    DVZ_PICK_RECT,   // all pixels in a rectangle
+} DvzPickType;
+
+
+
+// Async pick status.
+typedef enum
+{
+    DVZ_PICK_STATUS_NONE,
+    DVZ_PICK_STATUS_IDLE,
+    DVZ_PICK_STATUS_AWAIT_SUBMIT,
+    DVZ_PICK_STATUS_AWAIT_READBACK,
+} DvzPickStatus;
+
+
+
+// Batch rendering staging slot status.
+typedef enum
+{
+    DVZ_BATCH_SLOT_IDLE,
+    DVZ_BATCH_SLOT_AWAIT_SUBMIT,
+    DVZ_BATCH_SLOT_AWAIT_READBACK,
+} DvzBatchSlotStatus;
+
+
+
+// Frame phases, for per-phase CPU timing of the event loop.
+typedef enum
+{
+    DVZ_FRAME_PHASE_POLL,       // backend event polling
+    DVZ_FRAME_PHASE_FENCE_WAIT, // wait for the frame in flight to finish rendering
+    DVZ_FRAME_PHASE_ACQUIRE,    // swapchain image acquisition
+    DVZ_FRAME_PHASE_CALLBACKS,  // INTERACT, FRAME and TIMER callbacks, excluding scene updates
+    DVZ_FRAME_PHASE_SCENE,      // scene controllers and scene updates
+    DVZ_FRAME_PHASE_TRANSFERS,  // pending data transfers
+    DVZ_FRAME_PHASE_REFILL,     // command buffer refill
+    DVZ_FRAME_PHASE_SUBMIT,     // command buffer submission, including SEND callbacks
+    DVZ_FRAME_PHASE_PRESENT,    // swapchain image presentation
+    DVZ_FRAME_PHASE_TOTAL,      // time between the end of two successive frames
+    DVZ_FRAME_PHASE_COUNT,
+} DvzFramePhase;
+
+
+
 /*************************************************************************************************/
 /*  Event system                                                                                 */
 /*************************************************************************************************/
@@ -193,6 +252,7 @@ typedef enum
     DVZ_EVENT_RESIZE,             // called at every resize
     DVZ_EVENT_PRE_SEND,           // called before sending the commands buffers
     DVZ_EVENT_POST_SEND,          // called after sending the commands buffers
+    DVZ_EVENT_PICK,               // called when an async pick request has been read back
     DVZ_EVENT_DESTROY,            // called before destruction
 } DvzEventType;
 
@@ -252,6 +312,7 @@ typedef struct DvzMouseWheelEvent DvzMouseWheelEvent;
 typedef struct DvzRefillEvent DvzRefillEvent;
 typedef struct DvzResizeEvent DvzResizeEvent;
 typedef struct DvzScreencastEvent DvzScreencastEvent;
+typedef struct DvzPickEvent DvzPickEvent;
 typedef struct DvzSubmitEvent DvzSubmitEvent;
 typedef struct DvzGuiEvent DvzGuiEvent;
 typedef struct DvzTimerEvent DvzTimerEvent;
@@ -262,7 +323,16 @@ typedef void (*DvzEventCallback)(DvzCanvas*, DvzEvent);
 typedef struct DvzEventCallbackRegister DvzEventCallbackRegister;
 
 typedef struct DvzScreencast DvzScreencast;
+typedef struct DvzPickRequest DvzPickRequest;
+typedef struct DvzPick DvzPick;
+typedef struct DvzBatchSlot DvzBatchSlot;
+typedef struct DvzBatchJob DvzBatchJob;
+typedef struct DvzBatch DvzBatch;
+typedef struct DvzTiling DvzTiling;
+typedef struct DvzTilingRow DvzTilingRow;
 typedef struct DvzPendingRefill DvzPendingRefill;
+typedef struct DvzFrameStats DvzFrameStats;
+typedef struct DvzFrameTiming DvzFrameTiming;
 
 // Forward declarations.
 typedef struct DvzGui DvzGui;
@@ -332,8 +402,10 @@ struct DvzViewport
     uvec2 offset_screen;
     uvec2 size_screen;
 
-    // Position and size of the viewport in framebuffer coordinates.
-    uvec2 offset_framebuffer;
+    // Position and size of the viewport in framebuffer coordinates. In a tiled export, this is
+    // the full viewport within the image, relative to the current tile, and the Vulkan viewport
+    // is restricted to the current tile.
+    ivec2 offset_framebuffer; // may be negative when rendering a tile of a larger image
     uvec2 size_framebuffer;
 
     // Options
@@ -343,6 +415,19 @@ struct DvzViewport
     // Used to discard transform on one axis
     int32_t interact_axis;
 
+    // Linear data normalization made by the GPU when data_scale[3] is not zero:
+    // position in NDC = data_scale * position + data_shift
+    vec4 data_scale;
+    vec4 data_shift;
+
+    // Circular vertex buffer (see dvz_visual_ring()): index of the oldest vertex, capacity (0 if
+    // disabled), and number of valid vertices.
+    uvec4 ring;
+
+    // Tiled export (see dvz_viewport_tiled()): NDC scale (xy) and shift (zw) from the full
+    // viewport to the Vulkan viewport restricted to the current tile. Disabled if tile[0] is 0.
+    vec4 tile;
+
     // TODO: aspect ratio
 };
 
@@ -434,6 +519,19 @@ struct DvzScreencastEvent
 
 
 
+struct DvzPickEvent
+{
+    uint64_t idx;     // index of the pick request
+    DvzPickType type; // points or rectangle
+    uint32_t count;   // number of picked values
+    uvec2 offset;     // rectangle offset, in framebuffer pixels (RECT only)
+    uvec2 shape;      // rectangle shape, in framebuffer pixels (RECT only)
+    ivec4* values;    // picked values, owned by the canvas
+    void* user_data;  // user data passed to the pick request
+};
+
+
+
 struct DvzRefillEvent
 {
     uint32_t img_idx;
@@ -481,6 +579,7 @@ union DvzEventUnion
     DvzRefillEvent rf;     // for REFILL events
     DvzResizeEvent r;      // for RESIZE events
     DvzScreencastEvent sc; // for SCREENCAST events
+    DvzPickEvent p;        // for PICK events
     DvzSubmitEvent s;      // for SUBMIT events
     DvzGuiEvent g;         // for GUI events
 };
@@ -532,6 +631,155 @@ struct DvzScreencast
 
 
 
+struct DvzPickRequest
+{
+    uint64_t idx;
+    DvzPickType type;
+    uint32_t count;          // number of points, or number of pixels in the rectangle
+    uvec2* points;           // pixel positions in framebuffer coordinates (POINTS only)
+    uvec2 offset;            // rectangle offset in framebuffer coordinates (RECT only)
+    uvec2 shape;             // rectangle shape (RECT only)
+    VkDeviceSize buf_offset; // offset of the results within the readback buffer
+    void* user_data;
+};
+
+
+
+struct DvzPick
+{
+    DvzObject obj;
+    DvzCanvas* canvas;
+
+    DvzCommands cmds; // one command buffer per swapchain image, submitted with the frame
+    DvzBuffer buffer; // persistently-mapped readback buffer
+    DvzPickStatus status;
+    uint32_t fence_idx; // frame fence to check before reading back the buffer
+    atomic(uint64_t, request_count);
+
+    DvzFifo requests; // pending requests, not yet recorded
+    uint32_t batch_count;
+    DvzPickRequest* batch[DVZ_PICK_MAX_BATCH]; // requests recorded in the current batch
+
+    ivec4* values; // CPU copy of the last batch, passed to the PICK events
+    uint32_t values_count;
+};
+
+
+
+struct DvzBatchSlot
+{
+    DvzCommands cmds;  // copy commands, submitted with the frame that renders this image
+    DvzImages staging; // host-visible image the swapchain image is copied to
+    DvzBatchSlotStatus status;
+    uint32_t fence_idx; // frame fence to check before reading back the staging image
+    uint64_t idx;
+    char path[1024];
+};
+
+
+
+struct DvzBatchJob
+{
+    uint64_t idx;
+    uint32_t width, height;
+    uint8_t* rgb;
+    char path[1024];
+};
+
+
+
+struct DvzBatch
+{
+    DvzObject obj;
+    DvzCanvas* canvas;
+
+    DvzBatchSlot slots[DVZ_BATCH_STAGING_COUNT];
+    uint32_t slot_idx; // slot used by the next image
+    uint64_t image_count;
+
+    // PNG encoding worker pool.
+    uint32_t worker_count;
+    DvzThread workers[DVZ_BATCH_MAX_WORKERS];
+    DvzFifo jobs;
+    atomic(uint32_t, pending); // number of images read back but not yet written
+    atomic(uint64_t, written);
+    pthread_mutex_t lock;
+    pthread_cond_t cond_written; // signaled by the workers every time an image has been written
+};
+
+
+
+// Frame timing statistics of a given phase over the rolling window, in seconds.
+struct DvzFrameStats
+{
+    uint32_t count; // number of frames in the rolling window
+    double mean;
+    double max;
+    double p50;
+    double p95;
+    double p99;
+};
+
+
+
+// Per-phase CPU timing of the last frames.
+struct DvzFrameTiming
+{
+    double start[DVZ_FRAME_PHASE_COUNT]; // start time of the ongoing phase measurements
+    double cur[DVZ_FRAME_PHASE_COUNT];   // accumulated phase durations in the current frame
+    double last_end;                     // time of the end of the last frame
+
+    // Rolling window of the per-frame phase durations, in seconds.
+    uint64_t frame_count; // total number of timed frames
+    uint64_t frames[DVZ_TIMING_SAMPLES];
+    float samples[DVZ_FRAME_PHASE_COUNT][DVZ_TIMING_SAMPLES];
+
+    // Histogram of all phase durations since the canvas creation: bin 0 counts the durations
+    // below 1 us, bin i the durations between 2^(i-1) and 2^i us, the last bin the longer ones.
+    uint64_t hist[DVZ_FRAME_PHASE_COUNT][DVZ_TIMING_HIST_BINS];
+
+    // Statistics, updated periodically by the FPS timer callback.
+    DvzFrameStats stats[DVZ_FRAME_PHASE_COUNT];
+};
+
+
+
+// A row of tiles, encoded by the tiled export writer thread.
+struct DvzTilingRow
+{
+    uint8_t* rgb;
+    uint32_t row_count; // number of image rows in the tile row
+};
+
+
+
+// Tiled rendering of an image larger than the canvas.
+struct DvzTiling
+{
+    DvzObject obj;
+    DvzCanvas* canvas;
+
+    uvec2 size;       // size of the full image, in framebuffer pixels
+    uvec2 tile_size;  // size of a tile, equal to the canvas framebuffer size
+    uvec2 tile_count; // number of tiles along each axis
+    ivec2 offset;     // offset of the tile being rendered, in the full image
+
+    // Staging ring, the slot index is the tile index.
+    DvzBatchSlot slots[DVZ_BATCH_STAGING_COUNT];
+    uint32_t slot_idx;
+    uint8_t* tile_rgb; // RGB values of the tile being read back
+
+    // Tile rows, assembled in the calling thread and encoded in the writer thread.
+    DvzTilingRow rows[DVZ_TILING_ROW_BUFFERS];
+    DvzImageWriter* writer;
+    DvzThread writer_thread;
+    DvzFifo jobs;
+    atomic(uint32_t, rows_written);
+    atomic(bool, failed);
+};
+
+
+
 struct DvzPendingRefill
 {
     bool completed[DVZ_MAX_SWAPCHAIN_IMAGES];
@@ -581,6 +829,7 @@ struct DvzCanvas
     double fps, efps;
     double max_delay; // used to compute the effective frames per second (eFPS)
     double max_delay_roll[10];
+    DvzFrameTiming timing; // per-phase frame timing
 
     // Renderpasses.
     DvzRenderpass renderpass;         // default renderpass
@@ -597,9 +846,23 @@ struct DvzCanvas
     DvzCommands cmds_transfer;
     DvzCommands cmds_render;
 
+    // Staging buffer of the canvas transfers, used with cmds_transfer, so that the canvases
+    // processing their transfers in their own thread do not share the context staging buffer.
+    DvzBuffer staging;
+
     // Other command buffers.
     DvzContainer commands;
 
+    // Command pools owned by the canvas, one per queue, so that the canvas command buffers may be
+    // recorded in the canvas render thread.
+    VkCommandPool cmd_pools[DVZ_MAX_QUEUES];
+
+    // Render thread, when the app runs with dvz_app_run_threaded().
+    bool threaded;
+    DvzThread render_thread;
+    uint64_t render_frame_count; // number of frames to render in the render thread
+    DvzFifo input_events;        // backend input events forwarded by the main thread
+
     // Graphics pipelines.
     DvzContainer graphics;
 
@@ -626,6 +889,9 @@ struct DvzCanvas
     DvzContainer guis;
 
     DvzScreencast* screencast;
+    DvzPick pick;
+    DvzBatch* batch;
+    DvzTiling* tiling; // only during a tiled export
     DvzPendingRefill refills;
 
     DvzViewport viewport;
@@ -743,6 +1009,21 @@ DVZ_EXPORT DvzViewport dvz_viewport_default(uint32_t width, uint32_t height);
  */
 DVZ_EXPORT DvzViewport dvz_viewport_full(DvzCanvas* canvas);
 
+/**
+ * Restrict a viewport laid out in the full image of a tiled export to the current tile.
+ *
+ * The Vulkan viewport is clipped to the tile, so that it never has a negative offset nor exceeds
+ * the framebuffer size, and the shaders apply the scaling from the full viewport. If the viewport
+ * does not intersect the tile, the Vulkan viewport is set to a 1x1 placeholder and the function
+ * returns true: the caller should then neither set the viewport nor draw anything in it. This
+ * function does nothing outside of a tiled export.
+ *
+ * @param canvas the canvas
+ * @param viewport the viewport, with the position and size of the full viewport in the image
+ * @returns whether the viewport is empty, i.e. outside of the current tile
+ */
+DVZ_EXPORT bool dvz_viewport_tiled(DvzCanvas* canvas, DvzViewport* viewport);
+
 /**
  * Set the DPI scaling factor of a canvas.
  *
@@ -802,6 +1083,70 @@ DVZ_EXPORT void dvz_canvas_to_close(DvzCanvas* canvas);
 
 
 
+/*************************************************************************************************/
+/*  Frame timing                                                                                 */
+/*************************************************************************************************/
+
+/**
+ * Start the CPU timing of a frame phase.
+ *
+ * The event loop times the builtin phases automatically. This function may be used to time the
+ * phases that run in event callbacks, like the scene updates.
+ *
+ * @param canvas the canvas
+ * @param phase the frame phase
+ */
+DVZ_EXPORT void dvz_canvas_timing_begin(DvzCanvas* canvas, DvzFramePhase phase);
+
+/**
+ * Stop the CPU timing of a frame phase.
+ *
+ * The duration is accumulated into the current frame, a phase may be timed several times within
+ * the same frame.
+ *
+ * @param canvas the canvas
+ * @param phase the frame phase
+ */
+DVZ_EXPORT void dvz_canvas_timing_end(DvzCanvas* canvas, DvzFramePhase phase);
+
+/**
+ * Get the name of a frame phase.
+ *
+ * @param phase the frame phase
+ * @returns the phase name, as used in the CSV header
+ */
+DVZ_EXPORT const char* dvz_canvas_timing_name(DvzFramePhase phase);
+
+/**
+ * Compute the timing statistics of a frame phase over the last frames.
+ *
+ * @param canvas the canvas
+ * @param phase the frame phase
+ * @returns the statistics, in seconds
+ */
+DVZ_EXPORT DvzFrameStats dvz_canvas_timing_stats(DvzCanvas* canvas, DvzFramePhase phase);
+
+/**
+ * Reset the frame timing window and histograms, for example after a warm-up period.
+ *
+ * @param canvas the canvas
+ */
+DVZ_EXPORT void dvz_canvas_timing_reset(DvzCanvas* canvas);
+
+/**
+ * Save the per-phase durations of the last frames to a CSV file.
+ *
+ * The file has one row per frame, with the frame index followed by the phase durations in
+ * milliseconds.
+ *
+ * @param canvas the canvas
+ * @param path the path to the CSV file
+ * @returns 0 on success, a nonzero value otherwise
+ */
+DVZ_EXPORT int dvz_canvas_timing_csv(DvzCanvas* canvas, const char* path);
+
+
+
 /*************************************************************************************************/
 /*  Screencast                                                                                   */
 /*************************************************************************************************/
@@ -860,6 +1205,30 @@ DVZ_EXPORT uint8_t* dvz_screenshot(DvzCanvas* canvas, bool has_alpha);
  */
 DVZ_EXPORT void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path);
 
+/**
+ * Export an image larger than the canvas, rendered tile by tile.
+ *
+ * The panel viewports are laid out within the full image and restricted to every tile in turn,
+ * the shaders scaling the geometry accordingly. The tiles are read back through a staging ring
+ * and their rows are streamed to the file by a writer thread, so that the memory usage is
+ * proportional to a row of tiles and not to the full image.
+ *
+ * The file format depends on the extension: PNG (.png), PPM (.ppm), or headerless raw RGB
+ * values otherwise.
+ *
+ * !!! note
+ *     The canvas must be offscreen. The image size is not limited by the maximum viewport size
+ *     of the GPU, as the Vulkan viewports never exceed the canvas size.
+ *
+ * @param canvas the offscreen canvas
+ * @param path the path to the image file to create
+ * @param width the width of the full image, in pixels
+ * @param height the height of the full image, in pixels
+ * @returns 0 on success, a nonzero value otherwise
+ */
+DVZ_EXPORT int
+dvz_screenshot_tiled(DvzCanvas* canvas, const char* path, uint32_t width, uint32_t height);
+
 /**
  * Pick a pixel in a canvas from a pixel position.
  *
@@ -874,6 +1243,88 @@ DVZ_EXPORT void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path);
  */
 DVZ_EXPORT void dvz_canvas_pick(DvzCanvas* canvas, uvec2 pos_screen, ivec4 picked);
 
+/**
+ * Request an asynchronous pick of a set of pixels.
+ *
+ * The copy of the pick attachment is recorded in the next frame's submission, and the values are
+ * read back from a persistently-mapped buffer once that frame has finished rendering, without any
+ * GPU synchronization. The result is delivered through a `DVZ_EVENT_PICK` event, whose `values`
+ * field contains one `ivec4` per requested point.
+ *
+ * !!! note
+ *     The canvas must have been created with the `DVZ_CANVAS_FLAGS_PICK` flag. The `values`
+ *     pointer is owned by the canvas and is only valid until the next pick batch is read back,
+ *     so `DVZ_EVENT_MODE_ASYNC` callbacks should copy it.
+ *
+ * @param canvas the canvas
+ * @param count the number of points
+ * @param pos_screen the coordinates of the points, in pixel coordinates
+ * @param user_data a pointer passed to the PICK event
+ * @returns the index of the pick request, passed to the PICK event
+ */
+DVZ_EXPORT uint64_t dvz_canvas_pick_points(
+    DvzCanvas* canvas, uint32_t count, const uvec2* pos_screen, void* user_data);
+
+/**
+ * Request an asynchronous pick of all pixels in a rectangle.
+ *
+ * The PICK event `values` field contains `shape[0] * shape[1]` values, stored row by row.
+ *
+ * @param canvas the canvas
+ * @param pos0 the coordinates of one corner of the rectangle, in pixel coordinates
+ * @param pos1 the coordinates of the opposite corner, in pixel coordinates
+ * @param user_data a pointer passed to the PICK event
+ * @returns the index of the pick request, passed to the PICK event
+ */
+DVZ_EXPORT uint64_t
+dvz_canvas_pick_rect(DvzCanvas* canvas, uvec2 pos0, uvec2 pos1, void* user_data);
+
+
+
+/*************************************************************************************************/
+/*  Batch rendering                                                                              */
+/*************************************************************************************************/
+
+/**
+ * Prepare an offscreen canvas for batch rendering.
+ *
+ * Batch rendering is meant to render many static images (thumbnails, report figures) with a
+ * single offscreen canvas, reusing its swapchain image, renderpass and graphics pipelines. Each
+ * image is copied to one of a small ring of host-visible staging images in the same submission
+ * as the render commands. The image is read back only once the next frame has been submitted,
+ * and the PNG files are encoded and written by a pool of worker threads.
+ *
+ * @param canvas the offscreen canvas
+ * @param worker_count the number of PNG encoding threads (0 for the default)
+ */
+DVZ_EXPORT void dvz_batch(DvzCanvas* canvas, uint32_t worker_count);
+
+/**
+ * Render the current state of the canvas and save it to a PNG file asynchronously.
+ *
+ * The canvas data (visuals, panels, etc.) may be modified right after this call to prepare the
+ * next image, while the GPU renders the current one.
+ *
+ * @param canvas the offscreen canvas
+ * @param png_path the path to the PNG file to create
+ * @returns the index of the image within the batch
+ */
+DVZ_EXPORT uint64_t dvz_batch_render(DvzCanvas* canvas, const char* png_path);
+
+/**
+ * Wait until all images rendered so far have been written to disk.
+ *
+ * @param canvas the offscreen canvas
+ */
+DVZ_EXPORT void dvz_batch_flush(DvzCanvas* canvas);
+
+/**
+ * Flush and destroy the batch rendering resources.
+ *
+ * @param canvas the offscreen canvas
+ */
+DVZ_EXPORT void dvz_batch_destroy(DvzCanvas* canvas);
+
 
 
 /*************************************************************************************************/
@@ -1156,6 +1607,27 @@ DVZ_EXPORT void dvz_canvas_frame_submit(DvzCanvas* canvas);
  */
 DVZ_EXPORT void dvz_app_run(DvzApp* app, uint64_t frame_count);
 
+/**
+ * Start the main event loop, with one render thread per canvas.
+ *
+ * Every canvas waits for its fences, acquires its swapchain images, runs its frame logic and
+ * submits its command buffers in its own thread, so that a slow canvas does not slow down the
+ * other ones. The main thread only polls the window events, which are forwarded to the canvas
+ * render threads, and handles swapchain recreation and canvas destruction.
+ *
+ * !!! important
+ *     The FRAME, INTERACT, TIMER and mouse and keyboard callbacks are called in the canvas render
+ *     thread, whereas the INIT and RESIZE callbacks are called in the main thread.
+ *
+ * !!! note
+ *     ImGui is not thread-safe, so this function falls back to `dvz_app_run()` if any canvas has
+ *     a GUI overlay.
+ *
+ * @param app the app
+ * @param frame_count number of frames to process in each canvas (0 for infinite loop)
+ */
+DVZ_EXPORT void dvz_app_run_threaded(DvzApp* app, uint64_t frame_count);
+
 
 
 #ifdef __cplusplus
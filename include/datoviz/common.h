@@ -242,6 +242,7 @@ typedef struct DvzObject DvzObject;
 typedef struct DvzContainer DvzContainer;
 typedef struct DvzContainerIterator DvzContainerIterator;
 typedef struct DvzThread DvzThread;
+typedef struct DvzImageWriter DvzImageWriter;
 
 typedef void* (*DvzThreadCallback)(void*);
 
@@ -625,6 +626,38 @@ dvz_write_png(const char* filename, uint32_t width, uint32_t height, const uint8
 DVZ_EXPORT int
 dvz_write_ppm(const char* filename, uint32_t width, uint32_t height, const uint8_t* image);
 
+/**
+ * Open an image file to be written row by row, without holding the whole image in memory.
+ *
+ * The file format depends on the extension: PNG (.png), PPM (.ppm), or headerless raw RGB
+ * values otherwise.
+ *
+ * @param filename path to the image file to create
+ * @param width width of the image
+ * @param height height of the image
+ * @returns the image writer, or NULL if the file could not be created
+ */
+DVZ_EXPORT DvzImageWriter* dvz_image_writer(const char* filename, uint32_t width, uint32_t height);
+
+/**
+ * Append rows to an image file.
+ *
+ * @param writer the image writer
+ * @param row_count the number of rows to write
+ * @param rows pointer to the 24-bit RGB values of the rows
+ * @returns 0 on success, a nonzero value otherwise
+ */
+DVZ_EXPORT int
+dvz_image_writer_rows(DvzImageWriter* writer, uint32_t row_count, const uint8_t* rows);
+
+/**
+ * Finish writing an image file and close it.
+ *
+ * @param writer the image writer
+ * @returns 0 on success, a nonzero value otherwise (for example if rows are missing)
+ */
+DVZ_EXPORT int dvz_image_writer_close(DvzImageWriter* writer);
+
 /**
  * Read a binary file.
  *
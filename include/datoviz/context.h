@@ -64,6 +64,7 @@ typedef enum
 /*  Typedefs                                                                                     */
 /*************************************************************************************************/
 
+typedef struct DvzGlyphTable DvzGlyphTable;
 typedef struct DvzFontAtlas DvzFontAtlas;
 typedef struct DvzColorTexture DvzColorTexture;
 
@@ -73,6 +74,17 @@ typedef struct DvzColorTexture DvzColorTexture;
 /*  Structs                                                                                      */
 /*************************************************************************************************/
 
+// Hash table mapping Unicode code points to glyph cells, with open addressing.
+struct DvzGlyphTable
+{
+    uint32_t capacity;    // power of two
+    uint32_t count;       // number of occupied slots
+    uint32_t* codepoints; // 0 for empty slots
+    uint32_t* glyphs;     // glyph cell index in the atlas grid
+};
+
+
+
 struct DvzFontAtlas
 {
     const char* name;
@@ -82,6 +94,16 @@ struct DvzFontAtlas
     float glyph_width, glyph_height;
     const char* font_str;
     DvzTexture* texture;
+
+    // Glyph cache, the glyph cells are filled in order as new code points are used.
+    void* font_info;         // font loaded from the font file, NULL for the fixed ASCII atlas
+    uint8_t* font_data;      // contents of the font file
+    float font_scale;        // from font units to pixels
+    int baseline;            // position of the baseline in a glyph cell, in pixels
+    uint32_t glyph_count;    // number of glyph cells in use
+    uint32_t glyph_uploaded; // number of glyph cells uploaded to the GPU texture
+    uint32_t glyph_fallback; // glyph used for the missing code points
+    DvzGlyphTable glyphs;
 };
 
 
@@ -100,6 +122,11 @@ struct DvzContext
     DvzGpu* gpu;
 
     DvzCommands transfer_cmd;
+    DvzCommands compute_cmd;
+
+    // Protects the resource allocations, the staging buffer and the transfer and compute command
+    // buffers, which are shared by all canvases and threads. This is a recursive mutex.
+    pthread_mutex_t lock;
 
     DvzContainer buffers;
     DvzContainer images;
@@ -119,19 +146,13 @@ struct DvzContext
 /*  Utils                                                                                        */
 /*************************************************************************************************/
 
-// Get the staging buffer, and make sure it can contain `size` bytes.
-static DvzBuffer* staging_buffer(DvzContext* context, VkDeviceSize size)
+// Make sure a staging buffer can contain `size` bytes, and resize it with the given transfer
+// commands otherwise.
+static DvzBuffer* _staging_reserve(DvzBuffer* staging, DvzCommands* cmds, VkDeviceSize size)
 {
-    log_trace("requesting staging buffer of size %s", pretty_size(size));
-    DvzBuffer* staging = (DvzBuffer*)dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_STAGING);
     ASSERT(staging != NULL);
     ASSERT(staging->buffer != VK_NULL_HANDLE);
 
-    // Make sure the staging buffer is idle before using it.
-    // TODO: optimize this and avoid hard synchronization here before copying data into
-    // the staging buffer.
-    dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
-
     // Resize the staging buffer is needed.
     // TODO: keep staging buffer fixed and copy parts of the data to staging buffer in several
     // steps?
@@ -139,7 +160,7 @@ static DvzBuffer* staging_buffer(DvzContext* context, VkDeviceSize size)
     {
         VkDeviceSize new_size = dvz_next_pow2(size);
         log_debug("reallocating staging buffer to %s", pretty_size(new_size));
-        dvz_buffer_resize(staging, new_size, &context->transfer_cmd);
+        dvz_buffer_resize(staging, new_size, cmds);
     }
     ASSERT(staging->size >= size);
     return staging;
@@ -147,19 +168,35 @@ static DvzBuffer* staging_buffer(DvzContext* context, VkDeviceSize size)
 
 
 
-static void _copy_buffer_from_staging(
-    DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size)
+// Get the context staging buffer, and make sure it can contain `size` bytes.
+static DvzBuffer* staging_buffer(DvzContext* context, VkDeviceSize size)
 {
-    ASSERT(context != NULL);
+    log_trace("requesting staging buffer of size %s", pretty_size(size));
+    DvzBuffer* staging = (DvzBuffer*)dvz_container_get(&context->buffers, DVZ_BUFFER_TYPE_STAGING);
+    ASSERT(staging != NULL);
+
+    // Make sure the staging buffer is idle before using it.
+    // TODO: optimize this and avoid hard synchronization here before copying data into
+    // the staging buffer.
+    dvz_queue_wait(context->gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+
+    return _staging_reserve(staging, &context->transfer_cmd, size);
+}
 
-    DvzGpu* gpu = context->gpu;
-    ASSERT(gpu != NULL);
 
-    DvzBuffer* staging = staging_buffer(context, size);
+
+// NOTE: the _copy_*_staging() functions take the staging buffer and the transfer command buffer
+// to use, which belong either to the context or to a canvas. The staging buffer must be big
+// enough.
+static void _copy_buffer_from_staging(
+    DvzGpu* gpu, DvzCommands* cmds, DvzBuffer* staging, //
+    DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(cmds != NULL);
     ASSERT(staging != NULL);
+    ASSERT(staging->size >= size);
 
-    // Take transfer cmd buf.
-    DvzCommands* cmds = &context->transfer_cmd;
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
@@ -191,18 +228,14 @@ static void _copy_buffer_from_staging(
 
 
 static void _copy_buffer_to_staging(
-    DvzContext* context, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size)
+    DvzGpu* gpu, DvzCommands* cmds, DvzBuffer* staging, //
+    DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size)
 {
-    ASSERT(context != NULL);
-
-    DvzGpu* gpu = context->gpu;
     ASSERT(gpu != NULL);
-
-    DvzBuffer* staging = staging_buffer(context, size);
+    ASSERT(cmds != NULL);
     ASSERT(staging != NULL);
+    ASSERT(staging->size >= size * br.count);
 
-    // Take transfer cmd buf.
-    DvzCommands* cmds = &context->transfer_cmd;
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
@@ -241,35 +274,62 @@ static void _copy_buffer_to_staging(
 
 
 
-static void _copy_texture_from_staging(
-    DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size)
+// Resolve the region of a texture transfer, a zero shape denoting the whole texture. Return
+// whether the region covers the whole texture.
+static bool _texture_region(
+    DvzTexture* texture, uvec3 offset, uvec3 shape, ivec3 region_offset, uvec3 region_shape)
 {
-    ASSERT(context != NULL);
+    ASSERT(texture != NULL);
+    DvzImages* img = texture->image;
+    ASSERT(img != NULL);
+    uvec3 img_shape = {img->width, img->height, img->depth};
+
+    bool is_zero = shape[0] == 0 || shape[1] == 0 || shape[2] == 0;
+    bool whole = true;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        region_offset[i] = is_zero ? 0 : (int32_t)offset[i];
+        region_shape[i] = is_zero ? img_shape[i] : shape[i];
+        ASSERT((uint32_t)region_offset[i] + region_shape[i] <= img_shape[i]);
+        whole &= region_offset[i] == 0 && region_shape[i] == img_shape[i];
+    }
+    return whole;
+}
 
-    DvzGpu* gpu = context->gpu;
-    ASSERT(gpu != NULL);
 
-    DvzBuffer* staging = staging_buffer(context, size);
+
+static void _copy_texture_from_staging(
+    DvzGpu* gpu, DvzCommands* cmds, DvzBuffer* staging, //
+    DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(cmds != NULL);
     ASSERT(staging != NULL);
+    ASSERT(staging->size >= size);
+    ASSERT(texture != NULL);
+    ASSERT(texture->image != NULL);
+
+    ivec3 region_offset = {0};
+    uvec3 region_shape = {0};
+    bool whole = _texture_region(texture, offset, shape, region_offset, region_shape);
 
-    // Take transfer cmd buf.
-    DvzCommands* cmds = &context->transfer_cmd;
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
-    // Image transition.
+    // Image transition. The current contents are discarded only when the whole texture is
+    // overwritten, otherwise the texels outside of the region must be kept.
     DvzBarrier barrier = dvz_barrier(gpu);
     dvz_barrier_stages(&barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-    ASSERT(texture != NULL);
-    ASSERT(texture->image != NULL);
     dvz_barrier_images(&barrier, texture->image);
     dvz_barrier_images_layout(
-        &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        &barrier, whole ? VK_IMAGE_LAYOUT_UNDEFINED : texture->image->layout,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
     dvz_barrier_images_access(&barrier, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
     dvz_cmd_barrier(cmds, 0, &barrier);
 
-    // Copy to staging buffer
-    dvz_cmd_copy_buffer_to_image(cmds, 0, staging, texture->image);
+    // Copy from the staging buffer.
+    dvz_cmd_copy_buffer_to_image_region(
+        cmds, 0, staging, 0, texture->image, region_offset, region_shape);
 
     // Image transition.
     dvz_barrier_images_layout(
@@ -296,34 +356,35 @@ static void _copy_texture_from_staging(
 
 
 static void _copy_texture_to_staging(
-    DvzContext* context, DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size)
+    DvzGpu* gpu, DvzCommands* cmds, DvzBuffer* staging, //
+    DvzTexture* texture, uvec3 offset, uvec3 shape, VkDeviceSize size)
 {
-    ASSERT(context != NULL);
-
-    DvzGpu* gpu = context->gpu;
     ASSERT(gpu != NULL);
-
-    DvzBuffer* staging = staging_buffer(context, size);
+    ASSERT(cmds != NULL);
     ASSERT(staging != NULL);
+    ASSERT(staging->size >= size);
+    ASSERT(texture != NULL);
+    ASSERT(texture->image != NULL);
+
+    ivec3 region_offset = {0};
+    uvec3 region_shape = {0};
+    _texture_region(texture, offset, shape, region_offset, region_shape);
 
-    // Take transfer cmd buf.
-    DvzCommands* cmds = &context->transfer_cmd;
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
-    // Image transition.
+    // Image transition, from the current layout so that the contents are preserved.
     DvzBarrier barrier = dvz_barrier(gpu);
     dvz_barrier_stages(&barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-    ASSERT(texture != NULL);
-    ASSERT(texture->image != NULL);
     dvz_barrier_images(&barrier, texture->image);
     dvz_barrier_images_layout(
-        &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        &barrier, texture->image->layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
     dvz_barrier_images_access(&barrier, 0, VK_ACCESS_TRANSFER_READ_BIT);
     dvz_cmd_barrier(cmds, 0, &barrier);
 
-    // Copy to staging buffer
-    dvz_cmd_copy_image_to_buffer(cmds, 0, texture->image, staging);
+    // Copy to the staging buffer.
+    dvz_cmd_copy_image_region_to_buffer(
+        cmds, 0, texture->image, region_offset, region_shape, staging, 0);
 
     // Image transition.
     dvz_barrier_images_layout(
@@ -349,6 +410,99 @@ static void _copy_texture_to_staging(
 
 
 
+static void _copy_texture(
+    DvzGpu* gpu, DvzCommands* cmds, //
+    DvzTexture* src, uvec3 src_offset, DvzTexture* dst, uvec3 dst_offset, uvec3 shape)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(cmds != NULL);
+    ASSERT(src != NULL);
+    ASSERT(dst != NULL);
+
+    dvz_cmd_reset(cmds, 0);
+    dvz_cmd_begin(cmds, 0);
+
+    DvzBarrier src_barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &src_barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images(&src_barrier, src->image);
+
+    DvzBarrier dst_barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &dst_barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images(&dst_barrier, dst->image);
+
+    // Source image transition.
+    if (src->image->layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+    {
+        dvz_barrier_images_layout(
+            &src_barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        dvz_cmd_barrier(cmds, 0, &src_barrier);
+    }
+
+    // Destination image transition.
+    {
+        log_trace("destination image transition");
+        dvz_barrier_images_layout(
+            &dst_barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        dvz_cmd_barrier(cmds, 0, &dst_barrier);
+    }
+
+    // Copy texture command.
+    VkImageCopy copy = {0};
+    copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.srcSubresource.layerCount = 1;
+    copy.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.dstSubresource.layerCount = 1;
+    copy.extent.width = shape[0];
+    copy.extent.height = shape[1];
+    copy.extent.depth = shape[2];
+    copy.srcOffset.x = (int32_t)src_offset[0];
+    copy.srcOffset.y = (int32_t)src_offset[1];
+    copy.srcOffset.z = (int32_t)src_offset[2];
+    copy.dstOffset.x = (int32_t)dst_offset[0];
+    copy.dstOffset.y = (int32_t)dst_offset[1];
+    copy.dstOffset.z = (int32_t)dst_offset[2];
+    vkCmdCopyImage(
+        cmds->cmds[0],                                               //
+        src->image->images[0], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, //
+        dst->image->images[0], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, //
+        1, &copy);
+
+    // Source image transition.
+    if (src->image->layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+    {
+        dvz_barrier_images_layout(
+            &src_barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, src->image->layout);
+        dvz_cmd_barrier(cmds, 0, &src_barrier);
+    }
+
+    // Destination image transition.
+    if (dst->image->layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+    {
+        log_trace("destination image transition back");
+        dvz_barrier_images_layout(
+            &dst_barrier, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dst->image->layout);
+        dvz_cmd_barrier(cmds, 0, &dst_barrier);
+    }
+
+    dvz_cmd_end(cmds, 0);
+
+    // Wait for the render queue to be idle.
+    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
+
+    // Submit the commands to the transfer queue.
+    DvzSubmit submit = dvz_submit(gpu);
+    dvz_submit_commands(&submit, cmds);
+    log_debug("copy %dx%dx%d between 2 textures", shape[0], shape[1], shape[2]);
+    dvz_submit_send(&submit, 0, NULL, 0);
+
+    // Wait for the transfer queue to be idle.
+    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+}
+
+
+
 /*************************************************************************************************/
 /*  Context                                                                                      */
 /*************************************************************************************************/
@@ -375,6 +529,23 @@ DVZ_EXPORT void dvz_context_reset(DvzContext* context);
  */
 DVZ_EXPORT void dvz_context_colormap(DvzContext* context);
 
+/**
+ * Acquire the context lock.
+ *
+ * The context functions allocating GPU resources or using the staging buffer acquire this lock,
+ * so that they may be called from several canvas threads.
+ *
+ * @param context the context
+ */
+DVZ_EXPORT void dvz_context_lock(DvzContext* context);
+
+/**
+ * Release the context lock.
+ *
+ * @param context the context
+ */
+DVZ_EXPORT void dvz_context_unlock(DvzContext* context);
+
 
 
 /*************************************************************************************************/
@@ -412,7 +583,7 @@ dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceSize n
  * Create a new compute pipeline.
  *
  * @param context the context
- * @param shader_path path to the `.spirv` file containing the compute shader
+ * @param shader_path (optional) path to the `.spirv` file containing the compute shader
  */
 DVZ_EXPORT DvzCompute* dvz_ctx_compute(DvzContext* context, const char* shader_path);
 
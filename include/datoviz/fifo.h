@@ -18,6 +18,7 @@ extern "C" {
 /*************************************************************************************************/
 
 #define DVZ_MAX_FIFO_CAPACITY 256
+#define DVZ_TASK_CHUNKS_PER_THREAD 4
 
 
 
@@ -26,6 +27,12 @@ extern "C" {
 /*************************************************************************************************/
 
 typedef struct DvzFifo DvzFifo;
+typedef struct DvzTask DvzTask;
+typedef struct DvzTaskGroup DvzTaskGroup;
+typedef struct DvzTaskPool DvzTaskPool;
+
+typedef void (*DvzTaskCallback)(void* user_data);
+typedef void (*DvzTaskRangeCallback)(void* user_data, uint32_t first, uint32_t count);
 
 
 
@@ -49,6 +56,46 @@ struct DvzFifo
 
 
 
+/*************************************************************************************************/
+/*  Task pool                                                                                    */
+/*************************************************************************************************/
+
+struct DvzTask
+{
+    DvzTaskCallback callback;
+    void* user_data;
+    DvzTaskGroup* group;
+};
+
+
+
+// A set of tasks that can be waited upon. Protected by the pool lock.
+struct DvzTaskGroup
+{
+    uint32_t pending;
+};
+
+
+
+struct DvzTaskPool
+{
+    DvzObject obj;
+
+    uint32_t worker_count;
+    DvzThread* workers;
+
+    // Ring buffer of pending tasks, enlarged when full.
+    uint32_t task_first, task_count, task_capacity;
+    DvzTask* tasks;
+    bool is_stopping;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond_task; // signaled when a task is enqueued
+    pthread_cond_t cond_done; // broadcast when a task has completed
+};
+
+
+
 /*************************************************************************************************/
 /*  FIFO queue                                                                                   */
 /*************************************************************************************************/
@@ -112,6 +159,77 @@ DVZ_EXPORT void dvz_fifo_destroy(DvzFifo* fifo);
 
 
 
+/*************************************************************************************************/
+/*  Task pool                                                                                    */
+/*************************************************************************************************/
+
+/**
+ * Create a pool of worker threads processing tasks.
+ *
+ * With a worker count of 0, the number of workers is the number of CPU cores minus one, as the
+ * thread waiting for the tasks also processes them. The `DVZ_NUM_THREADS` environment variable
+ * overrides this default with a total number of threads. With no workers, all tasks run on the
+ * thread waiting for them.
+ *
+ * @param worker_count the number of worker threads, or 0 for the default
+ * @returns a pointer to the task pool
+ */
+DVZ_EXPORT DvzTaskPool* dvz_task_pool(uint32_t worker_count);
+
+/**
+ * Enqueue a task in a task pool.
+ *
+ * @param pool the task pool
+ * @param group the group of tasks to add the task to
+ * @param callback the function to call in a worker thread
+ * @param user_data the pointer passed to the callback
+ */
+DVZ_EXPORT void dvz_task_enqueue(
+    DvzTaskPool* pool, DvzTaskGroup* group, DvzTaskCallback callback, void* user_data);
+
+/**
+ * Wait until all tasks of a group have completed.
+ *
+ * The calling thread processes pending tasks while waiting, so that tasks may themselves enqueue
+ * and wait for other tasks.
+ *
+ * @param pool the task pool
+ * @param group the group of tasks
+ */
+DVZ_EXPORT void dvz_task_wait(DvzTaskPool* pool, DvzTaskGroup* group);
+
+/**
+ * Split a range of items in chunks processed in parallel, and wait until they have completed.
+ *
+ * Small ranges, and ranges processed with a NULL pool, run on the calling thread.
+ *
+ * @param pool the task pool, may be NULL
+ * @param item_count the number of items
+ * @param min_chunk the minimum number of items per chunk
+ * @param callback the function called on each chunk
+ * @param user_data the pointer passed to the callback
+ */
+DVZ_EXPORT void dvz_task_range(
+    DvzTaskPool* pool, uint32_t item_count, uint32_t min_chunk, DvzTaskRangeCallback callback,
+    void* user_data);
+
+/**
+ * Return the total number of threads processing the tasks of a pool.
+ *
+ * @param pool the task pool, may be NULL
+ * @returns the number of workers plus one for the waiting thread
+ */
+DVZ_EXPORT uint32_t dvz_task_pool_threads(DvzTaskPool* pool);
+
+/**
+ * Destroy a task pool after all pending tasks have completed.
+ *
+ * @param pool the task pool
+ */
+DVZ_EXPORT void dvz_task_pool_destroy(DvzTaskPool* pool);
+
+
+
 #ifdef __cplusplus
 }
 #endif
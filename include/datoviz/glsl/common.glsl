@@ -79,12 +79,22 @@ layout (std140, binding = 1) uniform Viewport {
     uvec2 offset_screen;    // offset
     uvec2 size_screen;      // size
 
-    uvec2 offset;           // framebuffer coordinates
+    ivec2 offset;           // framebuffer coordinates
     uvec2 size;             // framebuffer coordinates
 
     // Options
     int clip;               // viewport clipping
     int interact_axis;
+
+    // Data normalization, if data_scale.w != 0
+    vec4 data_scale;
+    vec4 data_shift;
+
+    // Circular vertex buffer, if ring.y != 0: oldest vertex, capacity, valid vertex count
+    uvec4 ring;
+
+    // Tiled export, if tile.x != 0: NDC scale and shift to the part of the viewport in the tile
+    vec4 tile;
 } viewport;
 
 
@@ -103,8 +113,28 @@ vec4 to_vulkan(vec4 tr) {
 
 
 
+vec3 normalize_pos(vec3 pos) {
+    // Linear normalization of the data to NDC, when it is not done on the CPU.
+    if (viewport.data_scale.w != 0)
+        pos = viewport.data_scale.xyz * pos + viewport.data_shift.xyz;
+    return pos;
+}
+
+
+
+float ring_age(uint index) {
+    // Age of a vertex in a circular vertex buffer, from 0 for the oldest vertex. The index is
+    // returned as is when the vertex buffer is not circular.
+    if (viewport.ring.y == 0)
+        return float(index);
+    return float((index + viewport.ring.y - viewport.ring.x) % viewport.ring.y);
+}
+
+
+
 vec4 transform(vec3 pos, vec2 shift, uint transform_mode) {
     mat4 mvp = mvp.proj * mvp.view * mvp.model;
+    pos = normalize_pos(pos);
     vec4 tr = vec4(pos, 1.0);
 
     // By default, take the viewport transform.
@@ -166,6 +196,11 @@ vec4 transform(vec3 pos, vec2 shift, uint transform_mode) {
         tr.xy += (2 * shift / viewport.size);
 
     tr = to_vulkan(tr);
+
+    // Tiled export: only the part of the viewport within the current tile is rendered.
+    if (viewport.tile.x != 0)
+        tr.xy = viewport.tile.xy * tr.xy + viewport.tile.zw * tr.w;
+
     return tr;
 }
 
@@ -231,6 +266,16 @@ bool clip_viewport(vec2 frag_coords, int coord) {
 
 
 
+vec2 frame_size() {
+    // Size of the rendered viewport, in framebuffer pixels. It is smaller than the viewport size
+    // when only a part of the viewport is rendered in a tile of a tiled export.
+    if (viewport.tile.x == 0)
+        return vec2(viewport.size);
+    return vec2(viewport.size) / viewport.tile.xy;
+}
+
+
+
 mat4 get_ortho_matrix(vec2 size) {
     // The orthographic projection is:
     //    2/w            -1
@@ -18,6 +18,8 @@
 #define DVZ_GRID_MAX_ROWS         64
 #define DVZ_MAX_PANELS            1024
 #define DVZ_MAX_VISUALS_PER_PANEL 64
+#define DVZ_MAX_MVP_BLOCKS        8  // maximum number of packed MVP buffers per grid
+#define DVZ_MVP_BLOCK_MIN         16 // minimum number of panels in the first packed MVP buffer
 
 // Group index of the set of panel DvzCommands objects.
 #define DVZ_COMMANDS_GROUP_PANELS 1
@@ -63,6 +65,7 @@ typedef enum
 
 typedef struct DvzGrid DvzGrid;
 typedef struct DvzPanel DvzPanel;
+typedef struct DvzMVPBlock DvzMVPBlock;
 typedef struct DvzController DvzController;
 
 
@@ -96,9 +99,12 @@ struct DvzPanel
 
     // Viewport.
     DvzViewport viewport;
+    bool viewport_empty; // the viewport is outside of the current tile of a tiled export
 
     // GPU objects
-    DvzBufferRegions br_mvp; // for the uniform buffer containing the MVP
+    DvzBufferRegions br_mvp; // for the uniform buffer containing the MVP, within an MVP block
+    uint32_t mvp_block;      // index of the MVP block of the grid
+    uint32_t mvp_slot;       // index of the panel MVP within the MVP block
 
     DvzController* controller;
     DvzCommands* cmds;
@@ -107,6 +113,19 @@ struct DvzPanel
 
 
 
+// MVP uniforms of consecutive panels, packed in a single mappable uniform buffer, so that they
+// can all be updated at every frame with a single copy.
+struct DvzMVPBlock
+{
+    uint32_t count;
+    uint32_t capacity;
+    VkDeviceSize stride; // size of an MVP struct aligned for uniform buffer offsets
+    DvzBufferRegions br; // one region of `capacity` MVP structs per swapchain image
+    void* data;          // packed MVP structs, uploaded at every frame
+};
+
+
+
 struct DvzGrid
 {
     DvzCanvas* canvas;
@@ -119,6 +138,10 @@ struct DvzGrid
     double heights[DVZ_GRID_MAX_ROWS];
 
     DvzContainer panels;
+
+    // Packed MVP uniforms of the panels, a new block is allocated when the last one is full.
+    uint32_t mvp_block_count;
+    DvzMVPBlock mvp_blocks[DVZ_MAX_MVP_BLOCKS];
 };
 
 
@@ -52,6 +52,10 @@ typedef enum
     DVZ_VISUAL_FLAGS_TRANSFORM_NONE = 0x0010,
     DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT = 0x0020, // do not recompute the panel box whenever
                                                   // the POS prop changes
+    DVZ_VISUAL_FLAGS_TRANSFORM_CPU = 0x0040, // always normalize the POS props on the CPU
+    DVZ_VISUAL_FLAGS_LOD = 0x0080, // screen-space level of detail (single line strips and paths,
+                                   // DVEC3 positions or VEC3 positions with an origin)
+    DVZ_VISUAL_FLAGS_SPATIAL_INDEX = 0x4000, // maintain a spatial index of the positions
 } DvzVisualFlags;
 
 
@@ -82,6 +86,7 @@ typedef struct DvzSceneUpdate DvzSceneUpdate;
 typedef struct DvzController DvzController;
 typedef struct DvzTransformOLD DvzTransformOLD;
 typedef struct DvzAxes2D DvzAxes2D;
+typedef struct DvzAxesJob DvzAxesJob;
 typedef union DvzControllerUnion DvzControllerUnion;
 
 typedef void (*DvzControllerCallback)(DvzController* controller, DvzEvent ev);
@@ -111,6 +116,8 @@ struct DvzAxes2D
 {
     DvzAxesContext ctx[2]; // one per dimension
     DvzAxesTicks ticks[2];
+    DvzAxesTicksCache cache[2]; // recently computed ticks, one cache per dimension
+    DvzAxesJob* jobs[2];        // ticks and vertices computed in the background, if any
     DvzBox box; // box, in data coordinates, corresponding to the box showed with initial panzoom
     float font_size;
 };
@@ -145,6 +152,22 @@ struct DvzController
 
 
 
+// Consecutive visuals of a panel with the same graphics pipeline and the same uniforms, drawn
+// with a single pipeline binding from a shared vertex buffer.
+struct DvzDrawBatch
+{
+    uint32_t visual_count;
+    uint32_t visual_capacity;
+    DvzVisual** visuals; // the first visual provides the pipeline and the bindings
+    uint32_t* first;     // first vertex of each visual in the shared vertex buffer
+
+    uint32_t vertex_count;
+    DvzArray vertices;   // copy of the vertex data of all visuals
+    DvzBufferRegions br; // shared vertex buffer
+};
+
+
+
 struct DvzScene
 {
     DvzObject obj;
@@ -161,6 +184,15 @@ struct DvzScene
 
     // FIFO queue with the pending scene updates.
     DvzFifo update_fifo;
+
+    // Draw batches, rebuilt when the command buffers are refilled.
+    uint32_t batch_count;
+    uint32_t batch_capacity;
+    DvzDrawBatch* batches;
+
+    // Snapshot file mapped in memory, referenced by the arrays of the loaded visuals.
+    void* snapshot;
+    VkDeviceSize snapshot_size;
 };
 
 
@@ -195,6 +227,41 @@ DVZ_EXPORT void dvz_scene_destroy(DvzScene* scene);
 
 
 
+/*************************************************************************************************/
+/*  Snapshots                                                                                    */
+/*************************************************************************************************/
+
+/**
+ * Save a scene to a binary snapshot file.
+ *
+ * The snapshot contains the grid, the panels with their data coordinates, and the visuals with
+ * their props and, if they have already been baked, their baked vertex, index, uniform and
+ * texture data. The visuals of the controllers, such as the axes, are not saved.
+ *
+ * !!! note
+ *     The snapshot can only be loaded by the same version of the library on the same platform.
+ *
+ * @param scene the scene
+ * @param path the path to the snapshot file
+ * @returns 0 if the snapshot was successfully saved
+ */
+DVZ_EXPORT int dvz_scene_save(DvzScene* scene, const char* path);
+
+/**
+ * Create a scene from a binary snapshot file.
+ *
+ * The file is mapped in memory and the visual arrays reference the mapping, which remains valid
+ * until the scene is destroyed. The baked data is uploaded to the GPU without baking the visuals
+ * again, and the panels are not renormalized if their data coordinates have not changed.
+ *
+ * @param canvas the canvas, which must not have a scene yet
+ * @param path the path to the snapshot file
+ * @returns a pointer to the created scene, or NULL if the file could not be loaded
+ */
+DVZ_EXPORT DvzScene* dvz_scene_load(DvzCanvas* canvas, const char* path);
+
+
+
 /*************************************************************************************************/
 /*  Controller                                                                                   */
 /*************************************************************************************************/
@@ -366,6 +433,64 @@ DVZ_EXPORT void dvz_arcball_rotate(DvzPanel* panel, float angle, vec3 axis);
 
 
 
+/*************************************************************************************************/
+/*  Spatial queries                                                                              */
+/*************************************************************************************************/
+
+/**
+ * Find the item of a visual nearest to a position, using a spatial index over the x and y
+ * coordinates of its POS prop.
+ *
+ * The spatial index is created on the first query, unless the visual has been created with the
+ * `DVZ_VISUAL_FLAGS_SPATIAL_INDEX` flag. It is then rebuilt in the background after the visual
+ * data changes, and updated incrementally when items are appended.
+ *
+ * !!! note
+ *     The queries are meant for 2D panels: the distances are computed in the (x, y) plane.
+ *
+ * @param panel the panel of the visual, may be NULL if the source is `DVZ_CDS_DATA`
+ * @param visual the visual
+ * @param source the coordinate system of the position and of the radius
+ * @param pos the position, for example the mouse position with `DVZ_CDS_WINDOW`
+ * @param radius the maximum distance to the nearest item, or 0 for no maximum distance
+ * @param[out] item the index of the nearest item in the POS prop
+ * @returns whether an item was found within the radius
+ */
+DVZ_EXPORT bool dvz_visual_nearest(
+    DvzPanel* panel, DvzVisual* visual, DvzCDS source, dvec3 pos, double radius, uint32_t* item);
+
+/**
+ * Find the items of a visual within a rectangle.
+ *
+ * @param panel the panel of the visual, may be NULL if the source is `DVZ_CDS_DATA`
+ * @param visual the visual
+ * @param source the coordinate system of the rectangle
+ * @param pos0 one corner of the rectangle
+ * @param pos1 the opposite corner of the rectangle
+ * @param[out] selection array of `DVZ_DTYPE_UINT` receiving the item indices in increasing order
+ * @returns the number of selected items
+ */
+DVZ_EXPORT uint32_t dvz_visual_select_rect(
+    DvzPanel* panel, DvzVisual* visual, DvzCDS source, dvec3 pos0, dvec3 pos1,
+    DvzArray* selection);
+
+/**
+ * Find the items of a visual within a polygon (lasso selection), with the even-odd rule.
+ *
+ * @param panel the panel of the visual, may be NULL if the source is `DVZ_CDS_DATA`
+ * @param visual the visual
+ * @param source the coordinate system of the polygon
+ * @param point_count the number of vertices of the polygon
+ * @param points the vertices of the polygon
+ * @param[out] selection array of `DVZ_DTYPE_UINT` receiving the item indices in increasing order
+ * @returns the number of selected items
+ */
+DVZ_EXPORT uint32_t dvz_visual_select_polygon(
+    DvzPanel* panel, DvzVisual* visual, DvzCDS source, uint32_t point_count, dvec3* points,
+    DvzArray* selection);
+
+
+
 static void _default_controller_callback(DvzController* controller, DvzEvent ev)
 {
     DvzScene* scene = controller->panel->scene;
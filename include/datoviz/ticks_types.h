@@ -9,6 +9,14 @@
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_TICKS_CACHE_SIZE 16
+
+
+
 /*************************************************************************************************/
 /*  Enums                                                                                        */
 /*************************************************************************************************/
@@ -29,6 +37,8 @@ typedef enum
 
 typedef struct DvzAxesContext DvzAxesContext;
 typedef struct DvzAxesTicks DvzAxesTicks;
+typedef struct DvzAxesTicksKey DvzAxesTicksKey;
+typedef struct DvzAxesTicksCache DvzAxesTicksCache;
 typedef struct Q Q;
 
 
@@ -63,4 +73,26 @@ struct DvzAxesTicks
 
 
 
+struct DvzAxesTicksKey
+{
+    int64_t span;        // quantized log2 of the requested range length
+    int64_t center;      // quantized center of the requested range, in span quanta
+    float size_viewport; // along the current dimension
+    float size_glyph;    // either width or height
+    uint32_t extensions; // number of extensions on each side
+};
+
+
+
+// Ticks computed for the most recent requested ranges, replaced in FIFO order.
+struct DvzAxesTicksCache
+{
+    uint32_t count; // number of cached ticks
+    uint32_t next;  // next entry to replace when the cache is full
+    DvzAxesTicksKey keys[DVZ_TICKS_CACHE_SIZE];
+    DvzAxesTicks ticks[DVZ_TICKS_CACHE_SIZE];
+};
+
+
+
 #endif
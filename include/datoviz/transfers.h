@@ -10,6 +10,14 @@
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_MAX_TRANSFER_PUSH_SIZE 64
+
+
+
 /*************************************************************************************************/
 /*  Transfer enums                                                                               */
 /*************************************************************************************************/
@@ -24,6 +32,7 @@ typedef enum
     DVZ_TRANSFER_TEXTURE_UPLOAD,
     DVZ_TRANSFER_TEXTURE_DOWNLOAD,
     DVZ_TRANSFER_TEXTURE_COPY,
+    DVZ_TRANSFER_COMPUTE,
 } DvzDataTransferType;
 
 
@@ -37,6 +46,7 @@ typedef struct DvzTransferBuffer DvzTransferBuffer;
 typedef struct DvzTransferBufferCopy DvzTransferBufferCopy;
 typedef struct DvzTransferTexture DvzTransferTexture;
 typedef struct DvzTransferTextureCopy DvzTransferTextureCopy;
+typedef struct DvzTransferCompute DvzTransferCompute;
 typedef union DvzTransferUnion DvzTransferUnion;
 
 
@@ -81,12 +91,23 @@ struct DvzTransferTextureCopy
 
 
 
+struct DvzTransferCompute
+{
+    DvzCompute* compute;
+    uvec3 size;
+    uint32_t push_size;
+    unsigned char push[DVZ_MAX_TRANSFER_PUSH_SIZE];
+};
+
+
+
 union DvzTransferUnion
 {
     DvzTransferBuffer buf;
     DvzTransferTexture tex;
     DvzTransferBufferCopy buf_copy;
     DvzTransferTextureCopy tex_copy;
+    DvzTransferCompute compute;
 };
 
 
@@ -188,6 +209,21 @@ DVZ_EXPORT void dvz_copy_texture(
     DvzCanvas* canvas, DvzTexture* src, uvec3 src_offset, DvzTexture* dst, uvec3 dst_offset,
     uvec3 shape, VkDeviceSize size);
 
+/**
+ * Dispatch a compute pipeline on the compute queue, after the pending transfers.
+ *
+ * The compute pipeline must have been created, with its bindings set. The dispatch is
+ * synchronous: the render queue waits for its completion.
+ *
+ * @param canvas the canvas
+ * @param compute the compute pipeline
+ * @param size the number of workgroups along the three dimensions
+ * @param push_size the size of the push constants, in bytes (0 if none)
+ * @param push pointer to the push constants, copied into the transfer
+ */
+DVZ_EXPORT void dvz_dispatch_compute(
+    DvzCanvas* canvas, DvzCompute* compute, uvec3 size, uint32_t push_size, const void* push);
+
 /**
  * Process the pending transfers.
  *
@@ -197,13 +197,29 @@ MAKE_TRANSPOSE(vec3)
  * Apply a CPU builtin transformation on position data.
  *
  * @param coords the data coordinate system and bounds
- * @param pos_in input array of dvec3 values
- * @param[out] pos_out output array of dvec3 values
+ * @param pos_in input array of dvec3 or vec3 values
+ * @param[out] pos_out output array of dvec3 or vec3 values
  * @param inverse whether to use the inverse or forward transformation
  */
 DVZ_EXPORT void
 dvz_transform_pos(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out, bool inverse);
 
+/**
+ * Apply a CPU builtin transformation on position data relative to an origin.
+ *
+ * The input positions are offsets relative to a double-precision origin (relative-to-center
+ * encoding). The transformation is computed in double precision, so that single-precision
+ * offsets keep their precision even when the origin is far from zero.
+ *
+ * @param coords the data coordinate system and bounds
+ * @param origin the origin of the input positions, in the data coordinate system
+ * @param pos_in input array of dvec3 or vec3 offsets
+ * @param[out] pos_out output array of dvec3 or vec3 values
+ * @param inverse whether to use the inverse or forward transformation
+ */
+DVZ_EXPORT void dvz_transform_pos_origin(
+    DvzDataCoords coords, dvec3 origin, DvzArray* pos_in, DvzArray* pos_out, bool inverse);
+
 /**
  * Convert a 3D position from a coordinate system to another.
  *
@@ -21,6 +21,9 @@
 #define DVZ_MAX_VISUAL_GROUPS       1024
 #define DVZ_MAX_VISUAL_PRIORITY     4
 #define DVZ_MAX_UNIFORM_SIZE        65536
+#define DVZ_ITEM_RANGE_ALL          UINT32_MAX
+#define DVZ_LOD_MAX_LEVELS          32
+#define DVZ_RING_OVERLAP            2
 
 
 /*************************************************************************************************/
@@ -109,6 +112,7 @@ typedef enum
     DVZ_SOURCE_TYPE_TRANSFER,      //
     DVZ_SOURCE_TYPE_COLOR_TEXTURE, //
     DVZ_SOURCE_TYPE_FONT_ATLAS,    //
+    DVZ_SOURCE_TYPE_STORAGE,       //
     DVZ_SOURCE_TYPE_OTHER,         //
 
     DVZ_SOURCE_TYPE_COUNT,
@@ -132,6 +136,7 @@ typedef enum
 typedef enum
 {
     DVZ_SOURCE_FLAG_MAPPABLE = 0x0001,
+    DVZ_SOURCE_FLAG_GPU_BAKE = 0x0002, // the buffer is filled on the GPU by a compute shader
 } DvzSourceFlags;
 
 
@@ -159,6 +164,10 @@ typedef struct DvzProp DvzProp;
 
 typedef union DvzSourceUnion DvzSourceUnion;
 typedef struct DvzSource DvzSource;
+typedef struct DvzItemRange DvzItemRange;
+typedef struct DvzLod DvzLod;
+typedef struct DvzSpatialIndex DvzSpatialIndex;
+typedef struct DvzDrawBatch DvzDrawBatch;
 
 typedef struct DvzVisualFillEvent DvzVisualFillEvent;
 typedef struct DvzVisualDataEvent DvzVisualDataEvent;
@@ -190,10 +199,27 @@ enqueue data transfers
 
 
 
+typedef void (*DvzVisualReleaseCallback)(DvzVisual* visual, void* data, void* user_data);
+/*
+called when a prop stops referencing the caller memory passed to dvz_visual_data_borrow()
+the caller may then free or reuse that memory
+*/
+
+
+
 /*************************************************************************************************/
 /*  Source structs                                                                               */
 /*************************************************************************************************/
 
+// Range of items that have changed since the last bake/upload. A zero count means that nothing
+// has changed, a DVZ_ITEM_RANGE_ALL count means that all items have changed.
+struct DvzItemRange
+{
+    uint32_t first;
+    uint32_t count;
+};
+
+
 union DvzSourceUnion
 {
     DvzBufferRegions br;
@@ -225,6 +251,7 @@ struct DvzSource
 
     DvzSourceOrigin origin; // whether the underlying GPU object is handled by the user or datoviz
     DvzSourceUnion u;
+    DvzItemRange dirty; // items of the source array that need to be uploaded
 };
 
 
@@ -254,6 +281,67 @@ struct DvzProp
     DvzArrayCopyType copy_type;
     uint32_t reps; // number of repeats when copying
     // bool is_set; // whether the user has set this prop
+
+    DvzItemRange dirty; // items of the prop array that need to be transformed and baked
+    dvec3 origin;       // origin of single-precision POS props (relative-to-center encoding)
+
+    // Caller memory borrowed by arr_orig, and callback called when the prop stops referencing it.
+    void* borrowed;
+    DvzVisualReleaseCallback release;
+    void* release_data;
+
+    uint64_t ring_written; // total number of items appended to the prop in a circular buffer
+
+    // Bounding box of arr_orig for POS props, without the origin, maintained incrementally.
+    DvzBox bounds;
+    bool bounds_valid; // false when all items need to be scanned again
+};
+
+
+
+// Screen-space level of detail of a line strip or path (see DVZ_VISUAL_FLAGS_LOD), with DVEC3
+// positions or VEC3 positions relative to an origin (see dvz_visual_prop_origin()).
+struct DvzLod
+{
+    uint32_t item_count;                      // number of original samples
+    bool sorted;                              // whether the x coordinates are increasing
+    double origin;                            // x origin of VEC3 positions
+    uint32_t level_count;                     // number of levels, level 0 is the original data
+    uint32_t bucket_size[DVZ_LOD_MAX_LEVELS]; // number of samples per bucket in each level
+    DvzArray levels[DVZ_LOD_MAX_LEVELS];      // indices of the samples kept in each level
+
+    // Visible range, updated by the scene at every panzoom.
+    dvec2 range; // visible x range, in data coordinates
+    float width; // viewport width, in pixels
+
+    // Selection.
+    uint32_t level; // uploaded level
+    uint32_t first; // first original sample of the uploaded window
+    uint32_t count; // number of original samples in the uploaded window
+};
+
+
+
+// Uniform grid over the x and y coordinates of the POS prop #0, for hover and selection queries
+// (see dvz_visual_nearest()).
+struct DvzSpatialIndex
+{
+    // Copy of the positions, in data coordinates.
+    uint32_t item_count;    // number of indexed items
+    uint32_t item_capacity; // number of allocated positions
+    dvec2* pos;             // x and y coordinates of the items
+    bool stale;             // whether the positions need to be copied again from the prop
+
+    // Grid over the first grid_count items, the next items are scanned linearly.
+    uint32_t grid_count;
+    DvzBox box;           // bounds of the grid, only x and y are used
+    uvec2 shape;          // number of cells along x and y
+    uint32_t* cell_first; // index of the first item of each cell in items, plus the item count
+    uint32_t* items;      // indices of the items sorted by cell
+
+    // Build in a worker thread.
+    DvzTaskGroup group;
+    bool building;
 };
 
 
@@ -266,6 +354,7 @@ struct DvzVisual
 {
     DvzObject obj;
     DvzCanvas* canvas;
+    int type; // builtin visual type (DvzVisualType), DVZ_VISUAL_NONE for custom visuals
     int flags;
     int priority;
     void* user_data;
@@ -290,6 +379,7 @@ struct DvzVisual
     // Data callbacks.
     // DvzVisualDataCallback callback_transform;
     DvzVisualDataCallback callback_bake;
+    DvzVisualDataCallback callback_bake_gpu;
 
     // Sources.
     DvzContainer sources;
@@ -305,6 +395,33 @@ struct DvzVisual
     DvzInteractAxis interact_axis[DVZ_MAX_GRAPHICS_PER_VISUAL];
     DvzViewportClip clip[DVZ_MAX_GRAPHICS_PER_VISUAL];
     DvzViewport viewport; // usually the visual's panel viewport, but may be customized
+    bool transform_gpu;   // whether the POS props are normalized by the GPU, set by the scene
+
+    // Circular vertex buffer (see dvz_visual_ring()).
+    uint32_t ring_capacity; // 0 if the vertex props are not circular
+    uint32_t ring_head;     // index of the oldest vertex
+    uint32_t ring_count;    // number of valid vertices
+    // Two indirect draw commands per graphics pipeline, from the oldest vertex to the end of the
+    // buffer and from the beginning of the buffer to the newest vertex.
+    VkDrawIndirectCommand ring_draws[2 * DVZ_MAX_GRAPHICS_PER_VISUAL];
+    DvzBufferRegions br_ring_draws;
+
+    DvzLod* lod; // level of detail, only with DVZ_VISUAL_FLAGS_LOD
+
+    DvzSpatialIndex* spatial; // spatial index, created on the first query or with
+                              // DVZ_VISUAL_FLAGS_SPATIAL_INDEX
+
+    // Culling, updated by the scene at every frame.
+    bool hidden;                              // hidden by the user (see dvz_visual_visible())
+    bool culled;                              // outside of the current view of the panel
+    uint32_t group_culled_count;              // number of groups outside of the current view
+    bool group_culled[DVZ_MAX_VISUAL_GROUPS]; // whether each group is outside of the view
+    DvzBox* group_boxes; // bounding box of each group in data coordinates, NULL if outdated
+
+    // Draw batching, updated by the scene when the command buffers are refilled.
+    DvzDrawBatch* batch; // batch of consecutive visuals drawn together, NULL if drawn alone
+    bool batch_changed;  // whether the vertex data has changed since it was copied to the batch
+    bool batch_outdated; // whether the own vertex buffer was not uploaded while in a batch
 
     // GPU data
     DvzContainer bindings;
@@ -452,6 +569,23 @@ DVZ_EXPORT void dvz_visual_prop_cast(
 
 DVZ_EXPORT void dvz_visual_prop_dpi(DvzProp* prop, float dpi_scaling);
 
+/**
+ * Store a POS prop in single precision, relative to a double-precision origin.
+ *
+ * The prop data is then expected as `vec3` offsets relative to the origin (relative-to-center
+ * encoding), instead of `dvec3` positions. The data normalization is computed in double precision
+ * and the normalized positions are stored in single precision, which divides the host memory
+ * used by the prop by two. Any data previously set to the prop is discarded.
+ *
+ * This is only supported by POS props that are directly cast to `vec3` in the vertex buffer,
+ * in visuals that use the default baking function. The origin is only used by the data
+ * normalization: it is ignored by visuals that are not transformed by the scene.
+ *
+ * @param prop the POS prop
+ * @param origin the origin of the positions, in the data coordinate system
+ */
+DVZ_EXPORT void dvz_visual_prop_origin(DvzProp* prop, dvec3 origin);
+
 /**
  * Add a graphics pipeline to a visual.
  *
@@ -463,6 +597,9 @@ DVZ_EXPORT void dvz_visual_graphics(DvzVisual* visual, DvzGraphics* graphics);
 /**
  * Add a compute pipeline to a visual.
  *
+ * The visual creates the bindings of the compute pipeline, so that its slots and push constants
+ * must be declared before this call, and `dvz_compute_create()` must be called after it.
+ *
  * @param visual the visual
  * @param compute the compute pipeline
  */
@@ -499,7 +636,9 @@ DVZ_EXPORT void dvz_visual_data(
  * Set partial data for a given visual prop.
  *
  * If the specified data has less elements than the number of elements to update, the last element
- * will be repeated as many times as necessary.
+ * will be repeated as many times as necessary. The prop is grown if needed, but the existing items
+ * after the updated range are kept. Only the updated range is baked and uploaded to the GPU, as
+ * long as the number of items in the prop does not change.
  *
  * @param visual the visual
  * @param prop_type the prop type
@@ -516,6 +655,9 @@ DVZ_EXPORT void dvz_visual_data_partial(
 /**
  * Append elements to the prop.
  *
+ * In visuals with a circular vertex buffer (see `dvz_visual_ring()`), the oldest items of vertex
+ * props are overwritten instead.
+ *
  * @param visual the visual
  * @param prop_type the prop type
  * @param prop_idx the prop index
@@ -525,6 +667,46 @@ DVZ_EXPORT void dvz_visual_data_partial(
 DVZ_EXPORT void dvz_visual_data_append(
     DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data);
 
+/**
+ * Set the data for a given visual prop without copying it.
+ *
+ * The prop references the caller memory, which is read directly when baking and uploading the
+ * visual. The memory must remain valid, and should not be modified, until the release callback
+ * is called: when the prop data is set again, or when the visual is destroyed. Modifying the prop
+ * with `dvz_visual_data_partial()` or `dvz_visual_data_append()` makes a private copy first.
+ *
+ * @param visual the visual
+ * @param prop_type the prop type
+ * @param prop_idx the prop index
+ * @param count the number of elements in `data`
+ * @param data the data, that should be in the dtype of the prop
+ * @param release the callback called when the prop stops referencing `data` (may be NULL)
+ * @param user_data pointer passed to the release callback
+ */
+DVZ_EXPORT void dvz_visual_data_borrow(
+    DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, void* data,
+    DvzVisualReleaseCallback release, void* user_data);
+
+/**
+ * Use a fixed-capacity circular buffer for the vertex props of a visual (streaming mode).
+ *
+ * The vertex props are allocated with the given capacity, and `dvz_visual_data_append()` then
+ * overwrites the oldest items instead of growing the props. The vertex count never changes, so
+ * that appending new items only bakes and uploads these items, without any GPU buffer
+ * reallocation or command buffer refill. The POS prop #0 determines the oldest and valid
+ * vertices, the other vertex props should be appended with the same number of items.
+ *
+ * The vertices are drawn in time order with two indirect draws, whose parameters are uploaded
+ * when items are appended. The first `DVZ_RING_OVERLAP` vertices are duplicated after the end of
+ * the buffer, so that line and triangle strips continue across the wraparound. The wraparound
+ * offset is also passed in the viewport uniform (see `ring_age()` in the shaders). This is only
+ * supported by the graphics with one vertex per item, such as the basic graphics.
+ *
+ * @param visual the visual
+ * @param capacity the number of vertices in the circular buffer, or 0 to disable it
+ */
+DVZ_EXPORT void dvz_visual_ring(DvzVisual* visual, uint32_t capacity);
+
 /**
  * Set partial data for a given source.
  *
@@ -570,6 +752,16 @@ DVZ_EXPORT void dvz_visual_texture(
  */
 DVZ_EXPORT void dvz_visual_flags(DvzVisual* visual, int flags);
 
+/**
+ * Show or hide a visual.
+ *
+ * Hidden visuals are skipped when the command buffers are filled.
+ *
+ * @param visual the visual
+ * @param visible whether the visual should be visible
+ */
+DVZ_EXPORT void dvz_visual_visible(DvzVisual* visual, bool visible);
+
 
 
 /*************************************************************************************************/
@@ -623,11 +815,28 @@ DVZ_EXPORT void dvz_visual_fill_end(DvzCanvas* canvas, DvzCommands* cmds, uint32
  *
  * Callback function signature: `void(DvzVisual*, DvzVisualDataEvent)`
  *
+ * In a scene, the callback may be called from a worker thread, concurrently with the bake
+ * callbacks of other visuals. It should only access the given visual and make no GPU call.
+ *
  * @param visual the visual
  * @param callback the bake callback function
  */
 DVZ_EXPORT void dvz_visual_callback_bake(DvzVisual* visual, DvzVisualDataCallback callback);
 
+/**
+ * Set the visual GPU bake callback function.
+ *
+ * Callback function signature: `void(DvzVisual*, DvzVisualDataEvent)`
+ *
+ * The callback is called by `dvz_visual_upload()`, in the thread owning the GPU objects, when the
+ * bake callback has marked sources with `DVZ_SOURCE_FLAG_GPU_BAKE`. These sources are allocated
+ * on the GPU but not uploaded: the callback is expected to fill them with a compute shader.
+ *
+ * @param visual the visual
+ * @param callback the GPU bake callback function
+ */
+DVZ_EXPORT void dvz_visual_callback_bake_gpu(DvzVisual* visual, DvzVisualDataCallback callback);
+
 
 
 /*************************************************************************************************/
@@ -704,9 +913,34 @@ DVZ_EXPORT void* dvz_prop_item(DvzProp* prop, uint32_t prop_idx);
 /*  Data update                                                                                  */
 /*************************************************************************************************/
 
+/**
+ * Bake the visual props into the visual sources, on the CPU only.
+ *
+ * This function makes no GPU call and may run in a worker thread, concurrently with the baking
+ * of other visuals. It is followed by `dvz_visual_upload()`.
+ *
+ * @param visual the visual
+ * @param viewport the viewport
+ * @param coords the data coordinates and transformation
+ * @param user_data arbitrary user data pointer
+ */
+DVZ_EXPORT void dvz_visual_bake(
+    DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data);
+
+/**
+ * Upload the baked visual sources to the GPU buffers and textures.
+ *
+ * This function must be called from the thread owning the GPU objects.
+ *
+ * @param visual the visual
+ */
+DVZ_EXPORT void dvz_visual_upload(DvzVisual* visual);
+
 /**
  * Update all GPU buffers and textures from the visual props and sources.
  *
+ * This function calls `dvz_visual_bake()` followed by `dvz_visual_upload()`.
+ *
  * @param visual the visual
  * @param viewport the viewport
  * @param coords the data coordinates and transformation
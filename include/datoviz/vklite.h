@@ -156,6 +156,7 @@ typedef enum
 {
     DVZ_GRAPHICS_FLAGS_DEPTH_TEST = 0x0100,
     DVZ_GRAPHICS_FLAGS_PICK = 0x0200,
+    DVZ_GRAPHICS_FLAGS_INSTANCED = 0x8000, // one vertex buffer item per instance
 } DvzGraphicsFlags;
 
 
@@ -324,6 +325,10 @@ struct DvzQueues
     uint32_t queue_indices[DVZ_MAX_QUEUES];  // for each requested queue, its # within its family
     VkQueue queues[DVZ_MAX_QUEUES];
     VkCommandPool cmd_pools[DVZ_MAX_QUEUE_FAMILIES];
+
+    // Host access to a VkQueue must be externally synchronized. Several requested queues may
+    // share the same VkQueue, in which case they share the lock of the first of them.
+    pthread_mutex_t locks[DVZ_MAX_QUEUES];
 };
 
 
@@ -347,6 +352,7 @@ struct DvzGpu
 
     DvzQueues queues;
     VkDescriptorPool dset_pool;
+    pthread_mutex_t dset_lock; // the descriptor pool is shared by all threads
 
     VkPhysicalDeviceFeatures requested_features;
     VkDevice device;
@@ -401,6 +407,7 @@ struct DvzCommands
 
     uint32_t queue_idx;
     uint32_t count;
+    VkCommandPool pool; // command pool the command buffers were allocated from
     VkCommandBuffer cmds[DVZ_MAX_COMMAND_BUFFERS_PER_SET];
 };
 
@@ -543,6 +550,7 @@ struct DvzVertexBinding
 {
     uint32_t binding;
     VkDeviceSize stride;
+    VkVertexInputRate input_rate;
 };
 
 
@@ -585,6 +593,10 @@ struct DvzGraphics
     uint32_t vertex_attr_count;
     DvzVertexAttr vertex_attrs[DVZ_MAX_VERTEX_ATTRS];
 
+    // Number of vertices generated by the vertex shader for every instance, when the vertex
+    // buffer has a per-instance input rate. 0 if the graphics is not instanced.
+    uint32_t instance_vertex_count;
+
     uint32_t shader_count;
     VkShaderStageFlagBits shader_stages[DVZ_MAX_SHADERS_PER_GRAPHICS];
     VkShaderModule shader_modules[DVZ_MAX_SHADERS_PER_GRAPHICS];
@@ -863,6 +875,26 @@ DVZ_EXPORT void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface);
  */
 DVZ_EXPORT void dvz_queue_wait(DvzGpu* gpu, uint32_t queue_idx);
 
+/**
+ * Acquire the lock of a queue.
+ *
+ * All vklite functions submitting to or waiting on a queue acquire its lock, so that several
+ * threads may share the same queues. This function is only needed when calling Vulkan queue
+ * functions directly.
+ *
+ * @param gpu the GPU
+ * @param queue_idx the queue index
+ */
+DVZ_EXPORT void dvz_queue_lock(DvzGpu* gpu, uint32_t queue_idx);
+
+/**
+ * Release the lock of a queue.
+ *
+ * @param gpu the GPU
+ * @param queue_idx the queue index
+ */
+DVZ_EXPORT void dvz_queue_unlock(DvzGpu* gpu, uint32_t queue_idx);
+
 /**
  * Full synchronization on all GPUs.
  *
@@ -1057,6 +1089,38 @@ DVZ_EXPORT void dvz_swapchain_destroy(DvzSwapchain* swapchain);
  */
 DVZ_EXPORT DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count);
 
+/**
+ * Create a command pool on the queue family of a given queue.
+ *
+ * Command pools must be externally synchronized, so that a thread recording command buffers
+ * concurrently with other threads needs its own command pool.
+ *
+ * @param gpu the GPU
+ * @param queue the queue index within the GPU
+ * @returns the command pool
+ */
+DVZ_EXPORT VkCommandPool dvz_cmd_pool(DvzGpu* gpu, uint32_t queue);
+
+/**
+ * Destroy a command pool, and free all command buffers allocated from it.
+ *
+ * @param gpu the GPU
+ * @param pool the command pool
+ */
+DVZ_EXPORT void dvz_cmd_pool_destroy(DvzGpu* gpu, VkCommandPool pool);
+
+/**
+ * Create a set of command buffers from a given command pool.
+ *
+ * @param gpu the GPU
+ * @param queue the queue index within the GPU
+ * @param pool the command pool, created with `dvz_cmd_pool()` on the same queue
+ * @param count the number of command buffers to create
+ * @returns the set of command buffers
+ */
+DVZ_EXPORT DvzCommands
+dvz_commands_pool(DvzGpu* gpu, uint32_t queue, VkCommandPool pool, uint32_t count);
+
 /**
  * Start recording a command buffer.
  *
@@ -1575,6 +1639,15 @@ DVZ_EXPORT void dvz_compute_create(DvzCompute* compute);
  */
 DVZ_EXPORT void dvz_compute_code(DvzCompute* compute, const char* code);
 
+/**
+ * Set the SPIRV code of a compute pipeline.
+ *
+ * @param compute the compute pipeline
+ * @param size the size of the SPIRV buffer, in bytes
+ * @param buffer the binary buffer with the SPIRV code
+ */
+DVZ_EXPORT void dvz_compute_spirv(DvzCompute* compute, VkDeviceSize size, const uint32_t* buffer);
+
 /**
  * Declare a slot for the compute pipeline.
  *
@@ -1683,6 +1756,21 @@ dvz_graphics_shader(DvzGraphics* graphics, VkShaderStageFlagBits stage, const ch
 DVZ_EXPORT void
 dvz_graphics_vertex_binding(DvzGraphics* graphics, uint32_t binding, VkDeviceSize stride);
 
+/**
+ * Set the input rate of a vertex binding.
+ *
+ * With `VK_VERTEX_INPUT_RATE_INSTANCE`, the vertex attributes of the binding advance once per
+ * instance instead of once per vertex.
+ *
+ * @param graphics the graphics pipeline
+ * @param binding the binding index
+ * @param input_rate the input rate
+ * @param instance_vertex_count the number of vertices drawn for every instance
+ */
+DVZ_EXPORT void dvz_graphics_vertex_input_rate(
+    DvzGraphics* graphics, uint32_t binding, VkVertexInputRate input_rate,
+    uint32_t instance_vertex_count);
+
 /**
  * Add a vertex attribute.
  *
@@ -2227,6 +2315,23 @@ DVZ_EXPORT void dvz_cmd_barrier(DvzCommands* cmds, uint32_t idx, DvzBarrier* bar
 DVZ_EXPORT void dvz_cmd_copy_buffer_to_image(
     DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, DvzImages* images);
 
+/**
+ * Copy a GPU buffer to a region of a GPU image.
+ *
+ * The texels are tightly packed in the buffer, starting at the given buffer offset.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param buffer the buffer
+ * @param buf_offset the offset in the buffer, in bytes
+ * @param images the image
+ * @param offset the offset of the region in the image
+ * @param shape the shape of the region to copy
+ */
+DVZ_EXPORT void dvz_cmd_copy_buffer_to_image_region(
+    DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, VkDeviceSize buf_offset,
+    DvzImages* images, ivec3 offset, uvec3 shape);
+
 /**
  * Copy a GPU image to a GPU buffer.
  *
@@ -2238,6 +2343,42 @@ DVZ_EXPORT void dvz_cmd_copy_buffer_to_image(
 DVZ_EXPORT void dvz_cmd_copy_image_to_buffer(
     DvzCommands* cmds, uint32_t idx, DvzImages* images, DvzBuffer* buffer);
 
+/**
+ * Copy a region of a GPU image to a GPU buffer.
+ *
+ * The texels are tightly packed in the buffer, starting at the given buffer offset.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param images the image
+ * @param offset the offset of the region in the image
+ * @param shape the shape of the region to copy
+ * @param buffer the buffer
+ * @param buf_offset the offset in the buffer, in bytes
+ */
+DVZ_EXPORT void dvz_cmd_copy_image_region_to_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, ivec3 offset, uvec3 shape,
+    DvzBuffer* buffer, VkDeviceSize buf_offset);
+
+/**
+ * Copy several regions of a GPU image to a GPU buffer, with a single copy command.
+ *
+ * The texels of each region are tightly packed in the buffer, starting at the region's buffer
+ * offset.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param images the image
+ * @param count the number of regions
+ * @param offsets the offset of each region in the image
+ * @param shapes the shape of each region
+ * @param buffer the buffer
+ * @param buf_offsets the offset of each region in the buffer, in bytes
+ */
+DVZ_EXPORT void dvz_cmd_copy_image_regions_to_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, uint32_t count, const ivec3* offsets,
+    const uvec3* shapes, DvzBuffer* buffer, const VkDeviceSize* buf_offsets);
+
 /**
  * Copy a GPU image to another.
  *
@@ -2321,6 +2462,20 @@ DVZ_EXPORT void dvz_cmd_bind_index_buffer(
 DVZ_EXPORT void
 dvz_cmd_draw(DvzCommands* cmds, uint32_t idx, uint32_t first_vertex, uint32_t vertex_count);
 
+/**
+ * Direct instanced draw.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param first_vertex index of the first vertex
+ * @param vertex_count number of vertices to draw for every instance
+ * @param first_instance index of the first instance
+ * @param instance_count number of instances to draw
+ */
+DVZ_EXPORT void dvz_cmd_draw_instanced(
+    DvzCommands* cmds, uint32_t idx, uint32_t first_vertex, uint32_t vertex_count,
+    uint32_t first_instance, uint32_t instance_count);
+
 /**
  * Direct indexed draw.
  *
@@ -0,0 +1,674 @@
+#include "../include/datoviz/array.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define DVZ_SIMD_X86 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define DVZ_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DVZ_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+// Copy `count` items of `size` bytes from `src` to `dst` with the given strides. The cast kernels
+// convert the double values of each item to float.
+typedef void (*DvzCopyKernel)(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count);
+
+// Extend the bounding box [p0, p1] with `count` contiguous vec3 or dvec3 items. NaN values are
+// ignored.
+typedef void (*DvzBoundsKernel)(const void* data, uint32_t count, dvec3 p0, dvec3 p1);
+
+typedef struct DvzCopyKernels DvzCopyKernels;
+
+struct DvzCopyKernels
+{
+    const char* name;
+    DvzCopyKernel copy;
+    DvzCopyKernel cast[4]; // double to float cast, indexed by the number of components
+    DvzBoundsKernel bounds_vec3;
+    DvzBoundsKernel bounds_dvec3;
+};
+
+
+
+/*************************************************************************************************/
+/*  Scalar kernels                                                                               */
+/*************************************************************************************************/
+
+// NOTE: the fixed-size memcpy() calls below are inlined by the compiler.
+#define COPY_LOOP(n)                                                                              \
+    for (uint32_t i = 0; i < count; i++)                                                          \
+    {                                                                                             \
+        memcpy(dst, src, n);                                                                      \
+        dst += dst_stride;                                                                        \
+        src += src_stride;                                                                        \
+    }
+
+static void _copy_scalar(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    // Contiguous copy.
+    if (dst_stride == size && src_stride == size)
+    {
+        memcpy(dst, src, count * size);
+        return;
+    }
+
+    switch (size)
+    {
+    case 1:
+        COPY_LOOP(1)
+        break;
+    case 2:
+        COPY_LOOP(2)
+        break;
+    case 4:
+        COPY_LOOP(4)
+        break;
+    case 8:
+        COPY_LOOP(8)
+        break;
+    case 12:
+        COPY_LOOP(12)
+        break;
+    case 16:
+        COPY_LOOP(16)
+        break;
+    case 24:
+        COPY_LOOP(24)
+        break;
+    default:
+        COPY_LOOP(size)
+        break;
+    }
+}
+
+
+
+#define CAST_LOOP(n)                                                                              \
+    const double* s = NULL;                                                                       \
+    float* d = NULL;                                                                              \
+    for (uint32_t i = 0; i < count; i++)                                                          \
+    {                                                                                             \
+        s = (const double*)(src + i * src_stride);                                                \
+        d = (float*)(dst + i * dst_stride);                                                       \
+        for (uint32_t k = 0; k < n; k++)                                                          \
+            d[k] = (float)s[k];                                                                   \
+    }
+
+static void _cast1_scalar(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    CAST_LOOP(1)
+}
+
+static void _cast2_scalar(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    CAST_LOOP(2)
+}
+
+static void _cast3_scalar(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    CAST_LOOP(3)
+}
+
+
+// NOTE: the comparisons are written so that NaN values are ignored, as in the SIMD kernels.
+#define BOUNDS_LOOP(type)                                                                         \
+    const type* s = (const type*)data;                                                            \
+    for (uint32_t i = 0; i < 3 * count; i++)                                                      \
+    {                                                                                             \
+        if (s[i] < p0[i % 3])                                                                     \
+            p0[i % 3] = s[i];                                                                     \
+        if (s[i] > p1[i % 3])                                                                     \
+            p1[i % 3] = s[i];                                                                     \
+    }
+
+static void _bounds_vec3_scalar(const void* data, uint32_t count, dvec3 p0, dvec3 p1)
+{
+    BOUNDS_LOOP(float)
+}
+
+static void _bounds_dvec3_scalar(const void* data, uint32_t count, dvec3 p0, dvec3 p1)
+{
+    BOUNDS_LOOP(double)
+}
+
+
+
+// Reduce the lanes of the min/max accumulators of a flat array of xyz values: lane k holds
+// component k % 3.
+static void _bounds_lanes(uint32_t lanes, const double* lo, const double* hi, dvec3 p0, dvec3 p1)
+{
+    for (uint32_t k = 0; k < lanes; k++)
+    {
+        if (lo[k] < p0[k % 3])
+            p0[k % 3] = lo[k];
+        if (hi[k] > p1[k % 3])
+            p1[k % 3] = hi[k];
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  SSE2 kernels                                                                                 */
+/*************************************************************************************************/
+
+#if DVZ_SIMD_X86
+
+// NOTE: SSE2 is always available on x86-64.
+
+static void _cast1_sse2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    if (dst_stride != sizeof(float) || src_stride != sizeof(double))
+    {
+        _cast1_scalar(dst, dst_stride, src, src_stride, size, count);
+        return;
+    }
+    const double* s = (const double*)src;
+    float* d = (float*)dst;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(s + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(s + i + 2));
+        _mm_storeu_ps(d + i, _mm_movelh_ps(lo, hi));
+    }
+    for (; i < count; i++)
+        d[i] = (float)s[i];
+}
+
+static void _cast2_sse2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        __m128 f = _mm_cvtpd_ps(_mm_loadu_pd((const double*)(src + i * src_stride)));
+        _mm_storel_epi64((__m128i*)(dst + i * dst_stride), _mm_castps_si128(f));
+    }
+}
+
+static void _cast3_sse2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    // Contiguous arrays of dvec3 are converted as flat arrays of doubles.
+    if (dst_stride == 3 * sizeof(float) && src_stride == 3 * sizeof(double))
+    {
+        _cast1_sse2(dst, sizeof(float), src, sizeof(double), size, 3 * count);
+        return;
+    }
+    const double* s = NULL;
+    float* d = NULL;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        s = (const double*)(src + i * src_stride);
+        d = (float*)(dst + i * dst_stride);
+        __m128 xy = _mm_cvtpd_ps(_mm_loadu_pd(s));
+        __m128 z = _mm_cvtsd_ss(xy, _mm_load_sd(s + 2));
+        _mm_storel_epi64((__m128i*)d, _mm_castps_si128(xy));
+        _mm_store_ss(d + 2, z);
+    }
+}
+
+
+// The contiguous xyz values are processed as a flat array, 3 registers (2 points of dvec3, or 4
+// points of vec3) at a time, the lane k of the accumulators holding the component k % 3.
+static void _bounds_dvec3_sse2(const void* data, uint32_t count, dvec3 p0, dvec3 p1)
+{
+    const double* s = (const double*)data;
+    __m128d lo[3], hi[3], v;
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        lo[r] = _mm_set1_pd(INFINITY);
+        hi[r] = _mm_set1_pd(-INFINITY);
+    }
+    uint32_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        for (uint32_t r = 0; r < 3; r++)
+        {
+            // NOTE: the accumulator is the second operand, so that NaN values are ignored.
+            v = _mm_loadu_pd(s + 3 * i + 2 * r);
+            lo[r] = _mm_min_pd(v, lo[r]);
+            hi[r] = _mm_max_pd(v, hi[r]);
+        }
+    }
+    double lanes_lo[6], lanes_hi[6];
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        _mm_storeu_pd(lanes_lo + 2 * r, lo[r]);
+        _mm_storeu_pd(lanes_hi + 2 * r, hi[r]);
+    }
+    _bounds_lanes(6, lanes_lo, lanes_hi, p0, p1);
+    _bounds_dvec3_scalar(s + 3 * i, count - i, p0, p1);
+}
+
+static void _bounds_vec3_sse2(const void* data, uint32_t count, dvec3 p0, dvec3 p1)
+{
+    const float* s = (const float*)data;
+    __m128 lo[3], hi[3], v;
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        lo[r] = _mm_set1_ps(INFINITY);
+        hi[r] = _mm_set1_ps(-INFINITY);
+    }
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        for (uint32_t r = 0; r < 3; r++)
+        {
+            v = _mm_loadu_ps(s + 3 * i + 4 * r);
+            lo[r] = _mm_min_ps(v, lo[r]);
+            hi[r] = _mm_max_ps(v, hi[r]);
+        }
+    }
+    float f_lo[12], f_hi[12];
+    double lanes_lo[12], lanes_hi[12];
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        _mm_storeu_ps(f_lo + 4 * r, lo[r]);
+        _mm_storeu_ps(f_hi + 4 * r, hi[r]);
+    }
+    for (uint32_t k = 0; k < 12; k++)
+    {
+        lanes_lo[k] = f_lo[k];
+        lanes_hi[k] = f_hi[k];
+    }
+    _bounds_lanes(12, lanes_lo, lanes_hi, p0, p1);
+    _bounds_vec3_scalar(s + 3 * i, count - i, p0, p1);
+}
+
+#endif
+
+
+
+/*************************************************************************************************/
+/*  AVX2 kernels                                                                                 */
+/*************************************************************************************************/
+
+#if DVZ_SIMD_AVX2
+
+__attribute__((target("avx2"))) static void _cast1_avx2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    if (dst_stride != sizeof(float) || src_stride != sizeof(double))
+    {
+        _cast1_scalar(dst, dst_stride, src, src_stride, size, count);
+        return;
+    }
+    const double* s = (const double*)src;
+    float* d = (float*)dst;
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(s + i));
+        __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(s + i + 4));
+        _mm256_storeu_ps(d + i, _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+    }
+    for (; i < count; i++)
+        d[i] = (float)s[i];
+}
+
+__attribute__((target("avx2"))) static void _cast3_avx2(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    if (dst_stride == 3 * sizeof(float) && src_stride == 3 * sizeof(double))
+    {
+        _cast1_avx2(dst, sizeof(float), src, sizeof(double), size, 3 * count);
+        return;
+    }
+
+    // Masked loads and stores so as to never touch the bytes after each dvec3/vec3.
+    const __m256i mask_d = _mm256_set_epi64x(0, -1, -1, -1);
+    const __m128i mask_f = _mm_set_epi32(0, -1, -1, -1);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        __m256d v = _mm256_maskload_pd((const double*)(src + i * src_stride), mask_d);
+        _mm_maskstore_ps((float*)(dst + i * dst_stride), mask_f, _mm256_cvtpd_ps(v));
+    }
+}
+
+
+__attribute__((target("avx2"))) static void
+_bounds_dvec3_avx2(const void* data, uint32_t count, dvec3 p0, dvec3 p1)
+{
+    // 3 registers hold 4 points.
+    const double* s = (const double*)data;
+    __m256d lo[3], hi[3], v;
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        lo[r] = _mm256_set1_pd(INFINITY);
+        hi[r] = _mm256_set1_pd(-INFINITY);
+    }
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        for (uint32_t r = 0; r < 3; r++)
+        {
+            v = _mm256_loadu_pd(s + 3 * i + 4 * r);
+            lo[r] = _mm256_min_pd(v, lo[r]);
+            hi[r] = _mm256_max_pd(v, hi[r]);
+        }
+    }
+    double lanes_lo[12], lanes_hi[12];
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        _mm256_storeu_pd(lanes_lo + 4 * r, lo[r]);
+        _mm256_storeu_pd(lanes_hi + 4 * r, hi[r]);
+    }
+    _bounds_lanes(12, lanes_lo, lanes_hi, p0, p1);
+    _bounds_dvec3_scalar(s + 3 * i, count - i, p0, p1);
+}
+
+#endif
+
+
+
+/*************************************************************************************************/
+/*  NEON kernels                                                                                 */
+/*************************************************************************************************/
+
+#if DVZ_SIMD_NEON
+
+static void _cast1_neon(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    if (dst_stride != sizeof(float) || src_stride != sizeof(double))
+    {
+        _cast1_scalar(dst, dst_stride, src, src_stride, size, count);
+        return;
+    }
+    const double* s = (const double*)src;
+    float* d = (float*)dst;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(s + i));
+        float32x2_t hi = vcvt_f32_f64(vld1q_f64(s + i + 2));
+        vst1q_f32(d + i, vcombine_f32(lo, hi));
+    }
+    for (; i < count; i++)
+        d[i] = (float)s[i];
+}
+
+static void _cast2_neon(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        vst1_f32(
+            (float*)(dst + i * dst_stride),
+            vcvt_f32_f64(vld1q_f64((const double*)(src + i * src_stride))));
+}
+
+static void _cast3_neon(
+    uint8_t* dst, VkDeviceSize dst_stride, const uint8_t* src, VkDeviceSize src_stride,
+    VkDeviceSize size, uint32_t count)
+{
+    if (dst_stride == 3 * sizeof(float) && src_stride == 3 * sizeof(double))
+    {
+        _cast1_neon(dst, sizeof(float), src, sizeof(double), size, 3 * count);
+        return;
+    }
+    const double* s = NULL;
+    float* d = NULL;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        s = (const double*)(src + i * src_stride);
+        d = (float*)(dst + i * dst_stride);
+        vst1_f32(d, vcvt_f32_f64(vld1q_f64(s)));
+        d[2] = (float)s[2];
+    }
+}
+
+
+static void _bounds_dvec3_neon(const void* data, uint32_t count, dvec3 p0, dvec3 p1)
+{
+    const double* s = (const double*)data;
+    float64x2_t lo[3], hi[3], v;
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        lo[r] = vdupq_n_f64(INFINITY);
+        hi[r] = vdupq_n_f64(-INFINITY);
+    }
+    uint32_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        for (uint32_t r = 0; r < 3; r++)
+        {
+            // NOTE: vminnmq/vmaxnmq return the number when one of the operands is NaN.
+            v = vld1q_f64(s + 3 * i + 2 * r);
+            lo[r] = vminnmq_f64(v, lo[r]);
+            hi[r] = vmaxnmq_f64(v, hi[r]);
+        }
+    }
+    double lanes_lo[6], lanes_hi[6];
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        vst1q_f64(lanes_lo + 2 * r, lo[r]);
+        vst1q_f64(lanes_hi + 2 * r, hi[r]);
+    }
+    _bounds_lanes(6, lanes_lo, lanes_hi, p0, p1);
+    _bounds_dvec3_scalar(s + 3 * i, count - i, p0, p1);
+}
+
+static void _bounds_vec3_neon(const void* data, uint32_t count, dvec3 p0, dvec3 p1)
+{
+    const float* s = (const float*)data;
+    float32x4_t lo[3], hi[3], v;
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        lo[r] = vdupq_n_f32(INFINITY);
+        hi[r] = vdupq_n_f32(-INFINITY);
+    }
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        for (uint32_t r = 0; r < 3; r++)
+        {
+            v = vld1q_f32(s + 3 * i + 4 * r);
+            lo[r] = vminnmq_f32(v, lo[r]);
+            hi[r] = vmaxnmq_f32(v, hi[r]);
+        }
+    }
+    float f_lo[12], f_hi[12];
+    double lanes_lo[12], lanes_hi[12];
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        vst1q_f32(f_lo + 4 * r, lo[r]);
+        vst1q_f32(f_hi + 4 * r, hi[r]);
+    }
+    for (uint32_t k = 0; k < 12; k++)
+    {
+        lanes_lo[k] = f_lo[k];
+        lanes_hi[k] = f_hi[k];
+    }
+    _bounds_lanes(12, lanes_lo, lanes_hi, p0, p1);
+    _bounds_vec3_scalar(s + 3 * i, count - i, p0, p1);
+}
+
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Dispatch                                                                                     */
+/*************************************************************************************************/
+
+static DvzCopyKernels _kernels(void)
+{
+    DvzCopyKernels k = {
+        "scalar", _copy_scalar, {NULL, _cast1_scalar, _cast2_scalar, _cast3_scalar},
+        _bounds_vec3_scalar, _bounds_dvec3_scalar};
+    if (getenv("DVZ_NO_SIMD") != NULL)
+        return k;
+
+#if DVZ_SIMD_X86
+    k.name = "sse2";
+    k.cast[1] = _cast1_sse2;
+    k.cast[2] = _cast2_sse2;
+    k.cast[3] = _cast3_sse2;
+    k.bounds_vec3 = _bounds_vec3_sse2;
+    k.bounds_dvec3 = _bounds_dvec3_sse2;
+#if DVZ_SIMD_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        k.name = "avx2";
+        k.cast[1] = _cast1_avx2;
+        k.cast[3] = _cast3_avx2;
+        k.bounds_dvec3 = _bounds_dvec3_avx2;
+    }
+#endif
+#elif DVZ_SIMD_NEON
+    k.name = "neon";
+    k.cast[1] = _cast1_neon;
+    k.cast[2] = _cast2_neon;
+    k.cast[3] = _cast3_neon;
+    k.bounds_vec3 = _bounds_vec3_neon;
+    k.bounds_dvec3 = _bounds_dvec3_neon;
+#endif
+
+    return k;
+}
+
+
+
+static DvzCopyKernels KERNELS;
+static pthread_once_t KERNELS_ONCE = PTHREAD_ONCE_INIT;
+
+static void _init_kernels(void) { KERNELS = _kernels(); }
+
+
+
+// The kernels are selected once, at the first call, which may happen concurrently in the worker
+// threads baking the visuals.
+static DvzCopyKernels* _get_kernels(void)
+{
+    pthread_once(&KERNELS_ONCE, _init_kernels);
+    ASSERT(KERNELS.copy != NULL);
+    return &KERNELS;
+}
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+const char* dvz_array_simd(void) { return _get_kernels()->name; }
+
+
+
+void dvz_column_copy(
+    void* dst, VkDeviceSize dst_stride, const void* src, VkDeviceSize src_stride,
+    VkDeviceSize col_size, uint32_t item_count, uint32_t data_item_count, //
+    DvzDataType source_dtype, DvzDataType target_dtype, DvzArrayCopyType copy_type, uint32_t reps)
+{
+    ASSERT(dst != NULL);
+    ASSERT(src != NULL);
+    ASSERT(dst_stride > 0);
+    ASSERT(src_stride > 0);
+    ASSERT(col_size > 0);
+    ASSERT(item_count > 0);
+    ASSERT(data_item_count > 0);
+
+    DvzCopyKernels* kernels = _get_kernels();
+    DvzCopyKernel kernel = kernels->copy;
+    VkDeviceSize dst_size = col_size; // number of bytes written per item
+
+    // Choose the kernel.
+    if (source_dtype != target_dtype &&  //
+        source_dtype != DVZ_DTYPE_NONE && //
+        target_dtype != DVZ_DTYPE_NONE)   //
+    {
+        uint32_t components = 0;
+        if (source_dtype == DVZ_DTYPE_DOUBLE && target_dtype == DVZ_DTYPE_FLOAT)
+            components = 1;
+        else if (source_dtype == DVZ_DTYPE_DVEC2 && target_dtype == DVZ_DTYPE_VEC2)
+            components = 2;
+        else if (source_dtype == DVZ_DTYPE_DVEC3 && target_dtype == DVZ_DTYPE_VEC3)
+            components = 3;
+        else
+        {
+            log_error("unknown casting dtypes %d %d", source_dtype, target_dtype);
+            return;
+        }
+        kernel = kernels->cast[components];
+        dst_size = components * sizeof(float);
+    }
+    ASSERT(kernel != NULL);
+
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    reps = MAX(1, reps);
+    // In SINGLE mode, only the first of each group of `reps` items is written.
+    bool single = copy_type == DVZ_ARRAY_COPY_SINGLE && reps > 1;
+
+    // The destination item i corresponds to the source item MIN(i / reps, data_item_count - 1).
+    // The first `body` destination items correspond to all source items except the last.
+    uint32_t last = data_item_count - 1;
+    uint32_t body = (uint32_t)MIN((uint64_t)last * reps, (uint64_t)item_count);
+
+    // Copy the body, one strided pass per repeat, without per-item branching.
+    uint32_t n = 0;
+    for (uint32_t r = 0; r < (single ? 1 : reps) && r < body; r++)
+    {
+        n = (body - r + reps - 1) / reps;
+        kernel(d + r * dst_stride, reps * dst_stride, s, src_stride, col_size, n);
+    }
+
+    // The last source item is repeated until the end.
+    if (body >= item_count)
+        return;
+    ASSERT(body % reps == 0);
+    uint8_t* first = d + body * dst_stride;
+    kernel(first, dst_stride, s + last * src_stride, src_stride, col_size, 1);
+    uint32_t step = single ? reps : 1;
+    for (uint32_t i = body + step; i < item_count; i += step)
+        memcpy(d + i * dst_stride, first, dst_size);
+}
+
+
+
+void dvz_array_bounds(
+    DvzArray* array, uint32_t first_item, uint32_t item_count, dvec3 p0, dvec3 p1)
+{
+    ASSERT(array != NULL);
+    if (item_count == 0)
+        return;
+    ASSERT(array->data != NULL);
+    ASSERT(first_item + item_count <= array->item_count);
+
+    DvzCopyKernels* kernels = _get_kernels();
+    const uint8_t* data = (const uint8_t*)array->data + first_item * array->item_size;
+    if (array->dtype == DVZ_DTYPE_VEC3)
+        kernels->bounds_vec3(data, item_count, p0, p1);
+    else if (array->dtype == DVZ_DTYPE_DVEC3)
+        kernels->bounds_dvec3(data, item_count, p0, p1);
+    else
+        log_error("unsupported dtype %d for bounds computation", array->dtype);
+}
@@ -0,0 +1,472 @@
+#include "../include/datoviz/atlas.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+BEGIN_INCL_NO_WARN
+#include "../external/stb_image.h"
+
+// NOTE: Dear ImGui ships stb_truetype and compiles its own static copy of it.
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+END_INCL_NO_WARN
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+// Printable ASCII characters, in the order of the first cells of the atlas grid.
+static const char DVZ_FONT_ATLAS_STRING[] =
+    " !\"#$%&'()*+,-./"
+    "0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\x7f";
+
+
+
+/*************************************************************************************************/
+/*  Glyph table                                                                                  */
+/*************************************************************************************************/
+
+static inline uint32_t _glyph_hash(uint32_t codepoint, uint32_t capacity)
+{
+    ASSERT(capacity > 0);
+    return (codepoint * 2654435761u) & (capacity - 1);
+}
+
+
+
+static void _glyph_table_insert(DvzGlyphTable* table, uint32_t codepoint, uint32_t glyph);
+
+static void _glyph_table_resize(DvzGlyphTable* table, uint32_t capacity)
+{
+    ASSERT(table != NULL);
+    ASSERT(capacity > 2 * table->count);
+
+    DvzGlyphTable old = *table;
+    table->capacity = capacity;
+    table->count = 0;
+    table->codepoints = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    table->glyphs = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    for (uint32_t i = 0; i < old.capacity; i++)
+        if (old.codepoints[i] != 0)
+            _glyph_table_insert(table, old.codepoints[i], old.glyphs[i]);
+    FREE(old.codepoints);
+    FREE(old.glyphs);
+}
+
+
+
+static void _glyph_table_insert(DvzGlyphTable* table, uint32_t codepoint, uint32_t glyph)
+{
+    ASSERT(table != NULL);
+    ASSERT(codepoint != 0);
+
+    // Keep the load factor below 1/2 so that the probe sequences remain short.
+    if (2 * (table->count + 1) > table->capacity)
+        _glyph_table_resize(table, MAX(64, 2 * table->capacity));
+
+    uint32_t i = _glyph_hash(codepoint, table->capacity);
+    while (table->codepoints[i] != 0 && table->codepoints[i] != codepoint)
+        i = (i + 1) & (table->capacity - 1);
+    if (table->codepoints[i] == 0)
+        table->count++;
+    table->codepoints[i] = codepoint;
+    table->glyphs[i] = glyph;
+}
+
+
+
+// Return UINT32_MAX if the code point is not in the table.
+static uint32_t _glyph_table_get(DvzGlyphTable* table, uint32_t codepoint)
+{
+    ASSERT(table != NULL);
+    if (table->capacity == 0)
+        return UINT32_MAX;
+
+    uint32_t i = _glyph_hash(codepoint, table->capacity);
+    while (table->codepoints[i] != 0)
+    {
+        if (table->codepoints[i] == codepoint)
+            return table->glyphs[i];
+        i = (i + 1) & (table->capacity - 1);
+    }
+    return UINT32_MAX;
+}
+
+
+
+static void _glyph_table_destroy(DvzGlyphTable* table)
+{
+    ASSERT(table != NULL);
+    FREE(table->codepoints);
+    FREE(table->glyphs);
+    memset(table, 0, sizeof(DvzGlyphTable));
+}
+
+
+
+/*************************************************************************************************/
+/*  Glyph rendering                                                                              */
+/*************************************************************************************************/
+
+// Render the signed distance field of a code point in its cell of the CPU copy of the atlas
+// texture. The cell is uploaded to the GPU texture later by dvz_font_atlas_upload().
+static void _font_atlas_render(DvzFontAtlas* atlas, uint32_t codepoint, uint32_t glyph)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->font_info != NULL);
+    ASSERT(atlas->font_texture != NULL);
+    ASSERT(glyph < atlas->rows * atlas->cols);
+
+    uint32_t cw = (uint32_t)atlas->glyph_width;
+    uint32_t ch = (uint32_t)atlas->glyph_height;
+    uint32_t x0 = (glyph % atlas->cols) * cw;
+    uint32_t y0 = (glyph / atlas->cols) * ch;
+
+    // The distance is 0.5 on the glyph edge and varies by 1 over DVZ_FONT_ATLAS_PXRANGE pixels.
+    // NOTE: the SDF is NULL for empty glyphs such as the space.
+    int w = 0, h = 0, xoff = 0, yoff = 0;
+    uint8_t* sdf = stbtt_GetCodepointSDF(
+        (stbtt_fontinfo*)atlas->font_info, atlas->font_scale, (int)codepoint,
+        DVZ_FONT_ATLAS_PXRANGE / 2, 128, 256.0f / DVZ_FONT_ATLAS_PXRANGE, &w, &h, &xoff, &yoff);
+
+    // The glyphs are laid out on a fixed-width grid by the text shader, so the narrower glyphs
+    // are centered in their cell.
+    int advance = 0, bearing = 0;
+    stbtt_GetCodepointHMetrics(
+        (stbtt_fontinfo*)atlas->font_info, (int)codepoint, &advance, &bearing);
+    int dx = (int)roundf((atlas->glyph_width - advance * atlas->font_scale) / 2);
+
+    // The text shader expects a multi-channel SDF and takes the median of the RGB channels, so
+    // the distance is copied in the three channels. The glyph origin is on the baseline, and the
+    // parts of the SDF outside of the cell are cropped.
+    uint8_t* px = NULL;
+    int x = 0, y = 0;
+    for (uint32_t i = 0; i < ch; i++)
+    {
+        for (uint32_t j = 0; j < cw; j++)
+        {
+            x = (int)j - dx - xoff;
+            y = (int)i - atlas->baseline - yoff;
+            px = &atlas->font_texture[4 * ((y0 + i) * atlas->width + x0 + j)];
+            px[0] = px[1] = px[2] = 0;
+            if (sdf != NULL && x >= 0 && x < w && y >= 0 && y < h)
+                px[0] = px[1] = px[2] = sdf[y * w + x];
+            px[3] = 255;
+        }
+    }
+    if (sdf != NULL)
+        stbtt_FreeSDF(sdf, NULL);
+}
+
+
+
+/*************************************************************************************************/
+/*  Font atlas creation                                                                          */
+/*************************************************************************************************/
+
+// Load a font file and allocate an atlas grid with empty cells, return false on failure.
+static bool _font_atlas_sdf(DvzFontAtlas* atlas, const char* path)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(path != NULL);
+
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        log_warn("font file %s not found, falling back to the ASCII font atlas", path);
+        return false;
+    }
+    fclose(f);
+
+    uint8_t* data = (uint8_t*)dvz_read_file(path, NULL);
+    stbtt_fontinfo* info = (stbtt_fontinfo*)calloc(1, sizeof(stbtt_fontinfo));
+    if (data == NULL || !stbtt_InitFont(info, data, stbtt_GetFontOffsetForIndex(data, 0)))
+    {
+        log_warn("unable to load the font file %s, falling back to the ASCII font atlas", path);
+        FREE(data);
+        FREE(info);
+        return false;
+    }
+    atlas->font_data = data;
+    atlas->font_info = info;
+
+    // Scale the font so that the ascent and descent fit in a cell, with room for the distance
+    // range at the top and bottom.
+    int pad = DVZ_FONT_ATLAS_PXRANGE / 2;
+    atlas->glyph_height = DVZ_FONT_ATLAS_GLYPH_HEIGHT;
+    atlas->font_scale = stbtt_ScaleForPixelHeight(info, atlas->glyph_height - 2 * pad);
+    int ascent = 0, descent = 0, line_gap = 0;
+    stbtt_GetFontVMetrics(info, &ascent, &descent, &line_gap);
+    atlas->baseline = pad + (int)roundf(ascent * atlas->font_scale);
+
+    // NOTE: the text shader lays out the glyphs on a fixed-width grid, the cell width is the
+    // largest advance width of the printable ASCII characters.
+    int advance = 0, bearing = 0, max_advance = 0;
+    for (int c = 32; c < 127; c++)
+    {
+        stbtt_GetCodepointHMetrics(info, c, &advance, &bearing);
+        max_advance = MAX(max_advance, advance);
+    }
+    atlas->glyph_width = ceilf(max_advance * atlas->font_scale);
+    ASSERT(atlas->glyph_width > 0);
+
+    atlas->name = DVZ_FONT_ATLAS_FILE;
+    atlas->cols = DVZ_FONT_ATLAS_COLS;
+    atlas->rows = DVZ_FONT_ATLAS_ROWS;
+    atlas->width = atlas->cols * (uint32_t)atlas->glyph_width;
+    atlas->height = atlas->rows * (uint32_t)atlas->glyph_height;
+    atlas->font_texture = (uint8_t*)calloc(atlas->width * atlas->height, 4 * sizeof(uint8_t));
+
+    return true;
+}
+
+
+
+// Load the fixed font texture with the printable ASCII characters.
+static void _font_atlas_png(DvzFontAtlas* atlas)
+{
+    ASSERT(atlas != NULL);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/textures/%s", DATA_DIR, "font_inconsolata.png");
+
+    int width, height, depth;
+    atlas->font_texture = stbi_load(path, &width, &height, &depth, STBI_rgb_alpha);
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+    ASSERT(depth > 0);
+
+    atlas->name = "font_inconsolata.png";
+    atlas->cols = 16;
+    atlas->rows = 6;
+
+    atlas->width = (uint32_t)width;
+    atlas->height = (uint32_t)height;
+    atlas->glyph_width = atlas->width / (float)atlas->cols;
+    atlas->glyph_height = atlas->height / (float)atlas->rows;
+}
+
+
+
+static DvzTexture* _font_texture(DvzContext* ctx, DvzFontAtlas* atlas)
+{
+    ASSERT(ctx != NULL);
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->font_texture != NULL);
+
+    uvec3 shape = {(uint32_t)atlas->width, (uint32_t)atlas->height, 1};
+    DvzTexture* texture = dvz_ctx_texture(ctx, 2, shape, VK_FORMAT_R8G8B8A8_UNORM);
+    // NOTE: the font texture must have LINEAR filter! otherwise no antialiasing
+    dvz_texture_filter(texture, DVZ_FILTER_MAG, VK_FILTER_LINEAR);
+    dvz_texture_filter(texture, DVZ_FILTER_MIN, VK_FILTER_LINEAR);
+
+    dvz_texture_upload(
+        texture, DVZ_ZERO_OFFSET, DVZ_ZERO_OFFSET, (uint32_t)(atlas->width * atlas->height * 4),
+        atlas->font_texture);
+    return texture;
+}
+
+
+
+DvzFontAtlas dvz_font_atlas(DvzContext* ctx)
+{
+    ASSERT(ctx != NULL);
+    DvzFontAtlas atlas = {0};
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/fonts/%s", DATA_DIR, DVZ_FONT_ATLAS_FILE);
+    if (!_font_atlas_sdf(&atlas, path))
+        _font_atlas_png(&atlas);
+    ASSERT(atlas.font_texture != NULL);
+
+    // In both cases, the first cells contain the printable ASCII characters. They are rendered
+    // before the texture creation, so that they are uploaded at once.
+    atlas.font_str = DVZ_FONT_ATLAS_STRING;
+    uint32_t n = (uint32_t)strlen(atlas.font_str);
+    ASSERT(n <= atlas.rows * atlas.cols);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (atlas.font_info != NULL)
+            _font_atlas_render(&atlas, (uint32_t)atlas.font_str[i], i);
+        _glyph_table_insert(&atlas.glyphs, (uint32_t)atlas.font_str[i], i);
+    }
+    atlas.glyph_count = n;
+    atlas.glyph_uploaded = n;
+    atlas.glyph_fallback = (uint32_t)strcspn(atlas.font_str, "?");
+
+    atlas.texture = _font_texture(ctx, &atlas);
+
+    return atlas;
+}
+
+
+
+/*************************************************************************************************/
+/*  Glyphs                                                                                       */
+/*************************************************************************************************/
+
+uint32_t dvz_font_atlas_glyph(DvzFontAtlas* atlas, uint32_t codepoint)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->texture != NULL);
+
+    // NOTE: the glyphs may be requested by the axes being baked in a worker thread, so the new
+    // glyphs are only rendered in the CPU texture here, and uploaded in the frame thread.
+    DvzContext* ctx = atlas->texture->context;
+    ASSERT(ctx != NULL);
+    dvz_context_lock(ctx);
+
+    uint32_t glyph = _glyph_table_get(&atlas->glyphs, codepoint);
+    if (glyph == UINT32_MAX)
+    {
+        // NOTE: the fixed ASCII atlas cannot grow.
+        glyph = atlas->glyph_fallback;
+        if (atlas->font_info != NULL && codepoint != 0)
+        {
+            if (!stbtt_FindGlyphIndex((stbtt_fontinfo*)atlas->font_info, (int)codepoint))
+                log_debug("no glyph for U+%04X in font %s", codepoint, atlas->name);
+            else if (atlas->glyph_count >= atlas->rows * atlas->cols)
+                log_warn("font atlas full, unable to add the glyph U+%04X", codepoint);
+            else
+            {
+                glyph = atlas->glyph_count++;
+                _font_atlas_render(atlas, codepoint, glyph);
+            }
+        }
+        // Missing code points are cached too, and map to the fallback glyph.
+        if (codepoint != 0)
+            _glyph_table_insert(&atlas->glyphs, codepoint, glyph);
+    }
+
+    dvz_context_unlock(ctx);
+    return glyph;
+}
+
+
+
+void dvz_font_atlas_upload(DvzFontAtlas* atlas)
+{
+    ASSERT(atlas != NULL);
+    if (atlas->texture == NULL)
+        return;
+    DvzContext* ctx = atlas->texture->context;
+    ASSERT(ctx != NULL);
+
+    // The new glyphs are in the cells [glyph_uploaded, glyph_count), which span a band of
+    // full-width rows, contiguous in the CPU texture. The band is copied while the context is
+    // locked, as a worker thread may be rendering new glyphs in the same rows.
+    dvz_context_lock(ctx);
+    if (atlas->glyph_uploaded >= atlas->glyph_count)
+    {
+        dvz_context_unlock(ctx);
+        return;
+    }
+    uint32_t ch = (uint32_t)atlas->glyph_height;
+    uint32_t row0 = atlas->glyph_uploaded / atlas->cols;
+    uint32_t row1 = (atlas->glyph_count - 1) / atlas->cols + 1;
+    uvec3 offset = {0, row0 * ch, 0};
+    uvec3 shape = {atlas->width, (row1 - row0) * ch, 1};
+    VkDeviceSize size = shape[0] * shape[1] * 4;
+    uint8_t* band = (uint8_t*)malloc(size);
+    memcpy(band, &atlas->font_texture[4 * offset[1] * atlas->width], size);
+    atlas->glyph_uploaded = atlas->glyph_count;
+    dvz_context_unlock(ctx);
+
+    log_debug("upload glyph rows %d to %d of the font atlas", row0, row1 - 1);
+    dvz_texture_upload(atlas->texture, offset, shape, size, band);
+    FREE(band);
+}
+
+
+
+void dvz_font_atlas_glyph_size(DvzFontAtlas* atlas, float size, vec2 glyph_size)
+{
+    ASSERT(atlas != NULL);
+    glyph_size[0] = size * atlas->glyph_width / atlas->glyph_height;
+    glyph_size[1] = size;
+}
+
+
+
+void dvz_font_atlas_destroy(DvzFontAtlas* atlas)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->font_texture != NULL);
+    if (atlas->font_info != NULL)
+    {
+        FREE(atlas->font_texture);
+        FREE(atlas->font_info);
+        FREE(atlas->font_data);
+    }
+    else
+        stbi_image_free(atlas->font_texture);
+    _glyph_table_destroy(&atlas->glyphs);
+}
+
+
+
+/*************************************************************************************************/
+/*  UTF-8                                                                                        */
+/*************************************************************************************************/
+
+uint32_t dvz_utf8_decode(const char* str, uint32_t* codepoint)
+{
+    ASSERT(str != NULL);
+    ASSERT(codepoint != NULL);
+
+    const uint8_t* s = (const uint8_t*)str;
+    uint32_t c = s[0];
+    uint32_t n = 0;
+    if (c < 0x80)
+        n = 1;
+    else if ((c & 0xE0) == 0xC0)
+    {
+        n = 2;
+        c &= 0x1F;
+    }
+    else if ((c & 0xF0) == 0xE0)
+    {
+        n = 3;
+        c &= 0x0F;
+    }
+    else if ((c & 0xF8) == 0xF0)
+    {
+        n = 4;
+        c &= 0x07;
+    }
+    else
+    {
+        // Invalid leading byte.
+        *codepoint = DVZ_UTF8_REPLACEMENT;
+        return 1;
+    }
+
+    for (uint32_t i = 1; i < n; i++)
+    {
+        // Truncated sequence, this also stops at the null terminator.
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            *codepoint = DVZ_UTF8_REPLACEMENT;
+            return i;
+        }
+        c = (c << 6) | (s[i] & 0x3F);
+    }
+    *codepoint = c;
+    return n;
+}
+
+
+
+uint32_t dvz_utf8_length(const char* str)
+{
+    ASSERT(str != NULL);
+    uint32_t n = 0;
+    uint32_t c = 0;
+    while (*str != 0)
+    {
+        str += dvz_utf8_decode(str, &c);
+        n++;
+    }
+    return n;
+}
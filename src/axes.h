@@ -15,6 +15,33 @@
 
 
 
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+// Ticks and vertices of the axes visual of an axis, computed in a worker thread. The job owns the
+// back buffers of the tick props and vertex sources of the visual, which are swapped with the
+// visual ones when the job has completed.
+struct DvzAxesJob
+{
+    DvzController* controller;
+    DvzAxisCoord coord;
+    dvec2 range; // visible range, in data coordinates
+    DvzAxesContext ctx;
+    DvzAxesTicks ticks;
+
+    DvzArray pos[DVZ_AXES_LEVEL_COUNT];
+    DvzArray text;
+    DvzArray vertices[2];
+
+    DvzTaskGroup group;
+    bool pending;       // submitted and not swapped in yet
+    bool stale;         // whether an update was requested while the job was pending
+    atomic(bool, done); // set by the worker thread
+};
+
+
+
 /*************************************************************************************************/
 /*  Axes functions                                                                               */
 /*************************************************************************************************/
@@ -64,6 +91,58 @@ static DvzAxesContext _axes_context(DvzController* controller, DvzAxisCoord coor
 
 
 
+// Whether two contexts lead to the same ticks up to a shift, i.e. when the view is only panned.
+static bool _axes_same_context(DvzAxesContext* a, DvzAxesContext* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    return a->coord == b->coord && a->size_viewport == b->size_viewport &&
+           a->size_glyph == b->size_glyph && a->scale_orig == b->scale_orig &&
+           a->extensions == b->extensions;
+}
+
+
+
+// Compute the ticks of an axis for a range in data coordinates. When the view is only panned, the
+// current ticks are shifted, otherwise the ticks are taken from the cache or computed. The
+// current ticks and context are only read, so that this function can run in a worker thread.
+static DvzAxesTicks
+_axes_ticks_compute(DvzAxes2D* axes, DvzAxisCoord coord, DvzAxesContext* ctx, dvec2 range)
+{
+    ASSERT(axes != NULL);
+    ASSERT(ctx != NULL);
+
+    double vmin = range[0];
+    double vmax = range[1];
+    double vlen = vmax - vmin;
+    ASSERT(vlen > 0);
+
+    DvzAxesTicks* prev = &axes->ticks[coord];
+    DvzAxesTicks ticks = {0};
+
+    // Pure pan: the existing ticks only need to be shifted.
+    if (prev->values != NULL && _axes_same_context(&axes->ctx[coord], ctx))
+    {
+        ticks = _ticks_copy(prev);
+        if (_ticks_shift(&ticks, vmin, vmax, ctx))
+            return ticks;
+        dvz_ticks_destroy(&ticks);
+    }
+
+    // Determine the tick number and positions, unless they were recently computed for this
+    // range.
+    DvzAxesTicksKey key = {0};
+    bool cached = _ticks_key(vmin, vmax, ctx, &key);
+    if (cached && _ticks_cache_get(&axes->cache[coord], &key, &ticks))
+        return ticks;
+    ticks = dvz_ticks(vmin, vmax, *ctx);
+    if (cached)
+        _ticks_cache_put(&axes->cache[coord], &key, &ticks);
+    return ticks;
+}
+
+
+
 // Recompute the tick locations as a function of the current axis range in data coordinates.
 static void _axes_ticks(DvzController* controller, DvzAxisCoord coord, dvec2 range)
 {
@@ -73,23 +152,16 @@ static void _axes_ticks(DvzController* controller, DvzAxisCoord coord, dvec2 ran
     DvzAxes2D* axes = &controller->u.axes_2D;
     ASSERT(axes != NULL);
 
-    DvzPanel* panel = controller->panel;
-    ASSERT(panel != NULL);
-
     // Prepare context for tick computation.
     DvzAxesContext ctx = _axes_context(controller, coord);
 
-    double vmin = range[0];
-    double vmax = range[1];
-    double vlen = vmax - vmin;
-    ASSERT(vlen > 0);
+    // Determine the tick number and positions.
+    DvzAxesTicks ticks = _axes_ticks_compute(axes, coord, &ctx, range);
 
-    // Free the existing ticks.
+    // Replace the existing ticks.
     if (axes->ticks[coord].values != NULL)
         dvz_ticks_destroy(&axes->ticks[coord]);
-
-    // Determine the tick number and positions.
-    axes->ticks[coord] = dvz_ticks(vmin, vmax, ctx);
+    axes->ticks[coord] = ticks;
 
     // We keep track of the context.
     axes->ctx[coord] = ctx;
@@ -97,66 +169,263 @@ static void _axes_ticks(DvzController* controller, DvzAxisCoord coord, dvec2 ran
 
 
 
-// Update the axes visual's data as a function of the computed ticks.
-static void _axes_upload(DvzController* controller, DvzAxisCoord coord)
+// Resize an array, which is allocated with the given dtype if needed.
+static void _axes_array(DvzArray* arr, DvzDataType dtype, uint32_t item_count)
 {
-    ASSERT(controller != NULL);
-    ASSERT(controller->type == DVZ_CONTROLLER_AXES_2D);
-    DvzAxes2D* axes = &controller->u.axes_2D;
-    ASSERT(axes != NULL);
-    ASSERT(controller->visual_count == 2);
+    ASSERT(arr != NULL);
+    if (arr->item_size == 0)
+        *arr = dvz_array(item_count, dtype);
+    else
+        dvz_array_resize(arr, item_count);
+}
 
-    DvzVisual* visual = controller->visuals[coord];
-    ASSERT(visual != NULL);
 
-    DvzPanel* panel = controller->panel;
-    ASSERT(panel != NULL);
 
-    DvzDataCoords* coords = &panel->data_coords;
-    ASSERT(coords != NULL);
+static void _axes_array_swap(DvzArray* a, DvzArray* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    DvzArray tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+
+
+// Compute the tick positions of each axes level, normalized in the NDC range of the initial
+// panzoom, and the tick labels.
+static void _axes_tick_data(
+    DvzAxes2D* axes, DvzAxisCoord coord, DvzAxesTicks* axticks, DvzArray* pos, DvzArray* text)
+{
+    ASSERT(axes != NULL);
+    ASSERT(axticks != NULL);
+    ASSERT(pos != NULL);
+    ASSERT(text != NULL);
 
-    DvzAxesTicks* axticks = &axes->ticks[coord];
     uint32_t N = axticks->value_count;
+    ASSERT(N >= 2);
 
     // Range used for normalization of the ticks (corresponds to init panzoom).
     double vmin = axes->box.p0[coord];
     double vmax = axes->box.p1[coord];
 
     // Normalize the tick values to fit in NDC range.
-    double* ticks = (double*)calloc(N, sizeof(double));
+    _axes_array(&pos[DVZ_AXES_LEVEL_MAJOR], DVZ_DTYPE_DOUBLE, N);
+    double* ticks = (double*)pos[DVZ_AXES_LEVEL_MAJOR].data;
     for (uint32_t i = 0; i < N; i++)
-    {
         ticks[i] = -1 + 2 * (axticks->values[i] - vmin) / (vmax - vmin);
-        // log_info("%d %f vmin=%f vmax=%f", i, ticks[i], vmin, vmax);
-    }
+
+    // Grid lines at the major ticks.
+    _axes_array(&pos[DVZ_AXES_LEVEL_GRID], DVZ_DTYPE_DOUBLE, N);
+    memcpy(pos[DVZ_AXES_LEVEL_GRID].data, ticks, N * sizeof(double));
 
     // Minor ticks.
-    double* minor_ticks = (double*)calloc((N - 1) * 4, sizeof(double));
+    _axes_array(&pos[DVZ_AXES_LEVEL_MINOR], DVZ_DTYPE_DOUBLE, (N - 1) * 4);
+    double* minor_ticks = (double*)pos[DVZ_AXES_LEVEL_MINOR].data;
     uint32_t k = 0;
     for (uint32_t i = 0; i < N - 1; i++)
         for (uint32_t j = 1; j <= 4; j++)
             minor_ticks[k++] = ticks[i] + j * (ticks[i + 1] - ticks[i]) / 5.;
     ASSERT(k == (N - 1) * 4);
 
+    // Axis line.
+    _axes_array(&pos[DVZ_AXES_LEVEL_LIM], DVZ_DTYPE_DOUBLE, 1);
+    ((double*)pos[DVZ_AXES_LEVEL_LIM].data)[0] = -1;
+
     // Prepare text values.
-    char** text = (char**)calloc(N, sizeof(char*));
+    _axes_array(text, DVZ_DTYPE_STR, N);
     for (uint32_t i = 0; i < N; i++)
+        ((char**)text->data)[i] = &axticks->labels[i * MAX_GLYPHS_PER_TICK];
+}
+
+
+
+// Update the axes visual's data as a function of the computed ticks.
+static void _axes_upload(DvzController* controller, DvzAxisCoord coord)
+{
+    ASSERT(controller != NULL);
+    ASSERT(controller->type == DVZ_CONTROLLER_AXES_2D);
+    DvzAxes2D* axes = &controller->u.axes_2D;
+    ASSERT(axes != NULL);
+    ASSERT(controller->visual_count == 2);
+
+    DvzVisual* visual = controller->visuals[coord];
+    ASSERT(visual != NULL);
+
+    DvzArray pos[DVZ_AXES_LEVEL_COUNT] = {0};
+    DvzArray text = {0};
+    _axes_tick_data(axes, coord, &axes->ticks[coord], pos, &text);
+
+    // Set visual data.
+    for (uint32_t level = 0; level < DVZ_AXES_LEVEL_COUNT; level++)
     {
-        text[i] = &axticks->labels[i * MAX_GLYPHS_PER_TICK];
-        // log_info("%f %s", ticks[i], text[i]);
+        dvz_visual_data(visual, DVZ_PROP_POS, level, pos[level].item_count, pos[level].data);
+        dvz_array_destroy(&pos[level]);
     }
+    dvz_visual_data(visual, DVZ_PROP_TEXT, 0, text.item_count, text.data);
+    dvz_array_destroy(&text);
+}
 
-    // Set visual data.
-    double lim[] = {-1};
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MINOR, 4 * (N - 1), minor_ticks);
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR, N, ticks);
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_GRID, N, ticks);
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_LIM, 1, lim);
-    dvz_visual_data(visual, DVZ_PROP_TEXT, 0, N, text);
-
-    FREE(minor_ticks);
-    FREE(ticks);
-    FREE(text);
+
+
+/*************************************************************************************************/
+/*  Background updates                                                                           */
+/*************************************************************************************************/
+
+static DvzTaskPool* _axes_pool(DvzController* controller)
+{
+    ASSERT(controller != NULL);
+    ASSERT(controller->panel != NULL);
+    ASSERT(controller->panel->grid != NULL);
+    DvzCanvas* canvas = controller->panel->grid->canvas;
+    if (canvas == NULL || canvas->app == NULL)
+        return NULL;
+    return canvas->app->tasks;
+}
+
+
+
+// Compute the ticks of an axis and bake the axes visual in the back buffers of the job.
+static void _axes_job_task(void* user_data)
+{
+    DvzAxesJob* job = (DvzAxesJob*)user_data;
+    ASSERT(job != NULL);
+    DvzController* controller = job->controller;
+    ASSERT(controller != NULL);
+    DvzAxes2D* axes = &controller->u.axes_2D;
+    DvzVisual* visual = controller->visuals[job->coord];
+    ASSERT(visual != NULL);
+    ASSERT(visual->callback_bake != NULL);
+
+    job->ticks = _axes_ticks_compute(axes, job->coord, &job->ctx, job->range);
+    _axes_tick_data(axes, job->coord, &job->ticks, job->pos, &job->text);
+
+    DvzAxesBake bake = {0};
+    for (uint32_t level = 0; level < DVZ_AXES_LEVEL_COUNT; level++)
+        bake.pos[level] = &job->pos[level];
+    bake.text = &job->text;
+    bake.vertices[0] = &job->vertices[0];
+    bake.vertices[1] = &job->vertices[1];
+
+    DvzVisualDataEvent ev = {0};
+    ev.user_data = &bake;
+    visual->callback_bake(visual, ev);
+
+    atomic_store(&job->done, true);
+}
+
+
+
+// Compute the ticks of an axis and bake the axes visual in a worker thread. The current axes are
+// kept until the new ones are swapped in, at a later frame.
+static void _axes_submit(DvzController* controller, DvzAxisCoord coord, dvec2 range)
+{
+    ASSERT(controller != NULL);
+    DvzAxes2D* axes = &controller->u.axes_2D;
+    DvzVisual* visual = controller->visuals[coord];
+    ASSERT(visual != NULL);
+
+    DvzAxesJob* job = axes->jobs[coord];
+    if (job == NULL)
+    {
+        job = (DvzAxesJob*)calloc(1, sizeof(DvzAxesJob));
+        atomic_init(&job->done, false);
+        for (uint32_t k = 0; k < 2; k++)
+            job->vertices[k] = dvz_array_struct(
+                0, dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, k)->arr.item_size);
+        axes->jobs[coord] = job;
+    }
+
+    // One job per axis at a time. The next one is submitted after the swap.
+    if (job->pending)
+    {
+        job->stale = true;
+        return;
+    }
+
+    job->controller = controller;
+    job->coord = coord;
+    job->range[0] = range[0];
+    job->range[1] = range[1];
+    job->ctx = _axes_context(controller, coord);
+    job->pending = true;
+    job->stale = false;
+    atomic_store(&job->done, false);
+    dvz_task_enqueue(_axes_pool(controller), &job->group, _axes_job_task, job);
+}
+
+
+
+// Swap in the ticks and the vertices of the completed job of an axis. Return whether they have
+// been swapped in.
+static bool _axes_swap(DvzController* controller, DvzAxisCoord coord)
+{
+    ASSERT(controller != NULL);
+    DvzAxes2D* axes = &controller->u.axes_2D;
+    DvzAxesJob* job = axes->jobs[coord];
+    if (job == NULL || !job->pending || !atomic_load(&job->done))
+        return false;
+    job->pending = false;
+
+    DvzVisual* visual = controller->visuals[coord];
+    ASSERT(visual != NULL);
+
+    // Ticks.
+    if (axes->ticks[coord].values != NULL)
+        dvz_ticks_destroy(&axes->ticks[coord]);
+    axes->ticks[coord] = job->ticks;
+    memset(&job->ticks, 0, sizeof(DvzAxesTicks));
+    axes->ctx[coord] = job->ctx;
+
+    // The props keep track of the ticks, in case the visual is baked again.
+    for (uint32_t level = 0; level < DVZ_AXES_LEVEL_COUNT; level++)
+        _axes_array_swap(&dvz_prop_get(visual, DVZ_PROP_POS, level)->arr_orig, &job->pos[level]);
+    _axes_array_swap(&dvz_prop_get(visual, DVZ_PROP_TEXT, 0)->arr_orig, &job->text);
+
+    // The visual is about to be baked again from its props anyway.
+    if (visual->obj.request == DVZ_VISUAL_REQUEST_UPLOAD)
+        return true;
+
+    // Double-buffered vertex sources: the vertices baked by the job are uploaded, and the
+    // previous vertices will be overwritten by the next job.
+    DvzSource* source = NULL;
+    bool count_changed = false;
+    for (uint32_t k = 0; k < 2; k++)
+    {
+        source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, k);
+        ASSERT(source != NULL);
+        _axes_array_swap(&source->arr, &job->vertices[k]);
+        if (source->arr.item_count != visual->prev_vertex_count[k])
+        {
+            visual->prev_vertex_count[k] = source->arr.item_count;
+            count_changed = true;
+        }
+        _source_set_changed(source, true);
+        _range_all(&source->dirty);
+    }
+    dvz_visual_upload(visual);
+    if (visual->batch != NULL)
+        visual->batch_changed = true;
+
+    // The command buffers must be refilled if the number of vertices has changed.
+    if (count_changed)
+        dvz_canvas_to_refill(controller->panel->grid->canvas);
+    return true;
+}
+
+
+
+// Wait for the job of an axis, if any, and discard its result.
+static void _axes_cancel(DvzController* controller, DvzAxisCoord coord)
+{
+    ASSERT(controller != NULL);
+    DvzAxesJob* job = controller->u.axes_2D.jobs[coord];
+    if (job == NULL || !job->pending)
+        return;
+    dvz_task_wait(_axes_pool(controller), &job->group);
+    dvz_ticks_destroy(&job->ticks);
+    job->pending = false;
+    job->stale = false;
 }
 
 
@@ -177,6 +446,10 @@ static void _axes_set(DvzController* controller, DvzBox box)
     // log_info(
     //     "set axes range to x=[%f, %f], y=[%f, %f]", box.p0[0], box.p1[0], box.p0[1], box.p1[1]);
     _check_box(box);
+
+    // The axes being computed in the background are outdated.
+    for (uint32_t coord = 0; coord < 2; coord++)
+        _axes_cancel(controller, (DvzAxisCoord)coord);
     axes->box = box;
 
     for (uint32_t coord = 0; coord < 2; coord++)
@@ -304,7 +577,15 @@ static void _axes_refresh(DvzController* controller, bool force)
     DvzPanel* panel = controller->panel;
     ASSERT(panel != NULL);
 
-    if (!force && !controller->interacts[0].is_active && !canvas->resized)
+    DvzAxes2D* axes = &controller->u.axes_2D;
+
+    // Swap in the axes computed in the background. They are checked again below, as the view may
+    // have changed since they were submitted.
+    bool swapped = false;
+    for (uint32_t coord = 0; coord < 2; coord++)
+        swapped |= _axes_swap(controller, (DvzAxisCoord)coord);
+
+    if (!force && !swapped && !controller->interacts[0].is_active && !canvas->resized)
         return;
 
     // Check label collision
@@ -338,10 +619,26 @@ static void _axes_refresh(DvzController* controller, bool force)
         update[1] = true;
     }
 
+    // Update the axes that were requested while their job was pending.
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (axes->jobs[i] != NULL && axes->jobs[i]->stale)
+            update[i] = true;
+    }
+
+    // The ticks are computed and the axes baked in the background while interacting, so that the
+    // frame is never blocked.
+    bool background = !force && dvz_task_pool_threads(_axes_pool(controller)) > 1;
     for (uint32_t coord = 0; coord < 2; coord++)
     {
         if (!update[coord])
             continue;
+        if (background)
+        {
+            _axes_submit(controller, (DvzAxisCoord)coord, range[coord]);
+            continue;
+        }
+        _axes_cancel(controller, (DvzAxisCoord)coord);
         _axes_ticks(controller, (DvzAxisCoord)coord, range[coord]);
         _axes_upload(controller, (DvzAxisCoord)coord);
 
@@ -464,9 +761,22 @@ static void _axes_destroy(DvzController* controller)
     DvzAxes2D* axes = &controller->u.axes_2D;
     ASSERT(axes != NULL);
 
+    DvzAxesJob* job = NULL;
     for (uint32_t i = 0; i < 2; i++)
     {
+        _axes_cancel(controller, (DvzAxisCoord)i);
+        job = axes->jobs[i];
+        if (job != NULL)
+        {
+            for (uint32_t level = 0; level < DVZ_AXES_LEVEL_COUNT; level++)
+                dvz_array_destroy(&job->pos[level]);
+            dvz_array_destroy(&job->text);
+            dvz_array_destroy(&job->vertices[0]);
+            dvz_array_destroy(&job->vertices[1]);
+            FREE(axes->jobs[i]);
+        }
         dvz_ticks_destroy(&axes->ticks[i]);
+        _ticks_cache_destroy(&axes->cache[i]);
     }
 }
 
@@ -1,7 +1,9 @@
 #include "../include/datoviz/builtin_visuals.h"
 #include "../include/datoviz/array.h"
+#include "../include/datoviz/atlas.h"
 #include "../include/datoviz/interact.h"
 #include "../include/datoviz/mesh.h"
+#include "lod_utils.h"
 #include "visuals_utils.h"
 
 
@@ -105,6 +107,85 @@ static void _visual_line(DvzVisual* visual)
 
 
 
+/*************************************************************************************************/
+/*  Level of detail                                                                              */
+/*************************************************************************************************/
+
+static void _lod_clear(DvzProp* prop)
+{
+    ASSERT(prop != NULL);
+    dvz_array_destroy(&prop->arr_staging);
+    prop->arr_staging = (DvzArray){0};
+}
+
+
+
+// Put the selected level of detail of the POS and COLOR props in their staging arrays. Return
+// false if the visual has no level of detail, or if all samples are selected.
+static bool _lod_bake(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzLod* lod = visual->lod;
+    if (lod == NULL)
+        return false;
+
+    DvzProp* prop_pos = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    DvzProp* prop_color = dvz_prop_get(visual, DVZ_PROP_COLOR, 0);
+    ASSERT(prop_pos != NULL);
+    ASSERT(prop_color != NULL);
+
+    // Only a single line strip or path, spanning all samples, is supported.
+    uint32_t n = prop_pos->arr_orig.item_count;
+    DvzArray* arr_length = dvz_prop_array(visual, DVZ_PROP_LENGTH, 0);
+    if (arr_length->item_count > 1 ||
+        (arr_length->item_count == 1 && *(uint32_t*)dvz_array_item(arr_length, 0) != n))
+    {
+        log_warn("level of detail is only supported with a single line strip or path");
+        _lod_clear(prop_pos);
+        _lod_clear(prop_color);
+        return false;
+    }
+
+    if (!_lod_supported(&prop_pos->arr_orig))
+    {
+        log_warn("level of detail is only supported with DVEC3 or VEC3 positions");
+        _lod_clear(prop_pos);
+        _lod_clear(prop_color);
+        return false;
+    }
+    lod->origin = prop_pos->dtype == DVZ_DTYPE_VEC3 ? prop_pos->origin[0] : 0;
+
+    // The pyramid is built from the original positions, once per dataset.
+    if (prop_pos->dirty.count > 0 || lod->item_count != n)
+    {
+        _lod_build(lod, &prop_pos->arr_orig);
+        lod->count = 0;
+    }
+    _lod_select(lod, &prop_pos->arr_orig);
+
+    if (lod->item_count == 0 || _lod_is_full(lod))
+    {
+        _lod_clear(prop_pos);
+        _lod_clear(prop_color);
+        return false;
+    }
+
+    // The positions may have been normalized by the scene.
+    DvzArray* arr_pos = &prop_pos->arr_trans;
+    if (arr_pos->item_count != n)
+        arr_pos = &prop_pos->arr_orig;
+    _lod_gather(lod, arr_pos, &prop_pos->arr_staging);
+
+    // Colors are only decimated if there is one color per sample.
+    if (prop_color->arr_orig.item_count == n)
+        _lod_gather(lod, &prop_color->arr_orig, &prop_color->arr_staging);
+    else
+        _lod_clear(prop_color);
+    return true;
+}
+
+
+
 /*************************************************************************************************/
 /*  Line strip                                                                                   */
 /*************************************************************************************************/
@@ -113,6 +194,13 @@ static void _line_strip_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 {
     ASSERT(visual != NULL);
 
+    // The decimated samples are copied from the staging arrays.
+    if (_lod_bake(visual))
+    {
+        _default_visual_bake(visual, ev);
+        return;
+    }
+
     DvzProp* prop_pos = dvz_prop_get(visual, DVZ_PROP_POS, 0);
     DvzProp* prop_color = dvz_prop_get(visual, DVZ_PROP_COLOR, 0);
 
@@ -446,10 +534,226 @@ static void _visual_marker(DvzVisual* visual)
 
 
 
+/*************************************************************************************************/
+/*  Segment                                                                                      */
+/*************************************************************************************************/
+
+static void _visual_segment(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics, with one vertex per segment so that the default baking function can be used.
+    int flags = visual->flags | DVZ_GRAPHICS_FLAGS_INSTANCED;
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_SEGMENT, flags));
+
+    // Sources
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, 0,
+        sizeof(DvzGraphicsSegmentVertex), 0);
+    _common_sources(visual);
+
+    // Props:
+
+    // Start and end positions.
+    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_cast(
+        prop, 0, offsetof(DvzGraphicsSegmentVertex, P0), DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE, 1);
+    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 1, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_cast(
+        prop, 1, offsetof(DvzGraphicsSegmentVertex, P1), DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Segment color.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 3, offsetof(DvzGraphicsSegmentVertex, color), DVZ_ARRAY_COPY_SINGLE, 1);
+    cvec4 color = {200, 200, 200, 255};
+    dvz_visual_prop_default(prop, &color);
+
+    // Line width.
+    prop = dvz_visual_prop(
+        visual, DVZ_PROP_LINE_WIDTH, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 4, offsetof(DvzGraphicsSegmentVertex, linewidth), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_dpi(prop, canvas->dpi_scaling);
+    float linewidth = 2;
+    dvz_visual_prop_default(prop, &linewidth);
+
+    // Start and end caps.
+    DvzCapType cap = DVZ_CAP_ROUND;
+    prop = dvz_visual_prop(visual, DVZ_PROP_CAP_TYPE, 0, DVZ_DTYPE_INT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 5, offsetof(DvzGraphicsSegmentVertex, cap0), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, &cap);
+    prop = dvz_visual_prop(visual, DVZ_PROP_CAP_TYPE, 1, DVZ_DTYPE_INT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 6, offsetof(DvzGraphicsSegmentVertex, cap1), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, &cap);
+
+    // Segment transform.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_TRANSFORM, 0, DVZ_DTYPE_CHAR, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 7, offsetof(DvzGraphicsSegmentVertex, transform), DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Common props.
+    _common_props(visual);
+}
+
+
+
+/*************************************************************************************************/
+/*  Text                                                                                         */
+/*************************************************************************************************/
+
+static float DVZ_DEFAULT_TEXT_SIZE = 12.0f;
+
+static void _visual_text_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzProp* prop_pos = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    DvzProp* prop_color = dvz_prop_get(visual, DVZ_PROP_COLOR, 0);
+    DvzProp* prop_size = dvz_prop_get(visual, DVZ_PROP_TEXT_SIZE, 0);
+    DvzProp* prop_angle = dvz_prop_get(visual, DVZ_PROP_ANGLE, 0);
+    DvzArray* arr_text = _prop_array(dvz_prop_get(visual, DVZ_PROP_TEXT, 0));
+    DvzArray* arr_vertex = dvz_source_array(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    ASSERT(arr_text != NULL);
+    ASSERT(arr_vertex != NULL);
+
+    // One string per position, empty strings are skipped.
+    uint32_t n_text = MIN(dvz_prop_size(prop_pos), arr_text->item_count);
+    char** strings = (char**)arr_text->data;
+    uint32_t count_chars = 0;
+    for (uint32_t i = 0; i < n_text; i++)
+        count_chars += strings[i] != NULL ? dvz_utf8_length(strings[i]) : 0;
+    if (count_chars == 0)
+    {
+        arr_vertex->item_count = 0;
+        return;
+    }
+
+    // NOTE: instanced graphics, one vertex per glyph.
+    DvzGraphicsData data = dvz_graphics_data(visual->graphics[0], arr_vertex, NULL, visual);
+    dvz_graphics_alloc(&data, count_chars);
+
+    DvzGraphicsTextItem item = {0};
+    float font_size = 0;
+    for (uint32_t i = 0; i < n_text; i++)
+    {
+        if (strings[i] == NULL || strings[i][0] == 0)
+            continue;
+        _vec3_cast((const dvec3*)dvz_prop_item(prop_pos, i), &item.vertex.pos);
+        memcpy(item.vertex.color, dvz_prop_item(prop_color, i), sizeof(cvec4));
+        memcpy(&item.vertex.angle, dvz_prop_item(prop_angle, i), sizeof(float));
+        memcpy(&font_size, dvz_prop_item(prop_size, i), sizeof(float));
+        DPI_SCALE(font_size)
+        item.font_size = font_size;
+        item.string = strings[i];
+        dvz_graphics_append(&data, &item);
+    }
+}
+
+static void _visual_text(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics.
+    int flags = visual->flags | DVZ_GRAPHICS_FLAGS_INSTANCED;
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_TEXT, flags));
+
+    // Sources
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, 0,
+        sizeof(DvzGraphicsTextVertex), 0);
+    _common_sources(visual);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING,
+        sizeof(DvzGraphicsTextParams), 0);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING + 1,
+        sizeof(cvec4), 0);
+
+    // Props:
+
+    // String positions.
+    dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
+
+    // Strings.
+    dvz_visual_prop(visual, DVZ_PROP_TEXT, 0, DVZ_DTYPE_STR, DVZ_SOURCE_TYPE_VERTEX, 0);
+
+    // String colors.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
+    cvec4 color = {255, 255, 255, 255};
+    dvz_visual_prop_default(prop, &color);
+
+    // Font sizes.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_TEXT_SIZE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_default(prop, &DVZ_DEFAULT_TEXT_SIZE);
+
+    // String angles.
+    prop = dvz_visual_prop(visual, DVZ_PROP_ANGLE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    float angle = 0;
+    dvz_visual_prop_default(prop, &angle);
+
+    // Common props.
+    _common_props(visual);
+
+    // Font atlas of the context.
+    DvzFontAtlas* atlas = &canvas->gpu->context->font_atlas;
+    dvz_visual_texture(visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0, atlas->texture);
+    DvzGraphicsTextParams params = {0};
+    params.grid_size[0] = (int32_t)atlas->rows;
+    params.grid_size[1] = (int32_t)atlas->cols;
+    params.tex_size[0] = (int32_t)atlas->width;
+    params.tex_size[1] = (int32_t)atlas->height;
+    dvz_visual_data_source(visual, DVZ_SOURCE_TYPE_PARAM, 0, 0, 1, 1, &params);
+
+    dvz_visual_callback_bake(visual, _visual_text_bake);
+}
+
+
+
 /*************************************************************************************************/
 /*  Polygon                                                                                      */
 /*************************************************************************************************/
 
+typedef struct DvzPolygonBake DvzPolygonBake;
+
+struct DvzPolygonBake
+{
+    const dvec3* points;
+    const uint32_t* poly_lengths;
+    const uint32_t* poly_offsets; // index of the first point of each polygon
+    uint32_t* index_count_list;   // number of indices of each triangulation
+    uint32_t** indices_list;      // indices of each triangulation
+};
+
+
+
+// Triangulate the polygons [first, first + count), possibly in a worker thread.
+static void _polygon_bake_chunk(void* user_data, uint32_t first, uint32_t count)
+{
+    DvzPolygonBake* bake = (DvzPolygonBake*)user_data;
+    ASSERT(bake != NULL);
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        dvz_triangulate_polygon(
+            bake->poly_lengths[i], &bake->points[bake->poly_offsets[i]],
+            &bake->index_count_list[i], &bake->indices_list[i]);
+        ASSERT(bake->indices_list[i] != NULL);
+        ASSERT(bake->index_count_list[i] > 0);
+    }
+}
+
 static void _polygon_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 {
     ASSERT(visual != NULL);
@@ -490,27 +794,23 @@ static void _polygon_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     uint32_t* poly_lengths = (uint32_t*)arr_length->data;
 
     // Triangulate the polygons.
-    uint32_t index_count = 0;
     uint32_t total_index_count = 0;
-    uint32_t* indices = NULL;
     uint32_t* index_count_list = (uint32_t*)calloc(n_polys, sizeof(uint32_t));
     uint32_t** indices_list = (uint32_t**)calloc(n_polys, sizeof(uint32_t*));
+    uint32_t* poly_offsets = (uint32_t*)calloc(n_polys, sizeof(uint32_t));
     uint32_t offset = 0;
-
-    // Triangulate all polygons.
     for (uint32_t i = 0; i < n_polys; i++)
     {
-        dvz_triangulate_polygon(
-            poly_lengths[i], (const dvec3*)&points[offset], &index_count, &indices);
-        ASSERT(indices != NULL);
-        ASSERT(index_count > 0);
-        total_index_count += index_count;
-        // Save each triangulation's indices in order to concatenate them afterwards.
-        index_count_list[i] = index_count;
-        indices_list[i] = indices;
+        poly_offsets[i] = offset;
         offset += poly_lengths[i];
     }
 
+    // Triangulate all polygons, in parallel chunks of polygons.
+    DvzPolygonBake bake = {points, poly_lengths, poly_offsets, index_count_list, indices_list};
+    dvz_task_range(_bake_tasks(visual), n_polys, 16, _polygon_bake_chunk, &bake);
+    for (uint32_t i = 0; i < n_polys; i++)
+        total_index_count += index_count_list[i];
+
     // Concatenate all triangulations.
     uint32_t* total_indices = (uint32_t*)calloc(total_index_count, sizeof(uint32_t));
     offset = 0;
@@ -552,6 +852,7 @@ static void _polygon_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 
     FREE(index_count_list);
     FREE(indices_list);
+    FREE(poly_offsets);
     FREE(total_indices);
 }
 
@@ -601,6 +902,287 @@ static void _visual_polygon(DvzVisual* visual)
 /*  Path                                                                                         */
 /*************************************************************************************************/
 
+typedef struct DvzPathBake DvzPathBake;
+
+struct DvzPathBake
+{
+    DvzGraphicsData data;
+    DvzArray* arr_pos;
+    DvzArray* arr_color;
+    DvzArray* arr_topology;
+    uint32_t n_paths;
+    uint32_t* path_offsets; // index of the first point of each path, and the total point count
+};
+
+
+
+// Bake the path points [first, first + count), possibly in a worker thread.
+static void _path_bake_chunk(void* user_data, uint32_t first, uint32_t count)
+{
+    DvzPathBake* bake = (DvzPathBake*)user_data;
+    ASSERT(bake != NULL);
+    const uint32_t* offsets = bake->path_offsets;
+
+    // Each chunk writes its own vertices, starting at the first point of the chunk.
+    DvzGraphicsData data = bake->data;
+    data.current_idx = first;
+
+    // Find the path containing the first point of the chunk.
+    uint32_t lo = 0, hi = bake->n_paths, mid = 0;
+    while (hi - lo > 1)
+    {
+        mid = (lo + hi) / 2;
+        if (offsets[mid] <= first)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    DvzGraphicsPathVertex item = {0};
+    dvec3* point = NULL;
+    cvec4* color = NULL;
+    int32_t* is_closed = NULL;
+    bool closed = false;
+    int32_t path_size = 0;
+    int32_t j, j0, j1, j2, j3;
+    uint32_t idx = 0; // index of the first point in the current path
+    uint32_t i = lo;  // current path
+    bool new_path = true;
+
+    for (uint32_t p = first; p < first + count; p++)
+    {
+        // Move to the path containing the current point, skipping empty paths.
+        while (p >= offsets[i + 1])
+        {
+            i++;
+            new_path = true;
+        }
+        ASSERT(i < bake->n_paths);
+
+        // Per-path data.
+        if (new_path)
+        {
+            idx = offsets[i];
+            path_size = (int32_t)(offsets[i + 1] - offsets[i]);
+            is_closed = dvz_array_item(bake->arr_topology, i);
+            closed = is_closed != NULL ? *is_closed : false;
+            new_path = false;
+        }
+
+        // Compute p0, p1, p2, p3.
+        j = (int32_t)(p - idx);
+        j0 = j - 1;
+        j1 = j;
+        j2 = j + 1;
+        j3 = j + 2;
+
+        if (!closed)
+        {
+            j0 = j0 < 0 ? 0 : j0;
+            j2 = j2 >= path_size ? (path_size - 1) : j2;
+            j3 = j3 >= path_size ? (path_size - 1) : j3;
+        }
+        else
+        {
+            j0 = j0 < 0 ? (path_size - 2) : j0;
+            j2 = j2 >= path_size ? 0 : j2;
+            j3 = j3 >= path_size ? 1 : j3;
+        }
+
+        ASSERT(0 <= j0 && j0 < path_size);
+        ASSERT(0 <= j1 && j1 < path_size);
+        ASSERT(0 <= j2 && j2 < path_size);
+        ASSERT(0 <= j3 && j3 < path_size);
+
+        point = dvz_array_item(bake->arr_pos, idx + (uint32_t)j0);
+        _vec3_cast((const dvec3*)point, &item.p0);
+
+        point = dvz_array_item(bake->arr_pos, idx + (uint32_t)j1);
+        _vec3_cast((const dvec3*)point, &item.p1);
+
+        point = dvz_array_item(bake->arr_pos, idx + (uint32_t)j2);
+        _vec3_cast((const dvec3*)point, &item.p2);
+
+        point = dvz_array_item(bake->arr_pos, idx + (uint32_t)j3);
+        _vec3_cast((const dvec3*)point, &item.p3);
+
+        color = dvz_array_item(bake->arr_color, idx + (uint32_t)j1);
+        memcpy(item.color, color, sizeof(cvec4));
+
+        dvz_graphics_append(&data, &item);
+    }
+}
+
+// Push constants of the GPU path bake compute shader.
+typedef struct DvzPathBakePush DvzPathBakePush;
+
+struct DvzPathBakePush
+{
+    uint32_t n_points;
+    uint32_t n_paths;
+    uint32_t n_colors;
+    uint32_t n_topology;
+};
+
+
+
+// Whether the path vertex buffer should be baked on the GPU.
+static bool _path_gpu_bake(DvzVisual* visual, uint32_t n_points)
+{
+    ASSERT(visual != NULL);
+    if ((visual->flags & DVZ_PATH_FLAGS_CPU_BAKE) != 0)
+        return false;
+
+    // The output vertex buffer is bound as a storage buffer by the compute shader.
+    VkDeviceSize size = 4 * (VkDeviceSize)n_points * sizeof(DvzGraphicsPathVertex);
+    DvzGpu* gpu = visual->canvas->gpu;
+    if (dvz_next_pow2(size) > gpu->device_properties.limits.maxStorageBufferRange)
+        return false;
+
+    if ((visual->flags & DVZ_PATH_FLAGS_GPU_BAKE) != 0)
+        return true;
+    return n_points >= DVZ_PATH_GPU_BAKE_MIN_POINTS && getenv("DVZ_NO_GPU_BAKE") == NULL;
+}
+
+
+
+// Copy a prop array to a storage source of the GPU bake, with at least 1 item.
+static void _path_storage(DvzSource* source, DvzArray* arr)
+{
+    ASSERT(source != NULL);
+    ASSERT(arr != NULL);
+    ASSERT(source->arr.item_size == arr->item_size);
+
+    dvz_array_resize(&source->arr, MAX(1, arr->item_count));
+    if (arr->item_count > 0)
+        memcpy(source->arr.data, arr->data, arr->item_count * arr->item_size);
+    else
+        dvz_array_clear(&source->arr);
+}
+
+
+
+// Prepare the storage sources of the GPU bake, no GPU call is made here.
+static void _path_bake_gpu(DvzVisual* visual, DvzPathBake* bake)
+{
+    ASSERT(visual != NULL);
+    ASSERT(bake != NULL);
+    uint32_t n_points = bake->path_offsets[bake->n_paths];
+    ASSERT(n_points > 0);
+
+    DvzSource* src_pos = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 0);
+    DvzSource* src_color = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 1);
+    DvzSource* src_offsets = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 2);
+    DvzSource* src_topology = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 3);
+    DvzSource* src_vertex = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+
+    // Positions, cast to single precision.
+    dvz_array_resize(&src_pos->arr, n_points);
+    dvz_array_column(
+        &src_pos->arr, 0, sizeof(dvec3), 0, n_points, n_points, bake->arr_pos->data,
+        DVZ_DTYPE_DVEC3, DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE, 1);
+
+    _path_storage(src_color, bake->arr_color);
+    _path_storage(src_topology, bake->arr_topology);
+
+    dvz_array_resize(&src_offsets->arr, bake->n_paths + 1);
+    memcpy(src_offsets->arr.data, bake->path_offsets, (bake->n_paths + 1) * sizeof(uint32_t));
+
+    // The vertex buffer is only allocated on the GPU, and filled by the compute shader: the
+    // vertex array only holds the number of vertices.
+    FREE(src_vertex->arr.data);
+    src_vertex->arr.buffer_size = 0;
+    src_vertex->arr.item_count = 4 * n_points;
+    src_vertex->flags |= DVZ_SOURCE_FLAG_GPU_BAKE;
+}
+
+
+
+// Create the compute pipeline of the GPU bake.
+static DvzCompute* _path_compute(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->compute_count > 0)
+        return visual->computes[0];
+
+    DvzContext* ctx = visual->canvas->gpu->context;
+    ASSERT(ctx != NULL);
+    DvzCompute* compute = dvz_ctx_compute(ctx, NULL);
+
+    unsigned long size = 0;
+    unsigned char* buffer = dvz_resource_shader("compute_path_comp", &size);
+    ASSERT(size > 0);
+    ASSERT(buffer != NULL);
+    ASSERT(size % 4 == 0);
+    uint32_t* code = (uint32_t*)calloc(size, 1);
+    memcpy(code, buffer, size);
+    dvz_compute_spirv(compute, size, code);
+    FREE(code);
+
+    // Positions, colors, path offsets, topology, output vertex buffer.
+    for (uint32_t i = 0; i < 5; i++)
+        dvz_compute_slot(compute, i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    dvz_compute_push(compute, 0, sizeof(DvzPathBakePush), VK_SHADER_STAGE_COMPUTE_BIT);
+
+    dvz_visual_compute(visual, compute);
+    dvz_compute_create(compute);
+    return compute;
+}
+
+
+
+// Upload the storage sources and fill the vertex buffer with the compute shader.
+static void _path_bake_gpu_dispatch(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzSource* src_vertex = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    if ((src_vertex->flags & DVZ_SOURCE_FLAG_GPU_BAKE) == 0)
+        return;
+    ASSERT(src_vertex->u.br.buffer != VK_NULL_HANDLE);
+
+    DvzCompute* compute = _path_compute(visual);
+    ASSERT(compute != NULL);
+    DvzBindings* bindings = dvz_container_get(&visual->bindings_comp, 0);
+    ASSERT(bindings != NULL);
+
+    // Upload the storage sources, which also sets the compute bindings.
+    DvzSource* source = NULL;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        source = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, i);
+        ASSERT(source != NULL);
+        ASSERT(source->arr.item_count > 0);
+        source->origin = DVZ_SOURCE_ORIGIN_LIB;
+        _source_buffer(visual, source);
+        dvz_upload_buffers(
+            canvas, source->u.br, 0, source->arr.item_count * source->arr.item_size,
+            source->arr.data);
+        _source_set(source);
+    }
+
+    // The output vertex buffer.
+    dvz_bindings_buffer(bindings, 4, src_vertex->u.br);
+    dvz_bindings_update(bindings);
+
+    DvzPathBakePush push = {0};
+    push.n_points = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 0)->arr.item_count;
+    push.n_paths = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 2)->arr.item_count - 1;
+    push.n_colors = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 1)->arr.item_count;
+    push.n_topology = dvz_source_get(visual, DVZ_SOURCE_TYPE_STORAGE, 3)->arr.item_count;
+    ASSERT(src_vertex->arr.item_count == 4 * push.n_points);
+
+    // 256 points per workgroup (see compute_path.comp), on a 2D grid if needed.
+    uint32_t groups = (push.n_points + 255) / 256;
+    uvec3 size = {MIN(groups, 65535), (groups + 65534) / 65535, 1};
+    log_debug("bake %d path points on the GPU", push.n_points);
+    dvz_dispatch_compute(canvas, compute, size, sizeof(push), &push);
+}
+
+
+
 static void _path_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 {
     ASSERT(visual != NULL);
@@ -611,11 +1193,6 @@ static void _path_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     DvzProp* prop_length = dvz_prop_get(visual, DVZ_PROP_LENGTH, 0);     // uint
     DvzProp* prop_topology = dvz_prop_get(visual, DVZ_PROP_TOPOLOGY, 0); // int
 
-    DvzArray* arr_pos = _prop_array(prop_pos);
-    DvzArray* arr_color = _prop_array(prop_color);
-    DvzArray* arr_length = _prop_array(prop_length);
-    DvzArray* arr_topology = _prop_array(prop_topology);
-
     DvzSource* src_vertex = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
 
     // The baking function doesn't run if the VERTEX source is handled by the user.
@@ -628,25 +1205,57 @@ static void _path_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         return;
     }
 
+    // The decimated samples are taken from the staging arrays.
+    bool lod = _lod_bake(visual);
+
+    DvzArray* arr_pos = _prop_array(prop_pos);
+    DvzArray* arr_color = _prop_array(prop_color);
+    DvzArray* arr_length = _prop_array(prop_length);
+    DvzArray* arr_topology = _prop_array(prop_topology);
+
     // Source arrays.
     DvzArray* arr_vertex = &src_vertex->arr;
 
     // Number of points and paths.
     uint32_t n_points = arr_pos->item_count;   // number of points
     uint32_t n_paths = arr_length->item_count; // number of paths
-    if (n_paths == 0)
+    // With a level of detail, the single path spans all decimated samples.
+    if (n_paths == 0 || lod)
         n_paths = 1;
-    // number of points, incl invisible join points
-    uint32_t n_points_tot = n_points + 0 * (n_paths);
-
 
     ASSERT(n_points > 0);
     ASSERT(n_paths > 0);
 
-    dvec3* point = NULL;
-    cvec4* color = NULL;
+    // Index of the first point of each path.
+    uint32_t* path_offsets = (uint32_t*)calloc(n_paths + 1, sizeof(uint32_t));
     uint32_t* path_length = NULL;
-    int32_t* is_closed = NULL;
+    for (uint32_t i = 0; i < n_paths; i++)
+    {
+        path_length = lod ? NULL : dvz_array_item(arr_length, i);
+        path_offsets[i + 1] = path_offsets[i] + (path_length != NULL ? *path_length : n_points);
+    }
+    ASSERT(path_offsets[n_paths] == n_points);
+
+    DvzPathBake bake = {0};
+    bake.arr_pos = arr_pos;
+    bake.arr_color = arr_color;
+    bake.arr_topology = arr_topology;
+    bake.n_paths = n_paths;
+    bake.path_offsets = path_offsets;
+
+    // Large paths are baked on the GPU, the vertex buffer is filled by a compute shader after
+    // the upload of the positions, colors, path lengths and topology.
+    if (_path_gpu_bake(visual, n_points))
+    {
+        _path_bake_gpu(visual, &bake);
+        FREE(path_offsets);
+        return;
+    }
+
+    // NOTE: the vertex array has no data after a GPU bake.
+    src_vertex->flags &= ~DVZ_SOURCE_FLAG_GPU_BAKE;
+    if (arr_vertex->data == NULL)
+        arr_vertex->item_count = 0;
 
     // Reesize and fill the vertex buffer.
     dvz_array_resize(arr_vertex, n_points);
@@ -654,102 +1263,14 @@ static void _path_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     _prop_copy(visual, prop_pos);
 
     // Graphics data.
-    DvzGraphicsData data = dvz_graphics_data(visual->graphics[0], arr_vertex, NULL, NULL);
-    dvz_graphics_alloc(&data, n_points_tot);
-
-    DvzGraphicsPathVertex item = {0};
-    int32_t path_size = 0;
-    bool closed = false;
-    int32_t j0, j1, j2, j3;
-    int32_t idx = 0; // index of the first point in the current path
-
-    for (uint32_t i = 0; i < n_paths; i++)
-    {
-        // log_info("path #%d", i);
-
-        // Per-path data.
-        path_length = dvz_array_item(arr_length, i);
-        path_size = path_length != NULL ? (int32_t)*path_length : (int32_t)n_points;
-
-        is_closed = dvz_array_item(arr_topology, i);
-        closed = is_closed != NULL ? *is_closed : false;
-
-        // Add join point at the beginning of each path.
-        {
-            point = dvz_array_item(arr_pos, (uint32_t)idx);
-
-            _vec3_cast((const dvec3*)point, &item.p0);
-            _vec3_cast((const dvec3*)point, &item.p1);
-            _vec3_cast((const dvec3*)point, &item.p2);
-            _vec3_cast((const dvec3*)point, &item.p3);
-
-            memset(item.color, 0, sizeof(cvec4));
-
-            // dvz_graphics_append(&data, &item);
-        }
-
-        // Add all points in the path.
-        for (int32_t j = 0; j < (int32_t)path_size; j++)
-        {
-            // Compute p0, p1, p2, p3.
-            j0 = j - 1;
-            j1 = j;
-            j2 = j + 1;
-            j3 = j + 2;
-
-            if (!closed)
-            {
-                j0 = j0 < 0 ? 0 : j0;
-                j2 = j2 >= path_size ? (path_size - 1) : j2;
-                j3 = j3 >= path_size ? (path_size - 1) : j3;
-            }
-            else
-            {
-                j0 = j0 < 0 ? (path_size - 2) : j0;
-                j2 = j2 >= path_size ? 0 : j2;
-                j3 = j3 >= path_size ? 1 : j3;
-            }
-
-            ASSERT(0 <= j0 && j0 < path_size);
-            ASSERT(0 <= j1 && j1 < path_size);
-            ASSERT(0 <= j2 && j2 < path_size);
-            ASSERT(0 <= j3 && j3 < path_size);
-
-            point = dvz_array_item(arr_pos, (uint32_t)(idx + j0));
-            _vec3_cast((const dvec3*)point, &item.p0);
+    // NOTE: the vertex array is allocated here, the chunks only fill it.
+    bake.data = dvz_graphics_data(visual->graphics[0], arr_vertex, NULL, NULL);
+    dvz_graphics_alloc(&bake.data, n_points);
 
-            point = dvz_array_item(arr_pos, (uint32_t)(idx + j1));
-            _vec3_cast((const dvec3*)point, &item.p1);
+    // Bake the points in parallel chunks.
+    dvz_task_range(_bake_tasks(visual), n_points, DVZ_BAKE_CHUNK_SIZE, _path_bake_chunk, &bake);
 
-            point = dvz_array_item(arr_pos, (uint32_t)(idx + j2));
-            _vec3_cast((const dvec3*)point, &item.p2);
-
-            point = dvz_array_item(arr_pos, (uint32_t)(idx + j3));
-            _vec3_cast((const dvec3*)point, &item.p3);
-
-            color = dvz_array_item(arr_color, (uint32_t)(idx + j1));
-            memcpy(item.color, color, sizeof(cvec4));
-
-            dvz_graphics_append(&data, &item);
-        }
-
-        // Add join point at the end of each path.
-        {
-            point = dvz_array_item(arr_pos, (uint32_t)(idx + path_size - 1));
-
-            _vec3_cast((const dvec3*)point, &item.p0);
-            _vec3_cast((const dvec3*)point, &item.p1);
-            _vec3_cast((const dvec3*)point, &item.p2);
-            _vec3_cast((const dvec3*)point, &item.p3);
-
-            memset(item.color, 0, sizeof(cvec4));
-
-            // dvz_graphics_append(&data, &item);
-        }
-
-        idx += path_size;
-    }
-    ASSERT(idx == (int32_t)n_points);
+    FREE(path_offsets);
 }
 
 static void _visual_path(DvzVisual* visual)
@@ -773,6 +1294,16 @@ static void _visual_path(DvzVisual* visual)
         visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, //
         DVZ_USER_BINDING, sizeof(DvzGraphicsPathParams), 0);        //
 
+    // Storage sources of the optional GPU bake: positions, colors, path offsets, topology.
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_STORAGE, 0, DVZ_PIPELINE_COMPUTE, 0, 0, sizeof(vec3), 0);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_STORAGE, 1, DVZ_PIPELINE_COMPUTE, 0, 1, sizeof(cvec4), 0);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_STORAGE, 2, DVZ_PIPELINE_COMPUTE, 0, 2, sizeof(uint32_t), 0);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_STORAGE, 3, DVZ_PIPELINE_COMPUTE, 0, 3, sizeof(int32_t), 0);
+
     // Props:
 
     // Path points, 1 position per point.
@@ -820,6 +1351,7 @@ static void _visual_path(DvzVisual* visual)
     dvz_visual_prop_default(prop, (int32_t[]){DVZ_JOIN_ROUND});
 
     dvz_visual_callback_bake(visual, _path_bake);
+    dvz_visual_callback_bake_gpu(visual, _path_bake_gpu_dispatch);
 }
 
 
@@ -1022,22 +1554,6 @@ static vec4 DVZ_DEFAULT_AXES_LINE_WIDTH = {2.0f, 4.0f, 1.0f, 2.0f};
 static vec2 DVZ_DEFAULT_AXES_TICK_LENGTH = {10.0f, 15.0f};
 static float DVZ_DEFAULT_AXES_FONT_SIZE = 12.0f;
 
-static uint32_t _count_prop_items(
-    DvzVisual* visual, uint32_t prop_count, DvzPropType* prop_types, //
-    uint32_t idx_count)
-{
-    ASSERT(visual != NULL);
-    uint32_t count = 0;
-    for (uint32_t i = 0; i < prop_count; i++)
-    {
-        for (uint32_t j = 0; j < idx_count; j++)
-        {
-            count += dvz_prop_size(dvz_prop_get(visual, prop_types[i], j));
-        }
-    }
-    return count;
-}
-
 static uint32_t _count_chars(DvzArray* arr_text)
 {
     ASSERT(arr_text != NULL);
@@ -1048,7 +1564,7 @@ static uint32_t _count_chars(DvzArray* arr_text)
     for (uint32_t i = 0; i < n_text; i++)
     {
         str = ((char**)arr_text->data)[i];
-        slen = strlen(str);
+        slen = dvz_utf8_length(str);
         ASSERT(slen > 0);
         char_count += slen;
     }
@@ -1131,10 +1647,10 @@ static void _tick_shift(
 }
 
 static void _add_ticks(
-    DvzProp* tick_prop, DvzGraphicsData* data, DvzAxisLevel level, DvzAxisCoord coord, cvec4 color,
+    DvzArray* arr_tick, DvzGraphicsData* data, DvzAxisLevel level, DvzAxisCoord coord, cvec4 color,
     float lw, vec2 tick_length)
 {
-    ASSERT(tick_prop != NULL);
+    ASSERT(arr_tick != NULL);
     ASSERT(data != NULL);
 
     double* x = NULL;
@@ -1146,14 +1662,14 @@ static void _add_ticks(
     interact_axis = interact_axis >> 12;
     ASSERT(0 <= interact_axis && interact_axis <= 8);
 
-    uint32_t n = tick_prop->arr_orig.item_count;
+    uint32_t n = arr_tick->item_count;
     ASSERT(n > 0);
     float s = 0 + .5 * lw;
     DvzGraphicsSegmentVertex vertex = {0};
     for (uint32_t i = 0; i < n; i++)
     {
         // TODO: transformation
-        x = dvz_prop_item(tick_prop, i);
+        x = dvz_array_item(arr_tick, i);
         ASSERT(x != NULL);
 
         _tick_shift(i, n, s, tick_length, level, coord, vertex.shift);
@@ -1174,24 +1690,34 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     ASSERT(visual != NULL);
     DvzCanvas* canvas = visual->canvas;
 
-    // Data sources.
-    DvzSource* seg_vert_src = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
-    DvzSource* seg_index_src = dvz_source_get(visual, DVZ_SOURCE_TYPE_INDEX, 0);
-    DvzSource* text_vert_src = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 1);
-
-    // HACK: mark the index buffer to be updated.
-    seg_index_src->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+    // NOTE: when baking in a worker thread, the ticks are taken from the arrays passed in the
+    // event, and the vertices are written there, so that the props and sources of the visual are
+    // left untouched.
+    const DvzAxesBake* bake = (const DvzAxesBake*)ev.user_data;
 
-    // Count the total number of segments.
-    // NOTE: the number of segments is determined by the POS prop.
-    uint32_t count = _count_prop_items(visual, 1, (DvzPropType[]){DVZ_PROP_POS}, 4);
+    // Tick positions of each level, and vertex arrays.
+    DvzArray* arr_pos[DVZ_AXES_LEVEL_COUNT] = {0};
+    DvzArray* arr_vertices[2] = {0};
+    uint32_t count = 0;
+    for (uint32_t level = 0; level < DVZ_AXES_LEVEL_COUNT; level++)
+    {
+        arr_pos[level] = bake != NULL ? bake->pos[level]
+                                      : _prop_array(dvz_prop_get(visual, DVZ_PROP_POS, level));
+        ASSERT(arr_pos[level] != NULL);
+        // NOTE: the number of segments is determined by the POS props.
+        count += arr_pos[level]->item_count;
+    }
+    for (uint32_t k = 0; k < 2; k++)
+        arr_vertices[k] = bake != NULL ? bake->vertices[k]
+                                       : &dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, k)->arr;
 
 
     // Segment graphics.
     // -----------------
 
+    // NOTE: instanced graphics, one vertex per segment and no index buffer.
     DvzGraphicsData seg_data =
-        dvz_graphics_data(visual->graphics[0], &seg_vert_src->arr, &seg_index_src->arr, visual);
+        dvz_graphics_data(visual->graphics[0], arr_vertices[0], NULL, visual);
     dvz_graphics_alloc(&seg_data, count);
 
     // Visual coordinate.
@@ -1210,7 +1736,6 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 
     vec2 tick_length = {tick_length_minor, tick_length_major};
 
-    DvzProp* prop = NULL;
     uint32_t tick_count = 0;
     int flags = ((visual->flags >> 2) & 0x0003);
     bool hide_minor = flags & 0x1;
@@ -1219,9 +1744,7 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     for (uint32_t level = 0; level < DVZ_AXES_LEVEL_COUNT; level++)
     {
         // Take the tick positions.
-        prop = dvz_prop_get(visual, DVZ_PROP_POS, level);
-        ASSERT(prop != NULL);
-        tick_count = prop->arr_orig.item_count; // number of ticks for this level.
+        tick_count = arr_pos[level]->item_count; // number of ticks for this level.
         if (tick_count == 0)
             continue;
         ASSERT(tick_count > 0);
@@ -1235,27 +1758,30 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
             (level == DVZ_AXES_LEVEL_GRID && hide_grid))
             color[3] = 0;
 
-        _add_ticks(prop, &seg_data, (DvzAxisLevel)level, coord, color, lw, tick_length);
+        _add_ticks(arr_pos[level], &seg_data, (DvzAxisLevel)level, coord, color, lw, tick_length);
     }
 
     // Labels: one for each major tick.
     DvzGraphicsData text_data =
-        dvz_graphics_data(visual->graphics[1], &text_vert_src->arr, NULL, visual);
+        dvz_graphics_data(visual->graphics[1], arr_vertices[1], NULL, visual);
 
     // Text prop.
-    DvzArray* arr_text = _prop_array(dvz_prop_get(visual, DVZ_PROP_TEXT, 0));
-    ASSERT(prop != NULL);
+    DvzArray* arr_text =
+        bake != NULL ? bake->text : _prop_array(dvz_prop_get(visual, DVZ_PROP_TEXT, 0));
+    ASSERT(arr_text != NULL);
 
-    // Major tick prop.
-    DvzProp* prop_major = dvz_prop_get(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR);
-    uint32_t n_major = prop_major->arr_orig.item_count;
+    // Major ticks.
+    DvzArray* arr_major = arr_pos[DVZ_AXES_LEVEL_MAJOR];
+    uint32_t n_major = arr_major->item_count;
     uint32_t n_text = arr_text->item_count;
     uint32_t count_chars = _count_chars(arr_text);
 
-    // Skip text graphics if no text.
+    // Skip text graphics if no text. The text vertex array may contain the labels of previous
+    // ticks, in the visual or in the back buffer of a worker job, which must not be drawn.
     if (n_text == 0 || count_chars == 0 || n_major == 0)
     {
         log_warn("skip text graphics in axes visual as MAJOR pos or TEXT not set");
+        arr_vertices[1]->item_count = 0;
         return;
     }
 
@@ -1304,7 +1830,7 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         str_item.string = text;
 
         // Position of the text corresponds to position of the major tick.
-        x = dvz_prop_item(prop_major, i);
+        x = dvz_array_item(arr_major, i);
         ASSERT(x != NULL);
         _tick_pos(*x, DVZ_AXES_LEVEL_MAJOR, coord, str_item.vertex.pos, P);
 
@@ -1319,9 +1845,10 @@ static void _visual_axes_2D(DvzVisual* visual)
     ASSERT(canvas != NULL);
     DvzProp* prop = NULL;
 
-    // Graphics.
-    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_SEGMENT, 0));
-    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_TEXT, 0));
+    // Graphics, with one vertex per segment and per glyph.
+    int flags = DVZ_GRAPHICS_FLAGS_INSTANCED;
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_SEGMENT, flags));
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_TEXT, flags));
 
     // Segment graphics.
     {
@@ -1329,11 +1856,6 @@ static void _visual_axes_2D(DvzVisual* visual)
         dvz_visual_source(
             visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, //
             0, sizeof(DvzGraphicsSegmentVertex), 0);
-
-        // Index buffer.
-        dvz_visual_source(
-            visual, DVZ_SOURCE_TYPE_INDEX, 0, DVZ_PIPELINE_GRAPHICS, 0, //
-            0, sizeof(DvzIndex), 0);
     }
 
     // Text graphics.
@@ -1919,6 +2441,7 @@ static void _visual_volume_slice(DvzVisual* visual)
 void dvz_visual_builtin(DvzVisual* visual, DvzVisualType type, int flags)
 {
     ASSERT(visual != NULL);
+    visual->type = (int)type;
     visual->flags = flags;
     switch (type)
     {
@@ -1953,6 +2476,14 @@ void dvz_visual_builtin(DvzVisual* visual, DvzVisualType type, int flags)
         _visual_marker(visual);
         break;
 
+    case DVZ_VISUAL_SEGMENT:
+        _visual_segment(visual);
+        break;
+
+    case DVZ_VISUAL_TEXT:
+        _visual_text(visual);
+        break;
+
     case DVZ_VISUAL_POLYGON:
         _visual_polygon(visual);
         break;
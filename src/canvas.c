@@ -1,5 +1,6 @@
 #include "../include/datoviz/canvas.h"
 #include "../external/video.h"
+#include "../include/datoviz/atlas.h"
 #include "../include/datoviz/context.h"
 #include "../include/datoviz/controls.h"
 #include "../include/datoviz/gui.h"
@@ -55,6 +56,43 @@ static inline bool _all_true(uint32_t n, bool* arr)
 
 
 
+// Allocate command buffers from the command pool owned by the canvas.
+static DvzCommands _canvas_cmds(DvzCanvas* canvas, uint32_t queue_idx, uint32_t count)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    ASSERT(queue_idx < DVZ_MAX_QUEUES);
+
+    if (canvas->cmd_pools[queue_idx] == VK_NULL_HANDLE)
+        canvas->cmd_pools[queue_idx] = dvz_cmd_pool(canvas->gpu, queue_idx);
+    return dvz_commands_pool(canvas->gpu, queue_idx, canvas->cmd_pools[queue_idx], count);
+}
+
+
+
+// In threaded mode, the backend input events are raised in the main thread. They are forwarded to
+// the canvas render thread which calls the event callbacks.
+static bool _input_forward(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    if (!canvas->threaded)
+        return false;
+
+    // Drop the event if the render thread lags behind.
+    if (dvz_fifo_size(&canvas->input_events) >= DVZ_MAX_FIFO_CAPACITY / 2)
+    {
+        log_trace("dropping input event as the render thread is overloaded");
+        return true;
+    }
+
+    DvzEvent* item = calloc(1, sizeof(DvzEvent));
+    *item = ev;
+    dvz_fifo_enqueue(&canvas->input_events, item);
+    return true;
+}
+
+
+
 /*************************************************************************************************/
 /*  Backend-specific event callbacks                                                             */
 /*************************************************************************************************/
@@ -93,6 +131,14 @@ static void _glfw_key_callback(GLFWwindow* window, int key, int scancode, int ac
     key_code = key;
 
     // Find the key event type.
+    DvzEvent ev = {0};
+    ev.type = action == GLFW_PRESS || action == GLFW_REPEAT ? DVZ_EVENT_KEY_PRESS
+                                                             : DVZ_EVENT_KEY_RELEASE;
+    ev.u.k.key_code = key_code;
+    ev.u.k.modifiers = mods;
+    if (_input_forward(canvas, ev))
+        return;
+
     if (action == GLFW_PRESS || action == GLFW_REPEAT)
         dvz_event_key_press(canvas, key_code, mods);
     else
@@ -105,6 +151,14 @@ static void _glfw_wheel_callback(GLFWwindow* window, double dx, double dy)
     ASSERT(canvas != NULL);
     ASSERT(canvas->window != NULL);
 
+    // NOTE: in threaded mode, the position and modifiers are determined in the render thread.
+    DvzEvent ev = {0};
+    ev.type = DVZ_EVENT_MOUSE_WHEEL;
+    ev.u.w.dir[0] = dx;
+    ev.u.w.dir[1] = dy;
+    if (_input_forward(canvas, ev))
+        return;
+
     // HACK: glfw doesn't seem to give a way to probe the keyboard modifiers while using the mouse
     // wheel, so we have to determine the modifiers manually.
     // Limitation: a single modifier is allowed here.
@@ -131,6 +185,13 @@ static void _glfw_button_callback(GLFWwindow* window, int button, int action, in
 
     // Find mouse button action type
     // NOTE: Datoviz modifiers code must match GLFW
+    DvzEvent ev = {0};
+    ev.type = action == GLFW_PRESS ? DVZ_EVENT_MOUSE_PRESS : DVZ_EVENT_MOUSE_RELEASE;
+    ev.u.b.button = b;
+    ev.u.b.modifiers = mods;
+    if (_input_forward(canvas, ev))
+        return;
+
     if (action == GLFW_PRESS)
         dvz_event_mouse_press(canvas, b, mods);
     else
@@ -143,6 +204,13 @@ static void _glfw_move_callback(GLFWwindow* window, double xpos, double ypos)
     ASSERT(canvas != NULL);
     ASSERT(canvas->window != NULL);
 
+    DvzEvent ev = {0};
+    ev.type = DVZ_EVENT_MOUSE_MOVE;
+    ev.u.m.pos[0] = xpos;
+    ev.u.m.pos[1] = ypos;
+    if (_input_forward(canvas, ev))
+        return;
+
     dvz_event_mouse_move(canvas, (vec2){xpos, ypos}, canvas->mouse.modifiers);
 }
 
@@ -157,6 +225,11 @@ static void _glfw_frame_callback(DvzCanvas* canvas, DvzEvent ev)
     // log_debug("mouse event %d", canvas->frame_idx);
     canvas->mouse.prev_state = canvas->mouse.cur_state;
 
+    // NOTE: GLFW functions must be called in the main thread. In threaded mode, the mouse move
+    // events are forwarded by the cursor position callback instead.
+    if (canvas->threaded)
+        return;
+
     // Mouse move event.
     double xpos, ypos;
     glfwGetCursorPos(w, &xpos, &ypos);
@@ -488,6 +561,385 @@ static void _fps_callback(DvzCanvas* canvas, DvzEvent ev)
     double mean = _mean(10, canvas->max_delay_roll);
     canvas->efps = 1.0 / (mean == 0 ? 1 : mean);
     canvas->max_delay = 0;
+
+    // Rolling frame timing statistics.
+    for (uint32_t phase = 0; phase < DVZ_FRAME_PHASE_COUNT; phase++)
+        canvas->timing.stats[phase] = dvz_canvas_timing_stats(canvas, (DvzFramePhase)phase);
+}
+
+
+
+/*************************************************************************************************/
+/*  Frame timing utils                                                                           */
+/*************************************************************************************************/
+
+static const char* _frame_phase_names[] = {
+    "poll",      "fence_wait", "acquire", "callbacks", "scene",
+    "transfers", "refill",     "submit",  "present",   "total",
+};
+
+
+
+static int _cmp_float(const void* a, const void* b)
+{
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return (fa > fb) - (fa < fb);
+}
+
+
+
+// Nearest-rank percentile of sorted values.
+static inline double _percentile(uint32_t n, float* sorted, double q)
+{
+    ASSERT(n > 0);
+    ASSERT(sorted != NULL);
+    int64_t k = (int64_t)ceil(q * n) - 1;
+    return sorted[CLIP(k, 0, (int64_t)n - 1)];
+}
+
+
+
+// Log2 histogram bin of a duration in seconds.
+static inline uint32_t _timing_bin(double duration)
+{
+    double us = duration * 1e6;
+    if (us < 1)
+        return 0;
+    return (uint32_t)MIN(1 + floor(log2(us)), DVZ_TIMING_HIST_BINS - 1);
+}
+
+
+
+// Called at the end of every frame, move the phase durations of the current frame to the rolling
+// window and the histograms.
+static void _timing_commit(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzFrameTiming* timing = &canvas->timing;
+
+    // The scene updates happen in FRAME callbacks, they are not counted twice.
+    double* cur = timing->cur;
+    cur[DVZ_FRAME_PHASE_CALLBACKS] =
+        fmax(0, cur[DVZ_FRAME_PHASE_CALLBACKS] - cur[DVZ_FRAME_PHASE_SCENE]);
+
+    // Total frame time, between the end of the last frame and the end of the current one. For the
+    // first frame, we just take the sum of all phases.
+    double now = _clock_now();
+    cur[DVZ_FRAME_PHASE_TOTAL] = 0;
+    if (timing->last_end > 0)
+        cur[DVZ_FRAME_PHASE_TOTAL] = now - timing->last_end;
+    else
+        for (uint32_t phase = 0; phase < DVZ_FRAME_PHASE_TOTAL; phase++)
+            cur[DVZ_FRAME_PHASE_TOTAL] += cur[phase];
+    timing->last_end = now;
+
+    uint32_t i = timing->frame_count % DVZ_TIMING_SAMPLES;
+    timing->frames[i] = canvas->frame_idx;
+    for (uint32_t phase = 0; phase < DVZ_FRAME_PHASE_COUNT; phase++)
+    {
+        timing->samples[phase][i] = (float)cur[phase];
+        timing->hist[phase][_timing_bin(cur[phase])]++;
+        cur[phase] = 0;
+    }
+    timing->frame_count++;
+}
+
+
+
+/*************************************************************************************************/
+/*  Async picking utils                                                                          */
+/*************************************************************************************************/
+
+// (Re)create the persistently-mapped readback buffer of the async picking.
+static void _pick_buffer(DvzPick* pick, VkDeviceSize size)
+{
+    ASSERT(pick != NULL);
+    ASSERT(pick->canvas != NULL);
+    ASSERT(size > 0);
+
+    // NOTE: this is only called when there is no pending copy, so that the old buffer can be
+    // safely destroyed.
+    if (dvz_obj_is_created(&pick->buffer.obj))
+    {
+        log_debug("enlarge the pick readback buffer to %s", pretty_size(size));
+        dvz_buffer_destroy(&pick->buffer);
+    }
+
+    pick->buffer = dvz_buffer(pick->canvas->gpu);
+    dvz_buffer_size(&pick->buffer, size);
+    dvz_buffer_usage(&pick->buffer, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    dvz_buffer_memory(
+        &pick->buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    dvz_buffer_queue_access(&pick->buffer, DVZ_DEFAULT_QUEUE_RENDER);
+    dvz_buffer_create(&pick->buffer);
+    ASSERT(dvz_obj_is_created(&pick->buffer.obj));
+
+    // Permanently map the buffer.
+    pick->buffer.mmap = dvz_buffer_map(&pick->buffer, 0, VK_WHOLE_SIZE);
+}
+
+
+
+static void _pick_create(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+    pick->canvas = canvas;
+
+    // The copy commands are submitted with the render commands, so they must be on the same queue
+    // and have one command buffer per swapchain image.
+    pick->cmds = _canvas_cmds(canvas, DVZ_DEFAULT_QUEUE_RENDER, canvas->swapchain.img_count);
+    _pick_buffer(pick, DVZ_PICK_BUFFER_SIZE);
+    pick->requests = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    atomic_init(&pick->request_count, 1); // 0 is reserved for failed requests
+    pick->status = DVZ_PICK_STATUS_IDLE;
+
+    pick->obj.type = DVZ_OBJECT_TYPE_CUSTOM;
+    dvz_obj_created(&pick->obj);
+}
+
+
+
+// Convert a position in screen coordinates into a pixel of the pick attachment.
+static void _pick_pos(DvzCanvas* canvas, const uvec2 pos_screen, uvec2 pos)
+{
+    ASSERT(canvas != NULL);
+
+    uvec2 size_screen = {0};
+    uvec2 size_fb = {0};
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_SCREEN, size_screen);
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_FRAMEBUFFER, size_fb);
+
+    double ratio = 1;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        ASSERT(size_fb[i] > 0);
+        ratio = size_screen[i] > 0 ? size_fb[i] / (double)size_screen[i] : 1;
+        pos[i] = MIN((uint32_t)round(pos_screen[i] * ratio), size_fb[i] - 1);
+    }
+}
+
+
+
+static uint64_t _pick_enqueue(DvzPick* pick, DvzPickRequest* req)
+{
+    ASSERT(pick != NULL);
+    ASSERT(req != NULL);
+    ASSERT(req->count > 0);
+
+    req->idx = atomic_fetch_add(&pick->request_count, 1);
+    dvz_fifo_enqueue(&pick->requests, req);
+    return req->idx;
+}
+
+
+
+// Record the copy of all pending pick requests into the pick command buffer of the current
+// swapchain image. This command buffer is submitted along with the render command buffer.
+static void _pick_record(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+
+    // Only one batch in flight at a time.
+    if (pick->status != DVZ_PICK_STATUS_IDLE ||
+        (dvz_fifo_size(&pick->requests) == 0 && pick->batch_count == 0))
+        return;
+
+    // Gather all pending requests in a single batch, unless a batch has been recorded but not
+    // submitted before the canvas was recreated.
+    const VkDeviceSize item_size = sizeof(ivec4);
+    VkDeviceSize size = 0;
+    DvzPickRequest* req = NULL;
+    if (pick->batch_count > 0)
+    {
+        req = pick->batch[pick->batch_count - 1];
+        size = req->buf_offset + req->count * item_size;
+    }
+    while (pick->batch_count < DVZ_PICK_MAX_BATCH)
+    {
+        req = (DvzPickRequest*)dvz_fifo_dequeue(&pick->requests, false);
+        if (req == NULL)
+            break;
+        req->buf_offset = size;
+        size += req->count * item_size;
+        pick->batch[pick->batch_count++] = req;
+    }
+    if (pick->batch_count == 0)
+        return;
+    log_trace("record async pick batch with %d request(s)", pick->batch_count);
+
+    // Enlarge the readback buffer if needed.
+    if (size > pick->buffer.size)
+        _pick_buffer(pick, dvz_next_pow2(size));
+
+    DvzImages* images = &canvas->pick_image;
+    DvzCommands* cmds = &pick->cmds;
+    uint32_t img_idx = canvas->swapchain.img_idx;
+
+    // The copy must wait for the renderpass to write to the pick attachment.
+    DvzBarrier barrier = dvz_barrier(canvas->gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images(&barrier, images);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    dvz_cmd_reset(cmds, img_idx);
+    dvz_cmd_begin(cmds, img_idx);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+
+    // One copy region per rectangle or point, all copied with a single command.
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < pick->batch_count; i++)
+        n += pick->batch[i]->type == DVZ_PICK_RECT ? 1 : pick->batch[i]->count;
+    ivec3* offsets = (ivec3*)calloc(n, sizeof(ivec3));
+    uvec3* shapes = (uvec3*)calloc(n, sizeof(uvec3));
+    VkDeviceSize* buf_offsets = (VkDeviceSize*)calloc(n, sizeof(VkDeviceSize));
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < pick->batch_count; i++)
+    {
+        req = pick->batch[i];
+        ASSERT(req != NULL);
+        if (req->type == DVZ_PICK_RECT)
+        {
+            offsets[k][0] = (int32_t)req->offset[0];
+            offsets[k][1] = (int32_t)req->offset[1];
+            shapes[k][0] = req->shape[0];
+            shapes[k][1] = req->shape[1];
+            shapes[k][2] = 1;
+            buf_offsets[k++] = req->buf_offset;
+            continue;
+        }
+        for (uint32_t j = 0; j < req->count; j++)
+        {
+            offsets[k][0] = (int32_t)req->points[j][0];
+            offsets[k][1] = (int32_t)req->points[j][1];
+            shapes[k][0] = shapes[k][1] = shapes[k][2] = 1;
+            buf_offsets[k++] = req->buf_offset + j * item_size;
+        }
+    }
+    ASSERT(k == n);
+    dvz_cmd_copy_image_regions_to_buffer(
+        cmds, img_idx, images, n, offsets, shapes, &pick->buffer, buf_offsets);
+    FREE(offsets);
+    FREE(shapes);
+    FREE(buf_offsets);
+
+    // The next renderpass must wait for the copy to finish.
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+    dvz_cmd_end(cmds, img_idx);
+
+    pick->status = DVZ_PICK_STATUS_AWAIT_SUBMIT;
+}
+
+
+
+// Read back the values of the last pick batch, if the frame that copied them has finished
+// rendering, and emit the PICK events. This function never waits on the GPU.
+static void _pick_readback(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+
+    if (pick->status != DVZ_PICK_STATUS_AWAIT_READBACK)
+        return;
+    if (!dvz_fences_ready(&canvas->fences_render_finished, pick->fence_idx))
+        return;
+
+    // Copy the values of the whole batch from the mapped buffer.
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < pick->batch_count; i++)
+        count += pick->batch[i]->count;
+    if (count > pick->values_count)
+    {
+        REALLOC(pick->values, count * sizeof(ivec4));
+        pick->values_count = count;
+    }
+    ASSERT(pick->buffer.mmap != NULL);
+    memcpy(pick->values, pick->buffer.mmap, count * sizeof(ivec4));
+
+    // One PICK event per request.
+    DvzPickRequest* req = NULL;
+    DvzEvent ev = {0};
+    ev.type = DVZ_EVENT_PICK;
+    for (uint32_t i = 0; i < pick->batch_count; i++)
+    {
+        req = pick->batch[i];
+        ASSERT(req != NULL);
+
+        ev.u.p.idx = req->idx;
+        ev.u.p.type = req->type;
+        ev.u.p.count = req->count;
+        ev.u.p.offset[0] = req->offset[0];
+        ev.u.p.offset[1] = req->offset[1];
+        ev.u.p.shape[0] = req->shape[0];
+        ev.u.p.shape[1] = req->shape[1];
+        ev.u.p.values = &pick->values[req->buf_offset / sizeof(ivec4)];
+        ev.u.p.user_data = req->user_data;
+        _event_produce(canvas, ev);
+
+        FREE(req->points);
+        FREE(req);
+        pick->batch[i] = NULL;
+    }
+    pick->batch_count = 0;
+    pick->status = DVZ_PICK_STATUS_IDLE;
+}
+
+
+
+// Called after the canvas has been recreated: the pick command buffers follow the new number of
+// swapchain images, and a batch recorded with the old pick image is recorded again.
+static void _pick_recreate(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+    if (pick->cmds.count != canvas->swapchain.img_count)
+    {
+        dvz_commands_destroy(&pick->cmds);
+        pick->cmds = _canvas_cmds(canvas, DVZ_DEFAULT_QUEUE_RENDER, canvas->swapchain.img_count);
+    }
+    if (pick->status == DVZ_PICK_STATUS_AWAIT_SUBMIT)
+        pick->status = DVZ_PICK_STATUS_IDLE;
+}
+
+
+
+static void _pick_destroy(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+    if (!dvz_obj_is_created(&pick->obj))
+        return;
+
+    // Discard the pending requests.
+    DvzPickRequest* req = NULL;
+    for (uint32_t i = 0; i < pick->batch_count; i++)
+    {
+        FREE(pick->batch[i]->points);
+        FREE(pick->batch[i]);
+    }
+    while ((req = (DvzPickRequest*)dvz_fifo_dequeue(&pick->requests, false)) != NULL)
+    {
+        FREE(req->points);
+        FREE(req);
+    }
+    dvz_fifo_destroy(&pick->requests);
+
+    dvz_commands_destroy(&pick->cmds);
+    dvz_buffer_destroy(&pick->buffer);
+    FREE(pick->values);
+    dvz_obj_destroyed(&pick->obj);
 }
 
 
@@ -692,15 +1144,19 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
 
     // Default transfer commands.
     {
-        canvas->cmds_transfer = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_TRANSFER, 1);
+        canvas->cmds_transfer = _canvas_cmds(canvas, DVZ_DEFAULT_QUEUE_TRANSFER, 1);
     }
 
     // Default render commands.
     {
         canvas->cmds_render =
-            dvz_commands(gpu, DVZ_DEFAULT_QUEUE_RENDER, canvas->swapchain.img_count);
+            _canvas_cmds(canvas, DVZ_DEFAULT_QUEUE_RENDER, canvas->swapchain.img_count);
     }
 
+    // Async picking.
+    if (support_pick)
+        _pick_create(canvas);
+
     // Default submit instance.
     canvas->submit = dvz_submit(gpu);
 
@@ -840,6 +1296,9 @@ void dvz_canvas_recreate(DvzCanvas* canvas)
     dvz_framebuffers_create(framebuffers, renderpass);
     if (canvas->overlay)
         dvz_framebuffers_create(framebuffers_overlay, renderpass_overlay);
+
+    if (support_pick && dvz_obj_is_created(&canvas->pick.obj))
+        _pick_recreate(canvas);
 }
 
 
@@ -848,7 +1307,7 @@ DvzCommands* dvz_canvas_commands(DvzCanvas* canvas, uint32_t queue_idx, uint32_t
 {
     ASSERT(canvas != NULL);
     DvzCommands* commands = dvz_container_alloc(&canvas->commands);
-    *commands = dvz_commands(canvas->gpu, queue_idx, count);
+    *commands = _canvas_cmds(canvas, queue_idx, count);
     return commands;
 }
 
@@ -963,6 +1422,14 @@ DvzViewport dvz_viewport_full(DvzCanvas* canvas)
     viewport.size_framebuffer[1] = viewport.viewport.height =
         (float)canvas->swapchain.images->height;
 
+    // In a tiled export, the viewport covers the full image, restricted to the current tile.
+    if (canvas->tiling != NULL)
+    {
+        viewport.size_framebuffer[0] = viewport.viewport.width = (float)canvas->tiling->size[0];
+        viewport.size_framebuffer[1] = viewport.viewport.height = (float)canvas->tiling->size[1];
+        dvz_viewport_tiled(canvas, &viewport);
+    }
+
     if (canvas->window != NULL)
     {
         viewport.size_screen[0] = canvas->window->width;
@@ -983,6 +1450,54 @@ DvzViewport dvz_viewport_full(DvzCanvas* canvas)
 
 
 
+bool dvz_viewport_tiled(DvzCanvas* canvas, DvzViewport* viewport)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(viewport != NULL);
+    DvzTiling* tiling = canvas->tiling;
+    if (tiling == NULL)
+        return false;
+
+    // Full viewport, relative to the current tile.
+    float x = viewport->viewport.x - tiling->offset[0];
+    float y = viewport->viewport.y - tiling->offset[1];
+    float w = viewport->viewport.width;
+    float h = viewport->viewport.height;
+    ASSERT(w > 0);
+    ASSERT(h > 0);
+    viewport->offset_framebuffer[0] = (int32_t)x;
+    viewport->offset_framebuffer[1] = (int32_t)y;
+
+    // The Vulkan viewport and scissor must fit in the framebuffer, which has the tile size.
+    float x0 = CLIP(x, 0, tiling->tile_size[0]);
+    float y0 = CLIP(y, 0, tiling->tile_size[1]);
+    float x1 = CLIP(x + w, 0, tiling->tile_size[0]);
+    float y1 = CLIP(y + h, 0, tiling->tile_size[1]);
+    viewport->viewport.x = x0;
+    viewport->viewport.y = y0;
+    viewport->viewport.width = x1 - x0;
+    viewport->viewport.height = y1 - y0;
+    if (x1 <= x0 || y1 <= y0)
+    {
+        // The viewport is outside of the tile and is not rendered. Vulkan forbids zero-size
+        // viewports, so we keep a valid 1x1 viewport within the framebuffer.
+        viewport->viewport.x = MIN(x0, tiling->tile_size[0] - 1);
+        viewport->viewport.y = MIN(y0, tiling->tile_size[1] - 1);
+        viewport->viewport.width = viewport->viewport.height = 1;
+        glm_vec4_zero(viewport->tile);
+        return true;
+    }
+
+    // NDC transformation from the full viewport to the clipped one, applied by the shaders.
+    viewport->tile[0] = w / (x1 - x0);
+    viewport->tile[1] = h / (y1 - y0);
+    viewport->tile[2] = (2 * (x - x0) + w) / (x1 - x0) - 1;
+    viewport->tile[3] = (2 * (y - y0) + h) / (y1 - y0) - 1;
+    return false;
+}
+
+
+
 /*************************************************************************************************/
 /*  Callbacks                                                                                    */
 /*************************************************************************************************/
@@ -1559,6 +2074,119 @@ void dvz_event_stop(DvzCanvas* canvas)
 
 
 
+/*************************************************************************************************/
+/*  Frame timing                                                                                 */
+/*************************************************************************************************/
+
+void dvz_canvas_timing_begin(DvzCanvas* canvas, DvzFramePhase phase)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(phase < DVZ_FRAME_PHASE_TOTAL);
+    canvas->timing.start[phase] = _clock_now();
+}
+
+
+
+void dvz_canvas_timing_end(DvzCanvas* canvas, DvzFramePhase phase)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(phase < DVZ_FRAME_PHASE_TOTAL);
+    ASSERT(canvas->timing.start[phase] > 0);
+    canvas->timing.cur[phase] += _clock_now() - canvas->timing.start[phase];
+}
+
+
+
+const char* dvz_canvas_timing_name(DvzFramePhase phase)
+{
+    ASSERT(phase < DVZ_FRAME_PHASE_COUNT);
+    return _frame_phase_names[phase];
+}
+
+
+
+DvzFrameStats dvz_canvas_timing_stats(DvzCanvas* canvas, DvzFramePhase phase)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(phase < DVZ_FRAME_PHASE_COUNT);
+    DvzFrameTiming* timing = &canvas->timing;
+
+    DvzFrameStats stats = {0};
+    uint32_t n = (uint32_t)MIN(timing->frame_count, DVZ_TIMING_SAMPLES);
+    if (n == 0)
+        return stats;
+    stats.count = n;
+
+    // NOTE: the first n samples are the valid ones, whether the window is full or not.
+    float sorted[DVZ_TIMING_SAMPLES];
+    memcpy(sorted, timing->samples[phase], n * sizeof(float));
+    qsort(sorted, n, sizeof(float), _cmp_float);
+
+    for (uint32_t i = 0; i < n; i++)
+        stats.mean += sorted[i];
+    stats.mean /= n;
+    stats.max = sorted[n - 1];
+    stats.p50 = _percentile(n, sorted, .50);
+    stats.p95 = _percentile(n, sorted, .95);
+    stats.p99 = _percentile(n, sorted, .99);
+    return stats;
+}
+
+
+
+void dvz_canvas_timing_reset(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzFrameTiming* timing = &canvas->timing;
+
+    // Keep the ongoing measurements of the current frame.
+    timing->frame_count = 0;
+    memset(timing->frames, 0, sizeof(timing->frames));
+    memset(timing->samples, 0, sizeof(timing->samples));
+    memset(timing->hist, 0, sizeof(timing->hist));
+    memset(timing->stats, 0, sizeof(timing->stats));
+}
+
+
+
+int dvz_canvas_timing_csv(DvzCanvas* canvas, const char* path)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(path != NULL);
+    DvzFrameTiming* timing = &canvas->timing;
+
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        log_error("unable to open %s for writing", path);
+        return 1;
+    }
+
+    // Header.
+    fprintf(fp, "frame");
+    for (uint32_t phase = 0; phase < DVZ_FRAME_PHASE_COUNT; phase++)
+        fprintf(fp, ",%s", _frame_phase_names[phase]);
+    fprintf(fp, "\n");
+
+    // One row per frame, from the oldest to the most recent one, durations in milliseconds.
+    uint64_t n = MIN(timing->frame_count, DVZ_TIMING_SAMPLES);
+    uint32_t i = 0;
+    for (uint64_t k = timing->frame_count - n; k < timing->frame_count; k++)
+    {
+        i = k % DVZ_TIMING_SAMPLES;
+        fprintf(fp, "%" PRIu64, timing->frames[i]);
+        for (uint32_t phase = 0; phase < DVZ_FRAME_PHASE_COUNT; phase++)
+            fprintf(fp, ",%.4f", 1000 * timing->samples[phase][i]);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp);
+    log_info("saved frame timing of %d frames to %s", (int)n, path);
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Screencast                                                                                   */
 /*************************************************************************************************/
@@ -1776,7 +2404,7 @@ void dvz_screencast(DvzCanvas* canvas, double interval, bool has_alpha)
 
     // NOTE: we predefine the transfer command buffers, one per swapchain image.
     sc->cmds =
-        dvz_commands(canvas->gpu, DVZ_DEFAULT_QUEUE_TRANSFER, canvas->swapchain.images->count);
+        _canvas_cmds(canvas, DVZ_DEFAULT_QUEUE_TRANSFER, canvas->swapchain.images->count);
     _screencast_cmds(sc);
     sc->submit = dvz_submit(canvas->gpu);
 
@@ -1976,29 +2604,91 @@ void dvz_canvas_pick(DvzCanvas* canvas, uvec2 pos_screen, ivec4 picked)
 
 
 
-/*************************************************************************************************/
-/*  Video screencast                                                                             */
-/*************************************************************************************************/
-
-static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
+uint64_t dvz_canvas_pick_points(
+    DvzCanvas* canvas, uint32_t count, const uvec2* pos_screen, void* user_data)
 {
     ASSERT(canvas != NULL);
-    log_debug("video frame #%d", ev.u.sc.idx);
-
-    Video* video = (Video*)canvas->screencast->user_data;
-    if (video == NULL)
-        return;
-    ASSERT(video != NULL);
+    ASSERT(pos_screen != NULL);
+    ASSERT(count > 0);
 
-    // Create the video if needed.
-    if (video->ost == NULL)
+    if (!dvz_obj_is_created(&canvas->pick.obj))
     {
-        create_video(video);
+        log_error("async picking requires a canvas created with DVZ_CANVAS_FLAGS_PICK");
+        return 0;
+    }
+    if (count > DVZ_PICK_MAX_POINTS)
+    {
+        log_warn(
+            "too many pick points (%d), only keeping the first %d", count, DVZ_PICK_MAX_POINTS);
+        count = DVZ_PICK_MAX_POINTS;
     }
-    ASSERT(video->ost != NULL);
 
-    add_frame(video, ev.u.sc.rgba);
-    FREE(ev.u.sc.rgba);
+    DvzPickRequest* req = calloc(1, sizeof(DvzPickRequest));
+    req->type = DVZ_PICK_POINTS;
+    req->count = count;
+    req->points = calloc(count, sizeof(uvec2));
+    for (uint32_t i = 0; i < count; i++)
+        _pick_pos(canvas, pos_screen[i], req->points[i]);
+    req->user_data = user_data;
+
+    return _pick_enqueue(&canvas->pick, req);
+}
+
+
+
+uint64_t dvz_canvas_pick_rect(DvzCanvas* canvas, uvec2 pos0, uvec2 pos1, void* user_data)
+{
+    ASSERT(canvas != NULL);
+
+    if (!dvz_obj_is_created(&canvas->pick.obj))
+    {
+        log_error("async picking requires a canvas created with DVZ_CANVAS_FLAGS_PICK");
+        return 0;
+    }
+
+    uvec2 p0 = {0};
+    uvec2 p1 = {0};
+    _pick_pos(canvas, pos0, p0);
+    _pick_pos(canvas, pos1, p1);
+
+    DvzPickRequest* req = calloc(1, sizeof(DvzPickRequest));
+    req->type = DVZ_PICK_RECT;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        req->offset[i] = MIN(p0[i], p1[i]);
+        req->shape[i] = MAX(p0[i], p1[i]) - req->offset[i] + 1;
+    }
+    req->count = req->shape[0] * req->shape[1];
+    req->user_data = user_data;
+
+    return _pick_enqueue(&canvas->pick, req);
+}
+
+
+
+/*************************************************************************************************/
+/*  Video screencast                                                                             */
+/*************************************************************************************************/
+
+static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    log_debug("video frame #%d", ev.u.sc.idx);
+
+    Video* video = (Video*)canvas->screencast->user_data;
+    if (video == NULL)
+        return;
+    ASSERT(video != NULL);
+
+    // Create the video if needed.
+    if (video->ost == NULL)
+    {
+        create_video(video);
+    }
+    ASSERT(video->ost != NULL);
+
+    add_frame(video, ev.u.sc.rgba);
+    FREE(ev.u.sc.rgba);
 }
 
 static void _video_destroy(DvzCanvas* canvas, DvzEvent ev)
@@ -2084,6 +2774,12 @@ void dvz_canvas_frame(DvzCanvas* canvas)
     // Compute the maximum delay between two successive frames.
     canvas->max_delay = fmax(canvas->max_delay, canvas->clock.interval);
 
+    // Read back the last async pick batch if its frame has finished rendering, and emit the PICK
+    // events.
+    _pick_readback(canvas);
+
+    dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_CALLBACKS);
+
     // Call INTERACT callbacks (for backends only), which may enqueue some events.
     _event_interact(canvas);
 
@@ -2096,15 +2792,27 @@ void dvz_canvas_frame(DvzCanvas* canvas)
     // Call TIMER callbacks, in the main thread.
     _event_timer(canvas);
 
+    dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_CALLBACKS);
+
     // Refill all command buffers at the first iteration.
     if (canvas->frame_idx == 0)
         dvz_canvas_to_refill(canvas);
 
     // Pending transfers.
+    dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_TRANSFERS);
     dvz_process_transfers(canvas);
+    // Upload the glyphs added to the font atlas, possibly by a worker thread, since the last
+    // frame.
+    dvz_font_atlas_upload(&canvas->gpu->context->font_atlas);
+    dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_TRANSFERS);
 
     // Refill if needed, only 1 swapchain command buffer per frame to avoid waiting on the device.
+    dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_REFILL);
     _refill_frame(canvas);
+    dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_REFILL);
+
+    // Record the copy of the pending async pick requests, to be submitted with this frame.
+    _pick_record(canvas);
 }
 
 
@@ -2119,6 +2827,8 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
     uint32_t f = canvas->cur_frame;
     uint32_t img_idx = canvas->swapchain.img_idx;
 
+    dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_SUBMIT);
+
     // Keep track of the fence associated to the current swapchain image.
     dvz_fences_copy(
         &canvas->fences_render_finished, f, //
@@ -2132,6 +2842,26 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
     if (canvas->cmds_render.obj.status == DVZ_OBJECT_STATUS_CREATED)
         dvz_submit_commands(s, &canvas->cmds_render);
 
+    // Async pick copy commands, which must come after the render commands.
+    bool pick_submit = canvas->pick.status == DVZ_PICK_STATUS_AWAIT_SUBMIT;
+    if (pick_submit)
+        dvz_submit_commands(s, &canvas->pick.cmds);
+
+    // Tiled export copy commands, which must also come after the render commands.
+    if (canvas->tiling != NULL)
+    {
+        DvzBatchSlot* slot = NULL;
+        for (uint32_t i = 0; i < DVZ_BATCH_STAGING_COUNT; i++)
+        {
+            slot = &canvas->tiling->slots[i];
+            if (slot->status != DVZ_BATCH_SLOT_AWAIT_SUBMIT)
+                continue;
+            dvz_submit_commands(s, &slot->cmds);
+            slot->fence_idx = f;
+            slot->status = DVZ_BATCH_SLOT_AWAIT_READBACK;
+        }
+    }
+
     // // Extra render commands.
     // DvzCommands* cmds = dvz_container_iter(&canvas->commands);
     // while (cmds != NULL)
@@ -2147,6 +2877,7 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
     if (s->commands_count == 0)
     {
         log_error("no recorded command buffers");
+        dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_SUBMIT);
         return;
     }
 
@@ -2168,19 +2899,33 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
         // Send the Submit instance.
         dvz_submit_send(s, img_idx, &canvas->fences_render_finished, f);
 
+        // The pick values will be read back once this frame's fence is signaled.
+        if (pick_submit)
+        {
+            canvas->pick.fence_idx = f;
+            canvas->pick.status = DVZ_PICK_STATUS_AWAIT_READBACK;
+        }
+
         // Call POST_SEND callbacks
         _event_postsend(canvas);
     }
 
+    dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_SUBMIT);
+
     // Once the image is rendered, we present the swapchain image.
     // The semaphore used for waiting during presentation may be changed by the canvas
     // callbacks.
+    dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_PRESENT);
     if (!canvas->offscreen)
         dvz_swapchain_present(
             &canvas->swapchain, 1, //
             canvas->present_semaphores, CLIP(f, 0, canvas->present_semaphores->count - 1));
+    dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_PRESENT);
 
     canvas->cur_frame = (f + 1) % canvas->fences_render_finished.count;
+
+    // End of the frame timing.
+    _timing_commit(canvas);
 }
 
 
@@ -2230,20 +2975,26 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
             }
 
             // Poll events.
+            dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_POLL);
             if (canvas->window != NULL)
                 dvz_window_poll_events(canvas->window);
+            dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_POLL);
 
             // NOTE: swapchain image acquisition happens here
 
             // Wait for fence.
+            dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_FENCE_WAIT);
             dvz_fences_wait(&canvas->fences_render_finished, canvas->cur_frame);
+            dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_FENCE_WAIT);
 
             // We acquire the next swapchain image.
             // NOTE: this call modifies swapchain->img_idx
+            dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_ACQUIRE);
             if (!canvas->offscreen)
                 dvz_swapchain_acquire(
                     &canvas->swapchain, &canvas->sem_img_available, //
                     canvas->cur_frame, NULL, 0);
+            dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_ACQUIRE);
 
             // If there is a problem with swapchain image acquisition, wait and try again later.
             if (canvas->swapchain.obj.status == DVZ_OBJECT_STATUS_INVALID)
@@ -2354,6 +3105,870 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
 
 
 
+/*************************************************************************************************/
+/*  Threaded event loop                                                                          */
+/*************************************************************************************************/
+
+// Call the event callbacks of the input events forwarded by the main thread.
+static void _input_process(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzEvent* ev = NULL;
+    while (true)
+    {
+        ev = (DvzEvent*)dvz_fifo_dequeue(&canvas->input_events, false);
+        if (ev == NULL)
+            break;
+        switch (ev->type)
+        {
+        case DVZ_EVENT_MOUSE_PRESS:
+            dvz_event_mouse_press(canvas, ev->u.b.button, ev->u.b.modifiers);
+            break;
+        case DVZ_EVENT_MOUSE_RELEASE:
+            dvz_event_mouse_release(canvas, ev->u.b.button, ev->u.b.modifiers);
+            break;
+        case DVZ_EVENT_MOUSE_MOVE:
+            dvz_event_mouse_move(canvas, ev->u.m.pos, canvas->mouse.modifiers);
+            break;
+        case DVZ_EVENT_MOUSE_WHEEL:
+            dvz_event_mouse_wheel(
+                canvas, canvas->mouse.cur_pos, ev->u.w.dir,
+                _key_modifiers(canvas->keyboard.key_code));
+            break;
+        case DVZ_EVENT_KEY_PRESS:
+            dvz_event_key_press(canvas, ev->u.k.key_code, ev->u.k.modifiers);
+            break;
+        case DVZ_EVENT_KEY_RELEASE:
+            dvz_event_key_release(canvas, ev->u.k.key_code, ev->u.k.modifiers);
+            break;
+        default:
+            break;
+        }
+        FREE(ev);
+    }
+}
+
+
+
+static void* _render_thread(void* p_canvas)
+{
+    DvzCanvas* canvas = (DvzCanvas*)p_canvas;
+    ASSERT(canvas != NULL);
+    log_debug("starting canvas render thread");
+
+    DvzObjectStatus status = DVZ_OBJECT_STATUS_NONE;
+    // NOTE: the iterations skipped because of an invalid swapchain or a swapchain recreation do
+    // not count as rendered frames.
+    uint64_t iter = 0;
+    while (iter < canvas->render_frame_count)
+    {
+        if (atomic_load(&canvas->to_close))
+            break;
+
+        // Input events forwarded by the main thread.
+        _input_process(canvas);
+
+        // Wait for fence.
+        dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_FENCE_WAIT);
+        dvz_fences_wait(&canvas->fences_render_finished, canvas->cur_frame);
+        dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_FENCE_WAIT);
+
+        // We acquire the next swapchain image.
+        dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_ACQUIRE);
+        if (!canvas->offscreen)
+            dvz_swapchain_acquire(
+                &canvas->swapchain, &canvas->sem_img_available, //
+                canvas->cur_frame, NULL, 0);
+        dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_ACQUIRE);
+
+        // If there is a problem with swapchain image acquisition, wait and try again later.
+        if (canvas->swapchain.obj.status == DVZ_OBJECT_STATUS_INVALID)
+        {
+            log_trace("swapchain image acquisition failed, waiting and skipping this frame");
+            dvz_gpu_wait(canvas->gpu);
+            continue;
+        }
+
+        // The swapchain recreation queries the window, which must be done in the main thread.
+        // We wait until the main thread has recreated the canvas.
+        if (canvas->swapchain.obj.status == DVZ_OBJECT_STATUS_NEED_RECREATE)
+        {
+            log_trace("swapchain image acquisition failed, request the canvas recreation");
+            status = DVZ_OBJECT_STATUS_NEED_RECREATE;
+            atomic_store(&canvas->cur_status, status);
+            while (atomic_load(&canvas->cur_status) == DVZ_OBJECT_STATUS_NEED_RECREATE)
+                dvz_sleep(1);
+            continue;
+        }
+
+        // Frame logic.
+        dvz_canvas_frame(canvas);
+        canvas->resized = false;
+
+        // Submit the command buffers and swapchain logic.
+        dvz_canvas_frame_submit(canvas);
+        canvas->frame_idx++;
+        iter++;
+    }
+
+    // Signal the main thread that the render thread is done.
+    log_debug("stopping canvas render thread");
+    status = DVZ_OBJECT_STATUS_INACTIVE;
+    atomic_store(&canvas->cur_status, status);
+    return NULL;
+}
+
+
+
+static void _render_thread_start(DvzCanvas* canvas, uint64_t frame_count)
+{
+    ASSERT(canvas != NULL);
+
+    // INIT event and RESIZE callbacks at the first frame, in the main thread.
+    if (canvas->frame_idx == 0)
+    {
+        _event_resize(canvas);
+
+        DvzEvent ev = {0};
+        ev.type = DVZ_EVENT_INIT;
+        _event_produce(canvas, ev);
+    }
+
+    canvas->render_frame_count = frame_count;
+    canvas->input_events = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    DvzObjectStatus status = DVZ_OBJECT_STATUS_CREATED;
+    atomic_store(&canvas->cur_status, status);
+    canvas->threaded = true;
+
+    // The mouse position cannot be polled from the render thread.
+    if (canvas->window != NULL && canvas->app->backend == DVZ_BACKEND_GLFW)
+        glfwSetCursorPosCallback(canvas->window->backend_window, _glfw_move_callback);
+
+    canvas->render_thread = dvz_thread(_render_thread, canvas);
+}
+
+
+
+static void _render_thread_stop(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+
+    dvz_thread_join(&canvas->render_thread);
+    canvas->threaded = false;
+
+    if (canvas->window != NULL && canvas->app->backend == DVZ_BACKEND_GLFW)
+        glfwSetCursorPosCallback(canvas->window->backend_window, NULL);
+
+    // Discard the pending input events.
+    void* item = NULL;
+    while ((item = dvz_fifo_dequeue(&canvas->input_events, false)) != NULL)
+        FREE(item);
+    dvz_fifo_destroy(&canvas->input_events);
+}
+
+
+
+void dvz_app_run_threaded(DvzApp* app, uint64_t frame_count)
+{
+    ASSERT(app != NULL);
+    if (frame_count == 0)
+        frame_count = UINT64_MAX;
+    ASSERT(frame_count > 0);
+
+    DvzContainerIterator iterator;
+    DvzCanvas* canvas = NULL;
+
+    // ImGui uses a global context and cannot be used concurrently in several threads.
+    iterator = dvz_container_iterator(&app->canvases);
+    while (iterator.item != NULL)
+    {
+        canvas = (DvzCanvas*)iterator.item;
+        if (dvz_obj_is_created(&canvas->obj) && canvas->overlay)
+        {
+            log_warn("threaded mode is not supported with GUIs, falling back to the serial loop");
+            dvz_app_run(app, frame_count == UINT64_MAX ? 0 : frame_count);
+            return;
+        }
+        dvz_container_iter(&iterator);
+    }
+
+    log_debug("start threaded main loop");
+    app->is_running = true;
+
+    // Start one render thread per canvas.
+    uint32_t n_threads = 0;
+    iterator = dvz_container_iterator(&app->canvases);
+    while (iterator.item != NULL)
+    {
+        canvas = (DvzCanvas*)iterator.item;
+        if (dvz_obj_is_created(&canvas->obj))
+        {
+            _render_thread_start(canvas, frame_count);
+            n_threads++;
+        }
+        dvz_container_iter(&iterator);
+    }
+
+    // The main thread only handles the window events, the canvas recreation and destruction.
+    DvzObjectStatus status = DVZ_OBJECT_STATUS_NONE;
+    while (n_threads > 0)
+    {
+        n_threads = 0;
+        iterator = dvz_container_iterator(&app->canvases);
+        while (iterator.item != NULL)
+        {
+            canvas = (DvzCanvas*)iterator.item;
+            if (!canvas->threaded)
+            {
+                dvz_container_iter(&iterator);
+                continue;
+            }
+
+            // Poll events, and forward them to the render thread.
+            if (canvas->window != NULL)
+            {
+                dvz_window_poll_events(canvas->window);
+                if (backend_window_should_close(app->backend, canvas->window->backend_window))
+                    canvas->window->obj.status = DVZ_OBJECT_STATUS_NEED_DESTROY;
+                if (canvas->window->obj.status == DVZ_OBJECT_STATUS_NEED_DESTROY)
+                    dvz_canvas_to_close(canvas);
+            }
+
+            status = atomic_load(&canvas->cur_status);
+
+            // Recreate the canvas on behalf of the render thread, which waits in the meantime.
+            if (status == DVZ_OBJECT_STATUS_NEED_RECREATE)
+            {
+                log_trace("recreating the canvas in the main thread");
+                dvz_canvas_recreate(canvas);
+                _event_resize(canvas);
+                canvas->resized = true;
+                dvz_canvas_to_refill(canvas);
+
+                status = DVZ_OBJECT_STATUS_CREATED;
+                atomic_store(&canvas->cur_status, status);
+            }
+
+            // The render thread has stopped.
+            else if (status == DVZ_OBJECT_STATUS_INACTIVE)
+            {
+                _render_thread_stop(canvas);
+
+                // Destroy the canvas if it was closed.
+                if (atomic_load(&canvas->to_close))
+                {
+                    log_trace("destroying canvas");
+                    dvz_event_stop(canvas);
+                    dvz_app_wait(app);
+                    dvz_canvas_destroy(canvas);
+                }
+                dvz_container_iter(&iterator);
+                continue;
+            }
+
+            n_threads++;
+            dvz_container_iter(&iterator);
+        }
+
+        // Do not spin when the render threads are busy.
+        dvz_sleep(1);
+    }
+    log_trace("end threaded main loop");
+
+    dvz_app_wait(app);
+    app->is_running = false;
+}
+
+
+
+/*************************************************************************************************/
+/*  Batch rendering                                                                              */
+/*************************************************************************************************/
+
+static void* _batch_worker(void* user_data)
+{
+    DvzBatch* batch = (DvzBatch*)user_data;
+    ASSERT(batch != NULL);
+
+    DvzBatchJob* job = NULL;
+    while (true)
+    {
+        // NOTE: a NULL job is the signal to stop the worker.
+        job = (DvzBatchJob*)dvz_fifo_dequeue(&batch->jobs, true);
+        if (job == NULL)
+            break;
+        ASSERT(job->rgb != NULL);
+
+        log_trace("batch worker writing image #%d to %s", job->idx, job->path);
+        if (dvz_write_png(job->path, job->width, job->height, job->rgb) != 0)
+            log_error("unable to write PNG file %s", job->path);
+
+        FREE(job->rgb);
+        FREE(job);
+        pthread_mutex_lock(&batch->lock);
+        atomic_fetch_add(&batch->written, 1);
+        atomic_fetch_sub(&batch->pending, 1);
+        pthread_cond_broadcast(&batch->cond_written);
+        pthread_mutex_unlock(&batch->lock);
+    }
+    return NULL;
+}
+
+
+
+// Block until at most max_pending images are waiting to be written by the workers.
+static void _batch_wait_pending(DvzBatch* batch, uint32_t max_pending)
+{
+    ASSERT(batch != NULL);
+    pthread_mutex_lock(&batch->lock);
+    while (atomic_load(&batch->pending) > max_pending)
+        pthread_cond_wait(&batch->cond_written, &batch->lock);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+
+
+// Record the copy of the swapchain image to the staging image of a slot.
+static void _batch_record(DvzCanvas* canvas, DvzBatchSlot* slot)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(slot != NULL);
+
+    DvzImages* images = canvas->swapchain.images;
+    ASSERT(images != NULL);
+    uint32_t img_idx = canvas->swapchain.img_idx;
+
+    DvzBarrier barrier = dvz_barrier(canvas->gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images(&barrier, images);
+
+    DvzCommands* cmds = &slot->cmds;
+    dvz_cmd_reset(cmds, img_idx);
+    dvz_cmd_begin(cmds, img_idx);
+
+    // Wait for the end of the renderpass before copying the image.
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+
+    dvz_cmd_copy_image(cmds, img_idx, images, &slot->staging);
+
+    // The next frame must not render into the image before the copy has completed.
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+
+    dvz_cmd_end(cmds, img_idx);
+}
+
+
+
+// Download a rendered staging image and hand it over to the PNG workers.
+static void _batch_readback(DvzBatch* batch, DvzBatchSlot* slot)
+{
+    ASSERT(batch != NULL);
+    ASSERT(slot != NULL);
+    ASSERT(slot->status == DVZ_BATCH_SLOT_AWAIT_READBACK);
+
+    // Limit the number of images waiting to be encoded, and thus the memory usage.
+    _batch_wait_pending(batch, DVZ_BATCH_MAX_PENDING - 1);
+
+    DvzImages* staging = &slot->staging;
+    DvzBatchJob* job = calloc(1, sizeof(DvzBatchJob));
+    job->idx = slot->idx;
+    job->width = staging->width;
+    job->height = staging->height;
+    strncpy(job->path, slot->path, sizeof(job->path) - 1);
+
+    // NOTE: this is a plain memcpy from the host-coherent staging image, the PNG encoding is done
+    // by the workers.
+    job->rgb = calloc(staging->width * staging->height, 3 * sizeof(uint8_t));
+    dvz_images_download(staging, 0, sizeof(uint8_t), true, false, job->rgb);
+    slot->status = DVZ_BATCH_SLOT_IDLE;
+
+    atomic_fetch_add(&batch->pending, 1);
+    dvz_fifo_enqueue(&batch->jobs, job);
+}
+
+
+
+// Read back all staging images whose frame has finished rendering.
+static void _batch_poll(DvzBatch* batch, bool wait)
+{
+    ASSERT(batch != NULL);
+    DvzCanvas* canvas = batch->canvas;
+    ASSERT(canvas != NULL);
+
+    DvzBatchSlot* slot = NULL;
+    // Read back the images in the order they have been rendered.
+    for (uint32_t i = 0; i < DVZ_BATCH_STAGING_COUNT; i++)
+    {
+        slot = &batch->slots[(batch->slot_idx + i) % DVZ_BATCH_STAGING_COUNT];
+        if (slot->status != DVZ_BATCH_SLOT_AWAIT_READBACK)
+            continue;
+        if (wait)
+            dvz_fences_wait(&canvas->fences_render_finished, slot->fence_idx);
+        else if (!dvz_fences_ready(&canvas->fences_render_finished, slot->fence_idx))
+            continue;
+        _batch_readback(batch, slot);
+    }
+}
+
+
+
+static void _batch_presend(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    DvzBatch* batch = canvas->batch;
+    if (batch == NULL || !dvz_obj_is_created(&batch->obj))
+        return;
+
+    DvzBatchSlot* slot = NULL;
+    for (uint32_t i = 0; i < DVZ_BATCH_STAGING_COUNT; i++)
+    {
+        slot = &batch->slots[i];
+        if (slot->status != DVZ_BATCH_SLOT_AWAIT_SUBMIT)
+            continue;
+
+        // The copy is submitted along with the render commands and signals the frame fence.
+        dvz_submit_commands(ev.u.s.submit, &slot->cmds);
+        slot->fence_idx = canvas->cur_frame;
+        slot->status = DVZ_BATCH_SLOT_AWAIT_READBACK;
+    }
+}
+
+
+
+static void _batch_destroy(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    dvz_batch_destroy(canvas);
+}
+
+
+
+// Process a single frame of the canvas, like in the main event loop but without any window or
+// swapchain logic.
+static void _batch_frame(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->offscreen);
+
+    if (canvas->frame_idx == 0)
+    {
+        _event_resize(canvas);
+
+        DvzEvent ev = {0};
+        ev.type = DVZ_EVENT_INIT;
+        _event_produce(canvas, ev);
+    }
+
+    dvz_canvas_frame(canvas);
+    canvas->resized = false;
+    dvz_canvas_frame_submit(canvas);
+    canvas->frame_idx++;
+}
+
+
+
+void dvz_batch(DvzCanvas* canvas, uint32_t worker_count)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    if (!canvas->offscreen)
+    {
+        log_error("batch rendering requires an offscreen canvas");
+        return;
+    }
+    if (canvas->batch != NULL)
+    {
+        log_warn("batch rendering already enabled on this canvas");
+        return;
+    }
+
+    DvzImages* images = canvas->swapchain.images;
+    ASSERT(images != NULL);
+
+    canvas->batch = calloc(1, sizeof(DvzBatch));
+    DvzBatch* batch = canvas->batch;
+    batch->canvas = canvas;
+
+    // Staging ring. The copy commands are submitted with the render commands, so they must be on
+    // the same queue and have one command buffer per swapchain image.
+    DvzBatchSlot* slot = NULL;
+    for (uint32_t i = 0; i < DVZ_BATCH_STAGING_COUNT; i++)
+    {
+        slot = &batch->slots[i];
+        slot->cmds = _canvas_cmds(canvas, DVZ_DEFAULT_QUEUE_RENDER, canvas->swapchain.img_count);
+        slot->staging = _staging_image(canvas, images->format, images->width, images->height);
+        slot->status = DVZ_BATCH_SLOT_IDLE;
+    }
+
+    // PNG encoding worker pool.
+    if (worker_count == 0)
+        worker_count = DVZ_BATCH_DEFAULT_WORKERS;
+    batch->worker_count = CLIP(worker_count, 1, DVZ_BATCH_MAX_WORKERS);
+    batch->jobs = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    atomic_init(&batch->pending, 0);
+    atomic_init(&batch->written, 0);
+    if (pthread_mutex_init(&batch->lock, NULL) != 0)
+        log_error("mutex creation failed");
+    if (pthread_cond_init(&batch->cond_written, NULL) != 0)
+        log_error("cond creation failed");
+    for (uint32_t i = 0; i < batch->worker_count; i++)
+        batch->workers[i] = dvz_thread(_batch_worker, batch);
+    log_debug("start batch rendering with %d PNG worker(s)", batch->worker_count);
+
+    dvz_event_callback(canvas, DVZ_EVENT_PRE_SEND, 0, DVZ_EVENT_MODE_SYNC, _batch_presend, NULL);
+    dvz_event_callback(canvas, DVZ_EVENT_DESTROY, 0, DVZ_EVENT_MODE_SYNC, _batch_destroy, NULL);
+
+    batch->obj.type = DVZ_OBJECT_TYPE_CUSTOM;
+    dvz_obj_created(&batch->obj);
+}
+
+
+
+uint64_t dvz_batch_render(DvzCanvas* canvas, const char* png_path)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(png_path != NULL);
+    DvzBatch* batch = canvas->batch;
+    if (batch == NULL || !dvz_obj_is_created(&batch->obj))
+    {
+        log_error("batch rendering has not been enabled on this canvas, call dvz_batch() first");
+        return 0;
+    }
+    DvzApp* app = canvas->app;
+    ASSERT(app != NULL);
+
+    // NOTE: the app is considered as running while the frame is processed so that data uploads
+    // are deferred to this frame instead of forcing a hard GPU synchronization. The previous
+    // state is restored on exit, so that the canvas is not seen as running between two calls.
+    bool is_running = app->is_running;
+    app->is_running = true;
+
+    // Wait for the previous frame (frames in flight) and read back the images it has rendered.
+    dvz_fences_wait(&canvas->fences_render_finished, canvas->cur_frame);
+    _batch_poll(batch, false);
+
+    // Find the staging slot of this image.
+    DvzBatchSlot* slot = &batch->slots[batch->slot_idx];
+    if (slot->status == DVZ_BATCH_SLOT_AWAIT_READBACK)
+    {
+        dvz_fences_wait(&canvas->fences_render_finished, slot->fence_idx);
+        _batch_readback(batch, slot);
+    }
+    ASSERT(slot->status == DVZ_BATCH_SLOT_IDLE);
+    batch->slot_idx = (batch->slot_idx + 1) % DVZ_BATCH_STAGING_COUNT;
+
+    slot->idx = batch->image_count++;
+    strncpy(slot->path, png_path, sizeof(slot->path) - 1);
+    slot->path[sizeof(slot->path) - 1] = 0;
+
+    // Record the copy, which is submitted with the frame by the PRE_SEND callback.
+    _batch_record(canvas, slot);
+    slot->status = DVZ_BATCH_SLOT_AWAIT_SUBMIT;
+
+    _batch_frame(canvas);
+    ASSERT(slot->status == DVZ_BATCH_SLOT_AWAIT_READBACK);
+
+    app->is_running = is_running;
+    return slot->idx;
+}
+
+
+
+void dvz_batch_flush(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzBatch* batch = canvas->batch;
+    if (batch == NULL || !dvz_obj_is_created(&batch->obj))
+        return;
+
+    _batch_poll(batch, true);
+    _batch_wait_pending(batch, 0);
+    log_debug("batch flushed, %d image(s) written", atomic_load(&batch->written));
+
+    dvz_app_wait(canvas->app);
+}
+
+
+
+void dvz_batch_destroy(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzBatch* batch = canvas->batch;
+    if (batch == NULL)
+        return;
+    if (!dvz_obj_is_created(&batch->obj))
+        return;
+
+    dvz_batch_flush(canvas);
+
+    // Stop the workers.
+    for (uint32_t i = 0; i < batch->worker_count; i++)
+        dvz_fifo_enqueue(&batch->jobs, NULL);
+    for (uint32_t i = 0; i < batch->worker_count; i++)
+        dvz_thread_join(&batch->workers[i]);
+    dvz_fifo_destroy(&batch->jobs);
+    pthread_cond_destroy(&batch->cond_written);
+    pthread_mutex_destroy(&batch->lock);
+
+    for (uint32_t i = 0; i < DVZ_BATCH_STAGING_COUNT; i++)
+    {
+        dvz_commands_destroy(&batch->slots[i].cmds);
+        dvz_images_destroy(&batch->slots[i].staging);
+    }
+
+    dvz_obj_destroyed(&batch->obj);
+    FREE(batch);
+    canvas->batch = NULL;
+}
+
+
+
+/*************************************************************************************************/
+/*  Tiled export                                                                                 */
+/*************************************************************************************************/
+
+static void* _tiling_writer(void* user_data)
+{
+    DvzTiling* tiling = (DvzTiling*)user_data;
+    ASSERT(tiling != NULL);
+
+    DvzTilingRow* row = NULL;
+    bool failed = false;
+    while (true)
+    {
+        // NOTE: a NULL row is the signal to stop the writer.
+        row = (DvzTilingRow*)dvz_fifo_dequeue(&tiling->jobs, true);
+        if (row == NULL)
+            break;
+        ASSERT(row->rgb != NULL);
+
+        if (!failed && dvz_image_writer_rows(tiling->writer, row->row_count, row->rgb) != 0)
+        {
+            log_error("unable to write the tiled image");
+            failed = true;
+            atomic_store(&tiling->failed, failed);
+        }
+        atomic_fetch_add(&tiling->rows_written, 1);
+    }
+    return NULL;
+}
+
+
+
+// Copy a rendered tile into its tile row, and hand over the row to the writer once complete.
+static void _tiling_readback(DvzTiling* tiling, DvzBatchSlot* slot)
+{
+    ASSERT(tiling != NULL);
+    ASSERT(slot != NULL);
+    ASSERT(slot->status == DVZ_BATCH_SLOT_AWAIT_READBACK);
+
+    uint32_t tx = slot->idx % tiling->tile_count[0];
+    uint32_t ty = slot->idx / tiling->tile_count[0];
+    uint32_t tw = tiling->tile_size[0];
+    uint32_t th = tiling->tile_size[1];
+    DvzTilingRow* row = &tiling->rows[ty % DVZ_TILING_ROW_BUFFERS];
+
+    // Wait until the writer is done with the row buffer before starting a new tile row.
+    if (tx == 0)
+    {
+        while (atomic_load(&tiling->rows_written) + DVZ_TILING_ROW_BUFFERS <= ty)
+            dvz_sleep(1);
+        row->row_count = MIN(th, tiling->size[1] - ty * th);
+    }
+
+    dvz_images_download(&slot->staging, 0, sizeof(uint8_t), true, false, tiling->tile_rgb);
+    slot->status = DVZ_BATCH_SLOT_IDLE;
+
+    // The last tiles of a row or column may be cropped.
+    uint32_t w = MIN(tw, tiling->size[0] - tx * tw);
+    uint64_t row_size = 3 * (uint64_t)tiling->size[0];
+    for (uint32_t j = 0; j < row->row_count; j++)
+        memcpy(
+            row->rgb + j * row_size + 3 * (uint64_t)tx * tw, //
+            tiling->tile_rgb + 3 * (uint64_t)j * tw, 3 * w);
+
+    if (tx == tiling->tile_count[0] - 1)
+        dvz_fifo_enqueue(&tiling->jobs, row);
+}
+
+
+
+static DvzTiling* _tiling_create(DvzCanvas* canvas, DvzImageWriter* writer, uvec2 size)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(writer != NULL);
+
+    DvzImages* images = canvas->swapchain.images;
+    ASSERT(images != NULL);
+
+    DvzTiling* tiling = calloc(1, sizeof(DvzTiling));
+    tiling->canvas = canvas;
+    tiling->writer = writer;
+    tiling->size[0] = size[0];
+    tiling->size[1] = size[1];
+    tiling->tile_size[0] = images->width;
+    tiling->tile_size[1] = images->height;
+    tiling->tile_count[0] = (size[0] + images->width - 1) / images->width;
+    tiling->tile_count[1] = (size[1] + images->height - 1) / images->height;
+
+    // Staging ring, the copy commands are submitted with the frame by dvz_canvas_frame_submit().
+    DvzBatchSlot* slot = NULL;
+    for (uint32_t i = 0; i < DVZ_BATCH_STAGING_COUNT; i++)
+    {
+        slot = &tiling->slots[i];
+        slot->cmds = _canvas_cmds(canvas, DVZ_DEFAULT_QUEUE_RENDER, canvas->swapchain.img_count);
+        slot->staging = _staging_image(canvas, images->format, images->width, images->height);
+        slot->status = DVZ_BATCH_SLOT_IDLE;
+    }
+    tiling->tile_rgb = calloc(images->width * images->height, 3 * sizeof(uint8_t));
+
+    // Tile rows.
+    for (uint32_t i = 0; i < DVZ_TILING_ROW_BUFFERS; i++)
+        tiling->rows[i].rgb = calloc((uint64_t)size[0] * images->height, 3 * sizeof(uint8_t));
+
+    // Writer thread.
+    tiling->jobs = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    atomic_init(&tiling->rows_written, 0);
+    atomic_init(&tiling->failed, false);
+    tiling->writer_thread = dvz_thread(_tiling_writer, tiling);
+
+    tiling->obj.type = DVZ_OBJECT_TYPE_CUSTOM;
+    dvz_obj_created(&tiling->obj);
+    return tiling;
+}
+
+
+
+static int _tiling_destroy(DvzTiling* tiling)
+{
+    ASSERT(tiling != NULL);
+
+    // Stop the writer once all rows have been written.
+    dvz_fifo_enqueue(&tiling->jobs, NULL);
+    dvz_thread_join(&tiling->writer_thread);
+    dvz_fifo_destroy(&tiling->jobs);
+
+    int res = atomic_load(&tiling->failed) ? 1 : 0;
+    if (dvz_image_writer_close(tiling->writer) != 0)
+        res = 1;
+
+    for (uint32_t i = 0; i < DVZ_BATCH_STAGING_COUNT; i++)
+    {
+        dvz_commands_destroy(&tiling->slots[i].cmds);
+        dvz_images_destroy(&tiling->slots[i].staging);
+    }
+    for (uint32_t i = 0; i < DVZ_TILING_ROW_BUFFERS; i++)
+        FREE(tiling->rows[i].rgb);
+    FREE(tiling->tile_rgb);
+
+    dvz_obj_destroyed(&tiling->obj);
+    FREE(tiling);
+    return res;
+}
+
+
+
+int dvz_screenshot_tiled(DvzCanvas* canvas, const char* path, uint32_t width, uint32_t height)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(path != NULL);
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+    DvzApp* app = canvas->app;
+    ASSERT(app != NULL);
+
+    if (!canvas->offscreen)
+    {
+        log_error("tiled export requires an offscreen canvas");
+        return 1;
+    }
+    if (canvas->tiling != NULL)
+    {
+        log_error("a tiled export is already running on this canvas");
+        return 1;
+    }
+
+    DvzImageWriter* writer = dvz_image_writer(path, width, height);
+    if (writer == NULL)
+    {
+        log_error("unable to create %s", path);
+        return 1;
+    }
+
+    DvzTiling* tiling = _tiling_create(canvas, writer, (uvec2){width, height});
+    canvas->tiling = tiling;
+    uint32_t n_tiles = tiling->tile_count[0] * tiling->tile_count[1];
+    log_info(
+        "start tiled export of %dx%d image with %dx%d tiles to %s", width, height,
+        tiling->tile_count[0], tiling->tile_count[1], path);
+
+    // NOTE: the app is considered as running during the export so that data uploads are
+    // deferred to the next frame instead of forcing a hard GPU synchronization.
+    bool is_running = app->is_running;
+    app->is_running = true;
+
+    // Waiting for the current frame fence at the beginning of a tile guarantees that the tile
+    // rendered that many tiles before is done.
+    uint32_t n_flight = canvas->fences_render_finished.count;
+    ASSERT(n_flight < DVZ_BATCH_STAGING_COUNT);
+    DvzBatchSlot* slot = NULL;
+    for (uint32_t k = 0; k < n_tiles; k++)
+    {
+        dvz_fences_wait(&canvas->fences_render_finished, canvas->cur_frame);
+
+        slot = &tiling->slots[k % DVZ_BATCH_STAGING_COUNT];
+        ASSERT(slot->status == DVZ_BATCH_SLOT_IDLE);
+        slot->idx = k;
+        _batch_record(canvas, slot);
+        slot->status = DVZ_BATCH_SLOT_AWAIT_SUBMIT;
+
+        // Shift the viewports to the tile, and record the command buffers again.
+        tiling->offset[0] = (int32_t)((k % tiling->tile_count[0]) * tiling->tile_size[0]);
+        tiling->offset[1] = (int32_t)((k / tiling->tile_count[0]) * tiling->tile_size[1]);
+        _event_resize(canvas);
+        dvz_canvas_to_refill(canvas);
+
+        _batch_frame(canvas);
+        ASSERT(slot->status == DVZ_BATCH_SLOT_AWAIT_READBACK);
+
+        // Read back an earlier tile while the GPU renders this one.
+        if (k >= n_flight)
+            _tiling_readback(tiling, &tiling->slots[(k - n_flight) % DVZ_BATCH_STAGING_COUNT]);
+    }
+
+    // Read back the last tiles.
+    dvz_gpu_wait(gpu);
+    for (uint32_t k = n_tiles - MIN(n_tiles, n_flight); k < n_tiles; k++)
+        _tiling_readback(tiling, &tiling->slots[k % DVZ_BATCH_STAGING_COUNT]);
+
+    int res = _tiling_destroy(tiling);
+    canvas->tiling = NULL;
+    app->is_running = is_running;
+
+    // Restore the viewports.
+    _event_resize(canvas);
+    dvz_canvas_to_refill(canvas);
+
+    if (res == 0)
+        log_info("tiled export of %d tiles done", n_tiles);
+    return res;
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas destruction                                                                           */
 /*************************************************************************************************/
@@ -2397,6 +4012,7 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     dvz_images_destroy(&canvas->depth_image);
     dvz_images_destroy(&canvas->pick_image);
     dvz_images_destroy(&canvas->pick_staging);
+    _pick_destroy(canvas);
 
     // Destroy the renderpasses.
     log_trace("canvas destroy renderpass");
@@ -2426,6 +4042,9 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     CONTAINER_DESTROY_ITEMS(DvzCommands, canvas->commands, dvz_commands_destroy)
     dvz_container_destroy(&canvas->commands);
 
+    // Destroy the staging buffer.
+    dvz_buffer_destroy(&canvas->staging);
+
     // Destroy the semaphores.
     log_trace("canvas destroy semaphores");
     dvz_semaphores_destroy(&canvas->sem_img_available);
@@ -2440,6 +4059,13 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     CONTAINER_DESTROY_ITEMS(DvzGui, canvas->guis, dvz_gui_destroy)
     dvz_container_destroy(&canvas->guis);
 
+    // Destroy the command pools, which frees all command buffers of the canvas.
+    log_trace("canvas destroy command pools");
+    for (uint32_t i = 0; i < DVZ_MAX_QUEUES; i++)
+    {
+        dvz_cmd_pool_destroy(canvas->gpu, canvas->cmd_pools[i]);
+        canvas->cmd_pools[i] = VK_NULL_HANDLE;
+    }
 
     dvz_obj_destroyed(&canvas->obj);
 }
@@ -103,6 +103,161 @@ int dvz_write_ppm(const char* filename, uint32_t width, uint32_t height, const u
     return 0;
 }
 
+typedef enum
+{
+    DVZ_IMAGE_FORMAT_RAW,
+    DVZ_IMAGE_FORMAT_PPM,
+    DVZ_IMAGE_FORMAT_PNG,
+} DvzImageFileFormat;
+
+struct DvzImageWriter
+{
+    DvzImageFileFormat format;
+    FILE* fp;
+    uint32_t width, height;
+    uint32_t row; // number of rows written so far
+    bool failed;
+#if HAS_PNG
+    png_structp png_ptr;
+    png_infop info_ptr;
+#endif
+};
+
+static bool _has_extension(const char* filename, const char* ext)
+{
+    size_t n = strlen(filename);
+    size_t k = strlen(ext);
+    return n >= k && strcmp(filename + n - k, ext) == 0;
+}
+
+DvzImageWriter* dvz_image_writer(const char* filename, uint32_t width, uint32_t height)
+{
+    ASSERT(filename != NULL);
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+
+    DvzImageFileFormat format = DVZ_IMAGE_FORMAT_RAW;
+    if (_has_extension(filename, ".png"))
+        format = DVZ_IMAGE_FORMAT_PNG;
+    else if (_has_extension(filename, ".ppm"))
+        format = DVZ_IMAGE_FORMAT_PPM;
+
+#if !HAS_PNG
+    if (format == DVZ_IMAGE_FORMAT_PNG)
+    {
+        log_error("datoviz was not build with PNG support, please install libpng-dev");
+        return NULL;
+    }
+#endif
+
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL)
+        return NULL;
+
+    DvzImageWriter* writer = calloc(1, sizeof(DvzImageWriter));
+    writer->format = format;
+    writer->fp = fp;
+    writer->width = width;
+    writer->height = height;
+
+    if (format == DVZ_IMAGE_FORMAT_PPM)
+        fprintf(fp, "P6\n%d\n%d\n255\n", width, height);
+
+#if HAS_PNG
+    if (format == DVZ_IMAGE_FORMAT_PNG)
+    {
+        writer->png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        if (writer->png_ptr != NULL)
+            writer->info_ptr = png_create_info_struct(writer->png_ptr);
+        if (writer->png_ptr == NULL || writer->info_ptr == NULL ||
+            setjmp(png_jmpbuf(writer->png_ptr)))
+        {
+            png_destroy_write_struct(&writer->png_ptr, &writer->info_ptr);
+            fclose(fp);
+            FREE(writer);
+            return NULL;
+        }
+
+        png_init_io(writer->png_ptr, fp);
+        png_set_IHDR(
+            writer->png_ptr, writer->info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB,
+            PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+        png_write_info(writer->png_ptr, writer->info_ptr);
+    }
+#endif
+
+    return writer;
+}
+
+int dvz_image_writer_rows(DvzImageWriter* writer, uint32_t row_count, const uint8_t* rows)
+{
+    ASSERT(writer != NULL);
+    ASSERT(rows != NULL);
+    if (writer->failed)
+        return 1;
+    if (writer->row + row_count > writer->height)
+    {
+        log_error("too many rows written to the image");
+        writer->failed = true;
+        return 1;
+    }
+
+    size_t row_size = writer->width * 3;
+
+#if HAS_PNG
+    if (writer->format == DVZ_IMAGE_FORMAT_PNG)
+    {
+        if (setjmp(png_jmpbuf(writer->png_ptr)))
+        {
+            writer->failed = true;
+            return 1;
+        }
+        for (uint32_t k = 0; k < row_count; k++)
+            png_write_row(writer->png_ptr, (png_const_bytep)(rows + k * row_size));
+        writer->row += row_count;
+        return 0;
+    }
+#endif
+
+    if (fwrite(rows, row_size, row_count, writer->fp) != row_count)
+    {
+        writer->failed = true;
+        return 1;
+    }
+    writer->row += row_count;
+    return 0;
+}
+
+int dvz_image_writer_close(DvzImageWriter* writer)
+{
+    ASSERT(writer != NULL);
+    if (writer->row != writer->height)
+    {
+        log_error("image closed after %d rows out of %d", writer->row, writer->height);
+        writer->failed = true;
+    }
+
+#if HAS_PNG
+    if (writer->format == DVZ_IMAGE_FORMAT_PNG)
+    {
+        if (!writer->failed)
+        {
+            if (setjmp(png_jmpbuf(writer->png_ptr)))
+                writer->failed = true;
+            else
+                png_write_end(writer->png_ptr, writer->info_ptr);
+        }
+        png_destroy_write_struct(&writer->png_ptr, &writer->info_ptr);
+    }
+#endif
+
+    int res = writer->failed ? 1 : 0;
+    if (fclose(writer->fp) != 0)
+        res = 1;
+    FREE(writer);
+    return res;
+}
+
 uint8_t* dvz_read_ppm(const char* filename, int* width, int* height)
 {
     FILE* fp;
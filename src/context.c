@@ -89,7 +89,10 @@ static void _context_default_buffers(DvzContext* context)
         ASSERT(buffer != NULL);
         dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_STORAGE);
         dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_STORAGE_SIZE);
-        dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        // The storage buffer also holds indirect draw commands.
+        dvz_buffer_usage(
+            buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
         dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         dvz_buffer_create(buffer);
         ASSERT(dvz_obj_is_created(&buffer->obj));
@@ -151,7 +154,9 @@ static void _destroy_resources(DvzContext* context)
 static void _gpu_default_features(DvzGpu* gpu)
 {
     ASSERT(gpu != NULL);
-    dvz_gpu_request_features(gpu, (VkPhysicalDeviceFeatures){.independentBlend = true});
+    dvz_gpu_request_features(
+        gpu, (VkPhysicalDeviceFeatures){
+                 .independentBlend = true, .drawIndirectFirstInstance = true});
 }
 
 
@@ -165,6 +170,14 @@ DvzContext* dvz_context(DvzGpu* gpu, DvzWindow* window)
     DvzContext* context = calloc(1, sizeof(DvzContext));
     context->gpu = gpu;
 
+    // NOTE: the lock is recursive as some locking functions call each other.
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (pthread_mutex_init(&context->lock, &attr) != 0)
+        log_error("mutex creation failed");
+    pthread_mutexattr_destroy(&attr);
+
     // Allocate memory for buffers, textures, and computes.
     context->buffers =
         dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzBuffer), DVZ_OBJECT_TYPE_BUFFER);
@@ -196,6 +209,7 @@ DvzContext* dvz_context(DvzGpu* gpu, DvzWindow* window)
     _context_default_buffers(context);
 
     context->transfer_cmd = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_TRANSFER, 1);
+    context->compute_cmd = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_COMPUTE, 1);
 
     gpu->context = context;
     dvz_obj_created(&context->obj);
@@ -267,6 +281,24 @@ void dvz_context_destroy(DvzContext* context)
     dvz_container_destroy(&context->samplers);
     dvz_container_destroy(&context->textures);
     dvz_container_destroy(&context->computes);
+
+    pthread_mutex_destroy(&context->lock);
+}
+
+
+
+void dvz_context_lock(DvzContext* context)
+{
+    ASSERT(context != NULL);
+    pthread_mutex_lock(&context->lock);
+}
+
+
+
+void dvz_context_unlock(DvzContext* context)
+{
+    ASSERT(context != NULL);
+    pthread_mutex_unlock(&context->lock);
 }
 
 
@@ -283,6 +315,7 @@ DvzBufferRegions dvz_ctx_buffers(
     ASSERT(buffer_count > 0);
     ASSERT(size > 0);
     ASSERT(buffer_type < DVZ_BUFFER_TYPE_COUNT);
+    dvz_context_lock(context);
 
     // Choose the first buffer with the requested type.
     DvzContainerIterator iter = dvz_container_iterator(&context->buffers);
@@ -297,6 +330,7 @@ DvzBufferRegions dvz_ctx_buffers(
     if (buffer == NULL)
     {
         log_error("could not find buffer with requested type %d", buffer_type);
+        dvz_context_unlock(context);
         return (DvzBufferRegions){0};
     }
     ASSERT(buffer != NULL);
@@ -307,13 +341,22 @@ DvzBufferRegions dvz_ctx_buffers(
     VkDeviceSize offset = buffer->allocated_size;
     bool needs_align =
         buffer_type == DVZ_BUFFER_TYPE_UNIFORM || buffer_type == DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE;
+    // NOTE: vertex buffers may also be bound as storage buffers by compute shaders.
+    bool needs_storage_align =
+        buffer_type == DVZ_BUFFER_TYPE_STORAGE || buffer_type == DVZ_BUFFER_TYPE_VERTEX;
     if (needs_align)
     {
         alignment = context->gpu->device_properties.limits.minUniformBufferOffsetAlignment;
         ASSERT(offset % alignment == 0); // offset should be already aligned
     }
+    else if (needs_storage_align)
+    {
+        alignment = context->gpu->device_properties.limits.minStorageBufferOffsetAlignment;
+    }
 
     DvzBufferRegions regions = dvz_buffer_regions(buffer, buffer_count, offset, size, alignment);
+    // The offset of the first region may have been aligned.
+    offset = regions.offsets[0];
     VkDeviceSize alsize = regions.aligned_size;
     if (alsize == 0)
         alsize = size;
@@ -322,6 +365,7 @@ DvzBufferRegions dvz_ctx_buffers(
     if (!dvz_obj_is_created(&buffer->obj))
     {
         log_error("invalid buffer %d", buffer_type);
+        dvz_context_unlock(context);
         return regions;
     }
 
@@ -346,9 +390,10 @@ DvzBufferRegions dvz_ctx_buffers(
         "allocating %d buffers (type %d) with size %s (aligned size %s)", //
         buffer_count, buffer_type, pretty_size(size), pretty_size(alsize));
     ASSERT(offset + alsize * buffer_count <= regions.buffer->size);
-    buffer->allocated_size += alsize * buffer_count;
+    buffer->allocated_size = offset + alsize * buffer_count;
 
     ASSERT(regions.offsets[buffer_count - 1] + alsize == buffer->allocated_size);
+    dvz_context_unlock(context);
     return regions;
 }
 
@@ -367,6 +412,7 @@ void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceS
         return;
     }
     ASSERT(br->count == 1);
+    dvz_context_lock(context);
 
     // The region is the last allocated in the buffer, we can safely resize it.
     VkDeviceSize old_size = br->aligned_size > 0 ? br->aligned_size : br->size;
@@ -394,6 +440,7 @@ void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceS
         log_debug("failed to resize the buffer region in-place, allocating a new region");
         *br = dvz_ctx_buffers(context, br->buffer->type, 1, new_size);
     }
+    dvz_context_unlock(context);
 }
 
 
@@ -405,10 +452,11 @@ void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceS
 DvzCompute* dvz_ctx_compute(DvzContext* context, const char* shader_path)
 {
     ASSERT(context != NULL);
-    ASSERT(shader_path != NULL);
 
+    dvz_context_lock(context);
     DvzCompute* compute = dvz_container_alloc(&context->computes);
     *compute = dvz_compute(context->gpu, shader_path);
+    dvz_context_unlock(context);
     return compute;
 }
 
@@ -448,6 +496,7 @@ DvzTexture* dvz_ctx_texture(DvzContext* context, uint32_t dims, uvec3 size, VkFo
         "creating %dD texture with shape %dx%dx%d and format %d", //
         dims, size[0], size[1], size[2], format);
 
+    dvz_context_lock(context);
     DvzTexture* texture = dvz_container_alloc(&context->textures);
     DvzImages* image = dvz_container_alloc(&context->images);
     DvzSampler* sampler = dvz_container_alloc(&context->samplers);
@@ -503,6 +552,7 @@ DvzTexture* dvz_ctx_texture(DvzContext* context, uint32_t dims, uvec3 size, VkFo
         dvz_cmd_end(cmds, 0);
         dvz_cmd_submit_sync(cmds, 0);
     }
+    dvz_context_unlock(context);
 
     return texture;
 }
@@ -566,13 +616,16 @@ void dvz_texture_upload(
     ASSERT(data != NULL);
 
     // Take the staging buffer.
+    dvz_context_lock(context);
     DvzBuffer* staging = staging_buffer(context, size);
 
     // Memcpy into the staging buffer.
     dvz_buffer_upload(staging, 0, size, data);
 
     // Copy from the staging buffer to the texture.
-    _copy_texture_from_staging(context, texture, offset, shape, size);
+    _copy_texture_from_staging(
+        context->gpu, &context->transfer_cmd, staging, texture, offset, shape, size);
+    dvz_context_unlock(context);
 }
 
 
@@ -587,13 +640,16 @@ void dvz_texture_download(
     ASSERT(data != NULL);
 
     // Take the staging buffer.
+    dvz_context_lock(context);
     DvzBuffer* staging = staging_buffer(context, size);
 
     // Copy from the staging buffer to the texture.
-    _copy_texture_to_staging(context, texture, offset, shape, size);
+    _copy_texture_to_staging(
+        context->gpu, &context->transfer_cmd, staging, texture, offset, shape, size);
 
     // Memcpy into the staging buffer.
     dvz_buffer_download(staging, 0, size, data);
+    dvz_context_unlock(context);
 }
 
 
@@ -604,91 +660,11 @@ void dvz_texture_copy(
     ASSERT(src != NULL);
     ASSERT(dst != NULL);
     DvzContext* context = src->context;
-    DvzGpu* gpu = context->gpu;
     ASSERT(context != NULL);
 
-    // Take transfer cmd buf.
-    DvzCommands* cmds = &context->transfer_cmd;
-    dvz_cmd_reset(cmds, 0);
-    dvz_cmd_begin(cmds, 0);
-
-    DvzBarrier src_barrier = dvz_barrier(gpu);
-    dvz_barrier_stages(
-        &src_barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-    dvz_barrier_images(&src_barrier, src->image);
-
-    DvzBarrier dst_barrier = dvz_barrier(gpu);
-    dvz_barrier_stages(
-        &dst_barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-    dvz_barrier_images(&dst_barrier, dst->image);
-
-    // Source image transition.
-    if (src->image->layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
-    {
-        dvz_barrier_images_layout(
-            &src_barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-        dvz_cmd_barrier(cmds, 0, &src_barrier);
-    }
-
-    // Destination image transition.
-    {
-        log_trace("destination image transition");
-        dvz_barrier_images_layout(
-            &dst_barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        dvz_cmd_barrier(cmds, 0, &dst_barrier);
-    }
-
-    // Copy texture command.
-    VkImageCopy copy = {0};
-    copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    copy.srcSubresource.layerCount = 1;
-    copy.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    copy.dstSubresource.layerCount = 1;
-    copy.extent.width = shape[0];
-    copy.extent.height = shape[1];
-    copy.extent.depth = shape[2];
-    copy.srcOffset.x = (int32_t)src_offset[0];
-    copy.srcOffset.y = (int32_t)src_offset[1];
-    copy.srcOffset.z = (int32_t)src_offset[2];
-    copy.dstOffset.x = (int32_t)dst_offset[0];
-    copy.dstOffset.y = (int32_t)dst_offset[1];
-    copy.dstOffset.z = (int32_t)dst_offset[2];
-    vkCmdCopyImage(
-        cmds->cmds[0],                                               //
-        src->image->images[0], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, //
-        dst->image->images[0], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, //
-        1, &copy);
-
-    // Source image transition.
-    if (src->image->layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
-    {
-        dvz_barrier_images_layout(
-            &src_barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, src->image->layout);
-        dvz_cmd_barrier(cmds, 0, &src_barrier);
-    }
-
-    // Destination image transition.
-    if (dst->image->layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-    {
-        log_trace("destination image transition back");
-        dvz_barrier_images_layout(
-            &dst_barrier, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dst->image->layout);
-        dvz_cmd_barrier(cmds, 0, &dst_barrier);
-    }
-
-    dvz_cmd_end(cmds, 0);
-
-    // Wait for the render queue to be idle.
-    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
-
-    // Submit the commands to the transfer queue.
-    DvzSubmit submit = dvz_submit(gpu);
-    dvz_submit_commands(&submit, cmds);
-    log_debug("copy %dx%dx%d between 2 textures", shape[0], shape[1], shape[2]);
-    dvz_submit_send(&submit, 0, NULL, 0);
-
-    // Wait for the transfer queue to be idle.
-    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+    dvz_context_lock(context);
+    _copy_texture(context->gpu, &context->transfer_cmd, src, src_offset, dst, dst_offset, shape);
+    dvz_context_unlock(context);
 }
 
 
@@ -187,3 +187,257 @@ void dvz_fifo_destroy(DvzFifo* fifo)
     ASSERT(fifo->items != NULL);
     FREE(fifo->items);
 }
+
+
+
+/*************************************************************************************************/
+/*  Task pool utils                                                                              */
+/*************************************************************************************************/
+
+typedef struct DvzTaskChunk DvzTaskChunk;
+
+struct DvzTaskChunk
+{
+    DvzTaskRangeCallback callback;
+    void* user_data;
+    uint32_t first, count;
+};
+
+
+
+static uint32_t _cpu_count(void)
+{
+#if OS_WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint32_t)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (uint32_t)n : 1;
+#endif
+}
+
+
+
+// NOTE: the pool lock must be held.
+static bool _task_pop(DvzTaskPool* pool, DvzTask* task)
+{
+    ASSERT(pool != NULL);
+    ASSERT(task != NULL);
+    if (pool->task_count == 0)
+        return false;
+    *task = pool->tasks[pool->task_first];
+    pool->task_first = (pool->task_first + 1) % pool->task_capacity;
+    pool->task_count--;
+    return true;
+}
+
+
+
+// NOTE: the pool lock must be held, it is released while the task runs.
+static void _task_run(DvzTaskPool* pool, DvzTask task)
+{
+    ASSERT(pool != NULL);
+    ASSERT(task.callback != NULL);
+
+    pthread_mutex_unlock(&pool->lock);
+    task.callback(task.user_data);
+    pthread_mutex_lock(&pool->lock);
+
+    if (task.group != NULL)
+    {
+        ASSERT(task.group->pending > 0);
+        task.group->pending--;
+    }
+    pthread_cond_broadcast(&pool->cond_done);
+}
+
+
+
+static void* _task_worker(void* user_data)
+{
+    DvzTaskPool* pool = (DvzTaskPool*)user_data;
+    ASSERT(pool != NULL);
+    DvzTask task = {0};
+
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        if (_task_pop(pool, &task))
+            _task_run(pool, task);
+        else if (pool->is_stopping)
+            break;
+        else
+            pthread_cond_wait(&pool->cond_task, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+
+
+static void _task_chunk(void* user_data)
+{
+    DvzTaskChunk* chunk = (DvzTaskChunk*)user_data;
+    ASSERT(chunk != NULL);
+    chunk->callback(chunk->user_data, chunk->first, chunk->count);
+}
+
+
+
+/*************************************************************************************************/
+/*  Task pool                                                                                    */
+/*************************************************************************************************/
+
+DvzTaskPool* dvz_task_pool(uint32_t worker_count)
+{
+    DvzTaskPool* pool = calloc(1, sizeof(DvzTaskPool));
+    dvz_obj_init(&pool->obj);
+
+    if (worker_count == 0)
+    {
+        const char* env = getenv("DVZ_NUM_THREADS");
+        uint32_t thread_count = env != NULL ? (uint32_t)atoi(env) : _cpu_count();
+        worker_count = thread_count > 0 ? thread_count - 1 : 0;
+    }
+    log_trace("creating task pool with %d worker(s)", worker_count);
+
+    pool->task_capacity = DVZ_MAX_FIFO_CAPACITY;
+    pool->tasks = calloc(pool->task_capacity, sizeof(DvzTask));
+
+    if (pthread_mutex_init(&pool->lock, NULL) != 0)
+        log_error("mutex creation failed");
+    if (pthread_cond_init(&pool->cond_task, NULL) != 0)
+        log_error("cond creation failed");
+    if (pthread_cond_init(&pool->cond_done, NULL) != 0)
+        log_error("cond creation failed");
+
+    pool->worker_count = worker_count;
+    if (worker_count > 0)
+        pool->workers = calloc(worker_count, sizeof(DvzThread));
+    for (uint32_t i = 0; i < worker_count; i++)
+        pool->workers[i] = dvz_thread(_task_worker, pool);
+
+    dvz_obj_created(&pool->obj);
+    return pool;
+}
+
+
+
+void dvz_task_enqueue(
+    DvzTaskPool* pool, DvzTaskGroup* group, DvzTaskCallback callback, void* user_data)
+{
+    ASSERT(pool != NULL);
+    ASSERT(callback != NULL);
+    pthread_mutex_lock(&pool->lock);
+
+    // Enlarge the ring buffer if it is full, moving the wrapped-around tasks after the others.
+    if (pool->task_count == pool->task_capacity)
+    {
+        uint32_t old_cap = pool->task_capacity;
+        pool->task_capacity *= 2;
+        log_debug("task queue is full, enlarging it to %d", pool->task_capacity);
+        REALLOC(pool->tasks, pool->task_capacity * sizeof(DvzTask));
+        memcpy(&pool->tasks[old_cap], &pool->tasks[0], pool->task_first * sizeof(DvzTask));
+    }
+
+    uint32_t idx = (pool->task_first + pool->task_count) % pool->task_capacity;
+    pool->tasks[idx] = (DvzTask){callback, user_data, group};
+    pool->task_count++;
+    if (group != NULL)
+        group->pending++;
+
+    pthread_cond_signal(&pool->cond_task);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+
+void dvz_task_wait(DvzTaskPool* pool, DvzTaskGroup* group)
+{
+    ASSERT(pool != NULL);
+    ASSERT(group != NULL);
+    DvzTask task = {0};
+
+    pthread_mutex_lock(&pool->lock);
+    while (group->pending > 0)
+    {
+        // Help with the pending tasks rather than sleeping.
+        if (_task_pop(pool, &task))
+            _task_run(pool, task);
+        else
+            pthread_cond_wait(&pool->cond_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+
+void dvz_task_range(
+    DvzTaskPool* pool, uint32_t item_count, uint32_t min_chunk, DvzTaskRangeCallback callback,
+    void* user_data)
+{
+    ASSERT(callback != NULL);
+    if (item_count == 0)
+        return;
+    min_chunk = MAX(min_chunk, 1);
+
+    uint32_t chunk_count = dvz_task_pool_threads(pool) * DVZ_TASK_CHUNKS_PER_THREAD;
+    chunk_count = MIN(chunk_count, (item_count + min_chunk - 1) / min_chunk);
+    if (pool == NULL || pool->worker_count == 0 || chunk_count <= 1)
+    {
+        callback(user_data, 0, item_count);
+        return;
+    }
+
+    // Spread the items evenly between the chunks.
+    DvzTaskChunk* chunks = calloc(chunk_count, sizeof(DvzTaskChunk));
+    DvzTaskGroup group = {0};
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < chunk_count; i++)
+    {
+        chunks[i].callback = callback;
+        chunks[i].user_data = user_data;
+        chunks[i].first = first;
+        chunks[i].count = item_count / chunk_count + (i < item_count % chunk_count ? 1 : 0);
+        first += chunks[i].count;
+        dvz_task_enqueue(pool, &group, _task_chunk, &chunks[i]);
+    }
+    ASSERT(first == item_count);
+
+    dvz_task_wait(pool, &group);
+    FREE(chunks);
+}
+
+
+
+uint32_t dvz_task_pool_threads(DvzTaskPool* pool)
+{
+    return pool != NULL ? pool->worker_count + 1 : 1;
+}
+
+
+
+void dvz_task_pool_destroy(DvzTaskPool* pool)
+{
+    ASSERT(pool != NULL);
+    log_trace("destroying task pool");
+
+    // Let the workers finish the pending tasks before stopping.
+    pthread_mutex_lock(&pool->lock);
+    pool->is_stopping = true;
+    pthread_cond_broadcast(&pool->cond_task);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (uint32_t i = 0; i < pool->worker_count; i++)
+        dvz_thread_join(&pool->workers[i]);
+    FREE(pool->workers);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond_task);
+    pthread_cond_destroy(&pool->cond_done);
+    FREE(pool->tasks);
+
+    dvz_obj_destroyed(&pool->obj);
+    FREE(pool);
+}
@@ -23,7 +23,7 @@ layout (location = 5) out float out_alpha;
 void main() {
     gl_Position = transform(pos);
 
-    out_pos = ((mvp.model * vec4(pos, 1.0))).xyz;
+    out_pos = ((mvp.model * vec4(normalize_pos(pos), 1.0))).xyz;
     out_normal = ((transpose(inverse(mvp.model)) * vec4(normal, 1.0))).xyz;
 
     out_uv = uv;
@@ -22,13 +22,15 @@ void main (void)
     out_color = color;
     out_linewidth = linewidth;
 
+    // Quad corner, in triangle strip order. With the instanced pipeline, gl_VertexIndex is the
+    // corner index within the instance.
     int index = gl_VertexIndex % 4;
 
     vec4 P0_ = transform(P0, shift.xy, transform_mode);
     vec4 P1_ = transform(P1, shift.zw, transform_mode);
 
     // Viewport coordinates.
-    mat4 ortho = get_ortho_matrix(viewport.size);
+    mat4 ortho = get_ortho_matrix(frame_size());
     mat4 ortho_inv = inverse(ortho);
 
     vec4 p0 = ortho_inv * P0_;
@@ -59,14 +61,14 @@ void main (void)
        out_cap = cap0;
     }
     else if (index < 2.5) {
-       position = vec2(p1.x + T.y + T.x, p1.y - T.x + T.y);
-       out_texcoord = vec2(out_length + w, -w);
+       position = vec2(p1.x - T.y + T.x, p1.y + T.x + T.y);
+       out_texcoord = vec2(out_length + w, +w);
        z = p1.z;
        out_cap = cap1;
     }
     else {
-       position = vec2(p1.x - T.y + T.x, p1.y + T.x + T.y);
-       out_texcoord = vec2(out_length + w, +w);
+       position = vec2(p1.x + T.y + T.x, p1.y - T.x + T.y);
+       out_texcoord = vec2(out_length + w, -w);
        z = p1.z;
        out_cap = cap1;
     }
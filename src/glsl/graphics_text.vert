@@ -24,7 +24,7 @@ layout (location = 3) out float out_str_index;
 void main() {
     vec4 pos_tr = transform(pos, shift, transform_mode);
 
-    mat4 ortho = get_ortho_matrix(viewport.size);
+    mat4 ortho = get_ortho_matrix(frame_size());
     mat4 ortho_inv = inverse(ortho);
 
     // Compute the rotation matrix for the glyphs.
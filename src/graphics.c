@@ -1,4 +1,3 @@
-#define STB_IMAGE_IMPLEMENTATION
 #include "../include/datoviz/graphics.h"
 #include "../include/datoviz/atlas.h"
 #include "../include/datoviz/canvas.h"
@@ -170,15 +169,36 @@ _graphics_segment_callback(DvzGraphicsData* data, uint32_t item_count, const voi
     // Fill the vertices array by simply repeating them 4 times.
     dvz_array_data(data->vertices, 4 * data->current_idx, 4, 1, item);
 
-    // Fill the indices array.
+    // Fill the indices array. The quad corners are in triangle strip order.
     DvzIndex* indices = (DvzIndex*)data->indices->data;
     uint32_t i = data->current_idx;
     indices[6 * i + 0] = 4 * i + 0;
     indices[6 * i + 1] = 4 * i + 1;
-    indices[6 * i + 2] = 4 * i + 2;
+    indices[6 * i + 2] = 4 * i + 3;
     indices[6 * i + 3] = 4 * i + 0;
-    indices[6 * i + 4] = 4 * i + 2;
-    indices[6 * i + 5] = 4 * i + 3;
+    indices[6 * i + 4] = 4 * i + 3;
+    indices[6 * i + 5] = 4 * i + 2;
+
+    data->current_idx++;
+}
+
+// Instanced version: one vertex per segment, the vertex shader generates the 4 corners.
+static void
+_graphics_segment_instanced_callback(DvzGraphicsData* data, uint32_t item_count, const void* item)
+{
+    ASSERT(data != NULL);
+    ASSERT(data->vertices != NULL);
+
+    ASSERT(item_count > 0);
+    dvz_array_resize(data->vertices, item_count);
+    // no indices
+
+    if (item == NULL)
+        return;
+    ASSERT(item != NULL);
+    ASSERT(data->current_idx < item_count);
+
+    dvz_array_data(data->vertices, data->current_idx, 1, 1, item);
 
     data->current_idx++;
 }
@@ -201,7 +221,15 @@ static void _graphics_segment(DvzCanvas* canvas, DvzGraphics* graphics)
     ATTR(DvzGraphicsSegmentVertex, VK_FORMAT_R8_UINT, transform)
 
     _common_slots(graphics);
-    dvz_graphics_callback(graphics, _graphics_segment_callback);
+
+    if ((graphics->flags & DVZ_GRAPHICS_FLAGS_INSTANCED) != 0)
+    {
+        dvz_graphics_topology(graphics, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+        dvz_graphics_vertex_input_rate(graphics, 0, VK_VERTEX_INPUT_RATE_INSTANCE, 4);
+        dvz_graphics_callback(graphics, _graphics_segment_instanced_callback);
+    }
+    else
+        dvz_graphics_callback(graphics, _graphics_segment_callback);
 
     CREATE
 }
@@ -262,15 +290,18 @@ static void _graphics_path(DvzCanvas* canvas, DvzGraphics* graphics)
 /*  Text graphics                                                                             */
 /*************************************************************************************************/
 
-static void _graphics_text_callback(DvzGraphicsData* data, uint32_t item_count, const void* item)
+// Write the glyphs of a string, with `repeat` copies of the vertex of each glyph.
+static void _graphics_text_glyphs(
+    DvzGraphicsData* data, uint32_t item_count, const void* item, uint32_t repeat)
 {
     // NOTE: item_count is the total number of glyphs
 
     ASSERT(data != NULL);
     ASSERT(data->vertices != NULL);
+    ASSERT(repeat > 0);
 
     ASSERT(item_count > 0);
-    dvz_array_resize(data->vertices, 4 * item_count);
+    dvz_array_resize(data->vertices, repeat * item_count);
     DvzFontAtlas* atlas = &data->graphics->gpu->context->font_atlas;
     ASSERT(atlas != NULL);
 
@@ -279,19 +310,22 @@ static void _graphics_text_callback(DvzGraphicsData* data, uint32_t item_count,
     ASSERT(item != NULL);
     ASSERT(data->current_idx < item_count);
 
-    // const char* str = item;
+    // NOTE: one glyph per code point of the UTF-8 string.
     const DvzGraphicsTextItem* str_item = item;
-    uint32_t n = strlen(str_item->string);
+    const char* str = str_item->string;
+    uint32_t n = dvz_utf8_length(str);
     DvzGraphicsTextVertex vertex = {0};
     vertex = str_item->vertex;
     ASSERT(n > 0);
     ASSERT(data->current_idx + n <= item_count);
+    uint32_t codepoint = 0;
     for (uint32_t i = 0; i < n; i++)
     {
-        size_t g = _font_atlas_glyph(atlas, str_item->string, i);
+        str += dvz_utf8_decode(str, &codepoint);
+        uint32_t g = dvz_font_atlas_glyph(atlas, codepoint);
 
         // Glyph size.
-        _font_atlas_glyph_size(atlas, str_item->font_size, vertex.glyph_size);
+        dvz_font_atlas_glyph_size(atlas, str_item->font_size, vertex.glyph_size);
 
         // Glyph.
         vertex.glyph[0] = g;                   // char
@@ -303,13 +337,25 @@ static void _graphics_text_callback(DvzGraphicsData* data, uint32_t item_count,
         if (str_item->glyph_colors != NULL)
             memcpy(vertex.color, str_item->glyph_colors[i], sizeof(cvec4));
 
-        // Fill the vertices array by simply repeating them 4 times.
-        dvz_array_data(data->vertices, 4 * data->current_idx, 4, 1, &vertex);
+        // Fill the vertices array by simply repeating them.
+        dvz_array_data(data->vertices, repeat * data->current_idx, repeat, 1, &vertex);
         data->current_idx++; // glyph index
     }
     data->current_group++; // glyph index
 }
 
+static void _graphics_text_callback(DvzGraphicsData* data, uint32_t item_count, const void* item)
+{
+    _graphics_text_glyphs(data, item_count, item, 4);
+}
+
+// Instanced version: one vertex per glyph, the vertex shader generates the 4 corners.
+static void
+_graphics_text_instanced_callback(DvzGraphicsData* data, uint32_t item_count, const void* item)
+{
+    _graphics_text_glyphs(data, item_count, item, 1);
+}
+
 static void _graphics_text(DvzCanvas* canvas, DvzGraphics* graphics)
 {
     SHADER(VERTEX, "graphics_text_vert")
@@ -330,7 +376,13 @@ static void _graphics_text(DvzCanvas* canvas, DvzGraphics* graphics)
     dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
-    dvz_graphics_callback(graphics, _graphics_text_callback);
+    if ((graphics->flags & DVZ_GRAPHICS_FLAGS_INSTANCED) != 0)
+    {
+        dvz_graphics_vertex_input_rate(graphics, 0, VK_VERTEX_INPUT_RATE_INSTANCE, 4);
+        dvz_graphics_callback(graphics, _graphics_text_instanced_callback);
+    }
+    else
+        dvz_graphics_callback(graphics, _graphics_text_callback);
 
     CREATE
 }
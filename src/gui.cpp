@@ -256,6 +256,27 @@ void dvz_gui_callback_fps(DvzCanvas* canvas, DvzEvent ev)
     dvz_gui_begin("FPS", DVZ_GUI_FLAGS_FIXED | DVZ_GUI_FLAGS_CORNER_UR);
     ImGui::Text("  FPS: %.0f", canvas->fps);
     ImGui::Text("eFPS: %.0f", canvas->efps);
+
+    // Frame time percentiles, in milliseconds.
+    DvzFrameStats* stats = canvas->timing.stats;
+    DvzFrameStats* total = &stats[DVZ_FRAME_PHASE_TOTAL];
+    ImGui::Text(
+        "frame: %.1f / %.1f / %.1f ms", 1000 * total->p50, 1000 * total->p95, 1000 * total->p99);
+
+    if (ImGui::CollapsingHeader("Timing"))
+    {
+        // Per-phase p50 and p95.
+        for (uint32_t phase = 0; phase < DVZ_FRAME_PHASE_TOTAL; phase++)
+            ImGui::Text(
+                "%-10s %6.2f %6.2f ms", dvz_canvas_timing_name((DvzFramePhase)phase),
+                1000 * stats[phase].p50, 1000 * stats[phase].p95);
+
+        // Log2 histogram of the frame times.
+        float hist[DVZ_TIMING_HIST_BINS] = {0};
+        for (uint32_t i = 0; i < DVZ_TIMING_HIST_BINS; i++)
+            hist[i] = (float)canvas->timing.hist[DVZ_FRAME_PHASE_TOTAL][i];
+        ImGui::PlotHistogram("##frame_hist", hist, DVZ_TIMING_HIST_BINS, 0, "log2(us)");
+    }
     dvz_gui_end();
 }
 
@@ -0,0 +1,306 @@
+/*
+Screen-space level of detail of line strips and paths.
+
+The pyramid stores, for increasing bucket sizes, the indices of the first, minimum, maximum, and
+last samples of every bucket of consecutive samples (M4 decimation). When a bucket is not larger
+than the number of samples per pixel column, the decimated line strip is rendered with the same
+pixels as the original one. Each level is built from the previous one, which is exact as the
+extrema of a bucket are the extrema of the extrema of its two halves.
+
+See "M4: A Visualization-Oriented Time Series Data Aggregation", Jugel et al., VLDB 2014.
+*/
+
+#ifndef DVZ_LOD_UTILS_HEADER
+#define DVZ_LOD_UTILS_HEADER
+
+#include "../include/datoviz/array.h"
+#include "../include/datoviz/visuals.h"
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_LOD_MIN_BUCKET    8    // bucket size of the first decimated level
+#define DVZ_LOD_DEFAULT_WIDTH 1024 // viewport width used before the first panzoom update
+
+
+
+/*************************************************************************************************/
+/*  Pyramid                                                                                      */
+/*************************************************************************************************/
+
+// Whether the pyramid can be built from a position array.
+static bool _lod_supported(DvzArray* arr_pos)
+{
+    ASSERT(arr_pos != NULL);
+    return arr_pos->dtype == DVZ_DTYPE_DVEC3 || arr_pos->dtype == DVZ_DTYPE_VEC3;
+}
+
+
+
+// Coordinate of a sample in a DVEC3 or VEC3 position array.
+static inline double _lod_coord(DvzArray* arr_pos, uint32_t idx, uint32_t coord)
+{
+    ASSERT(arr_pos != NULL);
+    ASSERT(coord < 3);
+    if (arr_pos->dtype == DVZ_DTYPE_VEC3)
+        return ((const vec3*)arr_pos->data)[idx][coord];
+    return ((const dvec3*)arr_pos->data)[idx][coord];
+}
+
+
+static void _lod_destroy(DvzLod* lod)
+{
+    ASSERT(lod != NULL);
+    for (uint32_t k = 0; k < lod->level_count; k++)
+        dvz_array_destroy(&lod->levels[k]);
+    memset(lod->levels, 0, sizeof(lod->levels));
+    memset(lod->bucket_size, 0, sizeof(lod->bucket_size));
+    lod->level_count = 0;
+    lod->item_count = 0;
+}
+
+
+
+// Write the M4 samples of a bucket in increasing order, without duplicates.
+static uint32_t _lod_m4(uint32_t first, uint32_t imin, uint32_t imax, uint32_t last, uint32_t* out)
+{
+    ASSERT(out != NULL);
+    uint32_t samples[4] = {first, MIN(imin, imax), MAX(imin, imax), last};
+    uint32_t k = 0;
+    for (uint32_t j = 0; j < 4; j++)
+    {
+        if (k == 0 || samples[j] != out[k - 1])
+            out[k++] = samples[j];
+    }
+    return k;
+}
+
+
+
+// Decimate n samples with the given bucket size. The input samples are the indices in `in`, or
+// all samples if `in` is NULL. Return the number of indices written to `out`.
+static uint32_t _lod_decimate(
+    DvzArray* arr_pos, uint32_t n, const uint32_t* in, uint32_t bucket_size, uint32_t* out)
+{
+    ASSERT(arr_pos != NULL);
+    ASSERT(bucket_size > 0);
+    ASSERT(out != NULL);
+
+    uint32_t k = 0, i = 0, idx = 0, bucket = 0;
+    uint32_t first = 0, last = 0, imin = 0, imax = 0;
+    double y = 0, ymin = 0, ymax = 0;
+    while (i < n)
+    {
+        idx = in != NULL ? in[i] : i;
+        bucket = idx / bucket_size;
+        first = last = imin = imax = idx;
+        ymin = ymax = _lod_coord(arr_pos, idx, 1);
+        for (i++; i < n; i++)
+        {
+            idx = in != NULL ? in[i] : i;
+            if (idx / bucket_size != bucket)
+                break;
+            last = idx;
+            y = _lod_coord(arr_pos, idx, 1);
+            if (y < ymin)
+            {
+                ymin = y;
+                imin = idx;
+            }
+            if (y > ymax)
+            {
+                ymax = y;
+                imax = idx;
+            }
+        }
+        k += _lod_m4(first, imin, imax, last, &out[k]);
+    }
+    return k;
+}
+
+
+
+// Build the pyramid of a DVEC3 or VEC3 position array.
+static void _lod_build(DvzLod* lod, DvzArray* arr_pos)
+{
+    ASSERT(lod != NULL);
+    ASSERT(arr_pos != NULL);
+    _lod_destroy(lod);
+
+    uint32_t n = arr_pos->item_count;
+    if (n == 0 || !_lod_supported(arr_pos))
+        return;
+    ASSERT(arr_pos->data != NULL);
+    lod->item_count = n;
+
+    // The visible samples can only be found by bisection if the x coordinates are increasing.
+    lod->sorted = true;
+    for (uint32_t i = 1; i < n && lod->sorted; i++)
+        lod->sorted = _lod_coord(arr_pos, i, 0) >= _lod_coord(arr_pos, i - 1, 0);
+
+    // Level 0: original samples.
+    lod->bucket_size[0] = 1;
+    lod->level_count = 1;
+
+    uint32_t prev_count = n;
+    const uint32_t* prev = NULL;
+    uint32_t bucket_size = DVZ_LOD_MIN_BUCKET;
+    uint32_t count = 0;
+    for (uint32_t k = 1; k < DVZ_LOD_MAX_LEVELS && bucket_size < n; k++)
+    {
+        count = MIN(prev_count, 4 * ((n + bucket_size - 1) / bucket_size));
+        lod->levels[k] = dvz_array(count, DVZ_DTYPE_UINT);
+        count = _lod_decimate(arr_pos, prev_count, prev, bucket_size, lod->levels[k].data);
+        lod->levels[k].item_count = count;
+        lod->bucket_size[k] = bucket_size;
+        lod->level_count = k + 1;
+
+        prev = lod->levels[k].data;
+        prev_count = count;
+        bucket_size *= 2;
+    }
+    log_debug("built LOD pyramid with %d levels for %d samples", lod->level_count, n);
+}
+
+
+
+/*************************************************************************************************/
+/*  Selection                                                                                    */
+/*************************************************************************************************/
+
+// Index of the first sample with x >= value, in a sorted DVEC3 or VEC3 position array.
+static uint32_t _lod_search(DvzArray* arr_pos, double value)
+{
+    ASSERT(arr_pos != NULL);
+    uint32_t lo = 0, hi = arr_pos->item_count, mid = 0;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (_lod_coord(arr_pos, mid, 0) < value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+
+// Index of the first item of a level that refers to a sample >= idx.
+static uint32_t _lod_level_search(DvzLod* lod, uint32_t level, uint32_t idx)
+{
+    ASSERT(lod != NULL);
+    if (level == 0)
+        return idx;
+    ASSERT(level < lod->level_count);
+    const uint32_t* items = (const uint32_t*)lod->levels[level].data;
+    uint32_t lo = 0, hi = lod->levels[level].item_count, mid = 0;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (items[mid] < idx)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+
+// Select the level and the window of samples to upload, from the visible x range and the
+// viewport width. Return whether the selection has changed.
+static bool _lod_select(DvzLod* lod, DvzArray* arr_pos)
+{
+    ASSERT(lod != NULL);
+    ASSERT(arr_pos != NULL);
+    uint32_t n = lod->item_count;
+    if (n == 0 || arr_pos->item_count != n)
+        return false;
+
+    // Visible samples, including the samples just outside the visible range.
+    uint32_t i0 = 0, i1 = n;
+    float width = lod->width > 0 ? lod->width : DVZ_LOD_DEFAULT_WIDTH;
+    if (lod->sorted && lod->width > 0)
+    {
+        // Single-precision positions are relative to the origin of the prop.
+        i0 = _lod_search(arr_pos, MIN(lod->range[0], lod->range[1]) - lod->origin);
+        i1 = _lod_search(arr_pos, MAX(lod->range[0], lod->range[1]) - lod->origin);
+        i0 = i0 > 0 ? i0 - 1 : 0;
+        i1 = MIN(i1 + 1, n);
+    }
+    uint32_t visible = MAX(1, i1 > i0 ? i1 - i0 : 0);
+
+    // Coarsest level with at most one bucket per pixel column.
+    double per_pixel = visible / (double)width;
+    uint32_t level = 0;
+    for (uint32_t k = 1; k < lod->level_count; k++)
+    {
+        if (lod->bucket_size[k] <= per_pixel)
+            level = k;
+    }
+
+    // Keep the selection as long as the visible samples are in the uploaded window.
+    if (lod->count > 0 && level == lod->level && i0 >= lod->first &&
+        i1 <= lod->first + lod->count)
+        return false;
+
+    // The window has a margin of one visible range on each side, so that panning does not
+    // require a new upload at every frame.
+    lod->level = level;
+    lod->first = i0 > visible ? i0 - visible : 0;
+    lod->count = MIN(n, i1 + visible) - lod->first;
+    log_debug("select LOD level %d, samples %d-%d", level, lod->first, lod->first + lod->count);
+    return true;
+}
+
+
+
+// Whether the selection contains all original samples.
+static bool _lod_is_full(DvzLod* lod)
+{
+    ASSERT(lod != NULL);
+    return lod->level == 0 && lod->first == 0 && lod->count == lod->item_count;
+}
+
+
+
+// Copy the selected items of a prop array to another array.
+static void _lod_gather(DvzLod* lod, DvzArray* src, DvzArray* dst)
+{
+    ASSERT(lod != NULL);
+    ASSERT(src != NULL);
+    ASSERT(dst != NULL);
+    ASSERT(src->item_count == lod->item_count);
+
+    uint32_t j0 = _lod_level_search(lod, lod->level, lod->first);
+    uint32_t j1 = _lod_level_search(lod, lod->level, lod->first + lod->count);
+    uint32_t count = j1 - j0;
+    ASSERT(count > 0);
+
+    if (dst->item_size == 0)
+        *dst = dvz_array(count, src->dtype);
+    ASSERT(dst->item_size == src->item_size);
+    dvz_array_resize(dst, count);
+
+    if (lod->level == 0)
+    {
+        dvz_array_copy_region(src, dst, j0, 0, count);
+        return;
+    }
+    const uint32_t* items = (const uint32_t*)lod->levels[lod->level].data;
+    VkDeviceSize item_size = src->item_size;
+    for (uint32_t j = 0; j < count; j++)
+    {
+        memcpy(
+            (char*)dst->data + j * item_size, (const char*)src->data + items[j0 + j] * item_size,
+            item_size);
+    }
+}
+
+
+
+#endif
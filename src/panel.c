@@ -1,4 +1,5 @@
 #include "../include/datoviz/panel.h"
+#include "vklite_utils.h"
 
 
 
@@ -50,14 +51,27 @@ static void _update_viewport(DvzPanel* panel)
     float win_width = panel->grid->canvas->swapchain.images->width;
     float win_height = panel->grid->canvas->swapchain.images->height;
 
-    viewport->offset_framebuffer[0] = viewport->viewport.x = panel->x * win_width;
-    viewport->offset_framebuffer[1] = viewport->viewport.y = panel->y * win_height;
+    // In a tiled export, the panels are laid out within the full image, and the Vulkan viewport
+    // is then restricted to the part of the panel within the current tile.
+    if (canvas->tiling != NULL)
+    {
+        win_width = canvas->tiling->size[0];
+        win_height = canvas->tiling->size[1];
+    }
+
+    viewport->offset_framebuffer[0] = viewport->viewport.x = floor(panel->x * win_width);
+    viewport->offset_framebuffer[1] = viewport->viewport.y = floor(panel->y * win_height);
     viewport->size_framebuffer[0] = viewport->viewport.width = panel->width * win_width;
     viewport->size_framebuffer[1] = viewport->viewport.height = panel->height * win_height;
     viewport->viewport.minDepth = 0;
     viewport->viewport.maxDepth = 1;
 
-    _check_viewport(viewport);
+    // NOTE: the panels outside of the tile are marked as empty and are not rendered.
+    panel->viewport_empty = false;
+    if (canvas->tiling != NULL)
+        panel->viewport_empty = dvz_viewport_tiled(canvas, viewport);
+    else
+        _check_viewport(viewport);
 
     // Mark the panel as changed.
     panel->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
@@ -162,6 +176,53 @@ static DvzPanel* _get_panel(DvzGrid* grid, uint32_t row, uint32_t col)
 
 
 
+// Allocate the MVP uniform of a new panel in the last MVP block of the grid, or in a new block
+// twice as large if it is full.
+static void _panel_mvp_alloc(DvzGrid* grid, DvzPanel* panel)
+{
+    ASSERT(grid != NULL);
+    ASSERT(panel != NULL);
+    DvzCanvas* canvas = grid->canvas;
+    ASSERT(canvas != NULL);
+    DvzContext* ctx = canvas->gpu->context;
+
+    DvzMVPBlock* block = NULL;
+    if (grid->mvp_block_count > 0)
+        block = &grid->mvp_blocks[grid->mvp_block_count - 1];
+    if (block == NULL || block->count >= block->capacity)
+    {
+        ASSERT(grid->mvp_block_count < DVZ_MAX_MVP_BLOCKS);
+        block = &grid->mvp_blocks[grid->mvp_block_count++];
+        block->capacity = MAX(DVZ_MVP_BLOCK_MIN, grid->n_rows * grid->n_cols)
+                          << (grid->mvp_block_count - 1);
+        block->stride = aligned_size(
+            sizeof(DvzMVP), canvas->gpu->device_properties.limits.minUniformBufferOffsetAlignment);
+        block->br = dvz_ctx_buffers(
+            ctx, DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE, canvas->swapchain.img_count,
+            block->capacity * block->stride);
+        block->data = calloc(block->capacity, block->stride);
+        log_debug("allocate a packed MVP buffer for %d panels", block->capacity);
+    }
+    panel->mvp_block = grid->mvp_block_count - 1;
+    panel->mvp_slot = block->count++;
+
+    // The panel MVP is a region of the block in each swapchain image.
+    VkDeviceSize offset = panel->mvp_slot * block->stride;
+    panel->br_mvp = block->br;
+    panel->br_mvp.size = sizeof(DvzMVP);
+    panel->br_mvp.aligned_size = block->stride;
+    for (uint32_t i = 0; i < panel->br_mvp.count; i++)
+        panel->br_mvp.offsets[i] += offset;
+
+    // Initialize with identity matrices. Will be later updated by the scene controllers at every
+    // frame.
+    void* mvp = (char*)block->data + offset;
+    memcpy(mvp, &MVP_ID, sizeof(DvzMVP));
+    dvz_upload_buffers(canvas, panel->br_mvp, 0, panel->br_mvp.size, mvp);
+}
+
+
+
 /*************************************************************************************************/
 /*  Functions                                                                                    */
 /*************************************************************************************************/
@@ -187,6 +248,9 @@ void dvz_grid_destroy(DvzGrid* grid)
 {
     ASSERT(grid != NULL);
     dvz_container_destroy(&grid->panels);
+    for (uint32_t i = 0; i < grid->mvp_block_count; i++)
+        FREE(grid->mvp_blocks[i].data);
+    grid->mvp_block_count = 0;
 }
 
 
@@ -194,9 +258,7 @@ void dvz_grid_destroy(DvzGrid* grid)
 DvzPanel* dvz_panel(DvzGrid* grid, uint32_t row, uint32_t col)
 {
     ASSERT(grid != NULL);
-    DvzCanvas* canvas = grid->canvas;
-    ASSERT(canvas != NULL);
-    DvzContext* ctx = canvas->gpu->context;
+    ASSERT(grid->canvas != NULL);
 
     ASSERT(row < grid->n_rows);
     ASSERT(col < grid->n_cols);
@@ -234,11 +296,7 @@ DvzPanel* dvz_panel(DvzGrid* grid, uint32_t row, uint32_t col)
     //     1);
 
     // MVP uniform buffer.
-    uint32_t n = canvas->swapchain.img_count;
-    panel->br_mvp = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE, n, sizeof(DvzMVP));
-    // Initialize with identity matrices. Will be later updated by the scene controllers at every
-    // frame.
-    dvz_upload_buffers(canvas, panel->br_mvp, 0, panel->br_mvp.size, &MVP_ID);
+    _panel_mvp_alloc(grid, panel);
 
     // Update the DvzViewport.
     dvz_panel_update(panel);
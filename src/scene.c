@@ -9,6 +9,7 @@
 #include "axes.h"
 #include "interact_utils.h"
 #include "scene_utils.h"
+#include "snapshot_utils.h"
 #include "visuals_utils.h"
 #include "vklite_utils.h"
 
@@ -239,6 +240,14 @@ static void _add_visual(DvzPanel* panel, DvzVisual* visual)
     for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
         visual->clip[pidx] = DVZ_VIEWPORT_INNER;
 
+    // Screen-space level of detail, the pyramid is built when the visual is baked.
+    if ((visual->flags & DVZ_VISUAL_FLAGS_LOD) != 0 && visual->lod == NULL)
+        visual->lod = (DvzLod*)calloc(1, sizeof(DvzLod));
+
+    // Spatial index of the positions, built in the background after each bake.
+    if ((visual->flags & DVZ_VISUAL_FLAGS_SPATIAL_INDEX) != 0)
+        _spatial_create(visual);
+
     // Update the panel data coords as a function of the visual's data.
     if (panel->scene->canvas->app->is_running)
         _enqueue_visual_changed(panel, visual);
@@ -400,6 +409,249 @@ void dvz_arcball_rotate(DvzPanel* panel, float angle, vec3 axis)
 
 
 
+/*************************************************************************************************/
+/*  Spatial queries                                                                              */
+/*************************************************************************************************/
+
+// Return the spatial index of a visual, after creating or rebuilding it if needed.
+static DvzSpatialIndex* _visual_spatial(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    _spatial_create(visual);
+    _spatial_update(visual, false);
+    ASSERT(visual->spatial != NULL);
+    return visual->spatial;
+}
+
+
+
+// Convert a position to the x and y data coordinates of a panel.
+static void _spatial_pos(DvzPanel* panel, DvzCDS source, dvec3 pos, dvec2 out)
+{
+    ASSERT(panel != NULL || source == DVZ_CDS_DATA);
+    dvec3 data = {pos[0], pos[1], pos[2]};
+    if (source != DVZ_CDS_DATA)
+        dvz_transform(panel, source, pos, DVZ_CDS_DATA, data);
+    out[0] = data[0];
+    out[1] = data[1];
+}
+
+
+
+// Scale factors converting x and y offsets in data coordinates to distances in another coordinate
+// system, around a position. This is exact when the transformation is linear along x and y.
+static void _spatial_scale(DvzPanel* panel, DvzCDS target, dvec2 pos, dvec2 scale)
+{
+    scale[0] = scale[1] = 1;
+    if (target == DVZ_CDS_DATA)
+        return;
+    ASSERT(panel != NULL);
+
+    DvzBox box = panel->data_coords.box;
+    dvec3 p = {pos[0], pos[1], 0};
+    dvec3 q = {0}, a = {0}, b = {0};
+    double h = 0;
+    dvz_transform(panel, DVZ_CDS_DATA, p, target, a);
+    for (uint32_t k = 0; k < 2; k++)
+    {
+        h = (box.p1[k] - box.p0[k]) * 1e-3;
+        h = h > 0 && !isinf(h) ? h : 1;
+        q[0] = p[0];
+        q[1] = p[1];
+        q[2] = p[2];
+        q[k] += h;
+        dvz_transform(panel, DVZ_CDS_DATA, q, target, b);
+        scale[k] = sqrt((b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1])) / h;
+    }
+}
+
+
+
+bool dvz_visual_nearest(
+    DvzPanel* panel, DvzVisual* visual, DvzCDS source, dvec3 pos, double radius, uint32_t* item)
+{
+    ASSERT(visual != NULL);
+    ASSERT(item != NULL);
+    DvzSpatialIndex* index = _visual_spatial(visual);
+
+    dvec2 q = {0}, scale = {0};
+    _spatial_pos(panel, source, pos, q);
+    _spatial_scale(panel, source, q, scale);
+
+    int64_t nearest = _spatial_nearest(index, q, scale, radius > 0 ? radius : INFINITY);
+    if (nearest < 0)
+        return false;
+    *item = (uint32_t)nearest;
+    return true;
+}
+
+
+
+uint32_t dvz_visual_select_rect(
+    DvzPanel* panel, DvzVisual* visual, DvzCDS source, dvec3 pos0, dvec3 pos1,
+    DvzArray* selection)
+{
+    // NOTE: the rectangle is not axis-aligned in data coordinates if the view is rotated.
+    dvec3 corners[4] = {
+        {pos0[0], pos0[1], pos0[2]},
+        {pos1[0], pos0[1], pos0[2]},
+        {pos1[0], pos1[1], pos1[2]},
+        {pos0[0], pos1[1], pos1[2]},
+    };
+    return dvz_visual_select_polygon(panel, visual, source, 4, corners, selection);
+}
+
+
+
+uint32_t dvz_visual_select_polygon(
+    DvzPanel* panel, DvzVisual* visual, DvzCDS source, uint32_t point_count, dvec3* points,
+    DvzArray* selection)
+{
+    ASSERT(visual != NULL);
+    ASSERT(selection != NULL);
+    ASSERT(points != NULL || point_count == 0);
+    DvzSpatialIndex* index = _visual_spatial(visual);
+    DvzSpatialSelection sel = {0};
+
+    if (point_count < 3)
+        log_error("a selection polygon requires at least 3 points, got %d", point_count);
+    else
+    {
+        dvec2* poly = (dvec2*)calloc(point_count, sizeof(dvec2));
+        for (uint32_t i = 0; i < point_count; i++)
+            _spatial_pos(panel, source, points[i], poly[i]);
+        _spatial_polygon(index, point_count, poly, &sel);
+        FREE(poly);
+    }
+    return _selection_output(&sel, selection);
+}
+
+
+
+/*************************************************************************************************/
+/*  Snapshots                                                                                    */
+/*************************************************************************************************/
+
+int dvz_scene_save(DvzScene* scene, const char* path)
+{
+    ASSERT(scene != NULL);
+    ASSERT(path != NULL);
+
+    DvzSnapshotWriter writer = {0};
+    memcpy(writer.header.magic, DVZ_SNAPSHOT_MAGIC, sizeof(DVZ_SNAPSHOT_MAGIC));
+    writer.header.version = DVZ_SNAPSHOT_VERSION;
+    writer.header.n_rows = scene->grid.n_rows;
+    writer.header.n_cols = scene->grid.n_cols;
+
+    DvzContainerIterator iter = dvz_container_iterator(&scene->grid.panels);
+    DvzPanel* panel = NULL;
+    DvzSnapshotPanel* rec = NULL;
+    uint32_t panel_idx = 0;
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        if (panel->obj.status == DVZ_OBJECT_STATUS_NONE)
+            break;
+        ASSERT(panel->controller != NULL);
+
+        panel_idx = writer.header.panel_count;
+        rec = _snapshot_panel_new(&writer);
+        rec->row = panel->row;
+        rec->col = panel->col;
+        rec->hspan = panel->hspan;
+        rec->vspan = panel->vspan;
+        rec->controller = (int32_t)panel->controller->type;
+        rec->flags = panel->controller->flags;
+        rec->transpose = (int32_t)panel->data_coords.transpose;
+        rec->transform = (int32_t)panel->data_coords.transform;
+        rec->coords_flags = panel->data_coords.flags;
+        rec->prority_max = panel->prority_max;
+        memcpy(&rec->box[0], panel->data_coords.box.p0, sizeof(dvec3));
+        memcpy(&rec->box[3], panel->data_coords.box.p1, sizeof(dvec3));
+
+        for (uint32_t i = 0; i < panel->visual_count; i++)
+        {
+            if (_snapshot_has_visual(panel, panel->visuals[i]))
+                _snapshot_visual(&writer, panel_idx, panel->visuals[i]);
+        }
+        dvz_container_iter(&iter);
+    }
+
+    int res = _snapshot_write(&writer, path);
+    if (res == 0)
+        log_info(
+            "saved scene snapshot %s with %d visual(s), %s", path, writer.header.visual_count,
+            pretty_size(writer.header.file_size));
+    _snapshot_writer_destroy(&writer);
+    return res;
+}
+
+
+
+DvzScene* dvz_scene_load(DvzCanvas* canvas, const char* path)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(path != NULL);
+    if (canvas->scene != NULL)
+    {
+        log_error("the canvas already has a scene, unable to load %s", path);
+        return NULL;
+    }
+
+    VkDeviceSize size = 0;
+    void* base = _snapshot_map(path, &size);
+    if (base == NULL)
+        return NULL;
+    if (!_snapshot_check(base, size))
+    {
+        _snapshot_unmap(base, size);
+        return NULL;
+    }
+    const DvzSnapshotHeader* header = (const DvzSnapshotHeader*)base;
+
+    DvzScene* scene = dvz_scene(canvas, header->n_rows, header->n_cols);
+    scene->snapshot = base;
+    scene->snapshot_size = size;
+
+    // Panels.
+    DvzPanel** panels = calloc(header->panel_count, sizeof(DvzPanel*));
+    const DvzSnapshotPanel* rec = NULL;
+    DvzPanel* panel = NULL;
+    for (uint32_t i = 0; i < header->panel_count; i++)
+    {
+        rec = &_snapshot_panels(base)[i];
+        panel = dvz_scene_panel(
+            scene, rec->row, rec->col, (DvzControllerType)rec->controller, rec->flags);
+        if (rec->hspan > 1)
+            dvz_panel_span(panel, DVZ_GRID_HORIZONTAL, rec->hspan);
+        if (rec->vspan > 1)
+            dvz_panel_span(panel, DVZ_GRID_VERTICAL, rec->vspan);
+        panel->data_coords.transpose = (DvzCDSTranspose)rec->transpose;
+        panel->data_coords.transform = (DvzTransformType)rec->transform;
+        panel->data_coords.flags = rec->coords_flags;
+        memcpy(panel->data_coords.box.p0, &rec->box[0], sizeof(dvec3));
+        memcpy(panel->data_coords.box.p1, &rec->box[3], sizeof(dvec3));
+        panel->prority_max = rec->prority_max;
+        panels[i] = panel;
+    }
+
+    // Visuals.
+    const DvzSnapshotVisual* vrec = NULL;
+    DvzVisual* visual = NULL;
+    for (uint32_t i = 0; i < header->visual_count; i++)
+    {
+        vrec = &_snapshot_visuals(base)[i];
+        visual = dvz_scene_visual(panels[vrec->panel], (DvzVisualType)vrec->type, vrec->flags);
+        _snapshot_restore(visual, vrec, base);
+    }
+    FREE(panels);
+
+    log_info("loaded scene snapshot %s with %d visual(s)", path, header->visual_count);
+    return scene;
+}
+
+
+
 /*************************************************************************************************/
 /*  Scene destruction                                                                            */
 /*************************************************************************************************/
@@ -418,6 +670,12 @@ void dvz_scene_destroy(DvzScene* scene)
         panel = iter.item;
         if (panel->obj.status == DVZ_OBJECT_STATUS_NONE)
             break;
+        // Wait for the axes being baked in the background before destroying their visuals.
+        if (panel->controller != NULL && panel->controller->type == DVZ_CONTROLLER_AXES_2D)
+        {
+            _axes_cancel(panel->controller, DVZ_AXES_COORD_X);
+            _axes_cancel(panel->controller, DVZ_AXES_COORD_Y);
+        }
         // This also destroys all visuals in the panel.
         dvz_panel_destroy(panel);
         dvz_container_iter(&iter);
@@ -428,8 +686,17 @@ void dvz_scene_destroy(DvzScene* scene)
     dvz_container_destroy(&scene->controllers);
 
     dvz_fifo_destroy(&scene->update_fifo);
+    _batches_destroy(scene);
+
+    // Free the panels and the packed MVP arrays.
+    dvz_grid_destroy(grid);
 
     dvz_container_destroy(&scene->visuals);
+
+    // NOTE: the arrays of the visuals loaded from a snapshot no longer reference the mapping.
+    _snapshot_unmap(scene->snapshot, scene->snapshot_size);
+    scene->snapshot = NULL;
+
     dvz_obj_destroyed(&scene->obj);
     FREE(scene);
 }
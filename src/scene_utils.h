@@ -2,6 +2,9 @@
 #define DVZ_SCENE_UTILS_HEADER
 
 #include "../include/datoviz/scene.h"
+#include "lod_utils.h"
+#include "spatial_utils.h"
+#include "visuals_utils.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +23,13 @@ static inline bool _is_visual_to_transform(DvzVisual* visual)
 
 
 
+// Maximum distance between the origin and the panel box, relative to the box size, for the data
+// normalization to be made by the GPU with single-precision positions. Beyond, the positions are
+// normalized on the CPU in double precision.
+#define DVZ_TRANSFORM_GPU_MAX_SHIFT 8
+
+
+
 static inline bool _is_aspect_fixed(DvzDataCoords* coords)
 {
     return (coords->flags & DVZ_TRANSFORM_FLAGS_FIXED_ASPECT) != 0;
@@ -114,7 +124,10 @@ static DvzBox _visual_box(DvzVisual* visual)
         ASSERT(arr != NULL);
         if (arr->item_count == 0)
             continue;
-        boxes[n_pos_props++] = _box_bounding(arr);
+        // NOTE: the bounds of the POS props are maintained incrementally when their data changes.
+        boxes[n_pos_props] = _prop_has_bounds(prop) ? _prop_bounds(prop) : _box_bounding(arr);
+        // Single-precision POS props are relative to a double-precision origin.
+        _box_translate(&boxes[n_pos_props++], prop->origin);
     }
 
     if (n_pos_props == 0)
@@ -138,17 +151,46 @@ static void _transform_pos_prop(DvzDataCoords coords, DvzProp* prop)
 
     arr = &prop->arr_orig;
     arr_tr = &prop->arr_trans;
+
+    // The original data is uploaded as is when the GPU does the normalization.
+    ASSERT(prop->source != NULL);
+    if (prop->source->visual->transform_gpu)
+    {
+        log_trace("skip CPU normalization of POS prop #%d", prop->prop_idx);
+        dvz_array_destroy(arr_tr);
+        *arr_tr = (DvzArray){0};
+        return;
+    }
+
     if (arr->item_count == 0)
     {
         log_warn("empty POS prop, skipping renormalization");
         return;
     }
 
+    // Only transform the items that have changed if the transformed array is up to date.
+    DvzItemRange dirty = prop->dirty;
+    if (arr_tr->item_count == arr->item_count && arr_tr->dtype == arr->dtype &&
+        !_range_is_all(dirty) && dirty.count > 0 && dirty.first + dirty.count <= arr->item_count)
+    {
+        log_trace(
+            "normalizing POS prop, items %d-%d", dirty.first, dirty.first + dirty.count);
+        DvzArray view_in = *arr;
+        DvzArray view_out = *arr_tr;
+        view_in.data = dvz_array_item(arr, dirty.first);
+        view_out.data = dvz_array_item(arr_tr, dirty.first);
+        view_in.item_count = view_out.item_count = dirty.count;
+        dvz_transform_pos_origin(coords, prop->origin, &view_in, &view_out, false);
+        return;
+    }
+
     // Create the transformed prop array.
     log_trace("normalizing POS prop, %d items", arr->item_count);
     // _box_print(coords.box);
+    dvz_array_destroy(arr_tr);
+    // NOTE: single-precision POS props are normalized into a single-precision array.
     *arr_tr = dvz_array(arr->item_count, arr->dtype);
-    dvz_transform_pos(coords, arr, arr_tr, false);
+    dvz_transform_pos_origin(coords, prop->origin, arr, arr_tr, false);
 }
 
 
@@ -210,10 +252,84 @@ static void _init_item_count_change_detection(DvzVisual* visual)
 
 
 
+// Return whether the POS props of a visual can be normalized by the GPU, which is the case for
+// linear transforms when the single-precision positions do not lose precision compared to the
+// normalized positions.
+static bool _can_transform_gpu(DvzDataCoords* coords, DvzVisual* visual)
+{
+    ASSERT(coords != NULL);
+    ASSERT(visual != NULL);
+
+    if (!_is_visual_to_transform(visual) ||
+        (visual->flags & DVZ_VISUAL_FLAGS_TRANSFORM_CPU) != 0)
+        return false;
+    // TODO: non-linear transforms on the GPU.
+    if (coords->transform != DVZ_TRANSFORM_NONE && coords->transform != DVZ_TRANSFORM_CARTESIAN)
+        return false;
+
+    // All POS props of the visual must have the same origin.
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    if (prop == NULL)
+        return false;
+    double* origin = prop->origin;
+    for (uint32_t i = 1; i < 32; i++)
+    {
+        prop = dvz_prop_get(visual, DVZ_PROP_POS, i);
+        if (prop == NULL)
+            break;
+        if (memcmp(prop->origin, origin, sizeof(dvec3)) != 0)
+            return false;
+    }
+
+    // The panel box, relative to the origin, must not be too far from zero.
+    DvzBox box = coords->box;
+    double extent = 0;
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        extent = box.p1[j] - box.p0[j];
+        if (MAX(fabs(box.p0[j] - origin[j]), fabs(box.p1[j] - origin[j])) >
+            DVZ_TRANSFORM_GPU_MAX_SHIFT * extent)
+            return false;
+    }
+    return true;
+}
+
+
+
+// Set the linear data normalization made by the GPU in a visual viewport.
+static void _visual_data_normalization(DvzDataCoords* coords, DvzVisual* visual)
+{
+    ASSERT(coords != NULL);
+    ASSERT(visual != NULL);
+
+    if (!visual->transform_gpu)
+    {
+        memset(visual->viewport.data_scale, 0, sizeof(vec4));
+        memset(visual->viewport.data_shift, 0, sizeof(vec4));
+        return;
+    }
+
+    // NOTE: the origin of the POS props is added here in double precision.
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    ASSERT(prop != NULL);
+    DvzTransform tr = _transform_interp(coords->box, DVZ_BOX_NDC);
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        visual->viewport.data_scale[j] = (float)tr.mat[j][j];
+        visual->viewport.data_shift[j] = (float)(tr.mat[j][j] * prop->origin[j] + tr.mat[3][j]);
+    }
+    visual->viewport.data_scale[3] = 1;
+    visual->viewport.data_shift[3] = 0;
+}
+
+
+
 // Update the GPU viewport struct of a visual.
 static void _update_visual_viewport(DvzPanel* panel, DvzVisual* visual)
 {
     visual->viewport = panel->viewport;
+    _visual_data_normalization(&panel->data_coords, visual);
+    _ring_viewport(visual, &visual->viewport);
     log_trace("update visual viewport");
     // Each graphics pipeline in the visual has its own transform/clip viewport options
     for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
@@ -395,57 +511,228 @@ static void _enqueue_coords_changed(DvzPanel* panel)
 
 
 
+/*************************************************************************************************/
+/*  Scene update collector                                                                       */
+/*************************************************************************************************/
+
+typedef struct DvzSceneUpdates DvzSceneUpdates;
+typedef struct DvzSceneCollector DvzSceneCollector;
+
+struct DvzSceneUpdates
+{
+    uint32_t count;
+    uint32_t capacity;
+    DvzSceneUpdate* items;
+};
+
+// Scene updates of a frame, merged per object so that every POS prop is normalized once, every
+// panel box is recomputed once, every panel is renormalized once, and every visual is baked once.
+struct DvzSceneCollector
+{
+    DvzSceneUpdates props;   // changed props, to be normalized
+    DvzSceneUpdates boxes;   // visuals with new POS data, to recompute the panel box
+    DvzSceneUpdates coords;  // panels with new data coords, to be renormalized
+    DvzSceneUpdates visuals; // changed visuals, to be baked
+};
+
+
+
+static DvzSceneUpdate
+_scene_update(DvzSceneUpdateType type, DvzPanel* panel, DvzVisual* visual, DvzProp* prop)
+{
+    ASSERT(panel != NULL);
+    DvzSceneUpdate up = {0};
+    up.type = type;
+    up.scene = panel->scene;
+    up.canvas = panel->scene != NULL ? panel->scene->canvas : NULL;
+    up.panel = panel;
+    up.visual = visual;
+    up.prop = prop;
+    up.source = prop != NULL ? prop->source : NULL;
+    return up;
+}
+
+
+
+static void _updates_append(DvzSceneUpdates* updates, DvzSceneUpdate up)
+{
+    ASSERT(updates != NULL);
+    if (updates->count == updates->capacity)
+    {
+        updates->capacity = MAX(16, 2 * updates->capacity);
+        REALLOC(updates->items, updates->capacity * sizeof(DvzSceneUpdate));
+    }
+    updates->items[updates->count++] = up;
+}
+
+
+
+static void _collector_destroy(DvzSceneCollector* col)
+{
+    ASSERT(col != NULL);
+    FREE(col->props.items);
+    FREE(col->boxes.items);
+    FREE(col->coords.items);
+    FREE(col->visuals.items);
+}
+
+
+
+static int _cmp_update_prop(const void* a, const void* b)
+{
+    uintptr_t x = (uintptr_t)((const DvzSceneUpdate*)a)->prop;
+    uintptr_t y = (uintptr_t)((const DvzSceneUpdate*)b)->prop;
+    return (x > y) - (x < y);
+}
+
+
+
+static int _cmp_update_visual(const void* a, const void* b)
+{
+    uintptr_t x = (uintptr_t)((const DvzSceneUpdate*)a)->visual;
+    uintptr_t y = (uintptr_t)((const DvzSceneUpdate*)b)->visual;
+    return (x > y) - (x < y);
+}
+
+
+
+static int _cmp_update_panel(const void* a, const void* b)
+{
+    uintptr_t x = (uintptr_t)((const DvzSceneUpdate*)a)->panel;
+    uintptr_t y = (uintptr_t)((const DvzSceneUpdate*)b)->panel;
+    return (x > y) - (x < y);
+}
+
+
+
+// Sort scene updates by object, and remove the duplicates so that no object is processed twice
+// concurrently. Return the number of unique updates.
+static uint32_t
+_unique_updates(uint32_t count, DvzSceneUpdate* ups, int (*cmp)(const void*, const void*))
+{
+    ASSERT(ups != NULL || count == 0);
+    if (count <= 1)
+        return count;
+    qsort(ups, count, sizeof(DvzSceneUpdate), cmp);
+    uint32_t k = 1;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        if (cmp(&ups[i], &ups[k - 1]) != 0)
+            ups[k++] = ups[i];
+    }
+    return k;
+}
+
+
+
 /*************************************************************************************************/
 /*  Processing scene updates                                                                     */
 /*************************************************************************************************/
 
-// Called when a prop's data has changed.
-// Change the visual and source request, to be picked up by dvz_visual_data() later.
-static void _process_prop_changed(DvzSceneUpdate up)
+// Choose whether the POS props of a visual are normalized by the CPU or the GPU. When this
+// changes, all POS props of the visual need to be normalized and baked again.
+static void _update_transform_mode(DvzPanel* panel, DvzVisual* visual, DvzSceneCollector* col)
 {
-    ASSERT(up.panel != NULL);
-    DvzDataCoords coords = up.panel->data_coords;
+    ASSERT(panel != NULL);
+    ASSERT(visual != NULL);
+
+    bool gpu = _can_transform_gpu(&panel->data_coords, visual);
+    bool changed = gpu != visual->transform_gpu;
+    visual->transform_gpu = gpu;
+
+    // NOTE: the origin of the POS props may also have changed.
+    if (gpu || changed)
+        _update_visual_viewport(panel, visual);
+    if (!changed)
+        return;
+
+    log_debug("POS props of visual normalized on the %s", gpu ? "GPU" : "CPU");
+    DvzProp* prop = NULL;
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        prop = dvz_prop_get(visual, DVZ_PROP_POS, i);
+        if (prop == NULL)
+            break;
+        _range_all(&prop->dirty);
+        _updates_append(
+            &col->props, _scene_update(DVZ_SCENE_UPDATE_PROP_CHANGED, panel, visual, prop));
+    }
+}
+
 
-    // if POS prop, we do data normalization
+
+// Called when a prop's data has changed. The box of its visual needs to be recomputed only when
+// the POS data itself has changed, and not only its normalization.
+static void _collect_prop(DvzSceneCollector* col, DvzSceneUpdate up, bool box)
+{
+    ASSERT(col != NULL);
     ASSERT(up.prop != NULL);
     ASSERT(up.visual != NULL);
-    if (up.prop->prop_type == DVZ_PROP_POS && _is_visual_to_transform(up.visual))
+
+    _updates_append(&col->props, up);
+    if (up.prop->prop_type != DVZ_PROP_POS || !_is_visual_to_transform(up.visual))
+        return;
+
+    // NOTE: the normalization mode must be chosen before the worker threads start.
+    _update_transform_mode(up.panel, up.visual, col);
+    if (box && (up.visual->flags & DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT) == 0)
+        _updates_append(&col->boxes, up);
+}
+
+
+
+// Called when the POS data of visuals has changed. The box of every panel is recomputed once,
+// from the boxes of its changed visuals.
+static void _process_boxes_changed(DvzSceneCollector* col)
+{
+    ASSERT(col != NULL);
+    DvzSceneUpdates* boxes = &col->boxes;
+    if (boxes->count == 0)
+        return;
+
+    // One update per visual, grouped by panel.
+    uint32_t n = _unique_updates(boxes->count, boxes->items, _cmp_update_visual);
+    qsort(boxes->items, n, sizeof(DvzSceneUpdate), _cmp_update_panel);
+
+    DvzPanel* panel = NULL;
+    DvzBox box = {0};
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < n; i = j)
     {
-        _transform_pos_prop(coords, up.prop);
+        panel = boxes->items[i].panel;
+        ASSERT(panel != NULL);
+        DvzDataCoords coords = panel->data_coords;
 
-        if ((up.visual->flags & DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT) == 0)
-        {
-            // Recompute the visual box.
-            DvzBox box = _visual_box(up.visual);
+        // Merge the boxes of the changed visuals of the panel.
+        box = _visual_box(boxes->items[i].visual);
+        for (j = i + 1; j < n && boxes->items[j].panel == panel; j++)
+            box = _box_merge(2, (DvzBox[]){box, _visual_box(boxes->items[j].visual)});
 
-            // Make the box square if needed.
-            if (_is_aspect_fixed(&coords))
-                box = _box_cube(box);
+        // Make the box square if needed.
+        if (_is_aspect_fixed(&coords))
+            box = _box_cube(box);
 
-            // If the new box has changed, renormalize all visuals.
-            if (_has_coords_changed(&coords, &box))
-            {
-                // Update the data coords.
-                up.panel->data_coords.box = box;
-                _enqueue_coords_changed(up.panel);
-            }
+        // If the new box has changed, renormalize all visuals.
+        if (_has_coords_changed(&coords, &box))
+        {
+            // Update the data coords.
+            panel->data_coords.box = box;
+            _updates_append(
+                &col->coords, _scene_update(DVZ_SCENE_UPDATE_COORDS_CHANGED, panel, NULL, NULL));
         }
     }
-
-    // Mark the visual and source has needing update, for dvz_visual_update()
-    ASSERT(up.source != NULL);
-    _source_set_changed(up.source, true);
+    boxes->count = 0;
 }
 
 
 
 // Called when the box coords has changed and ALL visuals in a panel must be renormalized.
-static void _process_coords_changed(DvzSceneUpdate up)
+static void _process_coords_changed(DvzPanel* panel, DvzSceneCollector* col)
 {
     log_trace("process coords changed");
 
-    DvzPanel* panel = up.panel;
     ASSERT(panel != NULL);
+    ASSERT(col != NULL);
 
     // We'll iterate through all visuals.
     DvzVisual* visual = NULL;
@@ -467,6 +754,13 @@ static void _process_coords_changed(DvzSceneUpdate up)
             continue;
         }
 
+        // When the GPU does the normalization, only the visual viewport needs to be uploaded.
+        bool was_gpu = visual->transform_gpu;
+        visual->transform_gpu = _can_transform_gpu(&panel->data_coords, visual);
+        _update_visual_viewport(panel, visual);
+        if (was_gpu && visual->transform_gpu)
+            continue;
+
         // Go through all visual props.
         iter = dvz_container_iterator(&visual->props);
         while (iter.item != NULL)
@@ -477,7 +771,11 @@ static void _process_coords_changed(DvzSceneUpdate up)
             // Transform all POS props with the panel data coordinates.
             if (prop->prop_type == DVZ_PROP_POS)
             {
-                _enqueue_prop_changed(panel, visual, prop);
+                // NOTE: all items need to be transformed and baked again.
+                _range_all(&prop->dirty);
+                _updates_append(
+                    &col->props,
+                    _scene_update(DVZ_SCENE_UPDATE_PROP_CHANGED, panel, visual, prop));
             }
 
             dvz_container_iter(&iter);
@@ -535,10 +833,10 @@ static void _process_visual_added(DvzSceneUpdate up)
 
 
 
-// Called when visual data has changed.
-static void _process_visual_changed(DvzSceneUpdate up)
+// Called when a visual has been baked, possibly in a worker thread.
+static void _process_visual_baked(DvzSceneUpdate up)
 {
-    log_trace("process visual changed");
+    log_trace("process visual baked");
 
     DvzVisual* visual = up.visual;
     ASSERT(visual != NULL);
@@ -546,7 +844,9 @@ static void _process_visual_changed(DvzSceneUpdate up)
     ASSERT(panel != NULL);
 
     // Visual data GPU upload.
-    dvz_visual_update(visual, panel->viewport, panel->data_coords, NULL);
+    dvz_visual_upload(visual);
+    if (visual->batch != NULL)
+        visual->batch_changed = true;
 
     // Detect whether the number of vertices/indices has changed, in which case a command buffer
     // refill will be needed.
@@ -566,6 +866,19 @@ static void _process_visual_changed(DvzSceneUpdate up)
 
 
 
+// Called when visual data has changed.
+static void _process_visual_changed(DvzSceneUpdate up)
+{
+    log_trace("process visual changed");
+
+    ASSERT(up.visual != NULL);
+    ASSERT(up.panel != NULL);
+    dvz_visual_bake(up.visual, up.panel->viewport, up.panel->data_coords, NULL);
+    _process_visual_baked(up);
+}
+
+
+
 // Called when the visibility of a visual has changed.
 static void _process_visibility_changed(DvzSceneUpdate up)
 {
@@ -640,7 +953,8 @@ static void _process_interact_changed(DvzSceneUpdate up)
 
 
 
-// Called when anything in the scene has changed.
+// Called when anything in the scene has changed. The prop and coords changes are merged per object
+// by the collector, and are not processed here (see _collect_updates()).
 static void _process_scene_update(DvzSceneUpdate up)
 {
     switch (up.type)
@@ -654,10 +968,6 @@ static void _process_scene_update(DvzSceneUpdate up)
         _process_visual_changed(up);
         break;
 
-    case DVZ_SCENE_UPDATE_PROP_CHANGED:
-        _process_prop_changed(up);
-        break;
-
     case DVZ_SCENE_UPDATE_VISIBILITY_CHANGED:
         _process_visibility_changed(up);
         break;
@@ -674,10 +984,6 @@ static void _process_scene_update(DvzSceneUpdate up)
         _process_interact_changed(up);
         break;
 
-    case DVZ_SCENE_UPDATE_COORDS_CHANGED:
-        _process_coords_changed(up);
-        break;
-
         // case DVZ_SCENE_UPDATE_CANVAS_RESIZED:
         //     _process_canvas_resized(up);
         //     break;
@@ -690,91 +996,743 @@ static void _process_scene_update(DvzSceneUpdate up)
 
 
 /*************************************************************************************************/
-/*  Scene updates                                                                                */
+/*  Culling                                                                                      */
 /*************************************************************************************************/
 
-static void _callback_controllers(DvzScene* scene)
+// Margin around the panel viewport, in framebuffer pixels, so that the markers and thick lines
+// whose positions are just outside of the view are still drawn.
+#define DVZ_CULLING_MARGIN 64
+
+
+
+// Whether a panel has a non-empty intersection with the framebuffer.
+static bool _panel_is_visible(DvzPanel* panel)
 {
-    ASSERT(scene != NULL);
-    DvzGrid* grid = &scene->grid;
+    ASSERT(panel != NULL);
+    // Panel outside of the current tile of a tiled export.
+    if (panel->viewport_empty)
+        return false;
+    VkViewport vp = panel->viewport.viewport;
+    if (vp.width <= 0 || vp.height <= 0)
+        return false;
+
+    ASSERT(panel->grid != NULL);
+    DvzCanvas* canvas = panel->grid->canvas;
+    ASSERT(canvas != NULL);
+    if (canvas->swapchain.images == NULL)
+        return true;
+    float w = canvas->swapchain.images->width;
+    float h = canvas->swapchain.images->height;
+    return vp.x < w && vp.y < h && vp.x + vp.width > 0 && vp.y + vp.height > 0;
+}
 
-    // Go through all panels that need to be updated.
-    DvzPanel* panel = NULL;
-    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
 
-    // Go through all panels in the scene to detect the scene updates.
-    while (iter.item != NULL)
+
+// Whether a visual follows the panel view entirely, so that it can be culled from its data box.
+static bool _can_cull(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (!_is_visual_to_transform(visual))
+        return false;
+    for (uint32_t i = 0; i < visual->graphics_count; i++)
     {
-        panel = iter.item;
+        if (visual->interact_axis[i] != DVZ_INTERACT_FIXED_AXIS_DEFAULT)
+            return false;
+    }
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    return prop != NULL && prop->arr_orig.item_count > 0;
+}
 
-        // Interactivity.
-        if (panel->controller != NULL && panel->controller->callback != NULL)
+
+
+// Whether the groups of a visual can be culled individually: each group must be a contiguous
+// range of vertices, one vertex per item of the POS prop, made of whole points, lines or
+// triangles.
+static bool _can_cull_groups(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->group_count <= 1 || visual->graphics_count != 1 ||
+        visual->callback_fill != _default_visual_fill || visual->ring_capacity > 0 ||
+        visual->lod != NULL)
+        return false;
+
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    if (prop == NULL || !_prop_has_bounds(prop) || dvz_prop_get(visual, DVZ_PROP_POS, 1) != NULL)
+        return false;
+    DvzSource* index = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_INDEX, 0);
+    if (index != NULL && index->arr.item_count > 0)
+        return false;
+    DvzSource* vertex = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    if (vertex == NULL || vertex->arr.item_count != prop->arr_orig.item_count)
+        return false;
+    return _are_groups_aligned(visual, visual->graphics[0], prop->arr_orig.item_count);
+}
+
+
+
+// Transformation matrix from data coordinates to Vulkan clip coordinates, with the panel MVP.
+static void _clip_matrix(DvzPanel* panel, dmat4 mat)
+{
+    ASSERT(panel != NULL);
+    DvzTransform tr_data = _transform_cds(panel, DVZ_CDS_DATA);
+    DvzTransform tr_mvp = _transform_cds(panel, DVZ_CDS_SCENE);
+    _dmat4_mul(tr_mvp.mat, tr_data.mat, mat);
+}
+
+
+
+// Whether a box in data coordinates intersects the clip volume, enlarged by the given margins in
+// normalized device coordinates. The box is outside if its 8 corners are outside of the same
+// clipping plane.
+static bool _box_in_frustum(dmat4 mat, DvzBox box, double mx, double my)
+{
+    uint32_t outside[6] = {0};
+    dvec4 p = {0};
+    double w = 0;
+    for (uint32_t k = 0; k < 8; k++)
+    {
+        p[0] = (k & 1) ? box.p1[0] : box.p0[0];
+        p[1] = (k & 2) ? box.p1[1] : box.p0[1];
+        p[2] = (k & 4) ? box.p1[2] : box.p0[2];
+        p[3] = 1;
+        _dmat4_mulv(mat, p, p);
+        w = p[3];
+        outside[0] += p[0] < -(1 + mx) * w;
+        outside[1] += p[0] > +(1 + mx) * w;
+        outside[2] += p[1] < -(1 + my) * w;
+        outside[3] += p[1] > +(1 + my) * w;
+        // NOTE: Vulkan depth range.
+        outside[4] += p[2] < 0;
+        outside[5] += p[2] > w;
+    }
+    for (uint32_t j = 0; j < 6; j++)
+    {
+        if (outside[j] == 8)
+            return false;
+    }
+    return true;
+}
+
+
+
+// Cull the groups of a visual. Return whether the culled groups have changed.
+static bool _visual_cull_groups(DvzVisual* visual, dmat4 mat, double mx, double my)
+{
+    ASSERT(visual != NULL);
+    bool can_cull = _can_cull_groups(visual);
+    uint32_t n = visual->group_count;
+
+    // The group boxes are computed again after each change of the POS prop.
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    if (can_cull && visual->group_boxes == NULL)
+    {
+        visual->group_boxes = calloc(n, sizeof(DvzBox));
+        uint32_t offset = 0;
+        for (uint32_t g = 0; g < n; g++)
         {
-            // TODO: event struct
-            panel->controller->callback(panel->controller, (DvzEvent){0});
+            visual->group_boxes[g] = DVZ_BOX_INF;
+            dvz_array_bounds(
+                &prop->arr_orig, offset, visual->group_sizes[g], visual->group_boxes[g].p0,
+                visual->group_boxes[g].p1);
+            _box_translate(&visual->group_boxes[g], prop->origin);
+            offset += visual->group_sizes[g];
         }
-        dvz_container_iter(&iter);
     }
+
+    bool changed = false, culled = false;
+    uint32_t count = 0;
+    for (uint32_t g = 0; g < n; g++)
+    {
+        culled = can_cull && visual->group_sizes[g] > 0 &&
+                 !_box_in_frustum(mat, visual->group_boxes[g], mx, my);
+        changed |= culled != visual->group_culled[g];
+        visual->group_culled[g] = culled;
+        count += culled;
+    }
+    visual->group_culled_count = count;
+    return changed;
 }
 
 
 
-static void _enqueue_all_visuals_changed(DvzScene* scene)
+// Cull the visuals and the groups of visuals outside of the current view of their panel, and
+// refill the command buffers when the culled visuals have changed.
+static void _update_culling(DvzScene* scene)
 {
-    // log_trace("enqueue all visuals changed");
-
     ASSERT(scene != NULL);
     DvzGrid* grid = &scene->grid;
 
-    // Go through all panels that need to be updated.
     DvzPanel* panel = NULL;
-    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
     DvzVisual* visual = NULL;
-    DvzContainerIterator iter_prop;
-    DvzProp* prop = NULL;
-
-    // Go through all panels in the scene to detect the scene updates.
+    DvzViewport* viewport = NULL;
+    dmat4 mat = {0};
+    double mx = 0, my = 0;
+    bool culled = false, changed = false;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
     while (iter.item != NULL)
     {
         panel = iter.item;
+        if (!_panel_is_visible(panel))
+        {
+            dvz_container_iter(&iter);
+            continue;
+        }
+        _clip_matrix(panel, mat);
 
-        // Determine what has changed in the scene since last frame:
+        // Margins in normalized device coordinates, including the panel margins.
+        viewport = &panel->viewport;
+        // NOTE: the framebuffer size is the full panel size, also in a tiled export.
+        mx = 2 * (DVZ_CULLING_MARGIN + viewport->margins[1] + viewport->margins[3]) /
+             MAX(1, viewport->size_framebuffer[0] - viewport->margins[1] - viewport->margins[3]);
+        my = 2 * (DVZ_CULLING_MARGIN + viewport->margins[0] + viewport->margins[2]) /
+             MAX(1, viewport->size_framebuffer[1] - viewport->margins[0] - viewport->margins[2]);
 
-        // Process panel and visual requests.
         for (uint32_t j = 0; j < panel->visual_count; j++)
         {
             visual = panel->visuals[j];
-
-            // Process visual upload.
-            if (visual->obj.request == DVZ_VISUAL_REQUEST_UPLOAD)
-            {
-                // Check if the POS props have been changed.
-                iter_prop = dvz_container_iterator(&visual->props);
-                while (iter_prop.item != NULL)
-                {
-                    prop = iter_prop.item;
-                    if (prop->prop_type == DVZ_PROP_POS &&
-                        prop->obj.request == DVZ_VISUAL_REQUEST_UPLOAD)
-                    {
-                        _enqueue_prop_changed(panel, visual, prop);
-                        prop->obj.request = DVZ_VISUAL_REQUEST_SET;
-                    }
-                    dvz_container_iter(&iter_prop);
-                }
-
-                _enqueue_visual_changed(panel, visual);
-            }
+            culled = _can_cull(visual) && !_box_in_frustum(mat, _visual_box(visual), mx, my);
+            changed |= culled != visual->culled;
+            visual->culled = culled;
+            if (!culled && visual->group_count > 1)
+                changed |= _visual_cull_groups(visual, mat, mx, my);
         }
         dvz_container_iter(&iter);
     }
+
+    if (changed)
+    {
+        log_debug("culled visuals have changed, refilling the command buffers");
+        dvz_canvas_to_refill(scene->canvas);
+    }
 }
 
 
 
-// Dequeue a scene update.
-static DvzSceneUpdate _scene_update_dequeue(DvzScene* scene)
-{
-    log_trace("dequeue scene update");
+/*************************************************************************************************/
+/*  Draw batching                                                                                */
+/*************************************************************************************************/
+
+// Whether a visual may be drawn in a batch: a single graphics pipeline filled by the default
+// callback, with a non-indexed vertex buffer baked on the CPU.
+static bool _can_batch(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->obj.status == DVZ_OBJECT_STATUS_INVALID || visual->graphics_count != 1 ||
+        visual->compute_count > 0 || visual->callback_fill != _default_visual_fill ||
+        visual->ring_capacity > 0 || visual->lod != NULL || visual->group_count > 1)
+        return false;
+
+    DvzSource* vertex = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    if (vertex == NULL || vertex->arr.item_count == 0 || vertex->arr.data == NULL ||
+        vertex->origin == DVZ_SOURCE_ORIGIN_USER || vertex->u.br.buffer == NULL ||
+        (vertex->flags & DVZ_SOURCE_FLAG_GPU_BAKE) != 0)
+        return false;
+    DvzSource* index = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_INDEX, 0);
+    return index == NULL || index->arr.item_count == 0;
+}
+
+
+
+// Whether two sources provide the same data to the shaders.
+static bool _same_source(DvzSource* a, DvzSource* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    if (a->source_kind != b->source_kind)
+        return false;
+    if (_source_is_texture(a->source_kind))
+        return a->u.tex == b->u.tex;
+    // Buffers shared between visuals, for example the MVP buffer of the panel.
+    if (a->origin == DVZ_SOURCE_ORIGIN_USER || b->origin == DVZ_SOURCE_ORIGIN_USER)
+        return a->u.br.buffer == b->u.br.buffer && a->u.br.offsets[0] == b->u.br.offsets[0];
+    VkDeviceSize size = a->arr.item_count * a->arr.item_size;
+    return a->arr.item_count == b->arr.item_count && a->arr.item_size == b->arr.item_size &&
+           (size == 0 || memcmp(a->arr.data, b->arr.data, size) == 0);
+}
+
+
+
+// Whether a visual can be drawn with the pipeline and the bindings of another visual.
+static bool _draw_batch_compatible(DvzVisual* leader, DvzVisual* visual)
+{
+    ASSERT(leader != NULL);
+    ASSERT(visual != NULL);
+    if (!_can_batch(visual) || leader->flags != visual->flags ||
+        leader->priority != visual->priority || leader->clip[0] != visual->clip[0] ||
+        leader->interact_axis[0] != visual->interact_axis[0])
+        return false;
+
+    // Same builtin pipeline. Custom pipelines may use different shaders.
+    DvzGraphics* g0 = leader->graphics[0];
+    DvzGraphics* g1 = visual->graphics[0];
+    if (g0 != g1 && (g0->type != g1->type || g0->flags != g1->flags ||
+                     g0->type == DVZ_GRAPHICS_NONE || g0->type == DVZ_GRAPHICS_CUSTOM))
+        return false;
+
+    // All sources other than the vertex buffer must be identical.
+    DvzSource* source = NULL;
+    DvzSource* other = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&leader->sources);
+    while (iter.item != NULL)
+    {
+        source = iter.item;
+        other = dvz_source_get(visual, source->source_type, source->source_idx);
+        if (other == NULL)
+            return false;
+        if (source->source_type == DVZ_SOURCE_TYPE_VERTEX)
+        {
+            if (source->arr.item_size != other->arr.item_size)
+                return false;
+        }
+        else if (!_same_source(source, other))
+            return false;
+        dvz_container_iter(&iter);
+    }
+    return true;
+}
+
+
+
+static void _draw_batch_append(DvzDrawBatch* batch, DvzVisual* visual)
+{
+    ASSERT(batch != NULL);
+    ASSERT(visual != NULL);
+    if (batch->visual_count == batch->visual_capacity)
+    {
+        batch->visual_capacity = MAX(16, 2 * batch->visual_capacity);
+        REALLOC(batch->visuals, batch->visual_capacity * sizeof(DvzVisual*));
+        REALLOC(batch->first, (batch->visual_capacity + 1) * sizeof(uint32_t));
+    }
+    batch->visuals[batch->visual_count++] = visual;
+}
+
+
+
+// Return a new empty batch, reusing the memory and the GPU buffer of the previous batches.
+static DvzDrawBatch* _draw_batch_new(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    if (scene->batch_count == scene->batch_capacity)
+    {
+        uint32_t capacity = MAX(4, 2 * scene->batch_capacity);
+        REALLOC(scene->batches, capacity * sizeof(DvzDrawBatch));
+        memset(
+            &scene->batches[scene->batch_capacity], 0,
+            (capacity - scene->batch_capacity) * sizeof(DvzDrawBatch));
+        scene->batch_capacity = capacity;
+    }
+    DvzDrawBatch* batch = &scene->batches[scene->batch_count++];
+    batch->visual_count = 0;
+    batch->vertex_count = 0;
+    return batch;
+}
+
+
+
+static void _batches_destroy(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    for (uint32_t i = 0; i < scene->batch_capacity; i++)
+    {
+        FREE(scene->batches[i].visuals);
+        FREE(scene->batches[i].first);
+        dvz_array_destroy(&scene->batches[i].vertices);
+    }
+    FREE(scene->batches);
+    scene->batch_count = 0;
+    scene->batch_capacity = 0;
+}
+
+
+
+// Copy the vertex data of the visuals of a batch to the shared vertex buffer, either all of them,
+// or only those that have changed. The changed range is uploaded at once. The vertex data of the
+// batched visuals is not uploaded to their own vertex buffers (see dvz_visual_upload()).
+static void _draw_batch_upload(DvzCanvas* canvas, DvzDrawBatch* batch, bool all)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(batch != NULL);
+    ASSERT(batch->visual_count > 0);
+    DvzSource* source = _get_pipeline_source(batch->visuals[0], DVZ_SOURCE_TYPE_VERTEX, 0);
+    ASSERT(source != NULL);
+    VkDeviceSize item_size = source->arr.item_size;
+    ASSERT(item_size > 0);
+
+    // Offset table.
+    if (all)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < batch->visual_count; i++)
+        {
+            batch->first[i] = count;
+            source = _get_pipeline_source(batch->visuals[i], DVZ_SOURCE_TYPE_VERTEX, 0);
+            count += source->arr.item_count;
+        }
+        batch->first[batch->visual_count] = count;
+        batch->vertex_count = count;
+
+        if (batch->vertices.item_size != item_size)
+        {
+            dvz_array_destroy(&batch->vertices);
+            batch->vertices = dvz_array_struct(count, item_size);
+        }
+        dvz_array_resize(&batch->vertices, count);
+
+        // Shared vertex buffer.
+        DvzContext* ctx = canvas->gpu->context;
+        VkDeviceSize size = dvz_next_pow2(count * item_size);
+        if (batch->br.buffer == NULL)
+            batch->br = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_VERTEX, 1, size);
+        else if (batch->br.size < count * item_size)
+            dvz_ctx_buffers_resize(ctx, &batch->br, size);
+    }
+
+    // Copy the vertex data.
+    uint32_t i0 = UINT32_MAX, i1 = 0;
+    DvzVisual* visual = NULL;
+    for (uint32_t i = 0; i < batch->visual_count; i++)
+    {
+        visual = batch->visuals[i];
+        if (!all && !visual->batch_changed)
+            continue;
+        source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+        ASSERT(source->arr.item_count == batch->first[i + 1] - batch->first[i]);
+        dvz_array_copy_region(
+            &source->arr, &batch->vertices, 0, batch->first[i], source->arr.item_count);
+        visual->batch_changed = false;
+        i0 = MIN(i0, batch->first[i]);
+        i1 = MAX(i1, batch->first[i + 1]);
+    }
+    if (i1 <= i0)
+        return;
+    log_trace("upload vertices %d-%d of a batch of %d visuals", i0, i1, batch->visual_count);
+    dvz_upload_buffers(
+        canvas, batch->br, i0 * item_size, (i1 - i0) * item_size,
+        (char*)batch->vertices.data + i0 * item_size);
+}
+
+
+
+// Group the consecutive compatible visuals of every panel into batches.
+static void _build_batches(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+    DvzPanel* panel = NULL;
+    DvzVisual* visual = NULL;
+    DvzVisual* leader = NULL;
+    DvzDrawBatch* batch = NULL;
+    scene->batch_count = 0;
+
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t k = 0; k < panel->visual_count; k++)
+        {
+            panel->visuals[k]->batch = NULL;
+            panel->visuals[k]->batch_changed = false;
+        }
+
+        // Same order as the command buffer fill.
+        for (int priority = -panel->prority_max; priority <= panel->prority_max; priority++)
+        {
+            leader = NULL;
+            batch = NULL;
+            for (uint32_t k = 0; k < panel->visual_count; k++)
+            {
+                visual = panel->visuals[k];
+                if (visual->priority != priority)
+                    continue;
+                if (leader != NULL && _draw_batch_compatible(leader, visual))
+                {
+                    if (batch == NULL)
+                    {
+                        batch = _draw_batch_new(scene);
+                        _draw_batch_append(batch, leader);
+                    }
+                    _draw_batch_append(batch, visual);
+                    continue;
+                }
+                leader = _can_batch(visual) ? visual : NULL;
+                batch = NULL;
+            }
+        }
+        dvz_container_iter(&iter);
+    }
+
+    // NOTE: the batches may have moved in memory while they were created.
+    for (uint32_t i = 0; i < scene->batch_count; i++)
+    {
+        batch = &scene->batches[i];
+        for (uint32_t j = 0; j < batch->visual_count; j++)
+            batch->visuals[j]->batch = batch;
+        _draw_batch_upload(scene->canvas, batch, true);
+        log_debug("batch #%d with %d visuals", i, batch->visual_count);
+    }
+
+    // The visuals that have left their batch are drawn from their own vertex buffer again.
+    DvzSource* source = NULL;
+    iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t k = 0; k < panel->visual_count; k++)
+        {
+            visual = panel->visuals[k];
+            if (visual->batch != NULL || !visual->batch_outdated ||
+                !dvz_obj_is_created(&visual->obj))
+                continue;
+            source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+            ASSERT(source != NULL);
+            _range_all(&source->dirty);
+            _source_set_changed(source, true);
+            dvz_visual_upload(visual);
+            visual->batch_outdated = false;
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+// Rebuild the batches when the command buffers are about to be refilled. Otherwise, copy the
+// changed vertex data to the shared vertex buffers, unless a visual can no longer be batched.
+static void _update_batches(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzCanvas* canvas = scene->canvas;
+    ASSERT(canvas != NULL);
+
+    bool refill = canvas->frame_idx == 0 ||
+                  atomic_load(&canvas->refills.status) == DVZ_REFILL_REQUESTED;
+    DvzDrawBatch* batch = NULL;
+    DvzVisual* visual = NULL;
+    DvzSource* source = NULL;
+    for (uint32_t i = 0; i < scene->batch_count && !refill; i++)
+    {
+        batch = &scene->batches[i];
+        for (uint32_t j = 0; j < batch->visual_count && !refill; j++)
+        {
+            visual = batch->visuals[j];
+            if (!dvz_obj_is_created(&visual->obj) || visual->batch != batch)
+            {
+                refill = true;
+                break;
+            }
+            if (!visual->batch_changed)
+                continue;
+            source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+            refill = !_draw_batch_compatible(batch->visuals[0], visual) ||
+                     source->arr.item_count != batch->first[j + 1] - batch->first[j];
+        }
+    }
+
+    if (refill)
+    {
+        if (atomic_load(&canvas->refills.status) != DVZ_REFILL_REQUESTED)
+            dvz_canvas_to_refill(canvas);
+        _build_batches(scene);
+        return;
+    }
+    for (uint32_t i = 0; i < scene->batch_count; i++)
+        _draw_batch_upload(canvas, &scene->batches[i], false);
+}
+
+
+
+// Draw the visible visuals of a batch, with one draw call per run of consecutive visible
+// visuals.
+static void _draw_batch_fill(DvzDrawBatch* batch, DvzCommands* cmds, uint32_t idx)
+{
+    ASSERT(batch != NULL);
+    ASSERT(batch->visual_count > 0);
+    DvzVisual* leader = batch->visuals[0];
+    DvzBindings* bindings = dvz_container_get(&leader->bindings, 0);
+    ASSERT(dvz_obj_is_created(&bindings->obj));
+    ASSERT(batch->br.size >= batch->vertex_count * batch->vertices.item_size);
+
+    dvz_cmd_bind_vertex_buffer(cmds, idx, batch->br, 0);
+    dvz_cmd_bind_graphics(cmds, idx, leader->graphics[0], bindings, 0);
+
+    DvzVisual* visual = NULL;
+    uint32_t first = 0, count = 0, draws = 0;
+    for (uint32_t i = 0; i < batch->visual_count; i++)
+    {
+        visual = batch->visuals[i];
+        if (!visual->hidden && !visual->culled)
+        {
+            if (count == 0)
+                first = batch->first[i];
+            count += batch->first[i + 1] - batch->first[i];
+        }
+        else if (count > 0)
+        {
+            _draw_vertices(leader->graphics[0], cmds, idx, first, count);
+            draws++;
+            count = 0;
+        }
+    }
+    if (count > 0)
+    {
+        _draw_vertices(leader->graphics[0], cmds, idx, first, count);
+        draws++;
+    }
+    log_debug("draw a batch of %d visuals with %d draw calls", batch->visual_count, draws);
+}
+
+
+
+/*************************************************************************************************/
+/*  Scene updates                                                                                */
+/*************************************************************************************************/
+
+static void _callback_controllers(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+
+    // Go through all panels that need to be updated.
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+
+    // Go through all panels in the scene to detect the scene updates.
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+
+        // Interactivity.
+        if (panel->controller != NULL && panel->controller->callback != NULL)
+        {
+            // TODO: event struct
+            panel->controller->callback(panel->controller, (DvzEvent){0});
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+// Update the visible x range of a visual with a level of detail, from the panzoom of its panel.
+// Return false if the panel has no panzoom.
+static bool _lod_visible(DvzPanel* panel, DvzLod* lod)
+{
+    ASSERT(panel != NULL);
+    ASSERT(lod != NULL);
+    DvzController* controller = panel->controller;
+    if (controller == NULL || controller->interact_count == 0)
+        return false;
+    DvzInteract* interact = &controller->interacts[0];
+    if (interact->type != DVZ_INTERACT_PANZOOM &&
+        interact->type != DVZ_INTERACT_PANZOOM_FIXED_ASPECT)
+        return false;
+    DvzPanzoom* panzoom = &interact->u.p;
+    ASSERT(panzoom->zoom[0] > 0);
+
+    // Visible x range in scene coordinates, from the camera position and zoom level.
+    dvec3 in0 = {panzoom->camera_pos[0] - 1.0 / panzoom->zoom[0], 0, 0};
+    dvec3 in1 = {panzoom->camera_pos[0] + 1.0 / panzoom->zoom[0], 0, 0};
+    dvec3 out0 = {0}, out1 = {0};
+    DvzTransformChain tc = _transforms_cds(panel, DVZ_CDS_SCENE, DVZ_CDS_DATA);
+    _transforms_apply(&tc, in0, out0);
+    _transforms_apply(&tc, in1, out1);
+
+    lod->range[0] = out0[0];
+    lod->range[1] = out1[0];
+    lod->width = panel->viewport.size_framebuffer[0];
+    return true;
+}
+
+
+
+// Select the level of detail of the visuals with DVZ_VISUAL_FLAGS_LOD, and rebake the visuals
+// whose selection has changed.
+static void _update_lod(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+
+    DvzPanel* panel = NULL;
+    DvzVisual* visual = NULL;
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+        {
+            visual = panel->visuals[j];
+            // The pyramid is built by the first bake.
+            if (visual->lod == NULL || visual->lod->item_count == 0)
+                continue;
+            if (!_lod_visible(panel, visual->lod))
+                continue;
+            prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+            if (_lod_select(visual->lod, &prop->arr_orig))
+                _source_set_changed(dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0), true);
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+static void _enqueue_all_visuals_changed(DvzScene* scene)
+{
+    // log_trace("enqueue all visuals changed");
+
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+
+    // Go through all panels that need to be updated.
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    DvzVisual* visual = NULL;
+    DvzContainerIterator iter_prop;
+    DvzProp* prop = NULL;
+
+    // Go through all panels in the scene to detect the scene updates.
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+
+        // Determine what has changed in the scene since last frame:
+
+        // Process panel and visual requests.
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+        {
+            visual = panel->visuals[j];
+
+            // Process visual upload.
+            if (visual->obj.request == DVZ_VISUAL_REQUEST_UPLOAD)
+            {
+                // Check if the POS props have been changed.
+                iter_prop = dvz_container_iterator(&visual->props);
+                while (iter_prop.item != NULL)
+                {
+                    prop = iter_prop.item;
+                    if (prop->prop_type == DVZ_PROP_POS &&
+                        prop->obj.request == DVZ_VISUAL_REQUEST_UPLOAD)
+                    {
+                        _enqueue_prop_changed(panel, visual, prop);
+                        prop->obj.request = DVZ_VISUAL_REQUEST_SET;
+                    }
+                    dvz_container_iter(&iter_prop);
+                }
+
+                _enqueue_visual_changed(panel, visual);
+            }
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+// Dequeue a scene update.
+static DvzSceneUpdate _scene_update_dequeue(DvzScene* scene)
+{
+    log_trace("dequeue scene update");
 
     ASSERT(scene != NULL);
     DvzFifo* fifo = &scene->update_fifo;
@@ -792,7 +1750,159 @@ static DvzSceneUpdate _scene_update_dequeue(DvzScene* scene)
 
 
 
-// Process all pending scene updates.
+/*************************************************************************************************/
+/*  Parallel scene updates                                                                       */
+/*************************************************************************************************/
+
+typedef struct DvzSceneBake DvzSceneBake;
+
+struct DvzSceneBake
+{
+    DvzSceneUpdate up;
+    DvzFifo* done; // baked visuals, to be uploaded by the thread processing the scene updates
+};
+
+
+
+static void _transform_task(void* user_data, uint32_t first, uint32_t count)
+{
+    DvzSceneUpdate* ups = (DvzSceneUpdate*)user_data;
+    ASSERT(ups != NULL);
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        if (ups[i].prop->prop_type == DVZ_PROP_POS && _is_visual_to_transform(ups[i].visual))
+            _transform_pos_prop(ups[i].panel->data_coords, ups[i].prop);
+    }
+}
+
+
+
+static void _bake_task(void* user_data)
+{
+    DvzSceneBake* bake = (DvzSceneBake*)user_data;
+    ASSERT(bake != NULL);
+    DvzPanel* panel = bake->up.panel;
+    ASSERT(panel != NULL);
+
+    dvz_visual_bake(bake->up.visual, panel->viewport, panel->data_coords, NULL);
+    dvz_fifo_enqueue(bake->done, bake);
+}
+
+
+
+// Bake the changed visuals in parallel, and upload each visual as soon as it has been baked.
+// NOTE: the GPU uploads all happen in the calling thread.
+static void _process_visuals_changed(DvzTaskPool* pool, uint32_t count, DvzSceneUpdate* ups)
+{
+    ASSERT(ups != NULL || count == 0);
+    if (dvz_task_pool_threads(pool) <= 1 || count <= 1)
+    {
+        for (uint32_t i = 0; i < count; i++)
+            _process_visual_changed(ups[i]);
+        return;
+    }
+
+    DvzSceneBake* bakes = calloc(count, sizeof(DvzSceneBake));
+    DvzFifo done = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    DvzTaskGroup group = {0};
+    DvzSceneBake* bake = NULL;
+
+    // NOTE: the bakes are submitted in windows so that the queue of baked visuals never overflows.
+    uint32_t n = 0;
+    for (uint32_t first = 0; first < count; first += n)
+    {
+        n = MIN(DVZ_MAX_FIFO_CAPACITY, count - first);
+        for (uint32_t i = first; i < first + n; i++)
+        {
+            bakes[i].up = ups[i];
+            bakes[i].done = &done;
+            dvz_task_enqueue(pool, &group, _bake_task, &bakes[i]);
+        }
+        for (uint32_t i = 0; i < n; i++)
+        {
+            bake = (DvzSceneBake*)dvz_fifo_dequeue(&done, true);
+            ASSERT(bake != NULL);
+            _process_visual_baked(bake->up);
+        }
+    }
+    dvz_task_wait(pool, &group);
+
+    dvz_fifo_destroy(&done);
+    FREE(bakes);
+}
+
+
+
+// Dequeue all pending scene updates and merge them per object. The other updates (visual added,
+// panel changed...) are processed in order, and may enqueue new updates.
+static void _collect_updates(DvzScene* scene, DvzSceneCollector* col)
+{
+    ASSERT(scene != NULL);
+    ASSERT(col != NULL);
+
+    DvzSceneUpdate up = _scene_update_dequeue(scene);
+    while (up.type != DVZ_SCENE_UPDATE_NONE)
+    {
+        switch (up.type)
+        {
+        case DVZ_SCENE_UPDATE_PROP_CHANGED:
+            _collect_prop(col, up, true);
+            break;
+        case DVZ_SCENE_UPDATE_COORDS_CHANGED:
+            _updates_append(&col->coords, up);
+            break;
+        case DVZ_SCENE_UPDATE_VISUAL_CHANGED:
+            _updates_append(&col->visuals, up);
+            break;
+        default:
+            _process_scene_update(up);
+            break;
+        }
+        up = _scene_update_dequeue(scene);
+    }
+}
+
+
+
+// Renormalize every panel whose data coords have changed, once.
+static void _collect_coords(DvzSceneCollector* col)
+{
+    ASSERT(col != NULL);
+    uint32_t n = _unique_updates(col->coords.count, col->coords.items, _cmp_update_panel);
+    for (uint32_t i = 0; i < n; i++)
+        _process_coords_changed(col->coords.items[i].panel, col);
+    col->coords.count = 0;
+}
+
+
+
+// Normalize the changed POS props in parallel, once per prop, and mark their sources and visuals
+// as changed.
+static void _collect_transforms(DvzTaskPool* pool, DvzSceneCollector* col)
+{
+    ASSERT(col != NULL);
+    DvzSceneUpdates* props = &col->props;
+    uint32_t n = _unique_updates(props->count, props->items, _cmp_update_prop);
+    dvz_task_range(pool, n, 1, _transform_task, props->items);
+
+    DvzSceneUpdate up = {0};
+    for (uint32_t i = 0; i < n; i++)
+    {
+        up = props->items[i];
+        // Mark the visual and source has needing update, for dvz_visual_bake()
+        ASSERT(up.source != NULL);
+        _source_set_changed(up.source, true);
+        _updates_append(
+            &col->visuals,
+            _scene_update(DVZ_SCENE_UPDATE_VISUAL_CHANGED, up.panel, up.visual, NULL));
+    }
+    props->count = 0;
+}
+
+
+
+// Process all pending scene updates. In each pass, the updates are merged per object until all
+// data normalizations are known, and then each changed visual is baked once, in parallel.
 static void _process_scene_updates(DvzScene* scene)
 {
     ASSERT(scene != NULL);
@@ -801,26 +1911,38 @@ static void _process_scene_updates(DvzScene* scene)
     // Find all visuals that need update, and enqueue them.
     _enqueue_all_visuals_changed(scene);
 
-    // Iteratively process the scene updates, which can trigger more visuals changes.
-    DvzSceneUpdate up = {0};
-    uint32_t i = 0;
+    ASSERT(scene->canvas != NULL);
+    DvzTaskPool* pool = scene->canvas->app->tasks;
+    DvzSceneCollector col = {0};
+    uint32_t i = 0, n = 0;
     while (dvz_fifo_size(fifo) > 0)
     {
         log_trace("scene update pass #%d", i);
 
-        // Process all pending updates.
-        up = _scene_update_dequeue(scene);
-        while (up.type != DVZ_SCENE_UPDATE_NONE)
+        // Merge the pending updates. The structural updates may enqueue new ones.
+        while (dvz_fifo_size(fifo) > 0)
         {
-            _process_scene_update(up);
-            up = _scene_update_dequeue(scene);
+            _collect_updates(scene, &col);
+            _process_boxes_changed(&col);
+            _collect_coords(&col);
+            _collect_transforms(pool, &col);
         }
 
-        // Find all visuals that need update, and enqueue them.
+        // Bake the changed visuals in parallel.
+        n = _unique_updates(col.visuals.count, col.visuals.items, _cmp_update_visual);
+        _process_visuals_changed(pool, n, col.visuals.items);
+
+        // Rebuild the outdated spatial indices in the background.
+        for (uint32_t j = 0; j < n; j++)
+            _spatial_update(col.visuals.items[j].visual, true);
+        col.visuals.count = 0;
+
+        // Find the visuals changed while processing this pass (axes...), and enqueue them.
         _enqueue_all_visuals_changed(scene);
 
         i++;
     }
+    _collector_destroy(&col);
 }
 
 
@@ -829,6 +1951,45 @@ static void _process_scene_updates(DvzScene* scene)
 /*  Scene callbacks                                                                              */
 /*************************************************************************************************/
 
+// Whether all visuals to transform in a panel have been uploaded, which is only the case
+// initially for the visuals loaded from a snapshot (see dvz_scene_load()).
+static bool _is_panel_uploaded(DvzPanel* panel)
+{
+    ASSERT(panel != NULL);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < panel->visual_count; i++)
+    {
+        if (!_is_visual_to_transform(panel->visuals[i]))
+            continue;
+        if (panel->visuals[i]->obj.request != DVZ_VISUAL_REQUEST_SET)
+            return false;
+        count++;
+    }
+    return count > 0;
+}
+
+
+
+// Set the normalization of the visuals of a panel and the axes, when the POS props of the
+// visuals have already been transformed with the current box.
+static void _restore_coords(DvzPanel* panel)
+{
+    ASSERT(panel != NULL);
+    log_debug("skip the initial normalization of the panel visuals");
+    for (uint32_t i = 0; i < panel->visual_count; i++)
+    {
+        if (_is_visual_to_transform(panel->visuals[i]))
+            _update_visual_viewport(panel, panel->visuals[i]);
+    }
+    if (panel->controller->type == DVZ_CONTROLLER_AXES_2D)
+    {
+        _axes_set(panel->controller, panel->data_coords.box);
+        _axes_refresh(panel->controller, true);
+    }
+}
+
+
+
 // At initialization, we must initialize the item count change detector.
 static void _scene_init(DvzCanvas* canvas, DvzEvent ev)
 {
@@ -843,14 +2004,22 @@ static void _scene_init(DvzCanvas* canvas, DvzEvent ev)
 
     // Go through all panels in the scene.
     DvzPanel* panel = NULL;
+    DvzBox box = {0};
     DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
     while (iter.item != NULL)
     {
         panel = iter.item;
 
-        // Trigger normalization of all visuals initially in the panel.
-        panel->data_coords.box = _compute_panel_box(panel);
-        _enqueue_coords_changed(panel);
+        // Trigger normalization of all visuals initially in the panel, unless they have been
+        // loaded from a snapshot already normalized with the same box.
+        box = _compute_panel_box(panel);
+        if (_is_panel_uploaded(panel) && memcmp(&box, &panel->data_coords.box, sizeof(box)) == 0)
+            _restore_coords(panel);
+        else
+        {
+            panel->data_coords.box = box;
+            _enqueue_coords_changed(panel);
+        }
 
         // Go through all visuals.
         for (uint32_t j = 0; j < panel->visual_count; j++)
@@ -896,6 +2065,14 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
         {
             panel = iter.item;
 
+            // Skip the panels that are collapsed, outside of the framebuffer, or outside of the
+            // current tile, without setting their viewport.
+            if (!_panel_is_visible(panel))
+            {
+                dvz_container_iter(&iter);
+                continue;
+            }
+
             // Find the panel viewport.
             viewport = dvz_panel_viewport(panel);
             dvz_cmd_viewport(cmds, img_idx, viewport.viewport);
@@ -910,6 +2087,18 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
                     if (visual->priority != priority)
                         continue;
 
+                    // The visuals of a batch are drawn with the first one.
+                    if (visual->batch != NULL)
+                    {
+                        if (visual == visual->batch->visuals[0])
+                            _draw_batch_fill(visual->batch, cmds, img_idx);
+                        continue;
+                    }
+
+                    // Skip the hidden visuals and the visuals outside of the current view.
+                    if (visual->hidden || visual->culled)
+                        continue;
+
                     dvz_visual_fill_event(
                         visual, ev.u.rf.clear_color, cmds, img_idx, viewport, NULL);
                 }
@@ -960,11 +2149,24 @@ static void _scene_frame(DvzCanvas* canvas, DvzEvent ev)
     DvzScene* scene = (DvzScene*)ev.user_data;
     ASSERT(scene != NULL);
 
+    dvz_canvas_timing_begin(canvas, DVZ_FRAME_PHASE_SCENE);
+
     // Call the controller callbacks of all panels.
     _callback_controllers(scene);
 
+    // Select the level of detail of the visuals from the new panzoom.
+    _update_lod(scene);
+
     // Process the scene updates.
     _process_scene_updates(scene);
+
+    // Cull the visuals outside of the new view.
+    _update_culling(scene);
+
+    // Group the compatible visuals in batches, or update their shared vertex buffers.
+    _update_batches(scene);
+
+    dvz_canvas_timing_end(canvas, DVZ_FRAME_PHASE_SCENE);
 }
 
 
@@ -981,6 +2183,7 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
 
     DvzInteract* interact = NULL;
     DvzController* controller = NULL;
+    DvzMVPBlock* block = NULL;
 
     // Go through all panels that need to be updated.
     DvzPanel* panel = NULL;
@@ -988,13 +2191,11 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
     while (iter.item != NULL)
     {
         panel = iter.item;
-        if (panel->controller == NULL)
-            continue;
         controller = panel->controller;
 
         // Go through all interact of the controllers.
         // TODO: only 1 interact to be supported?
-        for (uint32_t j = 0; j < controller->interact_count; j++)
+        for (uint32_t j = 0; controller != NULL && j < controller->interact_count; j++)
         {
             // Multiple interacts not yet supported.
             ASSERT(j == 0);
@@ -1003,17 +2204,25 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
             // NOTE: update MVP.time here.
             interact->mvp.time = canvas->clock.elapsed;
 
-            // NOTE: we need to update the uniform buffer at every frame
-
-            // NOTE: this is implemented with a FIFO queue even when using a single thread,
-            // which is overkill here. An optimization would be to use a function that updates the
-            // buffer region directly here, although one should make sure that GPU synchronization
-            // is properly taken care of.
-
-            dvz_upload_buffers(canvas, panel->br_mvp, 0, panel->br_mvp.size, &interact->mvp);
+            // Copy the MVP in the packed MVP array of the grid.
+            ASSERT(panel->mvp_block < grid->mvp_block_count);
+            block = &grid->mvp_blocks[panel->mvp_block];
+            memcpy(
+                (char*)block->data + panel->mvp_slot * block->stride, &interact->mvp,
+                sizeof(DvzMVP));
         }
         dvz_container_iter(&iter);
     }
+
+    // NOTE: we need to update the uniform buffer at every frame. The MVPs of all panels are
+    // packed in a few mappable buffers, so that the cost of the upload does not depend on the
+    // number of panels: a single transfer and a single memcpy per block.
+    for (uint32_t i = 0; i < grid->mvp_block_count; i++)
+    {
+        block = &grid->mvp_blocks[i];
+        if (block->count > 0)
+            dvz_upload_buffers(canvas, block->br, 0, block->count * block->stride, block->data);
+    }
 }
 
 
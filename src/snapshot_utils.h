@@ -0,0 +1,762 @@
+/*
+Binary scene snapshots, see dvz_scene_save() and dvz_scene_load().
+
+The file starts with a header, followed by fixed-size records for the panels, the visuals, and
+the arrays of the visuals (props, baked sources, group sizes). The data of the arrays comes after
+the records, starting on a page boundary, and each array is aligned on DVZ_SNAPSHOT_ALIGNMENT
+bytes. This lets the loader memory-map the file and make the prop and source arrays reference
+the mapping directly, without parsing or copying anything: the pages are only read when the baked
+buffers are uploaded to the GPU, or when the props are transformed again.
+
+The snapshot is only meant to be reloaded by the same build of the library, on the same machine:
+the data is stored with the native endianness and struct layouts.
+*/
+
+#ifndef DVZ_SNAPSHOT_UTILS_HEADER
+#define DVZ_SNAPSHOT_UTILS_HEADER
+
+#include "../include/datoviz/array.h"
+#include "../include/datoviz/scene.h"
+#include "spatial_utils.h"
+#include "visuals_utils.h"
+
+#if !OS_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_SNAPSHOT_MAGIC     "DVZSNAP"
+#define DVZ_SNAPSHOT_VERSION   1
+#define DVZ_SNAPSHOT_ALIGNMENT 64   // alignment of each array in the file
+#define DVZ_SNAPSHOT_PAGE_SIZE 4096 // alignment of the first array in the file
+
+
+
+/*************************************************************************************************/
+/*  Enums                                                                                        */
+/*************************************************************************************************/
+
+typedef enum
+{
+    DVZ_SNAPSHOT_ARRAY_NONE,
+    DVZ_SNAPSHOT_ARRAY_PROP_ORIG,  // original data of a prop
+    DVZ_SNAPSHOT_ARRAY_PROP_TRANS, // transformed data of a prop
+    DVZ_SNAPSHOT_ARRAY_SOURCE,     // baked data of a source
+    DVZ_SNAPSHOT_ARRAY_GROUPS,     // group sizes of a visual
+} DvzSnapshotArrayKind;
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+typedef struct DvzSnapshotHeader DvzSnapshotHeader;
+typedef struct DvzSnapshotPanel DvzSnapshotPanel;
+typedef struct DvzSnapshotVisual DvzSnapshotVisual;
+typedef struct DvzSnapshotArray DvzSnapshotArray;
+typedef struct DvzSnapshotWriter DvzSnapshotWriter;
+
+
+
+struct DvzSnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t n_rows, n_cols;
+    uint32_t panel_count, visual_count, array_count;
+    uint64_t data_offset; // offset of the first array, aligned on DVZ_SNAPSHOT_PAGE_SIZE
+    uint64_t file_size;
+};
+
+
+
+struct DvzSnapshotPanel
+{
+    uint32_t row, col, hspan, vspan;
+    int32_t controller; // controller type
+    int32_t flags;      // controller flags
+    int32_t transpose, transform, coords_flags;
+    int32_t prority_max;
+    double box[6]; // data coordinates box
+};
+
+
+
+struct DvzSnapshotVisual
+{
+    uint32_t panel; // index of the panel record
+    int32_t type;   // builtin visual type
+    int32_t flags, priority;
+    uint32_t baked; // whether the baked source arrays are stored
+    uint32_t hidden, transform_gpu;
+    uint32_t group_count;
+    uint32_t first_array, array_count; // array records of the visual
+};
+
+
+
+struct DvzSnapshotArray
+{
+    int32_t kind;  // DvzSnapshotArrayKind
+    int32_t type;  // prop type or source type
+    uint32_t idx;  // prop index or source index
+    int32_t dtype; // data type
+    uint64_t item_size;
+    uint32_t item_count;
+    uint32_t ndims;
+    uint32_t shape[3];
+    int32_t origin;  // source origin
+    double pos[3];   // origin of single-precision POS props
+    uint64_t offset; // offset of the data in the file
+    uint64_t size;   // size of the data, in bytes
+};
+
+
+
+struct DvzSnapshotWriter
+{
+    DvzSnapshotHeader header;
+
+    uint32_t panel_capacity, visual_capacity, array_capacity;
+    DvzSnapshotPanel* panels;
+    DvzSnapshotVisual* visuals;
+    DvzSnapshotArray* arrays;
+    const void** data; // data of each array, written after the records
+};
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+static inline uint64_t _snapshot_align(uint64_t offset, uint64_t alignment)
+{
+    ASSERT(alignment > 0);
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+
+
+// Return whether a visual can be stored in a snapshot. The visuals of the controllers (axes) are
+// recreated with the panels.
+static bool _snapshot_has_visual(DvzPanel* panel, DvzVisual* visual)
+{
+    ASSERT(panel != NULL);
+    ASSERT(visual != NULL);
+    ASSERT(panel->controller != NULL);
+
+    for (uint32_t i = 0; i < panel->controller->visual_count; i++)
+    {
+        if (panel->controller->visuals[i] == visual)
+            return false;
+    }
+    if (visual->type == DVZ_VISUAL_NONE || visual->type >= DVZ_VISUAL_COUNT)
+    {
+        log_warn("skipping custom visual in the scene snapshot");
+        return false;
+    }
+    if (visual->ring_capacity > 0)
+    {
+        log_warn("skipping visual with a circular vertex buffer in the scene snapshot");
+        return false;
+    }
+    return true;
+}
+
+
+
+// Return whether the baked sources of a visual can be stored in a snapshot. Otherwise, only the
+// props are stored and the visual is baked again after loading.
+static bool _snapshot_is_baked(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->obj.request != DVZ_VISUAL_REQUEST_SET || visual->lod != NULL)
+        return false;
+
+    // The sources baked on the GPU depend on the state of the GPU bake callback.
+    DvzSource* source = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->sources);
+    while (iter.item != NULL)
+    {
+        source = iter.item;
+        if ((source->flags & DVZ_SOURCE_FLAG_GPU_BAKE) != 0)
+            return false;
+        dvz_container_iter(&iter);
+    }
+    return true;
+}
+
+
+
+// Whether a source is stored in a snapshot. The MVP and viewport sources belong to the scene.
+static bool _snapshot_has_source(DvzSource* source)
+{
+    ASSERT(source != NULL);
+    if (source->origin != DVZ_SOURCE_ORIGIN_LIB && source->origin != DVZ_SOURCE_ORIGIN_NOBAKE)
+        return false;
+    if (source->source_type == DVZ_SOURCE_TYPE_MVP ||
+        source->source_type == DVZ_SOURCE_TYPE_VIEWPORT)
+        return false;
+    return source->arr.item_count > 0 && source->arr.data != NULL;
+}
+
+
+
+/*************************************************************************************************/
+/*  Writer                                                                                       */
+/*************************************************************************************************/
+
+static DvzSnapshotPanel* _snapshot_panel_new(DvzSnapshotWriter* writer)
+{
+    ASSERT(writer != NULL);
+    uint32_t n = writer->header.panel_count;
+    if (n >= writer->panel_capacity)
+    {
+        writer->panel_capacity = writer->panel_capacity > 0 ? 2 * writer->panel_capacity : 4;
+        REALLOC(writer->panels, writer->panel_capacity * sizeof(DvzSnapshotPanel));
+    }
+    writer->header.panel_count++;
+    memset(&writer->panels[n], 0, sizeof(DvzSnapshotPanel));
+    return &writer->panels[n];
+}
+
+
+
+static DvzSnapshotVisual* _snapshot_visual_new(DvzSnapshotWriter* writer)
+{
+    ASSERT(writer != NULL);
+    uint32_t n = writer->header.visual_count;
+    if (n >= writer->visual_capacity)
+    {
+        writer->visual_capacity = writer->visual_capacity > 0 ? 2 * writer->visual_capacity : 16;
+        REALLOC(writer->visuals, writer->visual_capacity * sizeof(DvzSnapshotVisual));
+    }
+    writer->header.visual_count++;
+    memset(&writer->visuals[n], 0, sizeof(DvzSnapshotVisual));
+    return &writer->visuals[n];
+}
+
+
+
+// Add an array record, the array data is not copied and must be alive until the file is written.
+static DvzSnapshotArray* _snapshot_array_new(
+    DvzSnapshotWriter* writer, DvzSnapshotArrayKind kind, int type, uint32_t idx, DvzArray* arr)
+{
+    ASSERT(writer != NULL);
+    ASSERT(arr != NULL);
+    uint32_t n = writer->header.array_count;
+    if (n >= writer->array_capacity)
+    {
+        writer->array_capacity = writer->array_capacity > 0 ? 2 * writer->array_capacity : 64;
+        REALLOC(writer->arrays, writer->array_capacity * sizeof(DvzSnapshotArray));
+        REALLOC(writer->data, writer->array_capacity * sizeof(void*));
+    }
+    writer->header.array_count++;
+
+    DvzSnapshotArray* rec = &writer->arrays[n];
+    memset(rec, 0, sizeof(DvzSnapshotArray));
+    rec->kind = (int32_t)kind;
+    rec->type = type;
+    rec->idx = idx;
+    rec->dtype = (int32_t)arr->dtype;
+    rec->item_size = arr->item_size;
+    rec->item_count = arr->item_count;
+    rec->ndims = arr->ndims;
+    memcpy(rec->shape, arr->shape, sizeof(rec->shape));
+    rec->size = arr->item_count * arr->item_size;
+    writer->data[n] = arr->data;
+    return rec;
+}
+
+
+
+// Add the records of a visual and of its arrays.
+static void _snapshot_visual(DvzSnapshotWriter* writer, uint32_t panel_idx, DvzVisual* visual)
+{
+    ASSERT(writer != NULL);
+    ASSERT(visual != NULL);
+
+    DvzSnapshotVisual* rec = _snapshot_visual_new(writer);
+    rec->panel = panel_idx;
+    rec->type = visual->type;
+    rec->flags = visual->flags;
+    rec->priority = visual->priority;
+    rec->baked = _snapshot_is_baked(visual);
+    rec->hidden = visual->hidden;
+    rec->transform_gpu = visual->transform_gpu;
+    rec->group_count = visual->group_count;
+    rec->first_array = writer->header.array_count;
+
+    // Props.
+    DvzSnapshotArray* arr = NULL;
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->arr_orig.item_count > 0 && prop->arr_orig.data != NULL)
+        {
+            arr = _snapshot_array_new(
+                writer, DVZ_SNAPSHOT_ARRAY_PROP_ORIG, (int)prop->prop_type, prop->prop_idx,
+                &prop->arr_orig);
+            memcpy(arr->pos, prop->origin, sizeof(dvec3));
+        }
+        if (rec->baked && prop->arr_trans.item_count > 0 && prop->arr_trans.data != NULL)
+            _snapshot_array_new(
+                writer, DVZ_SNAPSHOT_ARRAY_PROP_TRANS, (int)prop->prop_type, prop->prop_idx,
+                &prop->arr_trans);
+        dvz_container_iter(&iter);
+    }
+
+    // Baked sources.
+    DvzSource* source = NULL;
+    iter = dvz_container_iterator(&visual->sources);
+    while (rec->baked && iter.item != NULL)
+    {
+        source = iter.item;
+        if (_snapshot_has_source(source))
+        {
+            arr = _snapshot_array_new(
+                writer, DVZ_SNAPSHOT_ARRAY_SOURCE, (int)source->source_type, source->source_idx,
+                &source->arr);
+            arr->origin = (int32_t)source->origin;
+        }
+        dvz_container_iter(&iter);
+    }
+
+    // Group sizes.
+    if (visual->group_count > 0)
+    {
+        DvzArray groups = dvz_array_wrap(visual->group_count, DVZ_DTYPE_UINT, visual->group_sizes);
+        _snapshot_array_new(writer, DVZ_SNAPSHOT_ARRAY_GROUPS, 0, 0, &groups);
+    }
+
+    // NOTE: the pointer may have been invalidated by the reallocation of the records.
+    rec = &writer->visuals[writer->header.visual_count - 1];
+    rec->array_count = writer->header.array_count - rec->first_array;
+}
+
+
+
+static int _snapshot_write_padding(FILE* fp, uint64_t size)
+{
+    ASSERT(fp != NULL);
+    static const char zeros[DVZ_SNAPSHOT_ALIGNMENT] = {0};
+    uint64_t n = 0;
+    while (size > 0)
+    {
+        n = MIN(size, (uint64_t)DVZ_SNAPSHOT_ALIGNMENT);
+        if (fwrite(zeros, 1, n, fp) != n)
+            return 1;
+        size -= n;
+    }
+    return 0;
+}
+
+
+
+// Compute the layout of the file and write it.
+static int _snapshot_write(DvzSnapshotWriter* writer, const char* path)
+{
+    ASSERT(writer != NULL);
+    ASSERT(path != NULL);
+    DvzSnapshotHeader* header = &writer->header;
+
+    // Layout.
+    uint64_t offset = sizeof(DvzSnapshotHeader) +                         //
+                      header->panel_count * sizeof(DvzSnapshotPanel) +   //
+                      header->visual_count * sizeof(DvzSnapshotVisual) + //
+                      header->array_count * sizeof(DvzSnapshotArray);
+    offset = _snapshot_align(offset, DVZ_SNAPSHOT_PAGE_SIZE);
+    header->data_offset = offset;
+    for (uint32_t i = 0; i < header->array_count; i++)
+    {
+        writer->arrays[i].offset = offset;
+        offset = _snapshot_align(offset + writer->arrays[i].size, DVZ_SNAPSHOT_ALIGNMENT);
+    }
+    header->file_size = offset;
+
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL)
+    {
+        log_error("unable to open %s for writing", path);
+        return 1;
+    }
+
+    // Records.
+    int res = 0;
+    res |= fwrite(header, sizeof(DvzSnapshotHeader), 1, fp) != 1;
+    if (header->panel_count > 0)
+        res |= fwrite(writer->panels, sizeof(DvzSnapshotPanel), header->panel_count, fp) !=
+               header->panel_count;
+    if (header->visual_count > 0)
+        res |= fwrite(writer->visuals, sizeof(DvzSnapshotVisual), header->visual_count, fp) !=
+               header->visual_count;
+    if (header->array_count > 0)
+        res |= fwrite(writer->arrays, sizeof(DvzSnapshotArray), header->array_count, fp) !=
+               header->array_count;
+
+    // Array data.
+    uint64_t pos = (uint64_t)ftell(fp);
+    DvzSnapshotArray* arr = NULL;
+    for (uint32_t i = 0; i < header->array_count && res == 0; i++)
+    {
+        arr = &writer->arrays[i];
+        ASSERT(arr->offset >= pos);
+        res |= _snapshot_write_padding(fp, arr->offset - pos);
+        res |= fwrite(writer->data[i], 1, arr->size, fp) != arr->size;
+        pos = arr->offset + arr->size;
+    }
+    if (res == 0)
+        res |= _snapshot_write_padding(fp, header->file_size - pos);
+
+    fclose(fp);
+    if (res != 0)
+        log_error("error while writing the scene snapshot %s", path);
+    return res;
+}
+
+
+
+static void _snapshot_writer_destroy(DvzSnapshotWriter* writer)
+{
+    ASSERT(writer != NULL);
+    FREE(writer->panels);
+    FREE(writer->visuals);
+    FREE(writer->arrays);
+    FREE(writer->data);
+}
+
+
+
+/*************************************************************************************************/
+/*  Reader                                                                                       */
+/*************************************************************************************************/
+
+static inline const DvzSnapshotPanel* _snapshot_panels(const void* base)
+{
+    return (const DvzSnapshotPanel*)((const DvzSnapshotHeader*)base + 1);
+}
+
+
+
+static inline const DvzSnapshotVisual* _snapshot_visuals(const void* base)
+{
+    const DvzSnapshotHeader* header = (const DvzSnapshotHeader*)base;
+    return (const DvzSnapshotVisual*)(_snapshot_panels(base) + header->panel_count);
+}
+
+
+
+static inline const DvzSnapshotArray* _snapshot_arrays(const void* base)
+{
+    const DvzSnapshotHeader* header = (const DvzSnapshotHeader*)base;
+    return (const DvzSnapshotArray*)(_snapshot_visuals(base) + header->visual_count);
+}
+
+
+
+// Map a snapshot file in memory. The mapping is private and writable, so that the arrays
+// referencing it may be modified in place without changing the file.
+static void* _snapshot_map(const char* path, VkDeviceSize* size)
+{
+    ASSERT(path != NULL);
+    ASSERT(size != NULL);
+#if OS_WIN32
+    // NOTE: no memory mapping on Windows yet, the file is read in memory.
+    size_t length = 0;
+    void* data = dvz_read_file(path, &length);
+    *size = length;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        log_error("unable to open %s", path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        log_error("unable to get the size of %s", path);
+        close(fd);
+        return NULL;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        log_error("unable to map %s in memory", path);
+        return NULL;
+    }
+    *size = (VkDeviceSize)st.st_size;
+    return data;
+#endif
+}
+
+
+
+static void _snapshot_unmap(void* data, VkDeviceSize size)
+{
+    if (data == NULL)
+        return;
+#if OS_WIN32
+    FREE(data);
+#else
+    munmap(data, (size_t)size);
+#endif
+}
+
+
+
+// Check the header and the records of a snapshot mapped in memory.
+static bool _snapshot_check(const void* data, VkDeviceSize size)
+{
+    ASSERT(data != NULL);
+    const DvzSnapshotHeader* header = (const DvzSnapshotHeader*)data;
+    if (size < sizeof(DvzSnapshotHeader) ||
+        memcmp(header->magic, DVZ_SNAPSHOT_MAGIC, sizeof(DVZ_SNAPSHOT_MAGIC)) != 0)
+    {
+        log_error("not a scene snapshot");
+        return false;
+    }
+    if (header->version != DVZ_SNAPSHOT_VERSION)
+    {
+        log_error("unsupported scene snapshot version %d", header->version);
+        return false;
+    }
+    uint64_t records = sizeof(DvzSnapshotHeader) +                                   //
+                       (uint64_t)header->panel_count * sizeof(DvzSnapshotPanel) +   //
+                       (uint64_t)header->visual_count * sizeof(DvzSnapshotVisual) + //
+                       (uint64_t)header->array_count * sizeof(DvzSnapshotArray);
+    if (header->file_size != size || records > header->data_offset || header->data_offset > size)
+    {
+        log_error("truncated or corrupted scene snapshot");
+        return false;
+    }
+    if (header->n_rows == 0 || header->n_rows > DVZ_GRID_MAX_ROWS || header->n_cols == 0 ||
+        header->n_cols > DVZ_GRID_MAX_COLS)
+    {
+        log_error(
+            "invalid grid of %dx%d panels in the scene snapshot", header->n_rows, header->n_cols);
+        return false;
+    }
+
+    // Each panel must fit in the grid, with a distinct cell and a builtin controller.
+    const DvzSnapshotPanel* panels = _snapshot_panels(data);
+    const DvzSnapshotPanel* panel = NULL;
+    for (uint32_t i = 0; i < header->panel_count; i++)
+    {
+        panel = &panels[i];
+        bool valid = panel->row < header->n_rows && panel->col < header->n_cols &&
+                     panel->hspan >= 1 && panel->hspan <= header->n_cols - panel->col &&
+                     panel->vspan >= 1 && panel->vspan <= header->n_rows - panel->row &&
+                     panel->controller >= DVZ_CONTROLLER_NONE &&
+                     panel->controller <= DVZ_CONTROLLER_CAMERA && panel->prority_max >= 0 &&
+                     panel->prority_max <= DVZ_MAX_VISUAL_PRIORITY;
+        for (uint32_t j = 0; j < i && valid; j++)
+            valid = panels[j].row != panel->row || panels[j].col != panel->col;
+        if (!valid)
+        {
+            log_error("invalid panel record #%d in the scene snapshot", i);
+            return false;
+        }
+    }
+
+    const DvzSnapshotVisual* visuals = _snapshot_visuals(data);
+    for (uint32_t i = 0; i < header->visual_count; i++)
+    {
+        if (visuals[i].panel >= header->panel_count ||
+            (uint64_t)visuals[i].first_array + visuals[i].array_count > header->array_count ||
+            visuals[i].type <= DVZ_VISUAL_NONE || visuals[i].type >= DVZ_VISUAL_COUNT ||
+            visuals[i].group_count > DVZ_MAX_VISUAL_GROUPS)
+        {
+            log_error("invalid visual record #%d in the scene snapshot", i);
+            return false;
+        }
+    }
+
+    const DvzSnapshotArray* arrays = _snapshot_arrays(data);
+    const DvzSnapshotArray* arr = NULL;
+    for (uint32_t i = 0; i < header->array_count; i++)
+    {
+        arr = &arrays[i];
+        if (arr->offset < header->data_offset || arr->offset > size ||
+            arr->size > size - arr->offset || arr->item_count == 0 || arr->item_size == 0 ||
+            arr->size / arr->item_size != arr->item_count ||
+            arr->size % arr->item_size != 0 || arr->ndims > 3)
+        {
+            log_error("invalid array record #%d in the scene snapshot", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+// Make an array reference the data of an array record in the mapping.
+static void _snapshot_borrow(DvzArray* arr, const DvzSnapshotArray* rec, void* base)
+{
+    ASSERT(arr != NULL);
+    ASSERT(rec != NULL);
+    ASSERT(base != NULL);
+    ASSERT(rec->item_count > 0);
+
+    void* data = (char*)base + rec->offset;
+    if (!arr->is_borrowed)
+        FREE(arr->data);
+    arr->data = data;
+    arr->item_count = rec->item_count;
+    arr->buffer_size = rec->size;
+    arr->is_borrowed = true;
+    arr->ndims = rec->ndims;
+    memcpy(arr->shape, rec->shape, sizeof(arr->shape));
+}
+
+
+
+// Whether the arrays of the record match the props and sources of the visual.
+static bool _snapshot_matches(
+    DvzVisual* visual, const DvzSnapshotArray* arrays, uint32_t count, uint32_t group_count)
+{
+    ASSERT(visual != NULL);
+    const DvzSnapshotArray* rec = NULL;
+    DvzProp* prop = NULL;
+    DvzSource* source = NULL;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        rec = &arrays[i];
+        switch (rec->kind)
+        {
+        case DVZ_SNAPSHOT_ARRAY_PROP_ORIG:
+            prop = dvz_prop_get(visual, (DvzPropType)rec->type, rec->idx);
+            if (prop == NULL || prop->dtype != (DvzDataType)rec->dtype ||
+                _get_dtype_size(prop->dtype) != rec->item_size)
+                return false;
+            break;
+        case DVZ_SNAPSHOT_ARRAY_PROP_TRANS:
+            prop = dvz_prop_get(visual, (DvzPropType)rec->type, rec->idx);
+            if (prop == NULL || rec->dtype <= DVZ_DTYPE_CUSTOM ||
+                _get_dtype_size((DvzDataType)rec->dtype) != rec->item_size)
+                return false;
+            break;
+        case DVZ_SNAPSHOT_ARRAY_SOURCE:
+            source = dvz_source_get(visual, (DvzSourceType)rec->type, rec->idx);
+            if (source == NULL || source->arr.item_size != rec->item_size ||
+                (rec->origin != DVZ_SOURCE_ORIGIN_LIB && rec->origin != DVZ_SOURCE_ORIGIN_NOBAKE))
+                return false;
+            break;
+        case DVZ_SNAPSHOT_ARRAY_GROUPS:
+            if (rec->item_count != group_count || rec->item_size != sizeof(uint32_t))
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+// Restore a visual from its record. The props and the baked sources reference the mapping.
+static void _snapshot_restore(DvzVisual* visual, const DvzSnapshotVisual* vrec, void* base)
+{
+    ASSERT(visual != NULL);
+    ASSERT(vrec != NULL);
+    ASSERT(base != NULL);
+
+    const DvzSnapshotArray* arrays = _snapshot_arrays(base) + vrec->first_array;
+    if (!_snapshot_matches(visual, arrays, vrec->array_count, vrec->group_count))
+    {
+        log_warn("the snapshot of visual %d does not match the visual, skipping", vrec->type);
+        return;
+    }
+
+    visual->priority = vrec->priority;
+    visual->hidden = vrec->hidden;
+    visual->transform_gpu = vrec->transform_gpu;
+    ASSERT(vrec->group_count <= DVZ_MAX_VISUAL_GROUPS);
+    visual->group_count = vrec->group_count;
+    bool baked = vrec->baked;
+
+    const DvzSnapshotArray* rec = NULL;
+    DvzProp* prop = NULL;
+    DvzSource* source = NULL;
+    for (uint32_t i = 0; i < vrec->array_count; i++)
+    {
+        rec = &arrays[i];
+        switch (rec->kind)
+        {
+
+        case DVZ_SNAPSHOT_ARRAY_PROP_ORIG:
+            prop = dvz_prop_get(visual, (DvzPropType)rec->type, rec->idx);
+            dvz_array_destroy(&prop->arr_orig);
+            prop->arr_orig = dvz_array_borrow(
+                rec->item_count, prop->dtype, (char*)base + rec->offset);
+            memcpy(prop->origin, rec->pos, sizeof(dvec3));
+            prop->bounds_valid = false;
+            if (baked)
+            {
+                _range_clear(&prop->dirty);
+                prop->obj.request = DVZ_VISUAL_REQUEST_SET;
+            }
+            else
+            {
+                _range_all(&prop->dirty);
+                prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+            }
+            if (prop->source != NULL)
+            {
+                prop->source->origin = DVZ_SOURCE_ORIGIN_LIB;
+                if (!baked)
+                    _source_set_changed(prop->source, true);
+            }
+            break;
+
+        case DVZ_SNAPSHOT_ARRAY_PROP_TRANS:
+            prop = dvz_prop_get(visual, (DvzPropType)rec->type, rec->idx);
+            dvz_array_destroy(&prop->arr_trans);
+            prop->arr_trans = dvz_array_borrow(
+                rec->item_count, (DvzDataType)rec->dtype, (char*)base + rec->offset);
+            break;
+
+        case DVZ_SNAPSHOT_ARRAY_SOURCE:
+            source = dvz_source_get(visual, (DvzSourceType)rec->type, rec->idx);
+            _snapshot_borrow(&source->arr, rec, base);
+            source->origin = (DvzSourceOrigin)rec->origin;
+            _range_all(&source->dirty);
+            _source_set_changed(source, true);
+            break;
+
+        case DVZ_SNAPSHOT_ARRAY_GROUPS:
+            memcpy(visual->group_sizes, (char*)base + rec->offset, rec->size);
+            break;
+
+        default:
+            break;
+        }
+    }
+    FREE(visual->group_boxes);
+    _spatial_invalidate(visual);
+
+    // Stream the baked sources to the GPU, through the staging buffer for the device-local
+    // buffers. The mapping stays alive until the transfers have been processed.
+    if (baked)
+        dvz_visual_upload(visual);
+}
+
+
+
+#endif
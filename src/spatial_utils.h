@@ -0,0 +1,569 @@
+/*
+Spatial index of the positions of a visual, for hover and selection queries on the CPU.
+
+The index is a uniform grid over the x and y coordinates of the POS prop #0, in data coordinates,
+in compressed form: the item indices are sorted by cell, and each cell refers to a contiguous
+range of the sorted items. The items appended after the grid has been built are scanned linearly
+until the next build. The positions are copied in the index, so that the grid can be built in a
+worker thread of the application task pool while the prop arrays keep changing.
+*/
+
+#ifndef DVZ_SPATIAL_UTILS_HEADER
+#define DVZ_SPATIAL_UTILS_HEADER
+
+#include "../include/datoviz/array.h"
+#include "../include/datoviz/canvas.h"
+#include "../include/datoviz/visuals.h"
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_SPATIAL_ITEMS_PER_CELL 4         // average number of items per non-empty grid cell
+#define DVZ_SPATIAL_MAX_CELLS      (1 << 22) // maximum number of grid cells
+#define DVZ_SPATIAL_MIN_PENDING    1024      // items scanned linearly before rebuilding the grid
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+static DvzTaskPool* _spatial_pool(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->canvas == NULL || visual->canvas->app == NULL)
+        return NULL;
+    return visual->canvas->app->tasks;
+}
+
+
+
+// Wait until the grid being built in the background, if any, is ready.
+static void _spatial_wait(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzSpatialIndex* index = visual->spatial;
+    if (index == NULL || !index->building)
+        return;
+    dvz_task_wait(_spatial_pool(visual), &index->group);
+    index->building = false;
+}
+
+
+
+static void _spatial_create(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->spatial != NULL)
+        return;
+    visual->spatial = (DvzSpatialIndex*)calloc(1, sizeof(DvzSpatialIndex));
+    // The positions are copied from the prop at the first build.
+    visual->spatial->stale = true;
+}
+
+
+
+static void _spatial_destroy(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzSpatialIndex* index = visual->spatial;
+    if (index == NULL)
+        return;
+    _spatial_wait(visual);
+    FREE(index->pos);
+    FREE(index->cell_first);
+    FREE(index->items);
+    FREE(visual->spatial);
+}
+
+
+
+static void _spatial_reserve(DvzSpatialIndex* index, uint32_t count)
+{
+    ASSERT(index != NULL);
+    if (count <= index->item_capacity)
+        return;
+    index->item_capacity = MAX(count, 2 * index->item_capacity);
+    REALLOC(index->pos, index->item_capacity * sizeof(dvec2));
+}
+
+
+
+// Copy the x and y coordinates of some items of the POS prop, in data coordinates.
+static void _spatial_copy(DvzSpatialIndex* index, DvzProp* prop, uint32_t first, uint32_t count)
+{
+    ASSERT(index != NULL);
+    ASSERT(prop != NULL);
+    ASSERT(first + count <= prop->arr_orig.item_count);
+    _spatial_reserve(index, first + count);
+
+    DvzArray* arr = &prop->arr_orig;
+    if (arr->dtype == DVZ_DTYPE_DVEC3)
+    {
+        const dvec3* pos = (const dvec3*)arr->data;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            index->pos[i][0] = pos[i][0];
+            index->pos[i][1] = pos[i][1];
+        }
+    }
+    else if (arr->dtype == DVZ_DTYPE_VEC3)
+    {
+        // Single-precision positions are relative to the prop origin.
+        const vec3* pos = (const vec3*)arr->data;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            index->pos[i][0] = prop->origin[0] + pos[i][0];
+            index->pos[i][1] = prop->origin[1] + pos[i][1];
+        }
+    }
+    else
+    {
+        log_warn("spatial index not supported for POS dtype %d", arr->dtype);
+        count = 0;
+        first = 0;
+    }
+    index->item_count = first + count;
+}
+
+
+
+/*************************************************************************************************/
+/*  Updates                                                                                      */
+/*************************************************************************************************/
+
+// Mark the positions of the index as outdated, they will be copied again before the next build.
+static void _spatial_invalidate(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->spatial != NULL)
+        visual->spatial->stale = true;
+}
+
+
+
+// Called when the items [first, first + count) of the POS prop #0 have been set, the prop
+// previously had old_count items. Appended items are added to the index without rebuilding it.
+static void _spatial_data(
+    DvzVisual* visual, DvzProp* prop, uint32_t old_count, uint32_t first, uint32_t count)
+{
+    ASSERT(visual != NULL);
+    ASSERT(prop != NULL);
+    DvzSpatialIndex* index = visual->spatial;
+    if (index == NULL || prop->prop_type != DVZ_PROP_POS || prop->prop_idx != 0)
+        return;
+
+    if (index->stale || first != old_count || old_count != index->item_count ||
+        prop->arr_orig.item_count != first + count)
+    {
+        index->stale = true;
+        return;
+    }
+    _spatial_wait(visual);
+    _spatial_copy(index, prop, first, count);
+}
+
+
+
+static bool _spatial_needs_build(DvzSpatialIndex* index)
+{
+    ASSERT(index != NULL);
+    ASSERT(index->item_count >= index->grid_count);
+    uint32_t pending = index->item_count - index->grid_count;
+    return index->stale || pending > MAX(DVZ_SPATIAL_MIN_PENDING, index->grid_count / 4);
+}
+
+
+
+/*************************************************************************************************/
+/*  Grid                                                                                         */
+/*************************************************************************************************/
+
+static inline bool _spatial_valid(const dvec2 p)
+{
+    return !isnan(p[0]) && !isnan(p[1]) && !isinf(p[0]) && !isinf(p[1]);
+}
+
+
+
+static inline uint32_t _spatial_coord(DvzSpatialIndex* index, uint32_t dim, double value)
+{
+    ASSERT(index != NULL);
+    ASSERT(dim < 2);
+    double size = index->box.p1[dim] - index->box.p0[dim];
+    double x = size > 0 ? (value - index->box.p0[dim]) / size * index->shape[dim] : 0;
+    if (x <= 0)
+        return 0;
+    return (uint32_t)MIN(x, index->shape[dim] - 1);
+}
+
+
+
+static inline uint32_t _spatial_cell(DvzSpatialIndex* index, const dvec2 p)
+{
+    ASSERT(index != NULL);
+    return _spatial_coord(index, 1, p[1]) * index->shape[0] + _spatial_coord(index, 0, p[0]);
+}
+
+
+
+// Build the grid over all items of the index (counting sort of the item indices by cell).
+static void _spatial_build(DvzSpatialIndex* index)
+{
+    ASSERT(index != NULL);
+    uint32_t n = index->item_count;
+    FREE(index->cell_first);
+    FREE(index->items);
+    index->grid_count = 0;
+    index->shape[0] = index->shape[1] = 0;
+    if (n == 0)
+        return;
+
+    // Bounds of the valid positions.
+    DvzBox box = DVZ_BOX_INF;
+    uint32_t valid = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (!_spatial_valid(index->pos[i]))
+            continue;
+        for (uint32_t k = 0; k < 2; k++)
+        {
+            box.p0[k] = MIN(box.p0[k], index->pos[i][k]);
+            box.p1[k] = MAX(box.p1[k], index->pos[i][k]);
+        }
+        valid++;
+    }
+    index->grid_count = n;
+    if (valid == 0)
+        return;
+    box.p0[2] = box.p1[2] = 0;
+    index->box = box;
+
+    // Grid shape, with roughly square cells.
+    double w = box.p1[0] - box.p0[0];
+    double h = box.p1[1] - box.p0[1];
+    double cells = CLIP(valid / (double)DVZ_SPATIAL_ITEMS_PER_CELL, 1, DVZ_SPATIAL_MAX_CELLS);
+    double nx = 1, ny = 1;
+    if (w > 0 && h > 0)
+    {
+        nx = sqrt(cells * w / h);
+        ny = cells / MAX(nx, 1);
+    }
+    else if (w > 0)
+        nx = cells;
+    else if (h > 0)
+        ny = cells;
+    index->shape[0] = (uint32_t)CLIP(nx, 1, DVZ_SPATIAL_MAX_CELLS);
+    index->shape[1] = (uint32_t)CLIP(ny, 1, DVZ_SPATIAL_MAX_CELLS / index->shape[0]);
+    uint32_t cell_count = index->shape[0] * index->shape[1];
+
+    // Counting sort of the valid items by cell.
+    index->cell_first = (uint32_t*)calloc(cell_count + 1, sizeof(uint32_t));
+    index->items = (uint32_t*)calloc(valid, sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (_spatial_valid(index->pos[i]))
+            index->cell_first[_spatial_cell(index, index->pos[i]) + 1]++;
+    }
+    for (uint32_t c = 0; c < cell_count; c++)
+        index->cell_first[c + 1] += index->cell_first[c];
+    uint32_t* next = (uint32_t*)calloc(cell_count, sizeof(uint32_t));
+    memcpy(next, index->cell_first, cell_count * sizeof(uint32_t));
+    uint32_t cell = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (!_spatial_valid(index->pos[i]))
+            continue;
+        cell = _spatial_cell(index, index->pos[i]);
+        index->items[next[cell]++] = i;
+    }
+    FREE(next);
+    log_debug(
+        "built %dx%d spatial index grid for %d items", index->shape[0], index->shape[1], n);
+}
+
+
+
+static void _spatial_task(void* user_data)
+{
+    DvzSpatialIndex* index = (DvzSpatialIndex*)user_data;
+    ASSERT(index != NULL);
+    _spatial_build(index);
+}
+
+
+
+// Copy the positions again if needed and rebuild the grid, either in the background or
+// immediately. The grid is kept as long as not too many items have been appended.
+static void _spatial_update(DvzVisual* visual, bool background)
+{
+    ASSERT(visual != NULL);
+    DvzSpatialIndex* index = visual->spatial;
+    if (index == NULL)
+        return;
+    _spatial_wait(visual);
+    if (!_spatial_needs_build(index))
+        return;
+
+    if (index->stale)
+    {
+        DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+        index->item_count = 0;
+        if (prop != NULL && prop->arr_orig.data != NULL)
+            _spatial_copy(index, prop, 0, prop->arr_orig.item_count);
+        index->grid_count = 0;
+        index->stale = false;
+    }
+
+    DvzTaskPool* pool = _spatial_pool(visual);
+    if (background && dvz_task_pool_threads(pool) > 1)
+    {
+        index->building = true;
+        dvz_task_enqueue(pool, &index->group, _spatial_task, index);
+    }
+    else
+        _spatial_build(index);
+}
+
+
+
+/*************************************************************************************************/
+/*  Queries                                                                                      */
+/*************************************************************************************************/
+
+typedef struct DvzSpatialSelection DvzSpatialSelection;
+
+struct DvzSpatialSelection
+{
+    uint32_t count, capacity;
+    uint32_t* items;
+};
+
+
+
+static void _selection_append(DvzSpatialSelection* sel, uint32_t item)
+{
+    ASSERT(sel != NULL);
+    if (sel->count == sel->capacity)
+    {
+        sel->capacity = MAX(64, 2 * sel->capacity);
+        REALLOC(sel->items, sel->capacity * sizeof(uint32_t));
+    }
+    sel->items[sel->count++] = item;
+}
+
+
+
+static int _cmp_item(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return x < y ? -1 : (x > y ? +1 : 0);
+}
+
+
+
+// Copy the selected items in increasing order to a DVZ_DTYPE_UINT array, and free them.
+static uint32_t _selection_output(DvzSpatialSelection* sel, DvzArray* out)
+{
+    ASSERT(sel != NULL);
+    ASSERT(out != NULL);
+    if (out->item_size == 0)
+        *out = dvz_array(0, DVZ_DTYPE_UINT);
+    ASSERT(out->dtype == DVZ_DTYPE_UINT);
+
+    uint32_t count = sel->count;
+    if (count > 0)
+    {
+        qsort(sel->items, count, sizeof(uint32_t), _cmp_item);
+        dvz_array_resize(out, count);
+        memcpy(out->data, sel->items, count * sizeof(uint32_t));
+    }
+    else
+        out->item_count = 0;
+    FREE(sel->items);
+    return count;
+}
+
+
+
+// Distance between two points in data coordinates, where scale converts the x and y data
+// offsets to the units of the query.
+static inline double _spatial_dist(const dvec2 a, const dvec2 b, const dvec2 scale)
+{
+    double dx = (a[0] - b[0]) * scale[0];
+    double dy = (a[1] - b[1]) * scale[1];
+    return sqrt(dx * dx + dy * dy);
+}
+
+
+
+static inline void _spatial_nearest_item(
+    DvzSpatialIndex* index, uint32_t i, const dvec2 q, const dvec2 scale, double* best,
+    int64_t* best_item)
+{
+    double d = _spatial_dist(index->pos[i], q, scale);
+    if (d < *best || (d == *best && (int64_t)i < *best_item))
+    {
+        *best = d;
+        *best_item = i;
+    }
+}
+
+
+
+static inline void _spatial_nearest_cell(
+    DvzSpatialIndex* index, uint32_t cell, const dvec2 q, const dvec2 scale, double* best,
+    int64_t* best_item)
+{
+    for (uint32_t k = index->cell_first[cell]; k < index->cell_first[cell + 1]; k++)
+        _spatial_nearest_item(index, index->items[k], q, scale, best, best_item);
+}
+
+
+
+// Nearest item within a radius. The cells are visited in rings of increasing size around the
+// cell of the query point, until the ring is farther than the nearest item found so far.
+static int64_t
+_spatial_nearest(DvzSpatialIndex* index, const dvec2 q, const dvec2 scale, double radius)
+{
+    ASSERT(index != NULL);
+    double best = radius;
+    int64_t best_item = -1;
+
+    // Items appended after the grid was built.
+    for (uint32_t i = index->grid_count; i < index->item_count; i++)
+    {
+        if (_spatial_valid(index->pos[i]))
+            _spatial_nearest_item(index, i, q, scale, &best, &best_item);
+    }
+    if (index->cell_first == NULL)
+        return best_item;
+
+    int64_t nx = index->shape[0], ny = index->shape[1];
+    int64_t cx = _spatial_coord(index, 0, q[0]), cy = _spatial_coord(index, 1, q[1]);
+    double cw = (index->box.p1[0] - index->box.p0[0]) / nx;
+    double ch = (index->box.p1[1] - index->box.p0[1]) / ny;
+    double x0 = 0, x1 = 0, y0 = 0, y1 = 0, lb = 0;
+    for (int64_t r = 0;; r++)
+    {
+        // Lower bound of the distance to the items of the ring: the distance to the border of the
+        // cells visited so far, if the query point is inside them.
+        if (r > 0)
+        {
+            x0 = cx - r + 1 > 0 ? index->box.p0[0] + (cx - r + 1) * cw : -INFINITY;
+            x1 = cx + r < nx ? index->box.p0[0] + (cx + r) * cw : +INFINITY;
+            y0 = cy - r + 1 > 0 ? index->box.p0[1] + (cy - r + 1) * ch : -INFINITY;
+            y1 = cy + r < ny ? index->box.p0[1] + (cy + r) * ch : +INFINITY;
+            lb = 0;
+            if (x0 <= q[0] && q[0] <= x1 && y0 <= q[1] && q[1] <= y1)
+            {
+                lb = MIN((q[0] - x0) * scale[0], (x1 - q[0]) * scale[0]);
+                lb = MIN(lb, MIN((q[1] - y0) * scale[1], (y1 - q[1]) * scale[1]));
+            }
+            if (lb > best)
+                break;
+        }
+
+        // Visit the cells of the ring: the top and bottom rows, then the left and right columns.
+        for (int64_t j = cy - r; j <= cy + r; j += MAX(1, 2 * r))
+        {
+            if (j < 0 || j >= ny)
+                continue;
+            for (int64_t i = MAX(0, cx - r); i <= MIN(nx - 1, cx + r); i++)
+                _spatial_nearest_cell(index, (uint32_t)(j * nx + i), q, scale, &best, &best_item);
+        }
+        for (int64_t i = cx - r; r > 0 && i <= cx + r; i += 2 * r)
+        {
+            if (i < 0 || i >= nx)
+                continue;
+            for (int64_t j = MAX(0, cy - r + 1); j <= MIN(ny - 1, cy + r - 1); j++)
+                _spatial_nearest_cell(index, (uint32_t)(j * nx + i), q, scale, &best, &best_item);
+        }
+
+        // Stop when the ring covers the whole grid.
+        if (cx - r <= 0 && cx + r >= nx - 1 && cy - r <= 0 && cy + r >= ny - 1)
+            break;
+    }
+    return best_item;
+}
+
+
+
+// Even-odd rule.
+static bool _point_in_polygon(const dvec2 p, uint32_t count, dvec2* poly)
+{
+    ASSERT(poly != NULL);
+    bool inside = false;
+    for (uint32_t i = 0, j = count - 1; i < count; j = i++)
+    {
+        if ((poly[i][1] > p[1]) != (poly[j][1] > p[1]) &&
+            p[0] < (poly[j][0] - poly[i][0]) * (p[1] - poly[i][1]) / (poly[j][1] - poly[i][1]) +
+                       poly[i][0])
+            inside = !inside;
+    }
+    return inside;
+}
+
+
+
+// Items inside a polygon in data coordinates: the items of the cells overlapping the polygon
+// bounding box are tested against the polygon.
+static void _spatial_polygon(
+    DvzSpatialIndex* index, uint32_t count, dvec2* poly, DvzSpatialSelection* sel)
+{
+    ASSERT(index != NULL);
+    ASSERT(poly != NULL);
+    ASSERT(sel != NULL);
+    if (count < 3)
+        return;
+
+    DvzBox box = DVZ_BOX_INF;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t k = 0; k < 2; k++)
+        {
+            box.p0[k] = MIN(box.p0[k], poly[i][k]);
+            box.p1[k] = MAX(box.p1[k], poly[i][k]);
+        }
+    }
+
+    const double* p = NULL;
+    for (uint32_t i = index->grid_count; i < index->item_count; i++)
+    {
+        p = index->pos[i];
+        if (_spatial_valid(p) && p[0] >= box.p0[0] && p[0] <= box.p1[0] && p[1] >= box.p0[1] &&
+            p[1] <= box.p1[1] && _point_in_polygon(p, count, poly))
+            _selection_append(sel, i);
+    }
+    if (index->cell_first == NULL || box.p1[0] < index->box.p0[0] ||
+        box.p0[0] > index->box.p1[0] || box.p1[1] < index->box.p0[1] ||
+        box.p0[1] > index->box.p1[1])
+        return;
+
+    uint32_t i0 = _spatial_coord(index, 0, box.p0[0]), i1 = _spatial_coord(index, 0, box.p1[0]);
+    uint32_t j0 = _spatial_coord(index, 1, box.p0[1]), j1 = _spatial_coord(index, 1, box.p1[1]);
+    uint32_t cell = 0, item = 0;
+    for (uint32_t j = j0; j <= j1; j++)
+    {
+        for (uint32_t i = i0; i <= i1; i++)
+        {
+            cell = j * index->shape[0] + i;
+            for (uint32_t k = index->cell_first[cell]; k < index->cell_first[cell + 1]; k++)
+            {
+                item = index->items[k];
+                p = index->pos[item];
+                if (p[0] >= box.p0[0] && p[0] <= box.p1[0] && p[1] >= box.p0[1] &&
+                    p[1] <= box.p1[1] && _point_in_polygon(p, count, poly))
+                    _selection_append(sel, item);
+            }
+        }
+    }
+}
+
+
+
+#endif
@@ -38,6 +38,7 @@ https://github.com/quantenschaum/ctplot/blob/master/ctplot/ticks.py
 #define MAX_GLYPHS_PER_TICK 24
 #define MAX_LABELS          256
 #define TARGET_DENSITY      .2
+#define CACHE_QUANTUM       256 // quantization of the cache keys, per octave and per span
 
 
 
@@ -311,6 +312,9 @@ static void make_labels(DvzAxesTicks* ticks, DvzAxesContext* ctx, bool extended)
     for (uint32_t i = 0; i < ticks->value_count; i++)
     {
         x = x0 + i * ticks->lstep;
+        // NOTE: shifted ticks may not hit zero exactly, which would be formatted as -0.0.
+        if (fabs(x) < 1e-9 * ticks->lstep)
+            x = 0;
         ticks->values[i] = x;
         _tick_label(x, tick_format, &ticks->labels[i * MAX_GLYPHS_PER_TICK]);
     }
@@ -701,4 +705,149 @@ static void dvz_ticks_destroy(DvzAxesTicks* ticks)
 
 
 
+/*************************************************************************************************/
+/*  Incremental updates                                                                          */
+/*************************************************************************************************/
+
+// Shift extended ticks by a whole number of steps, so that they are centered on a requested
+// range with the same length (pure pan), without running the tick search. The ticks are modified
+// in place. Return false if the shifted labels do not cover the range, overlap, or are not
+// distinct, in which case the ticks must be recomputed.
+static bool _ticks_shift(DvzAxesTicks* ticks, double dmin, double dmax, DvzAxesContext* ctx)
+{
+    ASSERT(ticks != NULL);
+    ASSERT(ctx != NULL);
+    ASSERT(dmin < dmax);
+    if (ticks->values == NULL || ticks->lstep <= 0 || ticks->value_count < 2)
+        return false;
+    double span = ticks->dmax - ticks->dmin;
+    if (fabs((dmax - dmin) - span) > 1e-6 * span)
+        return false;
+
+    // NOTE: lmin_ex/lmax_ex is the tick range of the initial (non-extended) range.
+    double offset = .5 * (dmin + dmax) - .5 * (ticks->lmin_ex + ticks->lmax_ex);
+    double shift = round(offset / ticks->lstep) * ticks->lstep;
+    ticks->dmin = dmin;
+    ticks->dmax = dmax;
+    ticks->lmin_in += shift;
+    ticks->lmax_in += shift;
+    ticks->lmin_ex += shift;
+    ticks->lmax_ex += shift;
+    make_labels(ticks, ctx, false);
+
+    if (dmin <= ticks->lmin_in || dmax >= ticks->lmax_in)
+        return false;
+    return min_distance_labels(ticks, ctx) > 0 && !duplicate_labels(ticks, ctx);
+}
+
+
+
+/*************************************************************************************************/
+/*  Cache                                                                                        */
+/*************************************************************************************************/
+
+// Cache key of a requested range. The range length is quantized on a log scale, and the center
+// in fractions of the length. Return false if the range cannot be quantized.
+static bool _ticks_key(double dmin, double dmax, DvzAxesContext* ctx, DvzAxesTicksKey* key)
+{
+    ASSERT(ctx != NULL);
+    ASSERT(key != NULL);
+    ASSERT(dmin < dmax);
+
+    double span = floor(log2(dmax - dmin) * CACHE_QUANTUM);
+    double quantum = exp2(span / CACHE_QUANTUM) / CACHE_QUANTUM;
+    double center = floor(.5 * (dmin + dmax) / quantum);
+    if (!isfinite(span) || !isfinite(center) || fabs(center) > 1e15)
+        return false;
+
+    memset(key, 0, sizeof(DvzAxesTicksKey));
+    key->span = (int64_t)span;
+    key->center = (int64_t)center;
+    key->size_viewport = ctx->size_viewport;
+    key->size_glyph = ctx->size_glyph;
+    key->extensions = ctx->extensions;
+    return true;
+}
+
+
+
+static bool _ticks_key_equal(DvzAxesTicksKey* a, DvzAxesTicksKey* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    return a->span == b->span && a->center == b->center &&
+           a->size_viewport == b->size_viewport && a->size_glyph == b->size_glyph &&
+           a->extensions == b->extensions;
+}
+
+
+
+// Deep copy of ticks.
+static DvzAxesTicks _ticks_copy(DvzAxesTicks* ticks)
+{
+    ASSERT(ticks != NULL);
+    ASSERT(ticks->values != NULL);
+    ASSERT(ticks->labels != NULL);
+    uint32_t n = ticks->value_count;
+
+    DvzAxesTicks out = *ticks;
+    out.values = (double*)calloc(n, sizeof(double));
+    out.labels = (char*)calloc(n * MAX_GLYPHS_PER_TICK, sizeof(char));
+    memcpy(out.values, ticks->values, n * sizeof(double));
+    memcpy(out.labels, ticks->labels, n * MAX_GLYPHS_PER_TICK);
+    return out;
+}
+
+
+
+// Copy the cached ticks of a key to out, and return whether they were found.
+static bool _ticks_cache_get(DvzAxesTicksCache* cache, DvzAxesTicksKey* key, DvzAxesTicks* out)
+{
+    ASSERT(cache != NULL);
+    ASSERT(key != NULL);
+    ASSERT(out != NULL);
+    for (uint32_t i = 0; i < cache->count; i++)
+    {
+        if (_ticks_key_equal(&cache->keys[i], key))
+        {
+            *out = _ticks_copy(&cache->ticks[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+// Store a copy of the ticks of a key, replacing the oldest cached ticks if the cache is full.
+static void _ticks_cache_put(DvzAxesTicksCache* cache, DvzAxesTicksKey* key, DvzAxesTicks* ticks)
+{
+    ASSERT(cache != NULL);
+    ASSERT(key != NULL);
+    ASSERT(ticks != NULL);
+
+    uint32_t i = cache->next;
+    if (cache->count < DVZ_TICKS_CACHE_SIZE)
+        cache->count++;
+    else
+        dvz_ticks_destroy(&cache->ticks[i]);
+    cache->next = (i + 1) % DVZ_TICKS_CACHE_SIZE;
+
+    cache->keys[i] = *key;
+    cache->ticks[i] = _ticks_copy(ticks);
+}
+
+
+
+static void _ticks_cache_destroy(DvzAxesTicksCache* cache)
+{
+    ASSERT(cache != NULL);
+    for (uint32_t i = 0; i < cache->count; i++)
+        dvz_ticks_destroy(&cache->ticks[i]);
+    cache->count = 0;
+    cache->next = 0;
+}
+
+
+
 #endif
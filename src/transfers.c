@@ -35,6 +35,45 @@ static DvzTransfer _transfer_dequeue(DvzFifo* fifo, bool wait)
 
 
 
+/*************************************************************************************************/
+/*  Canvas staging buffer                                                                        */
+/*************************************************************************************************/
+
+// Get the staging buffer of the canvas, and make sure it can contain `size` bytes. The canvas
+// transfers are processed synchronously, so that the staging buffer is always idle here.
+static DvzBuffer* _canvas_staging(DvzCanvas* canvas, VkDeviceSize size)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    ASSERT(size > 0);
+    DvzBuffer* staging = &canvas->staging;
+
+    // Create the staging buffer at the first transfer requiring it.
+    if (!dvz_obj_is_created(&staging->obj))
+    {
+        log_trace("create the canvas staging buffer");
+        *staging = dvz_buffer(canvas->gpu);
+        dvz_buffer_queue_access(staging, DVZ_DEFAULT_QUEUE_TRANSFER);
+        dvz_buffer_queue_access(staging, DVZ_DEFAULT_QUEUE_COMPUTE);
+        dvz_buffer_queue_access(staging, DVZ_DEFAULT_QUEUE_RENDER);
+        dvz_buffer_type(staging, DVZ_BUFFER_TYPE_STAGING);
+        dvz_buffer_size(staging, dvz_next_pow2(size));
+        dvz_buffer_usage(
+            staging, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        dvz_buffer_memory(
+            staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        dvz_buffer_create(staging);
+        ASSERT(dvz_obj_is_created(&staging->obj));
+
+        // Permanently map the buffer.
+        staging->mmap = dvz_buffer_map(staging, 0, VK_WHOLE_SIZE);
+    }
+
+    return _staging_reserve(staging, &canvas->cmds_transfer, size);
+}
+
+
+
 /*************************************************************************************************/
 /*  Buffer transfers                                                                             */
 /*************************************************************************************************/
@@ -44,7 +83,6 @@ static void _process_buffer_upload(DvzCanvas* canvas, DvzTransfer tr)
     ASSERT(canvas != NULL);
     DvzGpu* gpu = canvas->gpu;
     ASSERT(gpu != NULL);
-    DvzContext* context = canvas->gpu->context;
     ASSERT(tr.type == DVZ_TRANSFER_BUFFER_UPLOAD);
     DvzBufferRegions br = tr.u.buf.regions;
     uint32_t idx = canvas->swapchain.img_idx;
@@ -102,14 +140,16 @@ static void _process_buffer_upload(DvzCanvas* canvas, DvzTransfer tr)
     {
         ASSERT(br.count == 1);
 
-        // Take the staging buffer and ensure it is big enough.
-        DvzBuffer* staging = staging_buffer(context, tr.u.buf.size);
+        // Take the staging buffer of the canvas and ensure it is big enough.
+        DvzBuffer* staging = _canvas_staging(canvas, tr.u.buf.size);
 
         // Memcpy into the staging buffer.
         dvz_buffer_upload(staging, 0, tr.u.buf.size, tr.u.buf.data);
 
         // Copy from the staging buffer to the target buffer.
-        _copy_buffer_from_staging(context, tr.u.buf.regions, tr.u.buf.offset, tr.u.buf.size);
+        _copy_buffer_from_staging(
+            gpu, &canvas->cmds_transfer, staging, //
+            tr.u.buf.regions, tr.u.buf.offset, tr.u.buf.size);
     }
 }
 
@@ -120,7 +160,6 @@ static void _process_buffer_download(DvzCanvas* canvas, DvzTransfer tr)
     ASSERT(canvas != NULL);
     DvzGpu* gpu = canvas->gpu;
     ASSERT(gpu != NULL);
-    DvzContext* context = canvas->gpu->context;
     ASSERT(tr.type == DVZ_TRANSFER_BUFFER_DOWNLOAD);
     DvzBufferRegions br = tr.u.buf.regions;
     uint32_t idx = canvas->swapchain.img_idx;
@@ -169,11 +208,13 @@ static void _process_buffer_download(DvzCanvas* canvas, DvzTransfer tr)
     {
         ASSERT(br.count == 1);
 
-        // Take the staging buffer and ensure it is big enough.
-        DvzBuffer* staging = staging_buffer(context, tr.u.buf.size);
+        // Take the staging buffer of the canvas and ensure it is big enough.
+        DvzBuffer* staging = _canvas_staging(canvas, tr.u.buf.size);
 
         // Copy from the source buffer to the staging buffer.
-        _copy_buffer_to_staging(context, tr.u.buf.regions, tr.u.buf.offset, tr.u.buf.size);
+        _copy_buffer_to_staging(
+            gpu, &canvas->cmds_transfer, staging, //
+            tr.u.buf.regions, tr.u.buf.offset, tr.u.buf.size);
 
         // Memcpy into the staging buffer.
         dvz_buffer_download(staging, 0, tr.u.buf.size, tr.u.buf.data);
@@ -187,7 +228,6 @@ static void _process_buffer_copy(DvzCanvas* canvas, DvzTransfer tr)
     ASSERT(canvas != NULL);
     DvzGpu* gpu = canvas->gpu;
     ASSERT(gpu != NULL);
-    DvzContext* context = canvas->gpu->context;
     ASSERT(tr.type == DVZ_TRANSFER_BUFFER_COPY);
 
     DvzBufferRegions* src = &tr.u.buf_copy.src;
@@ -198,8 +238,8 @@ static void _process_buffer_copy(DvzCanvas* canvas, DvzTransfer tr)
     VkDeviceSize src_offset = tr.u.buf_copy.src_offset;
     VkDeviceSize dst_offset = tr.u.buf_copy.dst_offset;
 
-    // Take transfer cmd buf.
-    DvzCommands* cmds = &context->transfer_cmd;
+    // Take the transfer cmd buf of the canvas.
+    DvzCommands* cmds = &canvas->cmds_transfer;
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
@@ -231,6 +271,92 @@ static void _process_buffer_copy(DvzCanvas* canvas, DvzTransfer tr)
 
 
 
+/*************************************************************************************************/
+/*  Texture transfers                                                                            */
+/*************************************************************************************************/
+
+static void _process_texture_upload(DvzCanvas* canvas, DvzTransfer tr)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(tr.type == DVZ_TRANSFER_TEXTURE_UPLOAD);
+    ASSERT(tr.u.tex.texture != NULL);
+    ASSERT(tr.u.tex.size > 0);
+    ASSERT(tr.u.tex.data != NULL);
+
+    // Memcpy into the staging buffer of the canvas.
+    DvzBuffer* staging = _canvas_staging(canvas, tr.u.tex.size);
+    dvz_buffer_upload(staging, 0, tr.u.tex.size, tr.u.tex.data);
+
+    // Copy from the staging buffer to the texture.
+    _copy_texture_from_staging(
+        canvas->gpu, &canvas->cmds_transfer, staging, //
+        tr.u.tex.texture, tr.u.tex.offset, tr.u.tex.shape, tr.u.tex.size);
+}
+
+
+
+static void _process_texture_download(DvzCanvas* canvas, DvzTransfer tr)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(tr.type == DVZ_TRANSFER_TEXTURE_DOWNLOAD);
+    ASSERT(tr.u.tex.texture != NULL);
+    ASSERT(tr.u.tex.size > 0);
+    ASSERT(tr.u.tex.data != NULL);
+
+    // Copy from the texture to the staging buffer of the canvas.
+    DvzBuffer* staging = _canvas_staging(canvas, tr.u.tex.size);
+    _copy_texture_to_staging(
+        canvas->gpu, &canvas->cmds_transfer, staging, //
+        tr.u.tex.texture, tr.u.tex.offset, tr.u.tex.shape, tr.u.tex.size);
+
+    // Memcpy from the staging buffer.
+    dvz_buffer_download(staging, 0, tr.u.tex.size, tr.u.tex.data);
+}
+
+
+
+/*************************************************************************************************/
+/*  Compute transfers                                                                            */
+/*************************************************************************************************/
+
+static void _process_compute(DvzCanvas* canvas, DvzTransfer tr)
+{
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+    DvzContext* context = canvas->gpu->context;
+    ASSERT(tr.type == DVZ_TRANSFER_COMPUTE);
+
+    DvzCompute* compute = tr.u.compute.compute;
+    ASSERT(compute != NULL);
+    ASSERT(dvz_obj_is_created(&compute->obj));
+
+    // Take compute cmd buf.
+    dvz_context_lock(context);
+    DvzCommands* cmds = &context->compute_cmd;
+    dvz_cmd_reset(cmds, 0);
+    dvz_cmd_begin(cmds, 0);
+    if (tr.u.compute.push_size > 0)
+        dvz_cmd_push(
+            cmds, 0, &compute->slots, VK_SHADER_STAGE_COMPUTE_BIT, 0, tr.u.compute.push_size,
+            tr.u.compute.push);
+    dvz_cmd_compute(cmds, 0, compute, tr.u.compute.size);
+    dvz_cmd_end(cmds, 0);
+
+    // Wait for the render queue to be idle, as the compute shader may write to buffers used for
+    // rendering.
+    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
+
+    // Submit the commands to the compute queue.
+    log_debug(
+        "dispatch compute with %dx%dx%d workgroups", //
+        tr.u.compute.size[0], tr.u.compute.size[1], tr.u.compute.size[2]);
+    dvz_cmd_submit_sync(cmds, 0);
+    dvz_context_unlock(context);
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas transfers processing                                                                  */
 /*************************************************************************************************/
@@ -271,15 +397,17 @@ void dvz_process_transfers(DvzCanvas* canvas)
 
         // Process texture transfers.
         if (tr.type == DVZ_TRANSFER_TEXTURE_UPLOAD)
-            dvz_texture_upload(
-                tr.u.tex.texture, tr.u.tex.offset, tr.u.tex.shape, tr.u.tex.size, tr.u.tex.data);
+            _process_texture_upload(canvas, tr);
         if (tr.type == DVZ_TRANSFER_TEXTURE_DOWNLOAD)
-            dvz_texture_download(
-                tr.u.tex.texture, tr.u.tex.offset, tr.u.tex.shape, tr.u.tex.size, tr.u.tex.data);
+            _process_texture_download(canvas, tr);
         if (tr.type == DVZ_TRANSFER_TEXTURE_COPY)
-            dvz_texture_copy(
-                tr.u.tex_copy.src, tr.u.tex_copy.src_offset, tr.u.tex_copy.dst,
-                tr.u.tex_copy.dst_offset, tr.u.tex_copy.shape);
+            _copy_texture(
+                gpu, &canvas->cmds_transfer, tr.u.tex_copy.src, tr.u.tex_copy.src_offset,
+                tr.u.tex_copy.dst, tr.u.tex_copy.dst_offset, tr.u.tex_copy.shape);
+
+        // Process compute dispatches.
+        if (tr.type == DVZ_TRANSFER_COMPUTE)
+            _process_compute(canvas, tr);
 
         fifo->is_processing = false;
     }
@@ -473,3 +601,42 @@ void dvz_copy_texture(
     if (!canvas->app->is_running)
         dvz_process_transfers(canvas);
 }
+
+
+
+/*************************************************************************************************/
+/*  Canvas compute dispatch                                                                      */
+/*************************************************************************************************/
+
+void dvz_dispatch_compute(
+    DvzCanvas* canvas, DvzCompute* compute, uvec3 size, uint32_t push_size, const void* push)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->transfers.capacity > 0);
+    ASSERT(compute != NULL);
+    if (push_size > DVZ_MAX_TRANSFER_PUSH_SIZE)
+    {
+        log_error(
+            "push constants too large for compute dispatch (%d > %d bytes)", push_size,
+            DVZ_MAX_TRANSFER_PUSH_SIZE);
+        return;
+    }
+
+    // Create the transfer object.
+    DvzTransfer tr = {0};
+    tr.type = DVZ_TRANSFER_COMPUTE;
+    tr.u.compute.compute = compute;
+    memcpy(tr.u.compute.size, size, sizeof(uvec3));
+    tr.u.compute.push_size = push_size;
+    // NOTE: the push constants are copied as the dispatch may be deferred to the next frame.
+    if (push_size > 0)
+    {
+        ASSERT(push != NULL);
+        memcpy(tr.u.compute.push, push, push_size);
+    }
+
+    _transfer_enqueue(&canvas->transfers, tr);
+
+    if (!canvas->app->is_running)
+        dvz_process_transfers(canvas);
+}
@@ -37,25 +37,15 @@ static void _box_enlarge(DvzBox* box, float rel_increase)
 
 
 
-// Return the bounding box of a set of dvec3 points.
+// Return the bounding box of a set of dvec3 or vec3 points.
 static DvzBox _box_bounding(DvzArray* points_in)
 {
     ASSERT(points_in != NULL);
     ASSERT(points_in->item_count > 0);
     ASSERT(points_in->item_size > 0);
 
-    dvec3* pos = NULL;
     DvzBox box = DVZ_BOX_INF;
-    for (uint32_t i = 0; i < points_in->item_count; i++)
-    {
-        pos = (dvec3*)dvz_array_item(points_in, i);
-        ASSERT(pos != NULL);
-        for (uint32_t j = 0; j < 3; j++)
-        {
-            box.p0[j] = MIN(box.p0[j], (*pos)[j]);
-            box.p1[j] = MAX(box.p1[j], (*pos)[j]);
-        }
-    }
+    dvz_array_bounds(points_in, 0, points_in->item_count, box.p0, box.p1);
 
     // Enlarge the box by 10%.
     // _box_enlarge(&box, .1);
@@ -65,6 +55,19 @@ static DvzBox _box_bounding(DvzArray* points_in)
 
 
 
+// Translate a box by a vector.
+static void _box_translate(DvzBox* box, dvec3 origin)
+{
+    ASSERT(box != NULL);
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        box->p0[j] += origin[j];
+        box->p1[j] += origin[j];
+    }
+}
+
+
+
 static DvzBox _box_merge(uint32_t count, DvzBox* boxes)
 {
     if (count == 0)
@@ -238,35 +241,81 @@ static inline void _transform_earth_mercator_web(DvzTransform* tr, dvec3 in, dve
 
 
 
-// NOTE: we use a macro here instead of doing a conditional test on the transform type at every
-// iteration, which is probably bad for performance
-#define MAKE_TRANSFORM_APPLY(func)                                                                \
-    static void _transform_array_##func(DvzTransform* tr, DvzArray* arr_in, DvzArray* arr_out)    \
+// NOTE: we use a macro here instead of doing a conditional test on the transform type and on the
+// dtypes at every iteration, which is probably bad for performance
+// The input positions are relative to a double-precision origin, the computation is made in
+// double precision, and the optional linear transform `lin` is applied after the transform.
+#define MAKE_TRANSFORM_APPLY(func, tin, tout, sout)                                               \
+    static void _transform_array_##func##_##tin##_##tout(                                         \
+        DvzTransform* tr, DvzTransform* lin, dvec3 origin, DvzArray* arr_in, DvzArray* arr_out)   \
     {                                                                                             \
-        ASSERT(arr_in->dtype == DVZ_DTYPE_DVEC3);                                                 \
-        ASSERT(arr_out->dtype == DVZ_DTYPE_DVEC3);                                                \
-        dvec3* pos_in = (dvec3*)arr_in->data;                                                     \
-        dvec3* pos_out = (dvec3*)arr_out->data;                                                   \
+        tin* pos_in = (tin*)arr_in->data;                                                         \
+        tout* pos_out = (tout*)arr_out->data;                                                     \
+        dvec3 in = {0};                                                                           \
+        dvec3 out = {0};                                                                          \
         for (uint32_t i = 0; i < arr_in->item_count; i++)                                         \
         {                                                                                         \
-            _transform_##func(tr, pos_in[i], pos_out[i]);                                         \
+            in[0] = origin[0] + pos_in[i][0];                                                     \
+            in[1] = origin[1] + pos_in[i][1];                                                     \
+            in[2] = origin[2] + pos_in[i][2];                                                     \
+            out[2] = in[2]; /* 2D transforms keep the third coordinate */                         \
+            _transform_##func(tr, in, out);                                                       \
+            if (lin != NULL)                                                                      \
+                _transform_cartesian(lin, out, out);                                              \
+            pos_out[i][0] = (sout)out[0];                                                         \
+            pos_out[i][1] = (sout)out[1];                                                         \
+            pos_out[i][2] = (sout)out[2];                                                         \
         }                                                                                         \
     }
 
+#define MAKE_TRANSFORM_APPLY_DTYPES(func)                                                         \
+    MAKE_TRANSFORM_APPLY(func, dvec3, dvec3, double)                                              \
+    MAKE_TRANSFORM_APPLY(func, dvec3, vec3, float)                                                \
+    MAKE_TRANSFORM_APPLY(func, vec3, dvec3, double)                                               \
+    MAKE_TRANSFORM_APPLY(func, vec3, vec3, float)                                                 \
+                                                                                                  \
+    static void _transform_array_##func(                                                          \
+        DvzTransform* tr, DvzTransform* lin, dvec3 origin, DvzArray* arr_in, DvzArray* arr_out)   \
+    {                                                                                             \
+        bool in_double = arr_in->dtype == DVZ_DTYPE_DVEC3;                                        \
+        bool out_double = arr_out->dtype == DVZ_DTYPE_DVEC3;                                      \
+        if (in_double && out_double)                                                              \
+            _transform_array_##func##_dvec3_dvec3(tr, lin, origin, arr_in, arr_out);              \
+        else if (in_double)                                                                       \
+            _transform_array_##func##_dvec3_vec3(tr, lin, origin, arr_in, arr_out);               \
+        else if (out_double)                                                                      \
+            _transform_array_##func##_vec3_dvec3(tr, lin, origin, arr_in, arr_out);               \
+        else                                                                                      \
+            _transform_array_##func##_vec3_vec3(tr, lin, origin, arr_in, arr_out);                \
+    }
 
-MAKE_TRANSFORM_APPLY(cartesian)
-MAKE_TRANSFORM_APPLY(earth_mercator_web)
 
-static void _transform_array(DvzTransform* tr, DvzArray* arr_in, DvzArray* arr_out)
+MAKE_TRANSFORM_APPLY_DTYPES(cartesian)
+MAKE_TRANSFORM_APPLY_DTYPES(earth_mercator_web)
+
+// Transform an array of dvec3 or vec3 positions, relative to an origin, with a transform followed
+// by an optional linear transform.
+static void _transform_array(
+    DvzTransform* tr, DvzTransform* lin, dvec3 origin, DvzArray* arr_in, DvzArray* arr_out)
 {
     ASSERT(tr != NULL);
+    ASSERT(arr_in != NULL);
+    ASSERT(arr_out != NULL);
+    ASSERT(arr_in->dtype == DVZ_DTYPE_DVEC3 || arr_in->dtype == DVZ_DTYPE_VEC3);
+    ASSERT(arr_out->dtype == DVZ_DTYPE_DVEC3 || arr_out->dtype == DVZ_DTYPE_VEC3);
+    ASSERT(arr_out->item_count >= arr_in->item_count);
+
     if (tr->type == DVZ_TRANSFORM_CARTESIAN)
     {
-        _transform_array_cartesian(tr, arr_in, arr_out);
+        // NOTE: the linear transform can be applied directly.
+        if (lin != NULL)
+            _transform_array_cartesian(lin, NULL, origin, arr_in, arr_out);
+        else
+            _transform_array_cartesian(tr, NULL, origin, arr_in, arr_out);
     }
     else if (tr->type == DVZ_TRANSFORM_EARTH_MERCATOR_WEB)
     {
-        _transform_array_earth_mercator_web(tr, arr_in, arr_out);
+        _transform_array_earth_mercator_web(tr, lin, origin, arr_in, arr_out);
     }
     else
     {
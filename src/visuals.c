@@ -1,6 +1,8 @@
 #include "../include/datoviz/visuals.h"
 #include "../include/datoviz/canvas.h"
 #include "../include/datoviz/graphics.h"
+#include "lod_utils.h"
+#include "spatial_utils.h"
 #include "visuals_utils.h"
 
 
@@ -45,6 +47,7 @@ void dvz_visual_destroy(DvzVisual* visual)
     {
         prop = iter.item;
         dvz_array_destroy(&prop->arr_orig);
+        _prop_release(visual, prop, true);
         dvz_array_destroy(&prop->arr_trans);
         dvz_array_destroy(&prop->arr_staging);
         if (prop->default_value != NULL)
@@ -71,6 +74,15 @@ void dvz_visual_destroy(DvzVisual* visual)
     CONTAINER_DESTROY_ITEMS(DvzBindings, visual->bindings, dvz_bindings_destroy)
     CONTAINER_DESTROY_ITEMS(DvzBindings, visual->bindings_comp, dvz_bindings_destroy)
 
+    // Free the level of detail pyramid.
+    if (visual->lod != NULL)
+    {
+        _lod_destroy(visual->lod);
+        FREE(visual->lod);
+    }
+    FREE(visual->group_boxes);
+    _spatial_destroy(visual);
+
     dvz_obj_destroyed(&visual->obj);
 }
 
@@ -216,6 +228,51 @@ void dvz_visual_prop_dpi(DvzProp* prop, float dpi_scaling)
 
 
 
+void dvz_visual_prop_origin(DvzProp* prop, dvec3 origin)
+{
+    ASSERT(prop != NULL);
+    ASSERT(prop->prop_type == DVZ_PROP_POS);
+    DvzSource* source = prop->source;
+    ASSERT(source != NULL);
+    DvzVisual* visual = source->visual;
+    ASSERT(visual != NULL);
+
+    if (prop->dtype != DVZ_DTYPE_VEC3)
+    {
+        if (prop->dtype != DVZ_DTYPE_DVEC3 || prop->target_dtype != DVZ_DTYPE_VEC3 ||
+            visual->callback_bake != _default_visual_bake)
+        {
+            log_error(
+                "single-precision storage is not supported by POS prop #%d of this visual",
+                prop->prop_idx);
+            return;
+        }
+
+        // Switch the prop to single precision, discarding the existing data.
+        log_debug("store POS prop #%d in single precision", prop->prop_idx);
+        dvz_array_destroy(&prop->arr_orig);
+        dvz_array_destroy(&prop->arr_trans);
+        prop->arr_trans = (DvzArray){0};
+        _prop_release(visual, prop, true);
+        prop->dtype = DVZ_DTYPE_VEC3;
+        prop->arr_orig = dvz_array(0, prop->dtype);
+        prop->bounds_valid = false;
+        FREE(visual->group_boxes);
+    }
+    if (prop->prop_idx == 0)
+        _spatial_invalidate(visual);
+    prop->origin[0] = origin[0];
+    prop->origin[1] = origin[1];
+    prop->origin[2] = origin[2];
+
+    // The positions need to be normalized again.
+    _range_all(&prop->dirty);
+    prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+    _source_set_changed(source, true);
+}
+
+
+
 void dvz_visual_graphics(DvzVisual* visual, DvzGraphics* graphics)
 {
     ASSERT(visual != NULL);
@@ -240,7 +297,6 @@ void dvz_visual_compute(DvzVisual* visual, DvzCompute* compute)
 {
     ASSERT(visual != NULL);
     ASSERT(compute != NULL);
-    ASSERT(dvz_obj_is_created(&compute->obj));
     if (visual->compute_count >= DVZ_MAX_COMPUTES_PER_VISUAL)
     {
         log_error("maximum number of computes per visual reached");
@@ -248,9 +304,11 @@ void dvz_visual_compute(DvzVisual* visual, DvzCompute* compute)
     }
     visual->computes[visual->compute_count] = compute;
 
-    DvzBindings* bindings = dvz_container_alloc(&visual->bindings);
-    ASSERT(visual->bindings.count == visual->compute_count + 1);
+    DvzBindings* bindings = dvz_container_alloc(&visual->bindings_comp);
+    ASSERT(visual->bindings_comp.count == visual->compute_count + 1);
     *bindings = dvz_bindings(&compute->slots, visual->canvas->swapchain.img_count);
+    // NOTE: the compute pipeline uses the visual's bindings, it may be created afterwards.
+    dvz_compute_bindings(compute, bindings);
     visual->compute_count++;
 }
 
@@ -270,22 +328,17 @@ void dvz_visual_group(DvzVisual* visual, uint32_t group_idx, uint32_t size)
     }
     visual->group_count = MAX(visual->group_count, group_idx + 1);
     visual->group_sizes[group_idx] = size;
+    FREE(visual->group_boxes);
 }
 
 
 
-void dvz_visual_data(
-    DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data)
-{
-    ASSERT(visual != NULL);
-    dvz_visual_data_partial(visual, prop_type, prop_idx, 0, count, count, data);
-}
-
-
-
-void dvz_visual_data_partial(
+// Set the prop items [first_item, first_item + item_count). If truncate is true, the prop array
+// is resized to first_item + item_count items, otherwise it is only grown if needed.
+static void _visual_data(
     DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, //
-    uint32_t first_item, uint32_t item_count, uint32_t data_item_count, const void* data)
+    uint32_t first_item, uint32_t item_count, uint32_t data_item_count, const void* data,
+    bool truncate)
 {
     ASSERT(visual != NULL);
     uint32_t count = first_item + item_count;
@@ -310,12 +363,35 @@ void dvz_visual_data_partial(
         count = 1;
     }
 
+    // The borrowed data does not need to be copied if it is entirely replaced.
+    if (truncate && first_item == 0)
+        _array_unborrow(&prop->arr_orig);
+
     // Make sure the array has the right size.
+    uint32_t old_count = prop->arr_orig.item_count;
+    if (!truncate)
+        count = MAX(count, old_count);
+    // NOTE: if the number of items changes, the whole source will need to be baked again.
+    if (count != old_count)
+        _range_all(&prop->dirty);
+    else
+        _range_merge(&prop->dirty, first_item, item_count);
+    _prop_bounds_before(prop, first_item, item_count, count);
+    if (prop->prop_type == DVZ_PROP_POS)
+        FREE(visual->group_boxes);
     dvz_array_resize(&prop->arr_orig, count);
 
     // Copy the specified array to the prop array.
     dvz_array_data(&prop->arr_orig, first_item, item_count, data_item_count, data);
 
+    // Only the new items extend the bounds, including the items added before first_item.
+    uint32_t first_new = MIN(first_item, old_count);
+    _prop_bounds_after(prop, first_new, first_item + item_count - first_new);
+    _spatial_data(visual, prop, old_count, first_item, item_count);
+
+    // The prop array now owns a copy of the data that was previously borrowed, if any.
+    _prop_release(visual, prop, false);
+
     prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
 
     if (source != NULL)
@@ -330,18 +406,227 @@ void dvz_visual_data_partial(
 
 
 
+void dvz_visual_data(
+    DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data)
+{
+    ASSERT(visual != NULL);
+    _visual_data(visual, prop_type, prop_idx, 0, count, count, data, true);
+}
+
+
+
+void dvz_visual_data_partial(
+    DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, //
+    uint32_t first_item, uint32_t item_count, uint32_t data_item_count, const void* data)
+{
+    ASSERT(visual != NULL);
+    _visual_data(
+        visual, prop_type, prop_idx, first_item, item_count, data_item_count, data, false);
+}
+
+
+
+// Upload the state of the circular vertex buffer to the indirect draw commands and to the
+// viewport of every graphics pipeline.
+static void _visual_ring_update(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    _ring_viewport(visual, &visual->viewport);
+
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    if (visual->ring_capacity > 0 && visual->graphics_count > 0)
+    {
+        // The draw commands are read by the GPU, so that the command buffers are not refilled.
+        VkDeviceSize size = sizeof(visual->ring_draws);
+        if (visual->br_ring_draws.buffer == NULL)
+            visual->br_ring_draws =
+                dvz_ctx_buffers(canvas->gpu->context, DVZ_BUFFER_TYPE_STORAGE, 1, size);
+        _ring_draws(visual);
+        dvz_upload_buffers(canvas, visual->br_ring_draws, 0, size, visual->ring_draws);
+    }
+
+    DvzSource* source = NULL;
+    DvzViewport viewport = {0};
+    for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
+    {
+        source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VIEWPORT, pidx);
+        if (source == NULL || source->origin == DVZ_SOURCE_ORIGIN_USER)
+            continue;
+        // Keep the other viewport fields, which may be specific to each graphics pipeline.
+        viewport = source->arr.item_count > 0 ? *(DvzViewport*)dvz_array_item(&source->arr, 0)
+                                              : visual->viewport;
+        _ring_viewport(visual, &viewport);
+        dvz_visual_data_source(visual, DVZ_SOURCE_TYPE_VIEWPORT, pidx, 0, 1, 1, &viewport);
+    }
+}
+
+
+
+// Overwrite the oldest items of a vertex prop in a circular vertex buffer.
+static void _visual_data_ring(DvzVisual* visual, DvzProp* prop, uint32_t count, const void* data)
+{
+    ASSERT(visual != NULL);
+    ASSERT(prop != NULL);
+    ASSERT(count > 0);
+
+    uint32_t capacity = visual->ring_capacity;
+    ASSERT(capacity > 0);
+    VkDeviceSize item_size = prop->arr_orig.item_size;
+    ASSERT(item_size > 0);
+    const char* items = (const char*)data;
+
+    // The prop array is allocated with the whole capacity on the first append, followed by the
+    // duplicated first items.
+    if (prop->arr_orig.item_count != capacity + DVZ_RING_OVERLAP)
+    {
+        dvz_array_resize(&prop->arr_orig, capacity + DVZ_RING_OVERLAP);
+        _range_all(&prop->dirty);
+        prop->bounds_valid = false;
+    }
+
+    // Only the last items are kept when appending more items than the capacity.
+    if (count > capacity)
+    {
+        items += (count - capacity) * item_size;
+        prop->ring_written += count - capacity;
+        count = capacity;
+    }
+
+    // Write the items in at most two contiguous chunks, at the end and at the beginning of the
+    // prop array. The prop array keeps the same size, so that only these items are baked.
+    uint32_t first = (uint32_t)(prop->ring_written % capacity);
+    uint32_t n = MIN(count, capacity - first);
+    _visual_data(visual, prop->prop_type, prop->prop_idx, first, n, n, items, false);
+    if (n < count)
+        _visual_data(
+            visual, prop->prop_type, prop->prop_idx, 0, count - n, count - n,
+            items + n * item_size, false);
+    prop->ring_written += count;
+
+    // Duplicate the first items after the end of the buffer, for the strips that continue across
+    // the wraparound (see _ring_draws()).
+    if (first < DVZ_RING_OVERLAP || n < count)
+    {
+        void* overlap = calloc(DVZ_RING_OVERLAP, item_size);
+        memcpy(overlap, prop->arr_orig.data, DVZ_RING_OVERLAP * item_size);
+        _visual_data(
+            visual, prop->prop_type, prop->prop_idx, capacity, DVZ_RING_OVERLAP,
+            DVZ_RING_OVERLAP, overlap, false);
+        FREE(overlap);
+    }
+
+    // The POS prop determines the oldest and valid vertices.
+    if (prop->prop_type == DVZ_PROP_POS && prop->prop_idx == 0)
+    {
+        visual->ring_count = (uint32_t)MIN(prop->ring_written, (uint64_t)capacity);
+        visual->ring_head =
+            prop->ring_written >= capacity ? (uint32_t)(prop->ring_written % capacity) : 0;
+        _visual_ring_update(visual);
+    }
+}
+
+
+
 void dvz_visual_data_append(
     DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data)
 {
     ASSERT(visual != NULL);
     DvzProp* prop = dvz_prop_get(visual, prop_type, prop_idx);
     ASSERT(prop != NULL);
+    if (visual->ring_capacity > 0 && prop->source != NULL &&
+        prop->source->source_kind == DVZ_SOURCE_KIND_VERTEX)
+    {
+        _visual_data_ring(visual, prop, count, data);
+        return;
+    }
     uint32_t first_item = prop->arr_orig.item_count;
     dvz_visual_data_partial(visual, prop_type, prop_idx, first_item, count, count, data);
 }
 
 
 
+void dvz_visual_data_borrow(
+    DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, void* data,
+    DvzVisualReleaseCallback release, void* user_data)
+{
+    ASSERT(visual != NULL);
+    ASSERT(count > 0);
+    ASSERT(data != NULL);
+
+    DvzProp* prop = dvz_prop_get(visual, prop_type, prop_idx);
+    ASSERT(prop != NULL);
+    DvzSource* source = prop->source;
+    if (source != NULL && source->source_kind == DVZ_SOURCE_KIND_UNIFORM && count > 1)
+    {
+        log_debug("discarding uniform data after the first item (number of items was %d)", count);
+        count = 1;
+    }
+
+    // Reference the caller memory, the previously borrowed memory is released.
+    dvz_array_destroy(&prop->arr_orig);
+    prop->arr_orig = dvz_array_borrow(count, prop->dtype, data);
+    prop->bounds_valid = false;
+    if (prop->prop_type == DVZ_PROP_POS)
+    {
+        FREE(visual->group_boxes);
+        if (prop->prop_idx == 0)
+            _spatial_invalidate(visual);
+    }
+    _prop_release(visual, prop, true);
+    prop->borrowed = data;
+    prop->release = release;
+    prop->release_data = user_data;
+
+    _range_all(&prop->dirty);
+    prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+
+    if (source != NULL)
+    {
+        log_trace("source type %d #%d handled by lib", source->source_type, source->source_idx);
+        source->origin = DVZ_SOURCE_ORIGIN_LIB;
+        _source_set_changed(source, true);
+    }
+}
+
+
+
+void dvz_visual_ring(DvzVisual* visual, uint32_t capacity)
+{
+    ASSERT(visual != NULL);
+
+    visual->ring_capacity = capacity;
+    visual->ring_head = 0;
+    visual->ring_count = 0;
+
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source != NULL && prop->source->source_kind == DVZ_SOURCE_KIND_VERTEX)
+        {
+            prop->ring_written = 0;
+            // Allocate the whole capacity once, repeating the last item (for example the default
+            // value of the prop), so that the vertex count never changes afterwards.
+            if (capacity > 0 && prop->arr_orig.data != NULL)
+            {
+                dvz_array_resize(&prop->arr_orig, capacity + DVZ_RING_OVERLAP);
+                prop->bounds_valid = false;
+                _spatial_invalidate(visual);
+                _range_all(&prop->dirty);
+                prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+                _source_set_changed(prop->source, true);
+            }
+        }
+        dvz_container_iter(&iter);
+    }
+
+    _visual_ring_update(visual);
+}
+
+
+
 static DvzSource*
 _assert_source_exists(DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx)
 {
@@ -389,6 +674,10 @@ void dvz_visual_data_source(
     ASSERT(source->source_type == source_type);
 
     // Make sure the array has the right size.
+    if (count != source->arr.item_count)
+        _range_all(&source->dirty);
+    else
+        _range_merge(&source->dirty, first_item, item_count);
     dvz_array_resize(&source->arr, count);
 
     // Copy the specified array to the prop array.
@@ -463,6 +752,19 @@ void dvz_visual_flags(DvzVisual* visual, int flags)
 
 
 
+void dvz_visual_visible(DvzVisual* visual, bool visible)
+{
+    ASSERT(visual != NULL);
+    if (visual->hidden == !visible)
+        return;
+    visual->hidden = !visible;
+    // The command buffers need to be refilled.
+    ASSERT(visual->canvas != NULL);
+    dvz_canvas_to_refill(visual->canvas);
+}
+
+
+
 /*************************************************************************************************/
 /*  Visual events                                                                                */
 /*************************************************************************************************/
@@ -475,6 +777,14 @@ void dvz_visual_callback_bake(DvzVisual* visual, DvzVisualDataCallback callback)
 
 
 
+void dvz_visual_callback_bake_gpu(DvzVisual* visual, DvzVisualDataCallback callback)
+{
+    ASSERT(visual != NULL);
+    visual->callback_bake_gpu = callback;
+}
+
+
+
 void dvz_visual_fill_callback(DvzVisual* visual, DvzVisualFillCallback callback)
 {
     ASSERT(visual != NULL);
@@ -618,17 +928,29 @@ void* dvz_prop_item(DvzProp* prop, uint32_t prop_idx)
 /*  Data update                                                                                  */
 /*************************************************************************************************/
 
-void dvz_visual_update(
+void dvz_visual_bake(
     DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data)
 {
     ASSERT(visual != NULL);
-    log_debug("visual update");
+    log_debug("visual bake");
 
     DvzVisualDataEvent ev = {0};
     ev.viewport = viewport;
     ev.coords = coords;
     ev.user_data = user_data;
 
+    // By default, the sources baked by the library are entirely uploaded, unless the baking
+    // function restricts the range of source items that have changed.
+    DvzContainerIterator iter = dvz_container_iterator(&visual->sources);
+    DvzSource* source = NULL;
+    while (iter.item != NULL)
+    {
+        source = iter.item;
+        if (source->origin == DVZ_SOURCE_ORIGIN_LIB && _source_has_changed(source))
+            _range_all(&source->dirty);
+        dvz_container_iter(&iter);
+    }
+
     if (visual->callback_bake != NULL)
     {
         log_trace("visual bake callback");
@@ -643,6 +965,24 @@ void dvz_visual_update(
     // NOTE: we bake the UNIFORM sources here.
     _bake_uniforms(visual);
 
+    // All prop changes have been baked into the sources.
+    iter = dvz_container_iterator(&visual->props);
+    DvzProp* prop = NULL;
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        _range_clear(&prop->dirty);
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+void dvz_visual_upload(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    log_debug("visual upload");
+
     // Here, we assume that all sources are correctly allocated, which includes VERTEX and INDEX
     // arrays, and that they have their data ready for upload.
 
@@ -653,6 +993,7 @@ void dvz_visual_update(
     DvzContext* ctx = canvas->gpu->context;
     DvzTexture* texture = NULL;
     bool to_upload = false;
+    bool gpu_bake = false;
 
     DvzContainerIterator iter = dvz_container_iterator(&visual->sources);
     DvzSource* source = NULL;
@@ -757,6 +1098,17 @@ void dvz_visual_update(
                 dvz_container_iter(&iter);
                 continue;
             }
+            // The vertices of a batched visual are drawn from the shared vertex buffer of its
+            // batch, which is filled by the scene. The own vertex buffer of the visual is only
+            // resized and uploaded when it leaves the batch.
+            if (visual->batch != NULL && source->source_type == DVZ_SOURCE_TYPE_VERTEX)
+            {
+                log_trace("skip vertex upload of a batched visual");
+                visual->batch_outdated = true;
+                _source_set(source);
+                dvz_container_iter(&iter);
+                continue;
+            }
             log_debug("uploading new data for source %d", source->source_type);
 
             br = &source->u.br;
@@ -767,7 +1119,21 @@ void dvz_visual_update(
             ASSERT(arr->item_size > 0);
 
             // Make sure the GPU buffer exists and is allocated with the right size.
-            _source_buffer(visual, source);
+            // NOTE: a new buffer needs to be entirely uploaded.
+            if (_source_buffer(visual, source))
+                _range_all(&source->dirty);
+
+            // The sources baked on the GPU are only allocated here, and filled by the GPU bake
+            // callback below.
+            if ((source->flags & DVZ_SOURCE_FLAG_GPU_BAKE) != 0)
+            {
+                log_debug("skip data upload for GPU-baked source %d", source->source_type);
+                gpu_bake = true;
+                _range_clear(&source->dirty);
+                _source_set(source);
+                dvz_container_iter(&iter);
+                continue;
+            }
 
             ASSERT(br->size > 0);
             VkDeviceSize size = arr->item_count * arr->item_size;
@@ -776,12 +1142,23 @@ void dvz_visual_update(
 
             ASSERT(br->buffer != VK_NULL_HANDLE);
 
+            // Only upload the items that have changed.
+            VkDeviceSize offset = 0;
+            if (!_range_is_all(source->dirty) && source->dirty.count > 0 &&
+                source->dirty.first + source->dirty.count <= arr->item_count)
+            {
+                offset = source->dirty.first * arr->item_size;
+                size = source->dirty.count * arr->item_size;
+            }
+
             log_trace(
-                "upload buffer (%d items, buffer size %d bytes) for automatically-handled source "
-                "%d #%d", //
-                arr->item_count, br->size, source->source_type, source->source_idx);
+                "upload buffer (%d/%d bytes from offset %d, buffer size %d bytes) for "
+                "automatically-handled source %d #%d", //
+                size, arr->item_count * arr->item_size, offset, br->size, source->source_type,
+                source->source_idx);
 
-            dvz_upload_buffers(canvas, *br, 0, size, arr->data);
+            dvz_upload_buffers(canvas, *br, offset, size, (char*)arr->data + offset);
+            _range_clear(&source->dirty);
             _source_set(source);
             // source->obj.status = DVZ_OBJECT_STATUS_CREATED;
             // visual->obj.status = DVZ_OBJECT_STATUS_CREATED;
@@ -811,6 +1188,7 @@ void dvz_visual_update(
             dvz_upload_texture(
                 canvas, texture, DVZ_ZERO_OFFSET, DVZ_ZERO_OFFSET,
                 arr->item_count * arr->item_size, arr->data);
+            _range_clear(&source->dirty);
             _source_set(source);
         }
 
@@ -832,4 +1210,22 @@ void dvz_visual_update(
         if (bindings->obj.status == DVZ_OBJECT_STATUS_NEED_UPDATE)
             dvz_bindings_update(bindings);
     }
+
+    // Fill the GPU-baked sources with compute shaders.
+    if (gpu_bake && visual->callback_bake_gpu != NULL)
+    {
+        log_trace("visual GPU bake callback");
+        DvzVisualDataEvent ev = {0};
+        visual->callback_bake_gpu(visual, ev);
+    }
+}
+
+
+
+void dvz_visual_update(
+    DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data)
+{
+    ASSERT(visual != NULL);
+    dvz_visual_bake(visual, viewport, coords, user_data);
+    dvz_visual_upload(visual);
 }
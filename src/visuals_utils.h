@@ -59,6 +59,9 @@ static DvzSourceKind _get_source_kind(DvzSourceType type)
     case DVZ_SOURCE_TYPE_INDEX:
         return DVZ_SOURCE_KIND_INDEX;
 
+    case DVZ_SOURCE_TYPE_STORAGE:
+        return DVZ_SOURCE_KIND_STORAGE;
+
     case DVZ_SOURCE_TYPE_TRANSFER:
         return DVZ_SOURCE_KIND_TEXTURE_1D;
 
@@ -117,6 +120,47 @@ static bool _source_is_set(DvzSource* source)
 
 
 
+static bool _range_is_all(DvzItemRange range) { return range.count == DVZ_ITEM_RANGE_ALL; }
+
+
+
+static void _range_all(DvzItemRange* range)
+{
+    ASSERT(range != NULL);
+    range->first = 0;
+    range->count = DVZ_ITEM_RANGE_ALL;
+}
+
+
+
+static void _range_clear(DvzItemRange* range)
+{
+    ASSERT(range != NULL);
+    range->first = 0;
+    range->count = 0;
+}
+
+
+
+// Extend a range so that it covers the items [first, first + count).
+static void _range_merge(DvzItemRange* range, uint32_t first, uint32_t count)
+{
+    ASSERT(range != NULL);
+    if (count == 0 || _range_is_all(*range))
+        return;
+    if (range->count == 0)
+    {
+        range->first = first;
+        range->count = count;
+        return;
+    }
+    uint32_t end = MAX(range->first + range->count, first + count);
+    range->first = MIN(range->first, first);
+    range->count = end - range->first;
+}
+
+
+
 static uint32_t _get_texture_ndims(DvzSourceKind source_kind)
 {
     uint32_t ndims = 1;
@@ -243,6 +287,20 @@ static DvzBindings* _get_bindings(DvzVisual* visual, DvzSource* source)
 
 
 
+// Stop referencing borrowed data, without copying it, before the array is entirely rewritten.
+static void _array_unborrow(DvzArray* arr)
+{
+    ASSERT(arr != NULL);
+    if (!arr->is_borrowed)
+        return;
+    arr->is_borrowed = false;
+    arr->data = NULL;
+    arr->item_count = 0;
+    arr->buffer_size = 0;
+}
+
+
+
 // Return the prop array, transformed if it exists, otherwise original.
 static DvzArray* _prop_array(DvzProp* prop)
 {
@@ -266,6 +324,118 @@ static DvzArray* _prop_array(DvzProp* prop)
 
 
 
+// Whether the bounding box of a prop is maintained.
+static bool _prop_has_bounds(DvzProp* prop)
+{
+    ASSERT(prop != NULL);
+    return prop->prop_type == DVZ_PROP_POS &&
+           (prop->arr_orig.dtype == DVZ_DTYPE_VEC3 || prop->arr_orig.dtype == DVZ_DTYPE_DVEC3);
+}
+
+
+
+// Return the bounding box of a POS prop, without its origin. All items are only scanned when the
+// bounds have been invalidated.
+static DvzBox _prop_bounds(DvzProp* prop)
+{
+    ASSERT(prop != NULL);
+    ASSERT(_prop_has_bounds(prop));
+    if (!prop->bounds_valid)
+    {
+        log_trace("scan all %d items of POS prop #%d", prop->arr_orig.item_count, prop->prop_idx);
+        prop->bounds = DVZ_BOX_INF;
+        dvz_array_bounds(
+            &prop->arr_orig, 0, prop->arr_orig.item_count, prop->bounds.p0, prop->bounds.p1);
+        prop->bounds_valid = true;
+    }
+    return prop->bounds;
+}
+
+
+
+// Called before the items [first, first + count) of a prop are overwritten, and the prop array is
+// resized to new_count items. The bounds are invalidated only if some of the overwritten or
+// removed items may be extremes.
+static void _prop_bounds_before(DvzProp* prop, uint32_t first, uint32_t count, uint32_t new_count)
+{
+    ASSERT(prop != NULL);
+    if (!prop->bounds_valid || !_prop_has_bounds(prop))
+        return;
+
+    // All items are replaced.
+    uint32_t n = prop->arr_orig.item_count;
+    if (first == 0 && count >= n)
+    {
+        prop->bounds_valid = false;
+        return;
+    }
+
+    // Overwritten and removed items.
+    DvzBox box = DVZ_BOX_INF;
+    if (first < n)
+        dvz_array_bounds(&prop->arr_orig, first, MIN(count, n - first), box.p0, box.p1);
+    if (new_count < n)
+        dvz_array_bounds(&prop->arr_orig, new_count, n - new_count, box.p0, box.p1);
+    for (uint32_t j = 0; j < 3; j++)
+    {
+        if (box.p0[j] <= prop->bounds.p0[j] || box.p1[j] >= prop->bounds.p1[j])
+        {
+            prop->bounds_valid = false;
+            return;
+        }
+    }
+}
+
+
+
+// Called after the items [first, first + count) of a prop have been written.
+static void _prop_bounds_after(DvzProp* prop, uint32_t first, uint32_t count)
+{
+    ASSERT(prop != NULL);
+    if (!prop->bounds_valid || !_prop_has_bounds(prop) || count == 0)
+        return;
+    dvz_array_bounds(&prop->arr_orig, first, count, prop->bounds.p0, prop->bounds.p1);
+}
+
+
+
+// Call the release callback once the prop no longer references the borrowed caller memory, or
+// unconditionally if force is true.
+static void _prop_release(DvzVisual* visual, DvzProp* prop, bool force)
+{
+    ASSERT(prop != NULL);
+    if (prop->borrowed == NULL)
+        return;
+    if (!force && prop->arr_orig.is_borrowed && prop->arr_orig.data == prop->borrowed)
+        return;
+
+    void* data = prop->borrowed;
+    DvzVisualReleaseCallback release = prop->release;
+    void* user_data = prop->release_data;
+    prop->borrowed = NULL;
+    prop->release = NULL;
+    prop->release_data = NULL;
+
+    log_trace("release the borrowed data of prop %d #%d", prop->prop_type, prop->prop_idx);
+    if (release != NULL)
+        release(visual, data, user_data);
+}
+
+
+
+// Copy the state of the circular vertex buffer of a visual to a viewport struct.
+static void _ring_viewport(DvzVisual* visual, DvzViewport* viewport)
+{
+    ASSERT(visual != NULL);
+    ASSERT(viewport != NULL);
+    viewport->ring[0] = visual->ring_head;
+    viewport->ring[1] = visual->ring_capacity;
+    viewport->ring[2] = visual->ring_count;
+    viewport->ring[3] = 0;
+}
+
+
+
 static uint32_t _source_size(DvzVisual* visual, DvzSource* source)
 {
     ASSERT(visual != NULL);
@@ -349,7 +519,8 @@ static void _create_source_buffer(DvzCanvas* canvas, DvzSource* source, VkDevice
 
 
 
-static void _source_buffer(DvzVisual* visual, DvzSource* source)
+// Return whether a new GPU buffer region has been allocated.
+static bool _source_buffer(DvzVisual* visual, DvzSource* source)
 {
     ASSERT(visual != NULL);
     ASSERT(source != NULL);
@@ -372,8 +543,11 @@ static void _source_buffer(DvzVisual* visual, DvzSource* source)
         _create_source_buffer(canvas, source, size);
         // Set the pipeline bindings with the source buffer.
         _set_source_bindings(visual, source);
+        ASSERT(source->u.br.buffer != VK_NULL_HANDLE);
+        return true;
     }
     ASSERT(source->u.br.buffer != VK_NULL_HANDLE);
+    return false;
 }
 
 
@@ -433,7 +607,43 @@ static void _source_texture(DvzVisual* visual, DvzSource* source)
 /*  Visual baking helpers                                                                        */
 /*************************************************************************************************/
 
-static void _prop_copy(DvzVisual* visual, DvzProp* prop)
+// Minimum number of items per chunk when a single bake is split between worker threads.
+#define DVZ_BAKE_CHUNK_SIZE 16384
+
+// Return the task pool used to split large bakes in parallel chunks, or NULL.
+static DvzTaskPool* _bake_tasks(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    return canvas != NULL && canvas->app != NULL ? canvas->app->tasks : NULL;
+}
+
+
+
+// Scale the float column of a prop in the source items [first, first + count).
+static void _source_scale(DvzSource* source, DvzProp* prop, uint32_t first, uint32_t count)
+{
+    ASSERT(source != NULL);
+    ASSERT(prop != NULL);
+    DvzDataType dtype =
+        prop->target_dtype != DVZ_DTYPE_NONE ? prop->target_dtype : prop->arr_orig.dtype;
+    // TODO: support other dtypes.
+    if (dtype != DVZ_DTYPE_FLOAT)
+        return;
+    VkDeviceSize item_size = source->arr.item_size;
+    float* value = NULL;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        value = (float*)((int64_t)source->arr.data + (int64_t)(i * item_size + prop->offset));
+        *value *= prop->dpi_scaling;
+    }
+}
+
+
+
+// Copy the prop items [first, first + count) to the source array. The last prop item is repeated
+// until the end of the source array.
+static void _prop_copy_range(DvzVisual* visual, DvzProp* prop, uint32_t first, uint32_t count)
 {
     ASSERT(prop != NULL);
 
@@ -457,21 +667,43 @@ static void _prop_copy(DvzVisual* visual, DvzProp* prop)
     ASSERT(arr->data != NULL);
     ASSERT(source->arr.data != NULL);
     ASSERT(arr->item_count <= source->arr.item_count);
+    ASSERT(count > 0);
+    ASSERT(first + count <= arr->item_count);
+
+    // Corresponding items in the source array.
+    uint32_t reps = MAX(1, prop->reps);
+    uint32_t dst_first = first * reps;
+    uint32_t dst_end =
+        first + count == arr->item_count ? source->arr.item_count : (first + count) * reps;
+    ASSERT(dst_first < dst_end);
+    ASSERT(dst_end <= source->arr.item_count);
+
+    log_debug(
+        "copy prop type %d items %d-%d to source buffer", prop->prop_type, first, first + count);
+    dvz_array_column(
+        &source->arr, prop->offset, col_size, dst_first, dst_end - dst_first, //
+        count, (const char*)arr->data + first * col_size,                     //
+        prop->arr_orig.dtype, prop->target_dtype,                             // optional cast
+        prop->copy_type, prop->reps);
 
-    // Implement DPI scaling here.
+    // DPI scaling is applied to the copied items of the source array, so that the prop data is
+    // never modified (it may be borrowed from the caller).
     if (prop->dpi_scaling != 1)
+        _source_scale(source, prop, dst_first, dst_end - dst_first);
+}
+
+
+
+static void _prop_copy(DvzVisual* visual, DvzProp* prop)
+{
+    ASSERT(prop != NULL);
+    DvzArray* arr = _prop_array(prop);
+    if (arr->item_count == 0)
     {
-        prop->arr_staging = dvz_array_copy(arr);
-        arr = &prop->arr_staging;
-        dvz_array_scale(arr, prop->dpi_scaling);
+        log_debug("visual prop %d #%d not set", prop->prop_type, prop->prop_idx);
+        return;
     }
-
-    log_debug("copy prop type %d to source buffer", prop->prop_type);
-    dvz_array_column(
-        &source->arr, prop->offset, col_size, 0, source->arr.item_count, //
-        arr->item_count, arr->data,                                      //
-        prop->arr_orig.dtype, prop->target_dtype,                        // optional cast
-        prop->copy_type, prop->reps);
+    _prop_copy_range(visual, prop, 0, arr->item_count);
 }
 
 
@@ -510,6 +742,62 @@ static void _source_fill(DvzVisual* visual, DvzSource* source)
 
 
 
+// Copy the changed items of all props associated to a source, and keep track of the changed
+// source items. Return false if the whole source needs to be baked again.
+static bool _source_fill_dirty(DvzVisual* visual, DvzSource* source)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+
+    DvzItemRange dirty = {0};
+    DvzArray* arr = NULL;
+    DvzProp* prop = NULL;
+    uint32_t reps = 0, end = 0;
+
+    // First pass: determine whether all changed props can be copied partially.
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source == source && prop->dirty.count > 0 &&
+            prop->copy_type != DVZ_ARRAY_COPY_NONE)
+        {
+            arr = _prop_array(prop);
+            if (_range_is_all(prop->dirty) || arr->data == NULL || arr == &prop->arr_staging ||
+                prop->dirty.first + prop->dirty.count > arr->item_count)
+                return false;
+
+            // Corresponding items in the source array, the last item being repeated until the
+            // end of the source.
+            reps = MAX(1, prop->reps);
+            end = prop->dirty.first + prop->dirty.count;
+            end = end == arr->item_count ? source->arr.item_count : end * reps;
+            _range_merge(&dirty, prop->dirty.first * reps, end - prop->dirty.first * reps);
+        }
+        dvz_container_iter(&iter);
+    }
+    if (dirty.count == 0)
+        return false;
+
+    // Second pass: copy the changed prop items.
+    log_debug(
+        "baking items %d-%d of source %d", dirty.first, dirty.first + dirty.count,
+        source->source_kind);
+    iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source == source && prop->dirty.count > 0)
+            _prop_copy_range(visual, prop, prop->dirty.first, prop->dirty.count);
+        dvz_container_iter(&iter);
+    }
+
+    source->dirty = dirty;
+    return true;
+}
+
+
+
 // Get the first source of a given type for the given pipeline, or none.
 static DvzSource*
 _get_pipeline_source(DvzVisual* visual, DvzSourceType source_type, uint32_t pipeline_idx)
@@ -529,6 +817,59 @@ _get_pipeline_source(DvzVisual* visual, DvzSourceType source_type, uint32_t pipe
 
 
 
+// Return the prop whose borrowed data can be used as is as the source array, or NULL. This is
+// the case when a single prop fills whole source items without any conversion.
+static DvzProp* _source_passthrough(DvzVisual* visual, DvzSource* source, uint32_t count)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+
+    DvzProp* out = NULL;
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source == source && prop->copy_type != DVZ_ARRAY_COPY_NONE)
+        {
+            if (out != NULL)
+                return NULL;
+            out = prop;
+        }
+        dvz_container_iter(&iter);
+    }
+    if (out == NULL || !out->arr_orig.is_borrowed || _prop_array(out) != &out->arr_orig)
+        return NULL;
+    if (out->copy_type != DVZ_ARRAY_COPY_SINGLE || out->reps > 1 || out->offset != 0 ||
+        out->dpi_scaling != 1 ||
+        (out->target_dtype != DVZ_DTYPE_NONE && out->target_dtype != out->arr_orig.dtype))
+        return NULL;
+    if (out->arr_orig.item_size != source->arr.item_size || out->arr_orig.item_count != count)
+        return NULL;
+    return out;
+}
+
+
+
+// Make the source array reference borrowed prop data instead of copying it.
+static void _source_borrow(DvzSource* source, DvzArray* arr)
+{
+    ASSERT(source != NULL);
+    ASSERT(arr != NULL);
+    if (source->arr.is_borrowed && source->arr.data == arr->data &&
+        source->arr.item_count == arr->item_count)
+        return;
+    log_debug("source %d references the borrowed prop data", source->source_kind);
+    if (!source->arr.is_borrowed)
+        FREE(source->arr.data)
+    source->arr.data = arr->data;
+    source->arr.item_count = arr->item_count;
+    source->arr.buffer_size = arr->buffer_size;
+    source->arr.is_borrowed = true;
+}
+
+
+
 static void _bake_source(DvzVisual* visual, DvzSource* source)
 {
     ASSERT(visual != NULL);
@@ -553,6 +894,21 @@ static void _bake_source(DvzVisual* visual, DvzSource* source)
         return;
     }
 
+    // Upload borrowed prop data directly when it has the same layout as the source.
+    DvzProp* prop = _source_passthrough(visual, source, count);
+    if (prop != NULL)
+    {
+        _source_borrow(source, &prop->arr_orig);
+        _range_all(&source->dirty);
+        return;
+    }
+    // The borrowed data may have been released since the last bake.
+    _array_unborrow(&source->arr);
+
+    // Only copy the items that have changed if the source array does not need to be resized.
+    if (source->arr.item_count == count && _source_fill_dirty(visual, source))
+        return;
+
     log_debug("baking source %d", source->source_kind);
 
     // Allocate the source array.
@@ -560,6 +916,7 @@ static void _bake_source(DvzVisual* visual, DvzSource* source)
 
     // Copy all corresponding props to the array.
     _source_fill(visual, source);
+    _range_all(&source->dirty);
 }
 
 
@@ -615,6 +972,175 @@ static void _default_visual_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 
 
 
+// Draw a range of vertices, or of instances if the graphics pipeline is instanced.
+static void _draw_vertices(
+    DvzGraphics* graphics, DvzCommands* cmds, uint32_t idx, uint32_t first, uint32_t count)
+{
+    ASSERT(graphics != NULL);
+    if (graphics->instance_vertex_count > 0)
+        dvz_cmd_draw_instanced(cmds, idx, 0, graphics->instance_vertex_count, first, count);
+    else
+        dvz_cmd_draw(cmds, idx, first, count);
+}
+
+
+
+// Number of vertices of each primitive of a graphics pipeline, or 0 with the strip and fan
+// topologies, whose primitives share vertices.
+static uint32_t _primitive_vertex_count(DvzGraphics* graphics)
+{
+    ASSERT(graphics != NULL);
+    // One primitive per instance, whatever the topology of the instance.
+    if (graphics->instance_vertex_count > 0)
+        return 1;
+    switch (graphics->topology)
+    {
+    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+        return 1;
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+        return 2;
+    case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+
+
+// Whether the groups of a visual can be drawn separately: they must cover the vertex buffer, and
+// each group must contain whole primitives.
+static bool _are_groups_aligned(DvzVisual* visual, DvzGraphics* graphics, uint32_t vertex_count)
+{
+    ASSERT(visual != NULL);
+    uint32_t k = _primitive_vertex_count(graphics);
+    if (k == 0)
+        return false;
+    uint32_t total = 0;
+    for (uint32_t g = 0; g < visual->group_count; g++)
+    {
+        if (visual->group_sizes[g] % k != 0)
+            return false;
+        total += visual->group_sizes[g];
+    }
+    return total == vertex_count;
+}
+
+
+
+// Draw the vertices of the groups that are not culled, one draw per run of consecutive groups.
+// Return false if the groups cannot be drawn separately (see _are_groups_aligned()).
+static bool _draw_groups(
+    DvzVisual* visual, DvzGraphics* graphics, DvzCommands* cmds, uint32_t idx,
+    uint32_t vertex_count)
+{
+    ASSERT(visual != NULL);
+    if (!_are_groups_aligned(visual, graphics, vertex_count))
+        return false;
+
+    uint32_t offset = 0, first = 0, count = 0;
+    for (uint32_t g = 0; g < visual->group_count; g++)
+    {
+        if (!visual->group_culled[g])
+        {
+            if (count == 0)
+                first = offset;
+            count += visual->group_sizes[g];
+        }
+        else if (count > 0)
+        {
+            _draw_vertices(graphics, cmds, idx, first, count);
+            count = 0;
+        }
+        offset += visual->group_sizes[g];
+    }
+    if (count > 0)
+        _draw_vertices(graphics, cmds, idx, first, count);
+    log_debug(
+        "draw %d groups out of %d", visual->group_count - visual->group_culled_count,
+        visual->group_count);
+    return true;
+}
+
+
+
+// Number of vertices of a circular vertex buffer drawn again after the wraparound, so that the
+// primitive joining the end and the beginning of the buffer is complete.
+static uint32_t _ring_overlap(DvzGraphics* graphics)
+{
+    ASSERT(graphics != NULL);
+    if (graphics->instance_vertex_count > 0)
+        return 0;
+    switch (graphics->topology)
+    {
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+        return 1;
+    case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+
+
+// Compute the two indirect draw commands of every graphics pipeline of a circular vertex buffer.
+static void _ring_draws(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    uint32_t capacity = visual->ring_capacity;
+    uint32_t head = visual->ring_head;
+    uint32_t count = visual->ring_count;
+    ASSERT(capacity > 0);
+    ASSERT(head < capacity);
+    ASSERT(count <= capacity);
+
+    // From the oldest vertex to the end of the buffer, then from the beginning of the buffer to
+    // the newest vertex. Strips continue in the first draw with the vertices duplicated after the
+    // end of the buffer.
+    uint32_t n1 = MIN(count, capacity - head);
+    uint32_t n0 = count - n1;
+
+    DvzGraphics* graphics = NULL;
+    VkDrawIndirectCommand* draws = NULL;
+    for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
+    {
+        graphics = visual->graphics[pidx];
+        ASSERT(graphics != NULL);
+        draws = &visual->ring_draws[2 * pidx];
+        if (graphics->instance_vertex_count > 0)
+        {
+            draws[0] = (VkDrawIndirectCommand){graphics->instance_vertex_count, n1, 0, head};
+            draws[1] = (VkDrawIndirectCommand){graphics->instance_vertex_count, n0, 0, 0};
+        }
+        else
+        {
+            draws[0] = (VkDrawIndirectCommand){
+                n1 + MIN(_ring_overlap(graphics), n0), 1, head, 0};
+            draws[1] = (VkDrawIndirectCommand){n0, 1, 0, 0};
+        }
+    }
+}
+
+
+
+// Draw a graphics pipeline of a circular vertex buffer in time order.
+static void _draw_ring(DvzVisual* visual, DvzCommands* cmds, uint32_t idx, uint32_t pipeline_idx)
+{
+    ASSERT(visual != NULL);
+    DvzBufferRegions br = visual->br_ring_draws;
+    ASSERT(br.buffer != NULL);
+    ASSERT(br.count == 1);
+    VkDeviceSize offset = br.offsets[0];
+    for (uint32_t k = 0; k < 2; k++)
+    {
+        br.offsets[0] = offset + (2 * pipeline_idx + k) * sizeof(VkDrawIndirectCommand);
+        dvz_cmd_draw_indirect(cmds, idx, br);
+    }
+}
+
+
+
 static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
 {
     ASSERT(visual != NULL);
@@ -679,7 +1205,18 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
             log_debug("draw %d vertices", vertex_count);
             // Make sure the bound vertex buffer is large enough.
             ASSERT(vertex_buf->size >= vertex_count * vertex_source->arr.item_size);
-            dvz_cmd_draw(cmds, idx, 0, vertex_count);
+            // Circular vertex buffer, drawn in time order.
+            if (visual->ring_capacity > 0 && visual->br_ring_draws.buffer != NULL)
+            {
+                _draw_ring(visual, cmds, idx, pipeline_idx);
+                continue;
+            }
+            // Skip the groups outside of the current view.
+            DvzGraphics* graphics = visual->graphics[pipeline_idx];
+            if (visual->group_culled_count > 0 &&
+                _draw_groups(visual, graphics, cmds, idx, vertex_count))
+                continue;
+            _draw_vertices(graphics, cmds, idx, 0, vertex_count);
         }
         else
         {
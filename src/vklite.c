@@ -21,6 +21,9 @@ DvzApp* dvz_app(DvzBackend backend)
     // Initialize the global clock.
     _clock_init(&app->clock);
 
+    // Worker threads shared by all canvases.
+    app->tasks = dvz_task_pool(0);
+
     app->gpus = dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzGpu), DVZ_OBJECT_TYPE_GPU);
     app->windows =
         dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzWindow), DVZ_OBJECT_TYPE_WINDOW);
@@ -80,6 +83,10 @@ int dvz_app_destroy(DvzApp* app)
     // Destroy the canvases.
     dvz_canvases_destroy(&app->canvases);
 
+    // Stop the worker threads.
+    dvz_task_pool_destroy(app->tasks);
+    app->tasks = NULL;
+
     // Destroy the GPUs.
     CONTAINER_DESTROY_ITEMS(DvzGpu, app->gpus, dvz_gpu_destroy)
     dvz_container_destroy(&app->gpus);
@@ -225,8 +232,17 @@ void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface)
             create_command_pool(gpu->device, qf, &q->cmd_pools[qf]);
     }
 
+    // Create the queue locks.
+    for (uint32_t i = 0; i < q->queue_count; i++)
+    {
+        if (pthread_mutex_init(&q->locks[i], NULL) != 0)
+            log_error("mutex creation failed");
+    }
+
     // Create descriptor pool.
     create_descriptor_pool(gpu->device, &gpu->dset_pool);
+    if (pthread_mutex_init(&gpu->dset_lock, NULL) != 0)
+        log_error("mutex creation failed");
 
     dvz_obj_created(&gpu->obj);
     log_trace("GPU #%d created", gpu->idx);
@@ -234,12 +250,45 @@ void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface)
 
 
 
+// Index of the lock protecting a given queue: several requested queues may share the same VkQueue.
+static uint32_t _queue_lock_idx(DvzQueues* q, uint32_t queue_idx)
+{
+    ASSERT(q != NULL);
+    ASSERT(queue_idx < q->queue_count);
+    for (uint32_t i = 0; i < queue_idx; i++)
+    {
+        if (q->queues[i] == q->queues[queue_idx])
+            return i;
+    }
+    return queue_idx;
+}
+
+
+
+void dvz_queue_lock(DvzGpu* gpu, uint32_t queue_idx)
+{
+    ASSERT(gpu != NULL);
+    pthread_mutex_lock(&gpu->queues.locks[_queue_lock_idx(&gpu->queues, queue_idx)]);
+}
+
+
+
+void dvz_queue_unlock(DvzGpu* gpu, uint32_t queue_idx)
+{
+    ASSERT(gpu != NULL);
+    pthread_mutex_unlock(&gpu->queues.locks[_queue_lock_idx(&gpu->queues, queue_idx)]);
+}
+
+
+
 void dvz_queue_wait(DvzGpu* gpu, uint32_t queue_idx)
 {
     ASSERT(gpu != NULL);
     ASSERT(queue_idx < gpu->queues.queue_count);
     // log_trace("waiting for queue #%d", queue_idx);
+    dvz_queue_lock(gpu, queue_idx);
     vkQueueWaitIdle(gpu->queues.queues[queue_idx]);
+    dvz_queue_unlock(gpu, queue_idx);
 }
 
 
@@ -248,8 +297,23 @@ void dvz_gpu_wait(DvzGpu* gpu)
 {
     ASSERT(gpu != NULL);
     log_trace("waiting for device");
-    if (gpu->device != VK_NULL_HANDLE)
-        vkDeviceWaitIdle(gpu->device);
+    if (gpu->device == VK_NULL_HANDLE)
+        return;
+
+    // vkDeviceWaitIdle() requires host access to all queues to be externally synchronized. The
+    // locks are always acquired in the same order to avoid deadlocks.
+    DvzQueues* q = &gpu->queues;
+    for (uint32_t i = 0; i < q->queue_count; i++)
+    {
+        if (_queue_lock_idx(q, i) == i)
+            pthread_mutex_lock(&q->locks[i]);
+    }
+    vkDeviceWaitIdle(gpu->device);
+    for (uint32_t i = 0; i < q->queue_count; i++)
+    {
+        if (_queue_lock_idx(q, i) == i)
+            pthread_mutex_unlock(&q->locks[i]);
+    }
 }
 
 
@@ -308,6 +372,9 @@ void dvz_gpu_destroy(DvzGpu* gpu)
         vkDestroyDescriptorPool(gpu->device, gpu->dset_pool, NULL);
         gpu->dset_pool = VK_NULL_HANDLE;
     }
+    pthread_mutex_destroy(&gpu->dset_lock);
+    for (uint32_t i = 0; i < gpu->queues.queue_count; i++)
+        pthread_mutex_destroy(&gpu->queues.locks[i]);
 
 
     // Destroy the device.
@@ -596,7 +663,9 @@ void dvz_swapchain_present(
     info.pSwapchains = &swapchain->swapchain;
     info.pImageIndices = &swapchain->img_idx;
 
+    dvz_queue_lock(swapchain->gpu, queue_idx);
     VkResult res = vkQueuePresentKHR(swapchain->gpu->queues.queues[queue_idx], &info);
+    dvz_queue_unlock(swapchain->gpu, queue_idx);
 
     switch (res)
     {
@@ -649,6 +718,46 @@ void dvz_swapchain_destroy(DvzSwapchain* swapchain)
 /*************************************************************************************************/
 
 DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(dvz_obj_is_created(&gpu->obj));
+    ASSERT(queue < gpu->queues.queue_count);
+    uint32_t qf = gpu->queues.queue_families[queue];
+    ASSERT(qf < gpu->queues.queue_family_count);
+
+    // Default command pool of the queue family.
+    return dvz_commands_pool(gpu, queue, gpu->queues.cmd_pools[qf], count);
+}
+
+
+
+VkCommandPool dvz_cmd_pool(DvzGpu* gpu, uint32_t queue)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(dvz_obj_is_created(&gpu->obj));
+    ASSERT(queue < gpu->queues.queue_count);
+    uint32_t qf = gpu->queues.queue_families[queue];
+    ASSERT(qf < gpu->queues.queue_family_count);
+
+    VkCommandPool pool = VK_NULL_HANDLE;
+    create_command_pool(gpu->device, qf, &pool);
+    return pool;
+}
+
+
+
+void dvz_cmd_pool_destroy(DvzGpu* gpu, VkCommandPool pool)
+{
+    ASSERT(gpu != NULL);
+    if (pool == VK_NULL_HANDLE)
+        return;
+    log_trace("destroy command pool");
+    vkDestroyCommandPool(gpu->device, pool, NULL);
+}
+
+
+
+DvzCommands dvz_commands_pool(DvzGpu* gpu, uint32_t queue, VkCommandPool pool, uint32_t count)
 {
     ASSERT(gpu != NULL);
     ASSERT(dvz_obj_is_created(&gpu->obj));
@@ -656,16 +765,17 @@ DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
     ASSERT(count <= DVZ_MAX_COMMAND_BUFFERS_PER_SET);
     ASSERT(queue < gpu->queues.queue_count);
     ASSERT(count > 0);
+    ASSERT(pool != VK_NULL_HANDLE);
     uint32_t qf = gpu->queues.queue_families[queue];
     ASSERT(qf < gpu->queues.queue_family_count);
-    ASSERT(gpu->queues.cmd_pools[qf] != VK_NULL_HANDLE);
     log_trace("creating commands on queue #%d, queue family #%d", queue, qf);
 
     DvzCommands commands = {0};
     commands.gpu = gpu;
     commands.queue_idx = queue;
     commands.count = count;
-    allocate_command_buffers(gpu->device, gpu->queues.cmd_pools[qf], count, commands.cmds);
+    commands.pool = pool;
+    allocate_command_buffers(gpu->device, pool, count, commands.cmds);
 
     dvz_obj_init(&commands.obj);
 
@@ -719,9 +829,8 @@ void dvz_cmd_free(DvzCommands* cmds)
     ASSERT(cmds->gpu->device != VK_NULL_HANDLE);
 
     log_trace("free %d command buffer(s)", cmds->count);
-    vkFreeCommandBuffers(
-        cmds->gpu->device, cmds->gpu->queues.cmd_pools[cmds->queue_idx], //
-        cmds->count, cmds->cmds);
+    ASSERT(cmds->pool != VK_NULL_HANDLE);
+    vkFreeCommandBuffers(cmds->gpu->device, cmds->pool, cmds->count, cmds->cmds);
 
     dvz_obj_init(&cmds->obj);
 }
@@ -735,6 +844,7 @@ void dvz_cmd_submit_sync(DvzCommands* cmds, uint32_t idx)
     DvzQueues* q = &cmds->gpu->queues;
     VkQueue queue = q->queues[cmds->queue_idx];
 
+    dvz_queue_lock(cmds->gpu, cmds->queue_idx);
     vkQueueWaitIdle(queue);
     VkSubmitInfo info = {0};
     info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -742,6 +852,7 @@ void dvz_cmd_submit_sync(DvzCommands* cmds, uint32_t idx)
     info.pCommandBuffers = cmds->cmds;
     vkQueueSubmit(queue, 1, &info, VK_NULL_HANDLE);
     vkQueueWaitIdle(queue);
+    dvz_queue_unlock(cmds->gpu, cmds->queue_idx);
 }
 
 
@@ -937,9 +1048,8 @@ void dvz_buffer_resize(DvzBuffer* buffer, VkDeviceSize size, DvzCommands* cmds)
         dvz_cmd_copy_buffer(cmds, 0, buffer, 0, &new_buffer, 0, buffer->size);
         dvz_cmd_end(cmds, 0);
 
-        VkQueue queue = gpu->queues.queues[queue_idx];
         dvz_cmd_submit_sync(cmds, 0);
-        vkQueueWaitIdle(queue);
+        dvz_queue_wait(gpu, queue_idx);
     }
 
     // Delete the old buffer after the transfer has finished.
@@ -1703,8 +1813,10 @@ DvzBindings dvz_bindings(DvzSlots* slots, uint32_t dset_count)
     log_trace("starting creation of bindings with %d descriptor sets...", dset_count);
     bindings.dset_count = dset_count;
 
+    pthread_mutex_lock(&gpu->dset_lock);
     allocate_descriptor_sets(
         gpu->device, gpu->dset_pool, slots->dset_layout, bindings.dset_count, bindings.dsets);
+    pthread_mutex_unlock(&gpu->dset_lock);
 
     dvz_obj_created(&bindings.obj);
     log_trace("bindings created");
@@ -1822,6 +1934,19 @@ void dvz_compute_code(DvzCompute* compute, const char* code)
 
 
 
+void dvz_compute_spirv(DvzCompute* compute, VkDeviceSize size, const uint32_t* buffer)
+{
+    ASSERT(compute != NULL);
+    ASSERT(compute->gpu != NULL);
+    ASSERT(compute->gpu->device != VK_NULL_HANDLE);
+    ASSERT(size > 0);
+    ASSERT(buffer != NULL);
+
+    compute->shader_module = create_shader_module(compute->gpu->device, size, buffer);
+}
+
+
+
 void dvz_compute_slot(DvzCompute* compute, uint32_t idx, VkDescriptorType type)
 {
     ASSERT(compute != NULL);
@@ -1865,7 +1990,12 @@ void dvz_compute_create(DvzCompute* compute)
 
     log_trace("starting creation of compute...");
 
-    if (compute->shader_code != NULL)
+    // NOTE: the shader module already exists if the SPIRV code was set directly.
+    if (compute->shader_module != VK_NULL_HANDLE)
+    {
+        log_trace("compute shader module already created from SPIRV code");
+    }
+    else if (compute->shader_code != NULL)
     {
         compute->shader_module =
             dvz_shader_compile(compute->gpu, compute->shader_code, VK_SHADER_STAGE_COMPUTE_BIT);
@@ -2005,6 +2135,27 @@ void dvz_graphics_vertex_binding(DvzGraphics* graphics, uint32_t binding, VkDevi
     DvzVertexBinding* vb = &graphics->vertex_bindings[graphics->vertex_binding_count++];
     vb->binding = binding;
     vb->stride = stride;
+    vb->input_rate = VK_VERTEX_INPUT_RATE_VERTEX;
+}
+
+
+
+void dvz_graphics_vertex_input_rate(
+    DvzGraphics* graphics, uint32_t binding, VkVertexInputRate input_rate,
+    uint32_t instance_vertex_count)
+{
+    ASSERT(graphics != NULL);
+    for (uint32_t i = 0; i < graphics->vertex_binding_count; i++)
+    {
+        if (graphics->vertex_bindings[i].binding == binding)
+        {
+            graphics->vertex_bindings[i].input_rate = input_rate;
+            if (input_rate == VK_VERTEX_INPUT_RATE_INSTANCE)
+                graphics->instance_vertex_count = instance_vertex_count;
+            return;
+        }
+    }
+    log_error("vertex binding %d not found", binding);
 }
 
 
@@ -2112,7 +2263,7 @@ void dvz_graphics_create(DvzGraphics* graphics)
     {
         bindings_info[i].binding = graphics->vertex_bindings[i].binding;
         bindings_info[i].stride = graphics->vertex_bindings[i].stride;
-        bindings_info[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindings_info[i].inputRate = graphics->vertex_bindings[i].input_rate;
     }
     vertex_input_info.vertexBindingDescriptionCount = graphics->vertex_binding_count;
     vertex_input_info.pVertexBindingDescriptions = bindings_info;
@@ -2993,7 +3144,11 @@ void dvz_submit_send(DvzSubmit* submit, uint32_t cmd_idx, DvzFences* fence, uint
         dvz_fences_reset(fence, fence_idx);
     }
     // log_trace("submit queue and signal fence %d", vfence);
-    VK_CHECK_RESULT(vkQueueSubmit(submit->gpu->queues.queues[queue_idx], 1, &submit_info, vfence));
+    dvz_queue_lock(submit->gpu, queue_idx);
+    VkResult result =
+        vkQueueSubmit(submit->gpu->queues.queues[queue_idx], 1, &submit_info, vfence);
+    dvz_queue_unlock(submit->gpu, queue_idx);
+    VK_CHECK_RESULT(result);
 
     // log_trace("submit done");
 }
@@ -3187,6 +3342,45 @@ void dvz_cmd_copy_buffer_to_image(
 
 
 
+void dvz_cmd_copy_buffer_to_image_region(
+    DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, VkDeviceSize buf_offset,
+    DvzImages* images, ivec3 offset, uvec3 shape)
+{
+    ASSERT(buffer != NULL);
+    ASSERT(images != NULL);
+    ASSERT(shape[0] > 0);
+    ASSERT(shape[1] > 0);
+    ASSERT(shape[2] > 0);
+
+    CMD_START_CLIP(images->count)
+
+    VkBufferImageCopy region = {0};
+    region.bufferOffset = buf_offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    region.imageOffset.x = offset[0];
+    region.imageOffset.y = offset[1];
+    region.imageOffset.z = offset[2];
+
+    region.imageExtent.width = shape[0];
+    region.imageExtent.height = shape[1];
+    region.imageExtent.depth = shape[2];
+
+    vkCmdCopyBufferToImage(
+        cb, buffer->buffer, images->images[iclip], //
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    CMD_END
+}
+
+
+
 void dvz_cmd_copy_image_to_buffer(
     DvzCommands* cmds, uint32_t idx, DvzImages* images, DvzBuffer* buffer)
 {
@@ -3219,6 +3413,67 @@ void dvz_cmd_copy_image_to_buffer(
 
 
 
+void dvz_cmd_copy_image_region_to_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, ivec3 offset, uvec3 shape,
+    DvzBuffer* buffer, VkDeviceSize buf_offset)
+{
+    dvz_cmd_copy_image_regions_to_buffer(
+        cmds, idx, images, 1, (const ivec3*)offset, (const uvec3*)shape, buffer, &buf_offset);
+}
+
+
+
+void dvz_cmd_copy_image_regions_to_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, uint32_t count, const ivec3* offsets,
+    const uvec3* shapes, DvzBuffer* buffer, const VkDeviceSize* buf_offsets)
+{
+    ASSERT(images != NULL);
+    ASSERT(buffer != NULL);
+    ASSERT(count > 0);
+    ASSERT(offsets != NULL);
+    ASSERT(shapes != NULL);
+    ASSERT(buf_offsets != NULL);
+
+    VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(count, sizeof(VkBufferImageCopy));
+    VkBufferImageCopy* region = NULL;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ASSERT(shapes[i][0] > 0);
+        ASSERT(shapes[i][1] > 0);
+        ASSERT(shapes[i][2] > 0);
+
+        region = &regions[i];
+        region->bufferOffset = buf_offsets[i];
+        region->bufferRowLength = 0;
+        region->bufferImageHeight = 0;
+
+        region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region->imageSubresource.mipLevel = 0;
+        region->imageSubresource.baseArrayLayer = 0;
+        region->imageSubresource.layerCount = 1;
+
+        region->imageOffset.x = offsets[i][0];
+        region->imageOffset.y = offsets[i][1];
+        region->imageOffset.z = offsets[i][2];
+
+        region->imageExtent.width = shapes[i][0];
+        region->imageExtent.height = shapes[i][1];
+        region->imageExtent.depth = shapes[i][2];
+    }
+
+    CMD_START_CLIP(images->count)
+
+    vkCmdCopyImageToBuffer(
+        cb, images->images[iclip], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, //
+        buffer->buffer, count, regions);
+
+    CMD_END
+
+    FREE(regions);
+}
+
+
+
 void dvz_cmd_copy_image_region(
     DvzCommands* cmds, uint32_t idx,      //
     DvzImages* src_img, ivec3 src_offset, //
@@ -3282,8 +3537,13 @@ void dvz_cmd_viewport(DvzCommands* cmds, uint32_t idx, VkViewport viewport)
 {
     CMD_START
     vkCmdSetViewport(cb, 0, 1, &viewport);
+    // NOTE: the scissor offset must not be negative.
+    int32_t x = (int32_t)MAX(viewport.x, 0);
+    int32_t y = (int32_t)MAX(viewport.y, 0);
     VkRect2D scissor = {
-        {viewport.x, viewport.y}, {(uint32_t)viewport.width, (uint32_t)viewport.height}};
+        {x, y},
+        {(uint32_t)MAX(viewport.x + viewport.width - x, 0),
+         (uint32_t)MAX(viewport.y + viewport.height - y, 0)}};
     vkCmdSetScissor(cb, 0, 1, &scissor);
     CMD_END
 }
@@ -3354,6 +3614,19 @@ void dvz_cmd_draw(DvzCommands* cmds, uint32_t idx, uint32_t first_vertex, uint32
 
 
 
+void dvz_cmd_draw_instanced(
+    DvzCommands* cmds, uint32_t idx, uint32_t first_vertex, uint32_t vertex_count,
+    uint32_t first_instance, uint32_t instance_count)
+{
+    ASSERT(vertex_count > 0);
+    ASSERT(instance_count > 0);
+    CMD_START
+    vkCmdDraw(cb, vertex_count, instance_count, first_vertex, first_instance);
+    CMD_END
+}
+
+
+
 void dvz_cmd_draw_indexed(
     DvzCommands* cmds, uint32_t idx, uint32_t first_index, uint32_t vertex_offset,
     uint32_t index_count)